@@ -1,6 +1,173 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "DarkHours.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, DarkHours, "DarkHours" );
+DEFINE_LOG_CATEGORY(LogDarkHours);
+
+DEFINE_STAT(STAT_DarkHours_CharacterTick);
+DEFINE_STAT(STAT_DarkHours_AnimUpdateGameThread);
+DEFINE_STAT(STAT_DarkHours_AnimUpdateWorker);
+DEFINE_STAT(STAT_DarkHours_Interaction);
+DEFINE_STAT(STAT_DarkHours_InteractableQuery);
+DEFINE_STAT(STAT_DarkHours_HitscanResolve);
+DEFINE_STAT(STAT_DarkHours_ProjectileStep);
+DEFINE_STAT(STAT_DarkHours_ImpactEffects);
+DEFINE_STAT(STAT_DarkHours_ServerReplicateActors);
+DEFINE_STAT(STAT_DarkHours_Spawn);
+DEFINE_STAT(STAT_DarkHours_Destroy);
+DEFINE_STAT(STAT_DarkHours_BotUpdate);
+DEFINE_STAT(STAT_DarkHours_LevelStreamingUpdate);
+DEFINE_STAT(STAT_DarkHours_PhysicsBudgetUpdate);
+DEFINE_STAT(STAT_DarkHours_LagCompensationRecord);
+DEFINE_STAT(STAT_DarkHours_LagCompensationRewind);
+
+DEFINE_STAT(STAT_DarkHours_NumCharacterTicks);
+DEFINE_STAT(STAT_DarkHours_NumAnimUpdates);
+DEFINE_STAT(STAT_DarkHours_NumInteractions);
+DEFINE_STAT(STAT_DarkHours_NumSpawns);
+DEFINE_STAT(STAT_DarkHours_NumDestroys);
+DEFINE_STAT(STAT_DarkHours_NumPoolReuses);
+DEFINE_STAT(STAT_DarkHours_NumShots);
+DEFINE_STAT(STAT_DarkHours_NumDroppedShots);
+DEFINE_STAT(STAT_DarkHours_NumImpacts);
+DEFINE_STAT(STAT_DarkHours_NumSkippedImpacts);
+DEFINE_STAT(STAT_DarkHours_NumMoveCorrections);
+DEFINE_STAT(STAT_DarkHours_NumBotDecisions);
+DEFINE_STAT(STAT_DarkHours_NumBotPathQueries);
+DEFINE_STAT(STAT_DarkHours_NumBotPathCacheHits);
+DEFINE_STAT(STAT_DarkHours_NumPhysicsRetirements);
+DEFINE_STAT(STAT_DarkHours_NumRewinds);
+
+DEFINE_STAT(STAT_DarkHours_PooledActors);
+DEFINE_STAT(STAT_DarkHours_Interactables);
+DEFINE_STAT(STAT_DarkHours_FrozenPickups);
+DEFINE_STAT(STAT_DarkHours_Rounds);
+DEFINE_STAT(STAT_DarkHours_ImpactComponents);
+DEFINE_STAT(STAT_DarkHours_Bots);
+DEFINE_STAT(STAT_DarkHours_StreamedLevelsVisible);
+DEFINE_STAT(STAT_DarkHours_StreamedLevelsPending);
+DEFINE_STAT(STAT_DarkHours_DestructibleChunks);
+DEFINE_STAT(STAT_DarkHours_Ragdolls);
+
+CSV_DEFINE_CATEGORY(DarkHours, true);
+
+// Perf counters - a fixed table, so worker threads never see it move
+static const int32 MaxPerfCounters = 64;
+
+static FString GPerfCounterNames[MaxPerfCounters];
+
+static volatile int64 GPerfCounterCycles[MaxPerfCounters];
+
+static int32 GNumPerfCounters = 0;
+
+static FCriticalSection GPerfCounterLock;
+
+bool FSPerfCounters::bCapturing = false;
+
+int32 FSPerfCounters::Register(const TCHAR* Name)
+{
+	FScopeLock Lock(&GPerfCounterLock);
+
+	for (int32 Index = 0; Index < GNumPerfCounters; Index++) {
+		if (GPerfCounterNames[Index] == Name) {
+			return Index;
+		}
+	}
+
+	if (GNumPerfCounters >= MaxPerfCounters) {
+		return INDEX_NONE;
+	}
+
+	GPerfCounterNames[GNumPerfCounters] = Name;
+	GPerfCounterCycles[GNumPerfCounters] = 0;
+
+	return GNumPerfCounters++;
+
+}
+
+void FSPerfCounters::Add(int32 Index, uint32 Cycles)
+{
+	if (Index >= 0 && Index < MaxPerfCounters) {
+		FPlatformAtomics::InterlockedAdd(&GPerfCounterCycles[Index], (int64)Cycles);
+	}
+
+}
+
+void FSPerfCounters::SetCapturing(bool bInCapturing)
+{
+	bCapturing = bInCapturing;
+
+}
+
+void FSPerfCounters::Reset()
+{
+	for (int32 Index = 0; Index < MaxPerfCounters; Index++) {
+		FPlatformAtomics::InterlockedExchange(&GPerfCounterCycles[Index], 0);
+	}
+
+}
+
+void FSPerfCounters::GetSeconds(TArray<TPair<FString, double>>& OutSeconds)
+{
+	FScopeLock Lock(&GPerfCounterLock);
+
+	OutSeconds.Reset(GNumPerfCounters);
+
+	for (int32 Index = 0; Index < GNumPerfCounters; Index++) {
+		OutSeconds.Emplace(GPerfCounterNames[Index], FPlatformTime::ToSeconds64(FPlatformAtomics::AtomicRead(&GPerfCounterCycles[Index])));
+	}
+
+}
+
+#if DARKHOURS_DEBUG_DRAW
+static TAutoConsoleVariable<int32> CVarDarkHoursDebug(
+	TEXT("DarkHours.Debug"),
+	0,
+	TEXT("1: show gameplay debug messages and debug drawing. Compiled out of test and shipping builds."),
+	ECVF_Cheat);
+
+bool IsDarkHoursDebugEnabled()
+{
+	return CVarDarkHoursDebug.GetValueOnGameThread() != 0;
+
+}
+#endif
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+DECLARE_LLM_MEMORY_STAT(TEXT("DarkHours Characters"), STAT_DarkHoursCharactersLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("DarkHours Weapons"), STAT_DarkHoursWeaponsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("DarkHours Pickups"), STAT_DarkHoursPickupsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("DarkHours Animation"), STAT_DarkHoursAnimationLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("DarkHours Physics Bodies"), STAT_DarkHoursPhysicsBodiesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("DarkHours"), STAT_DarkHoursSummaryLLM, STATGROUP_LLM);
+
+void RegisterDarkHoursLLMTags()
+{
+	FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+
+	Tracker.RegisterProjectTag((int32)ESLLMTag::Characters, TEXT("DarkHours_Characters"), GET_STATFNAME(STAT_DarkHoursCharactersLLM), GET_STATFNAME(STAT_DarkHoursSummaryLLM));
+	Tracker.RegisterProjectTag((int32)ESLLMTag::Weapons, TEXT("DarkHours_Weapons"), GET_STATFNAME(STAT_DarkHoursWeaponsLLM), GET_STATFNAME(STAT_DarkHoursSummaryLLM));
+	Tracker.RegisterProjectTag((int32)ESLLMTag::Pickups, TEXT("DarkHours_Pickups"), GET_STATFNAME(STAT_DarkHoursPickupsLLM), GET_STATFNAME(STAT_DarkHoursSummaryLLM));
+	Tracker.RegisterProjectTag((int32)ESLLMTag::Animation, TEXT("DarkHours_Animation"), GET_STATFNAME(STAT_DarkHoursAnimationLLM), GET_STATFNAME(STAT_DarkHoursSummaryLLM));
+	Tracker.RegisterProjectTag((int32)ESLLMTag::PhysicsBodies, TEXT("DarkHours_PhysicsBodies"), GET_STATFNAME(STAT_DarkHoursPhysicsBodiesLLM), GET_STATFNAME(STAT_DarkHoursSummaryLLM));
+
+}
+#endif
+
+// Game module - registers the memory tracker tags before any gameplay object exists
+class FDarkHoursModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		RegisterDarkHoursLLMTags();
+#endif
+	}
+
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FDarkHoursModule, DarkHours, "DarkHours" );
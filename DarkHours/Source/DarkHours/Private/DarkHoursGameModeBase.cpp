@@ -1,4 +1,38 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "DarkHoursGameModeBase.h"
+#include "DarkHours.h"
+#include "SBotManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+void ADarkHoursGameModeBase::StartPlay()
+{
+	Super::StartPlay();
+
+	int32 NumBots = 0;
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("Bots="), NumBots) && NumBots > 0) {
+		ASBotManager* BotManager = ASBotManager::Get(this);
+
+		if (BotManager != NULL) {
+			APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+			AActor* PlayerStart = PlayerPawn == NULL ? FindPlayerStart(NULL) : NULL;
+
+			const FVector Origin = PlayerPawn != NULL ? PlayerPawn->GetActorLocation() : (PlayerStart != NULL ? PlayerStart->GetActorLocation() : FVector(0.f, 0.f, 200.f));
+
+			BotManager->SpawnBots(NumBots, ASBotManager::ResolveCharacterClass(GetWorld(), FString()), Origin);
+		}
+	}
+
+}
+
+APawn* ADarkHoursGameModeBase::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	DARKHOURS_LLM_SCOPE(Characters);
+
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+
+}
 
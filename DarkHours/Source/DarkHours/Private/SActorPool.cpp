@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SActorPool.h"
+#include "DarkHours.h"
+#include "SPooledActor.h"
+#include "SWeapon.h"
+#include "SWeaponPickup.h"
+#include "SWorldManager.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+
+static TAutoConsoleVariable<int32> CVarPoolEnable(
+	TEXT("DarkHours.Pool.Enable"),
+	1,
+	TEXT("1: reuse weapon and pickup actors through the actor pool. 0: spawn and destroy them."),
+	ECVF_Default);
+
+// Sets default values
+ASActorPool::ASActorPool()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = false;
+
+	// Variables
+	LevelPrewarmCount = 4;
+	MaxFreeActorsPerClass = 64;
+
+}
+
+ASActorPool* ASActorPool::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASActorPool>(WorldContextObject);
+
+}
+
+// Called when the game starts or when spawned
+void ASActorPool::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Wait for the level to finish begin play before spawning into it
+	GetWorldTimerManager().SetTimerForNextTick(this, &ASActorPool::PrewarmLevel);
+
+}
+
+AActor* ASActorPool::AcquireActor(const UObject* WorldContextObject, TSubclassOf<AActor> ActorClass, const FTransform& Transform)
+{
+	if (ActorClass == NULL) {
+		return NULL;
+	}
+
+	ASActorPool* ActorPool = Get(WorldContextObject);
+
+	if (ActorPool == NULL) {
+		return NULL;
+	}
+
+	FSActorPoolList* Pool = CVarPoolEnable.GetValueOnGameThread() != 0 ? ActorPool->Pools.Find(ActorClass) : NULL;
+
+	while (Pool != NULL && Pool->FreeActors.Num() > 0) {
+		AActor* Actor = Pool->FreeActors.Pop(false);
+
+		DEC_DWORD_STAT(STAT_DarkHours_PooledActors);
+
+		if (Actor == NULL || Actor->IsPendingKill()) {
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_DarkHours_NumPoolReuses);
+
+		// Reactivate the actor where it is needed
+		const AActor* DefaultActor = ActorClass->GetDefaultObject<AActor>();
+
+		Actor->SetActorTransform(Transform, false, NULL, ETeleportType::TeleportPhysics);
+		Actor->SetActorHiddenInGame(DefaultActor->bHidden);
+		Actor->SetActorEnableCollision(DefaultActor->GetActorEnableCollision());
+		Actor->SetActorTickEnabled(DefaultActor->PrimaryActorTick.bStartWithTickEnabled);
+
+		ISPooledActor* PooledActor = Cast<ISPooledActor>(Actor);
+
+		if (PooledActor != NULL) {
+			PooledActor->OnAcquiredFromPool();
+		}
+
+		return Actor;
+	}
+
+	return ActorPool->SpawnPooledActor(ActorClass, Transform);
+
+}
+
+void ASActorPool::ReleaseActor(AActor* Actor)
+{
+	if (Actor == NULL || Actor->IsPendingKill()) {
+		return;
+	}
+
+	ASActorPool* ActorPool = CVarPoolEnable.GetValueOnGameThread() != 0 ? Get(Actor) : NULL;
+	FSActorPoolList* Pool = ActorPool != NULL ? &ActorPool->Pools.FindOrAdd(Actor->GetClass()) : NULL;
+
+	// No room in the pool, or placed in a streamed sublevel which would take it along when unloaded - destroy as usual
+	if (Pool == NULL || Pool->FreeActors.Num() >= ActorPool->MaxFreeActorsPerClass || Actor->GetLevel() != Actor->GetWorld()->PersistentLevel) {
+		DARKHOURS_SCOPED_STAT(STAT_DarkHours_Destroy, Destroy);
+		INC_DWORD_STAT(STAT_DarkHours_NumDestroys);
+
+		Actor->Destroy();
+		return;
+	}
+
+	ISPooledActor* PooledActor = Cast<ISPooledActor>(Actor);
+
+	if (PooledActor != NULL) {
+		PooledActor->OnReleasedToPool();
+	}
+
+	// Deactivate the actor until it is acquired again - pooled classes that tick stop in OnReleasedToPool
+	Actor->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+
+	Pool->FreeActors.Add(Actor);
+
+	INC_DWORD_STAT(STAT_DarkHours_PooledActors);
+
+}
+
+void ASActorPool::Prewarm(TSubclassOf<AActor> ActorClass, int32 Count)
+{
+	if (ActorClass == NULL || CVarPoolEnable.GetValueOnGameThread() == 0) {
+		return;
+	}
+
+	Count = FMath::Min(Count, MaxFreeActorsPerClass);
+
+	while (GetNumFree(ActorClass) < Count) {
+		AActor* Actor = SpawnPooledActor(ActorClass, GetActorTransform());
+
+		if (Actor == NULL) {
+			break;
+		}
+
+		ReleaseActor(Actor);
+	}
+
+}
+
+int32 ASActorPool::GetNumFree(TSubclassOf<AActor> ActorClass) const
+{
+	const FSActorPoolList* Pool = Pools.Find(ActorClass);
+
+	return Pool != NULL ? Pool->FreeActors.Num() : 0;
+
+}
+
+void ASActorPool::PrewarmLevel()
+{
+	for (const FSActorPoolPrewarm& PrewarmClass : PrewarmClasses) {
+		Prewarm(PrewarmClass.Class.TryLoadClass<AActor>(), PrewarmClass.Count);
+	}
+
+	// Placed pickups, plus their weapons and dropped pickups when those are already loaded.
+	// Weapon classes are streamed on demand, pre-warming must not force them in.
+	TSet<UClass*> LevelClasses;
+
+	for (TActorIterator<ASWeaponPickup> It(GetWorld()); It; ++It) {
+		LevelClasses.Add(It->GetClass());
+
+		UClass* WeaponClass = It->GetLoadedWeaponClass();
+
+		if (WeaponClass != NULL && !LevelClasses.Contains(WeaponClass)) {
+			LevelClasses.Add(WeaponClass);
+
+			UClass* DropPickupClass = WeaponClass->GetDefaultObject<ASWeapon>()->PickupClass.Get();
+
+			if (DropPickupClass != NULL) {
+				LevelClasses.Add(DropPickupClass);
+			}
+		}
+	}
+
+	for (UClass* LevelClass : LevelClasses) {
+		Prewarm(LevelClass, LevelPrewarmCount);
+	}
+
+	UE_LOG(LogDarkHours, Log, TEXT("ActorPool: pre-warmed %d configured and %d level classes"), PrewarmClasses.Num(), LevelClasses.Num());
+
+}
+
+AActor* ASActorPool::SpawnPooledActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform)
+{
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_Spawn, Spawn);
+	INC_DWORD_STAT(STAT_DarkHours_NumSpawns);
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	// Spawned memory goes to the pooled class - pooled actors are only weapons and pickups
+	const ESLLMTag LLMTag = ActorClass->IsChildOf(ASWeaponPickup::StaticClass()) ? ESLLMTag::Pickups : ESLLMTag::Weapons;
+
+	LLM_SCOPE((ELLMTag)LLMTag);
+#endif
+
+	FActorSpawnParameters SpawnInfos;
+	SpawnInfos.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn; // Always spawn, but ignore collision
+
+	return GetWorld()->SpawnActor<AActor>(ActorClass, Transform, SpawnInfos);
+
+}
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SAnimBenchmark.h"
+#include "DarkHours.h"
+#include "SAnimInstance.h"
+#include "SCharacter.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static void StartAnimBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	ASAnimBenchmark* Benchmark = Cast<ASAnimBenchmark>(ASBenchmark::Start(World, ASAnimBenchmark::StaticClass()));
+
+	if (Benchmark != NULL) {
+		if (Args.Num() > 0) {
+			Benchmark->NumCharacters = FMath::Max(FCString::Atoi(*Args[0]), 1);
+		}
+
+		if (Args.Num() > 1) {
+			Benchmark->SampleFrames = FMath::Max(FCString::Atoi(*Args[1]), 1);
+		}
+
+		Benchmark->CharacterClass = ASBenchmark::ResolveCharacterClass(Args.Num() > 2 ? Args[2] : FString());
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs AnimBenchmarkCommand(
+	TEXT("DarkHours.Bench.AnimUpdate"),
+	TEXT("Compares game thread animation update time with and without the anim instance proxy. Args: [NumCharacters] [SampleFrames] [CharacterClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartAnimBenchmark));
+
+// Sets default values
+ASAnimBenchmark::ASAnimBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("AnimUpdate");
+	NumPasses = 2;
+	NumCharacters = 100;
+
+	FrameSeconds = 0.0;
+	InputTime = 0.f;
+	bWasProxyUpdateEnabled = true;
+
+}
+
+void ASAnimBenchmark::BeginPass(int32 PassIndex)
+{
+	if (PassIndex == 0) {
+		bWasProxyUpdateEnabled = USAnimInstance::IsProxyUpdateEnabled();
+
+		if (CharacterClass == NULL) {
+			CharacterClass = ResolveCharacterClass(FString());
+		}
+
+		for (int32 Index = 0; Index < NumCharacters; Index++) {
+			SpawnCharacter(CharacterClass, Index);
+		}
+	}
+
+	// Pass 0 measures the game thread path, pass 1 the proxy path
+	SetProxyUpdate(PassIndex > 0);
+
+	USAnimInstance::ResetGameThreadUpdateSeconds();
+
+	FrameSeconds = 0.0;
+
+}
+
+void ASAnimBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	if (FrameSeconds == 0.0) { // Drop anything accumulated during warmup
+		USAnimInstance::ResetGameThreadUpdateSeconds();
+	}
+
+	FrameSeconds += DeltaTime;
+	InputTime += DeltaTime;
+
+	// Feed changing input so the characters keep blending through locomotion
+	for (int32 Index = 0; Index < SpawnedCharacters.Num(); Index++) {
+		ASCharacter* Character = SpawnedCharacters[Index];
+
+		if (Character != NULL) {
+			Character->InputX = FMath::Sin(InputTime + Index);
+			Character->InputY = FMath::Cos(InputTime * 0.5f + Index);
+			Character->bIsSprinting = (Index % 2) == 0;
+		}
+	}
+
+}
+
+void ASAnimBenchmark::EndPass(int32 PassIndex)
+{
+	const FString PassName = PassIndex == 0 ? TEXT("GameThread") : TEXT("Proxy");
+
+	const double UpdateMs = USAnimInstance::GetGameThreadUpdateSeconds() * 1000.0;
+
+	AddResult(PassName + TEXT(".Characters"), SpawnedCharacters.Num());
+	AddResult(PassName + TEXT(".AnimUpdateMsPerFrame"), UpdateMs / SampleFrames);
+	AddResult(PassName + TEXT(".AnimUpdateUsPerCharacter"), UpdateMs * 1000.0 / (SampleFrames * FMath::Max(SpawnedCharacters.Num(), 1)));
+	AddResult(PassName + TEXT(".FrameMs"), FrameSeconds * 1000.0 / SampleFrames);
+
+	if (PassIndex == NumPasses - 1) {
+		SetProxyUpdate(bWasProxyUpdateEnabled);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASAnimBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetProxyUpdate(bWasProxyUpdateEnabled);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASAnimBenchmark::SetProxyUpdate(bool bEnabled)
+{
+	IConsoleVariable* ProxyUpdateVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Anim.ProxyUpdate"));
+
+	if (ProxyUpdateVar != NULL) {
+		ProxyUpdateVar->Set(bEnabled ? 1 : 0, ECVF_SetByCode);
+	}
+
+}
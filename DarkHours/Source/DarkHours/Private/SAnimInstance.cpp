@@ -1,75 +1,376 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "SAnimInstance.h"
+#include "DarkHours.h"
 #include "SCharacter.h"
 #include "TimerManager.h"
 #include "Engine/GameEngine.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Pawn.h"
 #include "GameFramework/PawnMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetSystemLibrary.h"
 
-void USAnimInstance::UpdateAnimationProperties(float DeltaTime)
+static TAutoConsoleVariable<int32> CVarAnimProxyUpdate(
+	TEXT("DarkHours.Anim.ProxyUpdate"),
+	1,
+	TEXT("1: update character animation properties on anim worker threads through the anim instance proxy.\n")
+	TEXT("0: update them on the game thread from the Blueprint event graph."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAnimNativeNodes(
+	TEXT("DarkHours.Anim.NativeNodes"),
+	1,
+	TEXT("1: latch the start direction natively, into MovementDirection for Proto_AnimBP and StartDirection for the native start direction node.\n")
+	TEXT("0: receive it through the SetDirectionAndReceiveInitialDirection Blueprint event."),
+	ECVF_Default);
+
+// Game thread time spent on animation property updates, only touched from the game thread
+static double GGameThreadAnimUpdateSeconds = 0.0;
+
+// Anim graph update cycles, added to from every anim worker thread
+static volatile int64 GAnimGraphUpdateCycles = 0;
+
+FSAnimCharacterSnapshot::FSAnimCharacterSnapshot()
+	: Velocity(FVector::ZeroVector)
+	, RightVector(FVector::RightVector)
+	, MaxWalkSpeed(0.f)
+	, InputX(0.f)
+	, InputY(0.f)
+	, TurnX(0.f)
+	, MovementDirection(0.f)
+	, bIsFalling(false)
+	, bIsCrouching(false)
+	, bIsSprinting(false)
+	, bIsAiming(false)
+	, bHasCharacter(false)
+	, bInterpolateInputs(false)
+	, bNativeStartDirection(false)
+	, bProceduralLeaning(true)
 {
-	// Get owner pawn
-	APawn* OwnerPawn = TryGetPawnOwner();
+}
 
-	if (OwnerPawn != NULL) {
+void FSAnimCharacterSnapshot::Gather(const APawn* OwnerPawn, const ASCharacter* OwnerCharacter)
+{
+	bHasCharacter = false;
+	bNativeStartDirection = USAnimInstance::IsNativeNodesEnabled();
+	bProceduralLeaning = DARKHOURS_WITH_COSMETICS && (OwnerPawn == NULL || !OwnerPawn->IsNetMode(NM_DedicatedServer));
+
+	if (OwnerPawn != NULL && OwnerPawn->GetMovementComponent() != NULL) {
 		// Update animation properties from owner pawn movement component
 		bIsFalling = OwnerPawn->GetMovementComponent()->IsFalling();
 		bIsCrouching = OwnerPawn->GetMovementComponent()->IsCrouching();
+	}
 
-		// Cast owner pawn to owner character
-		OwnerCharacter = Cast<ASCharacter>(OwnerPawn);
+	if (OwnerCharacter != NULL) {
+		bHasCharacter = true;
+
+		// Input of remote characters only exists in the replicated animation inputs
+		bInterpolateInputs = OwnerCharacter->Role == ROLE_SimulatedProxy;
+
+		if (bInterpolateInputs) {
+			const FSReplicatedAnimInputs& AnimInputs = OwnerCharacter->GetReplicatedAnimInputs();
 
-		if (OwnerCharacter != NULL) {
-			// Update animation properties from owner character 
+			bIsSprinting = AnimInputs.bIsSprinting;
+			bIsAiming = AnimInputs.bIsAiming;
+			InputX = AnimInputs.InputX;
+			InputY = AnimInputs.InputY;
+			TurnX = AnimInputs.TurnX;
+			MovementDirection = AnimInputs.MovementDirection;
+		}
+		else { // Update animation properties from owner character 
 			bIsSprinting = OwnerCharacter->bIsSprinting;
 			bIsAiming = OwnerCharacter->bIsAiming;
-			Anim_InputX = OwnerCharacter->InputX; // Set animation fwd / bwd
-			Anim_InputY = OwnerCharacter->InputY; // Set animation rgt / lft
-			Anim_TurnX = OwnerCharacter->TurnX; // Set animation turn lft / rgt
-
-			if (bIsSprinting) {
-				MovementSpeed = FMath::Clamp(UKismetMathLibrary::Abs(Anim_InputX) + UKismetMathLibrary::Abs(Anim_InputY), 0.f, 1.f) * 2.f; // Speed up twice
-
-				AnimPlayRate = 1.45f; // Animation speed plays faster in sprinting state
-			}
-			else {
-				MovementSpeed = FMath::Clamp(UKismetMathLibrary::Abs(Anim_InputX) + UKismetMathLibrary::Abs(Anim_InputY), 0.f, 1.f); // Speed stays the same
-
-				AnimPlayRate = 1.f; // Animation speed is normal if not in sprinting state
-			}
-
-			// Debug character movement speed
-			if (GEngine != NULL) {
-				GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::Purple, FString::Printf(TEXT("Movement Speed: %f"), MovementSpeed));
-			}
-
-			if (MovementSpeed > 0.01f) { // If speed > 0.01 then set direction input to anim
-				if (bReceivedInitialDirection) {
-					if (MovementSpeed < 0.01f) { // If speed < 0.01 then reset received init direction value for next event
-						bReceivedInitialDirection = false;
-					}
-				}
-				else {
-					SetDirectionAndReceiveInitialDirection();
-				}
-			}
-			else {
-				if (MovementSpeed < 0.01f) { // If speed < 0.01 then reset received init direction value for next event
-					bReceivedInitialDirection = false;
-				}
-			}
-
-			if (!bIsFalling) {
-				// Calculate character leaning rotation to be used when character turns
-				float LeaningAxis = (UKismetMathLibrary::Dot_VectorVector(OwnerCharacter->GetActorRightVector(), OwnerCharacter->GetVelocity()) / LeaningScale) * OwnerCharacter->GetCharacterMovement()->MaxWalkSpeed;
-
-				ProcedualLeaningRotation = UKismetMathLibrary::MakeRotator(0.f, LeaningAxis, 0.f);
-			}
+			InputX = OwnerCharacter->InputX;
+			InputY = OwnerCharacter->InputY;
+			TurnX = OwnerCharacter->TurnX;
+			MovementDirection = OwnerCharacter->MovementDirection;
+		}
+
+		Velocity = OwnerCharacter->GetVelocity();
+		RightVector = OwnerCharacter->GetActorRightVector();
+		MaxWalkSpeed = OwnerCharacter->GetCharacterMovement()->MaxWalkSpeed;
+	}
+
+}
+
+FSAnimInstanceProxy::FSAnimInstanceProxy()
+	: SAnimInstance(NULL)
+	, bUpdateOnWorker(false)
+	, bRequestInitialDirection(false)
+{
+}
+
+FSAnimInstanceProxy::FSAnimInstanceProxy(UAnimInstance* Instance)
+	: FAnimInstanceProxy(Instance)
+	, SAnimInstance(NULL)
+	, bUpdateOnWorker(false)
+	, bRequestInitialDirection(false)
+{
+}
+
+void FSAnimInstanceProxy::Initialize(UAnimInstance* InAnimInstance)
+{
+	FAnimInstanceProxy::Initialize(InAnimInstance);
+
+	SAnimInstance = Cast<USAnimInstance>(InAnimInstance);
+
+}
+
+void FSAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	bUpdateOnWorker = SAnimInstance != NULL && USAnimInstance::IsProxyUpdateEnabled();
+	bRequestInitialDirection = false;
+
+	if (bUpdateOnWorker) {
+		DARKHOURS_SCOPED_STAT(STAT_DarkHours_AnimUpdateGameThread, AnimUpdateGameThread);
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		// Owner character is cached on initialization, only resolve it again if it was not available back then
+		if (SAnimInstance->OwnerCharacter == NULL) {
+			SAnimInstance->OwnerCharacter = Cast<ASCharacter>(SAnimInstance->TryGetPawnOwner());
+		}
+
+		// Falling and crouching are read from any pawn, like the Blueprint update did
+		Snapshot.Gather(SAnimInstance->TryGetPawnOwner(), SAnimInstance->OwnerCharacter);
+
+		GGameThreadAnimUpdateSeconds += FPlatformTime::Seconds() - StartTime;
+	}
+
+}
+
+void FSAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	FAnimInstanceProxy::Update(DeltaSeconds);
+
+	// The game thread leaves the anim instance properties alone between PreUpdate and PostUpdate, so they are written here directly for the anim graph
+	if (bUpdateOnWorker) {
+		DARKHOURS_SCOPED_STAT(STAT_DarkHours_AnimUpdateWorker, AnimUpdateWorker);
+		INC_DWORD_STAT(STAT_DarkHours_NumAnimUpdates);
+
+		bRequestInitialDirection = UpdateProperties(SAnimInstance, Snapshot, DeltaSeconds);
+	}
+
+}
+
+void FSAnimInstanceProxy::UpdateAnimationNode(float DeltaSeconds)
+{
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	FAnimInstanceProxy::UpdateAnimationNode(DeltaSeconds);
+
+	FPlatformAtomics::InterlockedAdd(&GAnimGraphUpdateCycles, (int64)(FPlatformTime::Cycles() - StartCycles));
+
+}
+
+void FSAnimInstanceProxy::PostUpdate(UAnimInstance* InAnimInstance) const
+{
+	FAnimInstanceProxy::PostUpdate(InAnimInstance);
+
+	if (bUpdateOnWorker) {
+		DARKHOURS_SCOPED_STAT(STAT_DarkHours_AnimUpdateGameThread, AnimUpdateGameThread);
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		CastChecked<USAnimInstance>(InAnimInstance)->OnProxyPostUpdate(bRequestInitialDirection);
+
+		GGameThreadAnimUpdateSeconds += FPlatformTime::Seconds() - StartTime;
+	}
+
+}
+
+bool FSAnimInstanceProxy::UpdateProperties(USAnimInstance* AnimInstance, const FSAnimCharacterSnapshot& Snapshot, float DeltaSeconds)
+{
+	AnimInstance->bIsFalling = Snapshot.bIsFalling;
+	AnimInstance->bIsCrouching = Snapshot.bIsCrouching;
+
+	if (!Snapshot.bHasCharacter) {
+		return false;
+	}
+
+	AnimInstance->bIsSprinting = Snapshot.bIsSprinting;
+	AnimInstance->bIsAiming = Snapshot.bIsAiming;
+
+	if (Snapshot.bInterpolateInputs) {
+		// Replicated inputs come in steps at the net update rate - smooth them out
+		const float InterpSpeed = AnimInstance->ReplicatedInputInterpSpeed;
+		const float DirectionDelta = FRotator::NormalizeAxis(Snapshot.MovementDirection - AnimInstance->LiveMovementDirection);
+
+		AnimInstance->Anim_InputX = FMath::FInterpTo(AnimInstance->Anim_InputX, Snapshot.InputX, DeltaSeconds, InterpSpeed);
+		AnimInstance->Anim_InputY = FMath::FInterpTo(AnimInstance->Anim_InputY, Snapshot.InputY, DeltaSeconds, InterpSpeed);
+		AnimInstance->Anim_TurnX = FMath::FInterpTo(AnimInstance->Anim_TurnX, Snapshot.TurnX, DeltaSeconds, InterpSpeed);
+		AnimInstance->LiveMovementDirection = FRotator::NormalizeAxis(AnimInstance->LiveMovementDirection + FMath::FInterpTo(0.f, DirectionDelta, DeltaSeconds, InterpSpeed));
+	}
+	else {
+		AnimInstance->Anim_InputX = Snapshot.InputX; // Set animation fwd / bwd
+		AnimInstance->Anim_InputY = Snapshot.InputY; // Set animation rgt / lft
+		AnimInstance->Anim_TurnX = Snapshot.TurnX; // Set animation turn lft / rgt
+		AnimInstance->LiveMovementDirection = Snapshot.MovementDirection;
+	}
+
+	const float InputSpeed = FMath::Clamp(FMath::Abs(AnimInstance->Anim_InputX) + FMath::Abs(AnimInstance->Anim_InputY), 0.f, 1.f);
+
+	if (Snapshot.bIsSprinting) {
+		AnimInstance->MovementSpeed = InputSpeed * 2.f; // Speed up twice
+
+		AnimInstance->AnimPlayRate = 1.45f; // Animation speed plays faster in sprinting state
+	}
+	else {
+		AnimInstance->MovementSpeed = InputSpeed; // Speed stays the same
+
+		AnimInstance->AnimPlayRate = 1.f; // Animation speed is normal if not in sprinting state
+	}
+
+	bool bRequestInitialDirection = false;
+
+	if (AnimInstance->MovementSpeed > 0.01f) { // If speed > 0.01 then set direction input to anim
+		if (!AnimInstance->bReceivedInitialDirection && Snapshot.bNativeStartDirection) {
+			// Latched here as the Blueprint event does, for anim blueprints reading MovementDirection and for the start direction node
+			AnimInstance->MovementDirection = AnimInstance->LiveMovementDirection;
+			AnimInstance->StartDirection = AnimInstance->LiveMovementDirection;
+			AnimInstance->bReceivedInitialDirection = true;
+		}
+
+		bRequestInitialDirection = !AnimInstance->bReceivedInitialDirection;
+	}
+	else { // Reset received init direction value for next event
+		AnimInstance->bReceivedInitialDirection = false;
+	}
+
+	if (!Snapshot.bIsFalling && Snapshot.bProceduralLeaning) {
+		// Calculate character leaning rotation to be used when character turns
+		float LeaningAxis = (FVector::DotProduct(Snapshot.RightVector, Snapshot.Velocity) / AnimInstance->LeaningScale) * Snapshot.MaxWalkSpeed;
+
+		AnimInstance->ProcedualLeaningRotation = FRotator(0.f, LeaningAxis, 0.f);
+	}
+
+	return bRequestInitialDirection;
+
+}
+
+// Sets default values
+USAnimInstance::USAnimInstance()
+{
+	// Variables
+	ReplicatedInputInterpSpeed = 10.f;
+	LiveMovementDirection = 0.f;
+	StartDirection = 0.f;
+
+}
+
+void USAnimInstance::NativeInitializeAnimation()
+{
+	DARKHOURS_LLM_SCOPE(Animation);
+
+	Super::NativeInitializeAnimation();
+
+	// Cache owner character once, instead of casting every frame
+	OwnerCharacter = Cast<ASCharacter>(TryGetPawnOwner());
+
+}
+
+FAnimInstanceProxy* USAnimInstance::CreateAnimInstanceProxy()
+{
+	DARKHOURS_LLM_SCOPE(Animation);
+
+	return new FSAnimInstanceProxy(this);
+
+}
+
+void USAnimInstance::OnProxyPostUpdate(bool bRequestInitialDirection)
+{
+	// Debug character movement speed
+	DARKHOURS_DEBUG_MESSAGE(FColor::Purple, TEXT("Movement Speed: %f"), MovementSpeed);
+
+	// Blueprint events have to run on the game thread
+	if (bRequestInitialDirection) {
+		SetDirectionAndReceiveInitialDirection();
+	}
+
+}
+
+void USAnimInstance::UpdateAnimationProperties(float DeltaTime)
+{
+	// Properties are filled in by the proxy, kept callable for the Blueprint event graph
+	if (IsProxyUpdateEnabled()) {
+		return;
+	}
+
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_AnimUpdateGameThread, AnimUpdateGameThread);
+	INC_DWORD_STAT(STAT_DarkHours_NumAnimUpdates);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Get owner pawn
+	APawn* OwnerPawn = TryGetPawnOwner();
+
+	if (OwnerPawn != NULL) {
+		// Cast owner pawn to owner character
+		OwnerCharacter = Cast<ASCharacter>(OwnerPawn);
+
+		FSAnimCharacterSnapshot Snapshot;
+		Snapshot.Gather(OwnerPawn, OwnerCharacter);
+
+		const bool bRequestInitialDirection = FSAnimInstanceProxy::UpdateProperties(this, Snapshot, DeltaTime);
+
+		if (Snapshot.bHasCharacter) {
+			OnProxyPostUpdate(bRequestInitialDirection);
 		}
 	}
 
+	GGameThreadAnimUpdateSeconds += FPlatformTime::Seconds() - StartTime;
+
+}
+
+float USAnimInstance::GetStartDirection() const
+{
+	return StartDirection;
+
+}
+
+FRotator USAnimInstance::GetProcedualLeaningRotation() const
+{
+	return ProcedualLeaningRotation;
+
+}
+
+bool USAnimInstance::IsProxyUpdateEnabled()
+{
+	return CVarAnimProxyUpdate.GetValueOnGameThread() != 0;
+
+}
+
+bool USAnimInstance::IsNativeNodesEnabled()
+{
+	return CVarAnimNativeNodes.GetValueOnGameThread() != 0;
+
+}
+
+double USAnimInstance::GetGameThreadUpdateSeconds()
+{
+	return GGameThreadAnimUpdateSeconds;
+
+}
+
+void USAnimInstance::ResetGameThreadUpdateSeconds()
+{
+	GGameThreadAnimUpdateSeconds = 0.0;
+
+}
+
+double USAnimInstance::GetGraphUpdateSeconds()
+{
+	return FPlatformTime::ToSeconds64(FPlatformAtomics::AtomicRead(&GAnimGraphUpdateCycles));
+
+}
+
+void USAnimInstance::ResetGraphUpdateSeconds()
+{
+	FPlatformAtomics::InterlockedExchange(&GAnimGraphUpdateCycles, 0);
+
 }
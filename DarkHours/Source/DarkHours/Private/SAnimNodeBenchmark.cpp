@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SAnimNodeBenchmark.h"
+#include "DarkHours.h"
+#include "SAnimInstance.h"
+#include "SCharacter.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static void StartAnimNodeBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	ASAnimNodeBenchmark* Benchmark = Cast<ASAnimNodeBenchmark>(ASBenchmark::Start(World, ASAnimNodeBenchmark::StaticClass()));
+
+	if (Benchmark != NULL) {
+		if (Args.Num() > 0) {
+			Benchmark->NumCharacters = FMath::Max(FCString::Atoi(*Args[0]), 1);
+		}
+
+		if (Args.Num() > 1 && !Args[1].IsEmpty()) {
+			Benchmark->NativeAnimClass = LoadClass<UAnimInstance>(NULL, *Args[1]);
+
+			if (Benchmark->NativeAnimClass == NULL) {
+				UE_LOG(LogDarkHours, Warning, TEXT("AnimNodes benchmark: could not load anim class %s, characters keep their own"), *Args[1]);
+			}
+		}
+
+		Benchmark->CharacterClass = ASBenchmark::ResolveCharacterClass(Args.Num() > 2 ? Args[2] : FString());
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs AnimNodeBenchmarkCommand(
+	TEXT("DarkHours.Bench.AnimNodes"),
+	TEXT("Compares game thread and anim graph update time of the Blueprint start direction event and the native anim nodes. Args: [NumCharacters] [NativeAnimClassPath] [CharacterClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartAnimNodeBenchmark));
+
+// Sets default values
+ASAnimNodeBenchmark::ASAnimNodeBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("AnimNodes");
+	NumPasses = 2;
+	NumCharacters = 200;
+
+	FrameSeconds = 0.0;
+	InputTime = 0.f;
+	bWasNativeNodesEnabled = true;
+
+}
+
+void ASAnimNodeBenchmark::BeginPass(int32 PassIndex)
+{
+	if (PassIndex == 0) {
+		bWasNativeNodesEnabled = USAnimInstance::IsNativeNodesEnabled();
+
+		if (CharacterClass == NULL) {
+			CharacterClass = ResolveCharacterClass(FString());
+		}
+
+		for (int32 Index = 0; Index < NumCharacters; Index++) {
+			SpawnCharacter(CharacterClass, Index);
+		}
+	}
+
+	// Pass 0 measures the Blueprint event, pass 1 the native nodes
+	SetNativeNodes(PassIndex > 0);
+
+	if (PassIndex > 0 && NativeAnimClass != NULL) {
+		for (ASCharacter* Character : SpawnedCharacters) {
+			if (Character != NULL) {
+				Character->GetMesh()->SetAnimInstanceClass(NativeAnimClass);
+			}
+		}
+	}
+
+	USAnimInstance::ResetGameThreadUpdateSeconds();
+	USAnimInstance::ResetGraphUpdateSeconds();
+
+	FrameSeconds = 0.0;
+
+}
+
+void ASAnimNodeBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	if (FrameSeconds == 0.0) { // Drop anything accumulated during warmup
+		USAnimInstance::ResetGameThreadUpdateSeconds();
+		USAnimInstance::ResetGraphUpdateSeconds();
+	}
+
+	FrameSeconds += DeltaTime;
+	InputTime += DeltaTime;
+
+	// Keep starting and stopping, so the start direction is latched over and over
+	for (int32 Index = 0; Index < SpawnedCharacters.Num(); Index++) {
+		ASCharacter* Character = SpawnedCharacters[Index];
+
+		if (Character != NULL) {
+			const bool bMoving = FMath::Sin(InputTime * 2.f + Index) > 0.f;
+
+			Character->InputX = bMoving ? FMath::Sin(InputTime + Index) : 0.f;
+			Character->InputY = bMoving ? FMath::Cos(InputTime * 0.5f + Index) : 0.f;
+			Character->bIsSprinting = (Index % 2) == 0;
+		}
+	}
+
+}
+
+void ASAnimNodeBenchmark::EndPass(int32 PassIndex)
+{
+	const FString PassName = PassIndex == 0 ? TEXT("Blueprint") : TEXT("Native");
+
+	const double GameThreadMs = USAnimInstance::GetGameThreadUpdateSeconds() * 1000.0;
+	const double GraphUpdateMs = USAnimInstance::GetGraphUpdateSeconds() * 1000.0;
+
+	AddResult(PassName + TEXT(".Characters"), SpawnedCharacters.Num());
+	AddResult(PassName + TEXT(".GameThreadMsPerFrame"), GameThreadMs / SampleFrames);
+	AddResult(PassName + TEXT(".GraphUpdateMsPerFrame"), GraphUpdateMs / SampleFrames);
+	AddResult(PassName + TEXT(".GraphUpdateUsPerCharacter"), GraphUpdateMs * 1000.0 / (SampleFrames * FMath::Max(SpawnedCharacters.Num(), 1)));
+	AddResult(PassName + TEXT(".FrameMs"), FrameSeconds * 1000.0 / SampleFrames);
+
+	if (PassIndex == NumPasses - 1) {
+		SetNativeNodes(bWasNativeNodesEnabled);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASAnimNodeBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetNativeNodes(bWasNativeNodesEnabled);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASAnimNodeBenchmark::SetNativeNodes(bool bEnabled)
+{
+	IConsoleVariable* NativeNodesVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Anim.NativeNodes"));
+
+	if (NativeNodesVar != NULL) {
+		NativeNodesVar->Set(bEnabled ? 1 : 0, ECVF_SetByCode);
+	}
+
+}
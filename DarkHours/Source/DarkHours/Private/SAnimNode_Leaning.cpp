@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SAnimNode_Leaning.h"
+#include "SAnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "AnimationRuntime.h"
+
+FSAnimNode_Leaning::FSAnimNode_Leaning()
+	: LeanSpace(BCS_BoneSpace)
+	, LeanScale(1.f)
+	, LeanRotation(ForceInitToZero)
+{
+}
+
+void FSAnimNode_Leaning::GatherDebugData(FNodeDebugData& DebugData)
+{
+	DebugData.AddDebugItem(FString::Printf(TEXT("%s(Bone: %s, Lean: %s)"), *DebugData.GetNodeName(this), *LeanBone.BoneName.ToString(), *LeanRotation.ToString()));
+
+	ComponentPose.GatherDebugData(DebugData);
+
+}
+
+void FSAnimNode_Leaning::UpdateInternal(const FAnimationUpdateContext& Context)
+{
+	FAnimNode_SkeletalControlBase::UpdateInternal(Context);
+
+	const USAnimInstance* AnimInstance = Cast<USAnimInstance>(Context.AnimInstanceProxy->GetAnimInstanceObject());
+
+	LeanRotation = AnimInstance != NULL ? AnimInstance->GetProcedualLeaningRotation() * LeanScale : FRotator::ZeroRotator;
+
+}
+
+void FSAnimNode_Leaning::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+	const FCompactPoseBoneIndex BoneIndex = LeanBone.GetCompactPoseIndex(BoneContainer);
+	const FTransform& ComponentTransform = Output.AnimInstanceProxy->GetComponentTransform();
+
+	// Add the leaning rotation in lean space
+	FTransform BoneTransform = Output.Pose.GetComponentSpaceTransform(BoneIndex);
+
+	FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, Output.Pose, BoneTransform, BoneIndex, LeanSpace);
+
+	BoneTransform.SetRotation(LeanRotation.Quaternion() * BoneTransform.GetRotation());
+
+	FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, Output.Pose, BoneTransform, BoneIndex, LeanSpace);
+
+	OutBoneTransforms.Add(FBoneTransform(BoneIndex, BoneTransform));
+
+}
+
+bool FSAnimNode_Leaning::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	return LeanBone.IsValidToEvaluate(RequiredBones) && !LeanRotation.IsNearlyZero();
+
+}
+
+void FSAnimNode_Leaning::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	LeanBone.Initialize(RequiredBones);
+
+}
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SAnimNode_StartDirection.h"
+#include "SAnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "AnimationRuntime.h"
+
+FSAnimNode_StartDirection::FSAnimNode_StartDirection()
+	: BlendTime(0.2f)
+	, ActiveIndex(0)
+{
+	BlendWeights[0] = 1.f;
+	BlendWeights[1] = 0.f;
+	BlendWeights[2] = 0.f;
+	BlendWeights[3] = 0.f;
+}
+
+void FSAnimNode_StartDirection::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	FAnimNode_Base::Initialize_AnyThread(Context);
+
+	for (int32 Index = 0; Index < 4; Index++) {
+		GetPose(Index).Initialize(Context);
+		BlendWeights[Index] = Index == 0 ? 1.f : 0.f;
+	}
+
+	ActiveIndex = 0;
+
+}
+
+void FSAnimNode_StartDirection::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	for (int32 Index = 0; Index < 4; Index++) {
+		GetPose(Index).CacheBones(Context);
+	}
+
+}
+
+void FSAnimNode_StartDirection::Update_AnyThread(const FAnimationUpdateContext& Context)
+{
+	EvaluateGraphExposedInputs.Execute(Context);
+
+	// Start direction is latched by the anim instance when the character starts moving
+	const USAnimInstance* AnimInstance = Cast<USAnimInstance>(Context.AnimInstanceProxy->GetAnimInstanceObject());
+
+	if (AnimInstance != NULL) {
+		ActiveIndex = GetDirectionIndex(AnimInstance->GetStartDirection());
+	}
+
+	// Move the weights toward the active pose
+	const float BlendStep = BlendTime > 0.f ? Context.GetDeltaTime() / BlendTime : 1.f;
+
+	for (int32 Index = 0; Index < 4; Index++) {
+		const float TargetWeight = Index == ActiveIndex ? 1.f : 0.f;
+
+		BlendWeights[Index] = BlendWeights[Index] < TargetWeight ? FMath::Min(BlendWeights[Index] + BlendStep, TargetWeight) : FMath::Max(BlendWeights[Index] - BlendStep, TargetWeight);
+	}
+
+	// Keep the weights normalized while cross fading
+	float TotalWeight = 0.f;
+
+	for (int32 Index = 0; Index < 4; Index++) {
+		TotalWeight += BlendWeights[Index];
+	}
+
+	for (int32 Index = 0; Index < 4; Index++) {
+		BlendWeights[Index] = TotalWeight > ZERO_ANIMWEIGHT_THRESH ? BlendWeights[Index] / TotalWeight : (Index == ActiveIndex ? 1.f : 0.f);
+
+		if (BlendWeights[Index] > ZERO_ANIMWEIGHT_THRESH) {
+			GetPose(Index).Update(Context.FractionalWeight(BlendWeights[Index]));
+		}
+	}
+
+}
+
+void FSAnimNode_StartDirection::Evaluate_AnyThread(FPoseContext& Output)
+{
+	TArray<int32, TInlineAllocator<4>> ActivePoses;
+
+	for (int32 Index = 0; Index < 4; Index++) {
+		if (BlendWeights[Index] > ZERO_ANIMWEIGHT_THRESH) {
+			ActivePoses.Add(Index);
+		}
+	}
+
+	if (ActivePoses.Num() == 0) {
+		Output.ResetToRefPose();
+		return;
+	}
+
+	// No cross fade - no blend
+	if (ActivePoses.Num() == 1) {
+		GetPose(ActivePoses[0]).Evaluate(Output);
+		return;
+	}
+
+	TArray<FCompactPose, TInlineAllocator<4>> Poses;
+	TArray<FBlendedCurve, TInlineAllocator<4>> Curves;
+	TArray<float, TInlineAllocator<4>> Weights;
+
+	Poses.SetNum(ActivePoses.Num());
+	Curves.SetNum(ActivePoses.Num());
+
+	for (int32 ActiveIndexInList = 0; ActiveIndexInList < ActivePoses.Num(); ActiveIndexInList++) {
+		FPoseContext PoseContext(Output);
+
+		GetPose(ActivePoses[ActiveIndexInList]).Evaluate(PoseContext);
+
+		Poses[ActiveIndexInList].MoveBonesFrom(PoseContext.Pose);
+		Curves[ActiveIndexInList].MoveFrom(PoseContext.Curve);
+		Weights.Add(BlendWeights[ActivePoses[ActiveIndexInList]]);
+	}
+
+	FAnimationRuntime::BlendPosesTogether(Poses, Curves, Weights, Output.Pose, Output.Curve);
+
+}
+
+void FSAnimNode_StartDirection::GatherDebugData(FNodeDebugData& DebugData)
+{
+	DebugData.AddDebugItem(FString::Printf(TEXT("%s(Active: %d)"), *DebugData.GetNodeName(this), ActiveIndex));
+
+	for (int32 Index = 0; Index < 4; Index++) {
+		GetPose(Index).GatherDebugData(DebugData.BranchFlow(BlendWeights[Index]));
+	}
+
+}
+
+int32 FSAnimNode_StartDirection::GetDirectionIndex(float StartDirection)
+{
+	const float Direction = FRotator::NormalizeAxis(StartDirection);
+
+	if (FMath::Abs(Direction) <= 45.f) {
+		return 0;
+	}
+
+	if (FMath::Abs(Direction) >= 135.f) {
+		return 2;
+	}
+
+	return Direction > 0.f ? 1 : 3;
+
+}
+
+FPoseLink& FSAnimNode_StartDirection::GetPose(int32 Index)
+{
+	switch (Index) {
+		case 1:
+			return Right;
+
+		case 2:
+			return Backward;
+
+		case 3:
+			return Left;
+
+		default:
+			return Forward;
+	}
+
+}
@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SBenchmark.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/PlatformMisc.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+// Sets default values
+ASBenchmark::ASBenchmark()
+{
+	// Benchmarks drive themselves from tick
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	// Variables
+	WarmupFrames = 60;
+	SampleFrames = 300;
+	NumPasses = 1;
+
+	BenchmarkName = TEXT("Benchmark");
+
+	CurrentPass = -1;
+	CurrentFrame = 0;
+	bFinished = false;
+	bFailed = false;
+
+}
+
+ASBenchmark* ASBenchmark::Start(UWorld* World, TSubclassOf<ASBenchmark> BenchmarkClass)
+{
+	if (World == NULL || BenchmarkClass == NULL) {
+		return NULL;
+	}
+
+	// Place the benchmark at the local player if there is one, scenes are built around it
+	FVector Origin = FVector(0.f, 0.f, 200.f);
+
+	APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(World, 0);
+
+	if (PlayerPawn != NULL) {
+		Origin = PlayerPawn->GetActorLocation();
+	}
+
+	FActorSpawnParameters SpawnInfos;
+	SpawnInfos.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	return World->SpawnActor<ASBenchmark>(BenchmarkClass, Origin, FRotator::ZeroRotator, SpawnInfos);
+
+}
+
+// Called every frame
+void ASBenchmark::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bFinished) {
+		return;
+	}
+
+	if (CurrentPass < 0) { // First frame - start the first pass
+		CurrentPass = 0;
+		CurrentFrame = 0;
+
+		UE_LOG(LogDarkHours, Log, TEXT("%s: starting %d pass(es)"), *BenchmarkName, NumPasses);
+
+		BeginPass(CurrentPass);
+		return;
+	}
+
+	// Skip the warmup frames, then sample
+	if (CurrentFrame >= WarmupFrames) {
+		SampleFrame(CurrentPass, DeltaTime);
+	}
+
+	CurrentFrame++;
+
+	if (CurrentFrame >= WarmupFrames + SampleFrames) {
+		EndPass(CurrentPass);
+
+		CurrentPass++;
+		CurrentFrame = 0;
+
+		if (CurrentPass < NumPasses) {
+			BeginPass(CurrentPass);
+		}
+		else {
+			FinishBenchmark();
+		}
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DestroyCharacters();
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASBenchmark::BeginPass(int32 PassIndex)
+{
+}
+
+void ASBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+}
+
+void ASBenchmark::EndPass(int32 PassIndex)
+{
+}
+
+void ASBenchmark::AddResult(const FString& Name, double Value)
+{
+	UE_LOG(LogDarkHours, Log, TEXT("%s: %s = %.4f"), *BenchmarkName, *Name, Value);
+
+	ResultLines.Add(FString::Printf(TEXT("%s,%.6f"), *Name, Value));
+
+}
+
+void ASBenchmark::MarkFailed(const FString& Reason)
+{
+	UE_LOG(LogDarkHours, Error, TEXT("%s: FAILED - %s"), *BenchmarkName, *Reason);
+
+	bFailed = true;
+	Failures.Add(Reason);
+
+}
+
+bool ASBenchmark::HasFailed() const
+{
+	return bFailed;
+
+}
+
+const TArray<FString>& ASBenchmark::GetFailures() const
+{
+	return Failures;
+
+}
+
+ASCharacter* ASBenchmark::SpawnCharacter(TSubclassOf<ASCharacter> CharacterClass, int32 Index, float Spacing)
+{
+	if (CharacterClass == NULL) {
+		return NULL;
+	}
+
+	DARKHOURS_LLM_SCOPE(Characters);
+
+	const int32 NumColumns = 16;
+
+	FTransform SpawnTransform(FRotator::ZeroRotator, GetGridLocation(Index, NumColumns, Spacing));
+
+	// Defer construction, so the benchmark characters do not auto possess the local player
+	ASCharacter* Character = GetWorld()->SpawnActorDeferred<ASCharacter>(CharacterClass, SpawnTransform, NULL, NULL, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+
+	if (Character != NULL) {
+		Character->AutoPossessPlayer = EAutoReceiveInput::Disabled;
+
+		UGameplayStatics::FinishSpawningActor(Character, SpawnTransform);
+
+		SpawnedCharacters.Add(Character);
+	}
+
+	return Character;
+
+}
+
+void ASBenchmark::DestroyCharacters()
+{
+	for (ASCharacter* Character : SpawnedCharacters) {
+		if (Character != NULL && !Character->IsPendingKill()) {
+			Character->Destroy();
+		}
+	}
+
+	SpawnedCharacters.Reset();
+
+}
+
+FVector ASBenchmark::GetGridLocation(int32 Index, int32 NumColumns, float Spacing) const
+{
+	const int32 Row = Index / FMath::Max(NumColumns, 1);
+	const int32 Column = Index % FMath::Max(NumColumns, 1);
+
+	return GetActorLocation() + FVector((Row + 1) * Spacing, (Column - NumColumns / 2) * Spacing, 0.f);
+
+}
+
+TSubclassOf<ASCharacter> ASBenchmark::ResolveCharacterClass(const FString& ClassPath)
+{
+	UClass* CharacterClass = NULL;
+
+	if (!ClassPath.IsEmpty()) {
+		CharacterClass = LoadClass<ASCharacter>(NULL, *ClassPath);
+	}
+
+	if (CharacterClass == NULL) {
+		CharacterClass = LoadClass<ASCharacter>(NULL, TEXT("/Game/Blueprints/Character/BP_Proto.BP_Proto_C"));
+	}
+
+	if (CharacterClass == NULL) {
+		CharacterClass = ASCharacter::StaticClass();
+	}
+
+	return CharacterClass;
+
+}
+
+void ASBenchmark::FinishBenchmark()
+{
+	bFinished = true;
+
+	DestroyCharacters();
+
+	// Write results as name,value pairs
+	FString Report = TEXT("Name,Value\n");
+
+	for (const FString& Line : ResultLines) {
+		Report += Line + TEXT("\n");
+	}
+
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / BenchmarkName + TEXT(".csv");
+
+	if (FFileHelper::SaveStringToFile(Report, *ReportPath)) {
+		UE_LOG(LogDarkHours, Log, TEXT("%s: report written to %s"), *BenchmarkName, *ReportPath);
+	}
+	else {
+		UE_LOG(LogDarkHours, Warning, TEXT("%s: failed to write report to %s"), *BenchmarkName, *ReportPath);
+	}
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("BenchmarkExit"))) {
+		FPlatformMisc::RequestExitWithStatus(false, bFailed ? 1 : 0);
+	}
+
+	OnFinished.Broadcast(this);
+
+	Destroy();
+
+}
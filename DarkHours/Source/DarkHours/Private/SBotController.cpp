@@ -0,0 +1,194 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SBotController.h"
+#include "DarkHours.h"
+#include "SBotManager.h"
+#include "SCharacter.h"
+#include "SInteractableRegistry.h"
+#include "SWeaponPickup.h"
+#include "Engine/World.h"
+
+// Holds the action in the frame, as a press if it was not held by the previous frame
+static void SetBotAction(FSInputFrame& Frame, const FSInputFrame& PreviousFrame, ESInputAction Action, bool bHeld)
+{
+	if (!bHeld) {
+		return;
+	}
+
+	if (PreviousFrame.IsHeld(Action)) {
+		Frame.HeldActions |= 1 << (uint8)Action;
+	}
+	else {
+		Frame.SetAction(Action, true);
+	}
+
+}
+
+// Sets default values
+ASBotController::ASBotController()
+{
+	// Bots are updated by the bot manager
+	PrimaryActorTick.bCanEverTick = false;
+
+	bWantsPlayerState = false;
+
+	// Variables
+	SeekPickupChance = 0.5f;
+	SeekPickupRadius = 3000.f;
+	SprintChance = 0.5f;
+	AimChance = 0.25f;
+	AcceptRadius = 100.f;
+	SwapDistance = 150.f;
+	TurnRate = 360.f;
+
+	Behavior = ESBotBehavior::Wander;
+	Goal = FVector::ZeroVector;
+	PathIndex = 0;
+	bNeedsPath = false;
+	bWantsSprint = false;
+	bWantsAim = false;
+	bWantsInteract = false;
+
+}
+
+void ASBotController::SetRandomSeed(int32 Seed)
+{
+	RandomStream.Initialize(Seed);
+
+}
+
+void ASBotController::Think(ASBotManager* BotManager)
+{
+	ASCharacter* Character = GetBotCharacter();
+
+	if (Character == NULL || BotManager == NULL) {
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_DarkHours_NumBotDecisions);
+
+	const FVector Location = Character->GetActorLocation();
+
+	// Swapped last decision, or the pickup was taken or could not be reached
+	const bool bPathDone = !bNeedsPath && (!Path.IsValid() || PathIndex >= Path->Num());
+
+	if (Behavior == ESBotBehavior::SwapWeapon || (Behavior == ESBotBehavior::SeekPickup && (!TargetPickup.IsValid() || bPathDone))) {
+		Behavior = ESBotBehavior::Wander;
+		TargetPickup = NULL;
+		Path = NULL;
+		bNeedsPath = false;
+	}
+
+	// New goal once the last one is reached
+	if (Behavior == ESBotBehavior::Wander && !bNeedsPath && (!Path.IsValid() || PathIndex >= Path->Num())) {
+		ASInteractableRegistry* InteractableRegistry = ASInteractableRegistry::Get(this);
+		AActor* Pickup = NULL;
+
+		if (InteractableRegistry != NULL && RandomStream.FRand() < SeekPickupChance) {
+			Pickup = InteractableRegistry->FindNearest(Location, Character->GetActorForwardVector(), SeekPickupRadius, -1.f, ASWeaponPickup::StaticClass());
+		}
+
+		if (Pickup != NULL) {
+			Behavior = ESBotBehavior::SeekPickup;
+			TargetPickup = Pickup;
+			Goal = InteractableRegistry->GetLocation(Pickup);
+			bNeedsPath = true;
+		}
+		else if (BotManager->GetWanderPoint(RandomStream, Goal)) {
+			bNeedsPath = true;
+		}
+
+		bWantsSprint = RandomStream.FRand() < SprintChance;
+		bWantsAim = !bWantsSprint && RandomStream.FRand() < AimChance;
+	}
+
+	// Shared path - stays pending while the query budget of the frame is spent
+	if (bNeedsPath) {
+		TSharedPtr<const TArray<FVector>> NewPath = BotManager->FindPath(Location, Goal);
+
+		if (NewPath.IsValid()) {
+			SetPath(NewPath);
+			bNeedsPath = false;
+		}
+	}
+
+}
+
+void ASBotController::UpdateInput(float DeltaTime)
+{
+	ASCharacter* Character = GetBotCharacter();
+
+	if (Character == NULL) {
+		return;
+	}
+
+	const FVector Location = Character->GetActorLocation();
+	const FRotator ControlRotation = GetControlRotation();
+
+	float NewYaw = ControlRotation.Yaw;
+	float Forward = 0.f;
+
+	// Skip the points already reached, then turn toward the next one and walk
+	while (Path.IsValid() && PathIndex < Path->Num() && FVector::DistSquared2D((*Path)[PathIndex], Location) < FMath::Square(AcceptRadius)) {
+		PathIndex++;
+	}
+
+	if (Path.IsValid() && PathIndex < Path->Num()) {
+		const FVector ToPoint = (*Path)[PathIndex] - Location;
+
+		NewYaw = FMath::FixedTurn(ControlRotation.Yaw, ToPoint.Rotation().Yaw, TurnRate * DeltaTime);
+		Forward = 1.f;
+	}
+
+	// Close enough to the pickup, face it and interact
+	if (Behavior == ESBotBehavior::SeekPickup && TargetPickup.IsValid() && FVector::DistSquared2D(Goal, Location) < FMath::Square(SwapDistance)) {
+		NewYaw = (Goal - Location).Rotation().Yaw;
+		Forward = 0.f;
+
+		Path = NULL;
+		Behavior = ESBotBehavior::SwapWeapon;
+		bWantsInteract = true;
+	}
+
+	FSInputFrame Frame;
+	Frame.Time = GetWorld()->GetTimeSeconds();
+	Frame.SetMove(Forward, 0.f);
+	Frame.SetControlRotation(FRotator(0.f, NewYaw, 0.f));
+
+	// Turn rate as the camera axis, which drives the turn animation
+	Frame.CameraX = DeltaTime > 0.f ? FMath::Clamp(FMath::FindDeltaAngleDegrees(ControlRotation.Yaw, NewYaw) / (TurnRate * DeltaTime), -1.f, 1.f) : 0.f;
+
+	SetBotAction(Frame, PreviousFrame, ESInputAction::Sprint, bWantsSprint && Forward > 0.f);
+	SetBotAction(Frame, PreviousFrame, ESInputAction::Aim, bWantsAim);
+
+	if (bWantsInteract) {
+		Frame.SetAction(ESInputAction::Interact, true);
+		Frame.SetAction(ESInputAction::Interact, false); // Press only
+
+		bWantsInteract = false;
+	}
+
+	Character->ApplyInputFrame(Frame, PreviousFrame);
+
+	PreviousFrame = Frame;
+
+}
+
+ESBotBehavior ASBotController::GetBehavior() const
+{
+	return Behavior;
+
+}
+
+ASCharacter* ASBotController::GetBotCharacter() const
+{
+	return Cast<ASCharacter>(GetPawn());
+
+}
+
+void ASBotController::SetPath(TSharedPtr<const TArray<FVector>> NewPath)
+{
+	Path = NewPath;
+	PathIndex = Path.IsValid() && Path->Num() > 1 ? 1 : 0;
+
+}
@@ -0,0 +1,398 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SBotManager.h"
+#include "DarkHours.h"
+#include "SBotController.h"
+#include "SCharacter.h"
+#include "SWorldManager.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerStart.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+
+// Returns where bots spawn - the local player, the first player start or the world origin
+static FVector GetBotSpawnOrigin(UWorld* World)
+{
+	APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(World, 0);
+
+	if (PlayerPawn != NULL) {
+		return PlayerPawn->GetActorLocation();
+	}
+
+	for (TActorIterator<APlayerStart> It(World); It; ++It) {
+		return It->GetActorLocation();
+	}
+
+	return FVector(0.f, 0.f, 200.f);
+
+}
+
+static void SpawnBots(const TArray<FString>& Args, UWorld* World)
+{
+	if (World == NULL || World->GetNetMode() == NM_Client) {
+		UE_LOG(LogDarkHours, Warning, TEXT("Bots: bots only spawn on the server"));
+		return;
+	}
+
+	ASBotManager* BotManager = ASBotManager::Get(World);
+
+	if (BotManager == NULL) {
+		return;
+	}
+
+	const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 50;
+
+	BotManager->SpawnBots(Count, ASBotManager::ResolveCharacterClass(World, Args.Num() > 1 ? Args[1] : FString()), GetBotSpawnOrigin(World));
+
+}
+
+static void ClearBots(UWorld* World)
+{
+	ASBotManager* BotManager = GetWorldManager<ASBotManager>(World, false);
+
+	if (BotManager != NULL) {
+		BotManager->DestroyBots();
+	}
+
+}
+
+static void LogBotReport(UWorld* World)
+{
+	ASBotManager* BotManager = GetWorldManager<ASBotManager>(World, false);
+
+	if (BotManager != NULL) {
+		BotManager->LogReport();
+	}
+	else {
+		UE_LOG(LogDarkHours, Log, TEXT("Bots: no bot manager in this world"));
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SpawnBotsCommand(
+	TEXT("DarkHours.Bots.Spawn"),
+	TEXT("Spawns load test bots around the player. Args: [Count=50] [CharacterClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SpawnBots));
+
+static FAutoConsoleCommandWithWorld ClearBotsCommand(
+	TEXT("DarkHours.Bots.Clear"),
+	TEXT("Destroys all load test bots and their characters."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&ClearBots));
+
+static FAutoConsoleCommandWithWorld BotReportCommand(
+	TEXT("DarkHours.Bots.Report"),
+	TEXT("Logs the number of bots per behavior and the use of the shared path cache."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogBotReport));
+
+// Sets default values
+ASBotManager::ASBotManager()
+{
+	// Input must reach the characters before movement runs
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = false;
+
+	// Variables
+	DecisionsPerFrame = 8;
+	PathQueriesPerFrame = 4;
+	PathCellSize = 500.f;
+	PathLifetime = 10.f;
+	MaxCachedPaths = 1024;
+	NumWanderPoints = 32;
+	WanderRadius = 5000.f;
+	SpawnRadius = 2000.f;
+
+	NextBotIndex = 0;
+	WanderOrigin = FVector::ZeroVector;
+	NumPathQueries = 0;
+	TotalPathQueries = 0;
+	TotalPathCacheHits = 0;
+
+}
+
+// Called every frame
+void ASBotManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_BotUpdate, BotUpdate);
+
+	// Bots whose character is gone are done
+	for (int32 Index = Bots.Num() - 1; Index >= 0; Index--) {
+		ASBotController* Bot = Bots[Index];
+
+		if (Bot == NULL || Bot->IsPendingKill() || Bot->GetPawn() == NULL) {
+			if (Bot != NULL && !Bot->IsPendingKill()) {
+				Bot->Destroy();
+			}
+
+			Bots.RemoveAtSwap(Index);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_DarkHours_Bots, Bots.Num());
+
+	if (Bots.Num() == 0) {
+		return;
+	}
+
+	NumPathQueries = 0;
+
+	// A few bots think per frame, round robin
+	const int32 NumDecisions = FMath::Min(DecisionsPerFrame, Bots.Num());
+
+	for (int32 Decision = 0; Decision < NumDecisions; Decision++) {
+		NextBotIndex = (NextBotIndex + 1) % Bots.Num();
+
+		Bots[NextBotIndex]->Think(this);
+	}
+
+	// All bots steer and apply their input
+	for (ASBotController* Bot : Bots) {
+		Bot->UpdateInput(DeltaTime);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASBotManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DestroyBots();
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+ASBotManager* ASBotManager::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASBotManager>(WorldContextObject);
+
+}
+
+int32 ASBotManager::SpawnBots(int32 Count, TSubclassOf<ASCharacter> CharacterClass, const FVector& Origin)
+{
+	if (CharacterClass == NULL || !HasAuthority()) {
+		return 0;
+	}
+
+	DARKHOURS_LLM_SCOPE(Characters);
+
+	// Wander points are spread around the first spawn
+	if (Bots.Num() == 0) {
+		WanderOrigin = Origin;
+		WanderPoints.Reset();
+	}
+
+	FRandomStream RandomStream(Bots.Num());
+	int32 NumSpawned = 0;
+
+	for (int32 Index = 0; Index < Count; Index++) {
+		const FTransform SpawnTransform(FRotator(0.f, RandomStream.FRandRange(-180.f, 180.f), 0.f), GetRandomNavigablePoint(Origin, SpawnRadius, RandomStream) + FVector(0.f, 0.f, 100.f));
+
+		// Defer construction, so the characters neither possess the local player nor spawn an AI controller
+		ASCharacter* Character = GetWorld()->SpawnActorDeferred<ASCharacter>(CharacterClass, SpawnTransform, NULL, NULL, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+
+		if (Character == NULL) {
+			continue;
+		}
+
+		Character->AutoPossessPlayer = EAutoReceiveInput::Disabled;
+		Character->AutoPossessAI = EAutoPossessAI::Disabled;
+
+		UGameplayStatics::FinishSpawningActor(Character, SpawnTransform);
+
+		FActorSpawnParameters SpawnInfos;
+		SpawnInfos.ObjectFlags |= RF_Transient;
+
+		ASBotController* Bot = GetWorld()->SpawnActor<ASBotController>(ASBotController::StaticClass(), SpawnTransform, SpawnInfos);
+
+		if (Bot == NULL) {
+			Character->Destroy();
+			continue;
+		}
+
+		Bot->SetRandomSeed(Bots.Num());
+		Bot->Possess(Character);
+
+		Bots.Add(Bot);
+		NumSpawned++;
+	}
+
+	UE_LOG(LogDarkHours, Log, TEXT("Bots: spawned %d bots of %s, %d total"), NumSpawned, *CharacterClass->GetName(), Bots.Num());
+
+	return NumSpawned;
+
+}
+
+void ASBotManager::DestroyBots()
+{
+	for (ASBotController* Bot : Bots) {
+		if (Bot == NULL || Bot->IsPendingKill()) {
+			continue;
+		}
+
+		if (Bot->GetPawn() != NULL) {
+			Bot->GetPawn()->Destroy();
+		}
+
+		Bot->Destroy();
+	}
+
+	Bots.Reset();
+	Paths.Reset();
+
+	SET_DWORD_STAT(STAT_DarkHours_Bots, 0);
+
+}
+
+TSharedPtr<const TArray<FVector>> ASBotManager::FindPath(const FVector& Start, const FVector& Goal)
+{
+	const TPair<FIntVector, FIntVector> Key(GetCell(Start), GetCell(Goal));
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Another bot went this way lately
+	const FSBotPath* CachedPath = Paths.Find(Key);
+
+	if (CachedPath != NULL && Now - CachedPath->Time < PathLifetime) {
+		INC_DWORD_STAT(STAT_DarkHours_NumBotPathCacheHits);
+		TotalPathCacheHits++;
+
+		return CachedPath->Points;
+	}
+
+	if (NumPathQueries >= PathQueriesPerFrame) {
+		return NULL;
+	}
+
+	INC_DWORD_STAT(STAT_DarkHours_NumBotPathQueries);
+	NumPathQueries++;
+	TotalPathQueries++;
+
+	TSharedPtr<TArray<FVector>> Points = MakeShared<TArray<FVector>>();
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	ANavigationData* NavData = NavSys != NULL ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : NULL;
+
+	if (NavData != NULL) {
+		FPathFindingQuery Query(this, *NavData, Start, Goal);
+		FPathFindingResult Result = NavSys->FindPathSync(Query);
+
+		if (Result.IsSuccessful() && Result.Path.IsValid()) {
+			for (const FNavPathPoint& PathPoint : Result.Path->GetPathPoints()) {
+				Points->Add(PathPoint.Location);
+			}
+		}
+	}
+
+	// Straight to the goal without a navmesh or a path
+	if (Points->Num() == 0) {
+		Points->Add(Start);
+		Points->Add(Goal);
+	}
+
+	// Drop expired paths once the cache is full, everything if they are all fresh
+	if (Paths.Num() >= MaxCachedPaths) {
+		for (auto It = Paths.CreateIterator(); It; ++It) {
+			if (Now - It.Value().Time >= PathLifetime) {
+				It.RemoveCurrent();
+			}
+		}
+
+		if (Paths.Num() >= MaxCachedPaths) {
+			Paths.Reset();
+		}
+	}
+
+	FSBotPath& NewPath = Paths.Add(Key);
+	NewPath.Points = Points;
+	NewPath.Time = Now;
+
+	return Points;
+
+}
+
+bool ASBotManager::GetWanderPoint(FRandomStream& RandomStream, FVector& OutPoint)
+{
+	// Wander points are found once, one per call, as they are needed
+	if (WanderPoints.Num() < NumWanderPoints) {
+		WanderPoints.Add(GetRandomNavigablePoint(WanderOrigin, WanderRadius, RandomStream));
+	}
+
+	if (WanderPoints.Num() == 0) {
+		return false;
+	}
+
+	OutPoint = WanderPoints[RandomStream.RandHelper(WanderPoints.Num())];
+
+	return true;
+
+}
+
+int32 ASBotManager::GetNumBots() const
+{
+	return Bots.Num();
+
+}
+
+void ASBotManager::LogReport() const
+{
+	int32 NumPerBehavior[3] = { 0, 0, 0 };
+
+	for (const ASBotController* Bot : Bots) {
+		if (Bot != NULL) {
+			NumPerBehavior[(int32)Bot->GetBehavior()]++;
+		}
+	}
+
+	const int32 NumPathRequests = TotalPathQueries + TotalPathCacheHits;
+
+	UE_LOG(LogDarkHours, Log, TEXT("Bots: %d bots - %d wandering, %d seeking pickups, %d swapping"), Bots.Num(), NumPerBehavior[0], NumPerBehavior[1], NumPerBehavior[2]);
+	UE_LOG(LogDarkHours, Log, TEXT("Bots: %d cached paths, %d path searches, %d cache hits (%.1f%%), %d wander points"), Paths.Num(), TotalPathQueries, TotalPathCacheHits, NumPathRequests > 0 ? 100.f * TotalPathCacheHits / NumPathRequests : 0.f, WanderPoints.Num());
+
+}
+
+TSubclassOf<ASCharacter> ASBotManager::ResolveCharacterClass(UWorld* World, const FString& ClassPath)
+{
+	UClass* CharacterClass = NULL;
+
+	if (!ClassPath.IsEmpty()) {
+		CharacterClass = LoadClass<ASCharacter>(NULL, *ClassPath);
+	}
+
+	// Same pawn as the players
+	AGameModeBase* GameMode = World != NULL ? World->GetAuthGameMode() : NULL;
+
+	if (CharacterClass == NULL && GameMode != NULL && GameMode->DefaultPawnClass != NULL && GameMode->DefaultPawnClass->IsChildOf(ASCharacter::StaticClass())) {
+		CharacterClass = GameMode->DefaultPawnClass;
+	}
+
+	if (CharacterClass == NULL) {
+		CharacterClass = ASCharacter::StaticClass();
+	}
+
+	return CharacterClass;
+
+}
+
+FIntVector ASBotManager::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / PathCellSize), FMath::FloorToInt(Location.Y / PathCellSize), FMath::FloorToInt(Location.Z / PathCellSize));
+
+}
+
+FVector ASBotManager::GetRandomNavigablePoint(const FVector& Location, float Radius, FRandomStream& RandomStream) const
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FNavLocation NavLocation;
+
+	if (NavSys != NULL && NavSys->GetRandomReachablePointInRadius(Location, Radius, NavLocation)) {
+		return NavLocation.Location;
+	}
+
+	return Location + FVector(RandomStream.FRandRange(-Radius, Radius), RandomStream.FRandRange(-Radius, Radius), 0.f);
+
+}
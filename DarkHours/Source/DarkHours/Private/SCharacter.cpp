@@ -1,7 +1,18 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "SCharacter.h"
+#include "DarkHours.h"
+#include "SActorPool.h"
+#include "SCharacterMovementComponent.h"
+#include "SImpactEffectsManager.h"
+#include "SInteractableRegistry.h"
+#include "SInventoryComponent.h"
+#include "SLagCompensationManager.h"
+#include "SLevelStreamingManager.h"
+#include "SPhysicsBudgetManager.h"
+#include "SPickupInstanceManager.h"
 #include "SRifleWeapon.h"
+#include "SSignificanceManager.h"
 #include "SWeapon.h"
 #include "SWeaponPickup.h"
 #include "Camera/CameraComponent.h"
@@ -14,16 +25,108 @@
 #include "Engine/GameEngine.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/GameStateBase.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
+
+// Bits and range of the replicated animation inputs - 26 bits in total
+static const int32 AnimInputAxisBits = 5;
+static const float AnimInputAxisRange = 1.f;
+static const int32 AnimInputTurnBits = 6;
+static const float AnimInputTurnRange = 4.f;
+static const int32 AnimInputDirectionBits = 8;
+static const float AnimInputDirectionRange = 180.f;
+
+// Maps the value to an even number of steps, so zero stays exact
+static uint32 QuantizeAnimInput(float Value, float Range, int32 NumBits)
+{
+	const uint32 MaxValue = (1u << NumBits) - 2;
+	const float Alpha = (FMath::Clamp(Value, -Range, Range) + Range) / (2.f * Range);
+
+	return (uint32)FMath::RoundToInt(Alpha * MaxValue);
+
+}
+
+static float DequantizeAnimInput(uint32 Quantized, float Range, int32 NumBits)
+{
+	const uint32 MaxValue = (1u << NumBits) - 2;
+
+	return (FMath::Min(Quantized, MaxValue) / (float)MaxValue) * 2.f * Range - Range;
+
+}
+
+void FSReplicatedAnimInputs::Quantize()
+{
+	InputX = DequantizeAnimInput(QuantizeAnimInput(InputX, AnimInputAxisRange, AnimInputAxisBits), AnimInputAxisRange, AnimInputAxisBits);
+	InputY = DequantizeAnimInput(QuantizeAnimInput(InputY, AnimInputAxisRange, AnimInputAxisBits), AnimInputAxisRange, AnimInputAxisBits);
+	TurnX = DequantizeAnimInput(QuantizeAnimInput(TurnX, AnimInputTurnRange, AnimInputTurnBits), AnimInputTurnRange, AnimInputTurnBits);
+	MovementDirection = DequantizeAnimInput(QuantizeAnimInput(MovementDirection, AnimInputDirectionRange, AnimInputDirectionBits), AnimInputDirectionRange, AnimInputDirectionBits);
+
+}
+
+bool FSReplicatedAnimInputs::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 Packed = 0;
+	int32 Shift = 0;
+
+	if (Ar.IsSaving()) {
+		Packed |= QuantizeAnimInput(InputX, AnimInputAxisRange, AnimInputAxisBits);
+		Shift += AnimInputAxisBits;
+		Packed |= QuantizeAnimInput(InputY, AnimInputAxisRange, AnimInputAxisBits) << Shift;
+		Shift += AnimInputAxisBits;
+		Packed |= QuantizeAnimInput(TurnX, AnimInputTurnRange, AnimInputTurnBits) << Shift;
+		Shift += AnimInputTurnBits;
+		Packed |= QuantizeAnimInput(MovementDirection, AnimInputDirectionRange, AnimInputDirectionBits) << Shift;
+		Shift += AnimInputDirectionBits;
+		Packed |= (bIsSprinting ? 1u : 0u) << Shift++;
+		Packed |= (bIsAiming ? 1u : 0u) << Shift++;
+	}
+	else {
+		Shift = AnimInputAxisBits * 2 + AnimInputTurnBits + AnimInputDirectionBits + 2;
+	}
+
+	Ar.SerializeBits(&Packed, Shift);
+
+	if (Ar.IsLoading()) {
+		Shift = 0;
+		InputX = DequantizeAnimInput((Packed >> Shift) & ((1u << AnimInputAxisBits) - 1), AnimInputAxisRange, AnimInputAxisBits);
+		Shift += AnimInputAxisBits;
+		InputY = DequantizeAnimInput((Packed >> Shift) & ((1u << AnimInputAxisBits) - 1), AnimInputAxisRange, AnimInputAxisBits);
+		Shift += AnimInputAxisBits;
+		TurnX = DequantizeAnimInput((Packed >> Shift) & ((1u << AnimInputTurnBits) - 1), AnimInputTurnRange, AnimInputTurnBits);
+		Shift += AnimInputTurnBits;
+		MovementDirection = DequantizeAnimInput((Packed >> Shift) & ((1u << AnimInputDirectionBits) - 1), AnimInputDirectionRange, AnimInputDirectionBits);
+		Shift += AnimInputDirectionBits;
+		bIsSprinting = ((Packed >> Shift++) & 1u) != 0;
+		bIsAiming = ((Packed >> Shift++) & 1u) != 0;
+	}
+
+	bOutSuccess = true;
+
+	return true;
+
+}
+
+bool FSReplicatedAnimInputs::operator==(const FSReplicatedAnimInputs& Other) const
+{
+	return InputX == Other.InputX && InputY == Other.InputY && TurnX == Other.TurnX && MovementDirection == Other.MovementDirection
+		&& bIsSprinting == Other.bIsSprinting && bIsAiming == Other.bIsAiming;
+
+}
 
 // Sets default values
-ASCharacter::ASCharacter()
+ASCharacter::ASCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<USCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
-	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	DARKHOURS_LLM_SCOPE(Characters);
+
+	// Set this character to call Tick() every frame.  Tick is only enabled while there is movement input or a camera transition, unless the Blueprint implements Event Tick.
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	// Automatically possess this character
 	AutoPossessPlayer = EAutoReceiveInput::Player0;
@@ -59,70 +162,118 @@ ASCharacter::ASCharacter()
 	CameraComp->SetupAttachment(SpringArmComp, USpringArmComponent::SocketName); // Attach camera component to the 'tail' of the spring arm component
 	CameraComp->bUsePawnControlRotation = false;
 
-	GetCapsuleComponent()->SetGenerateOverlapEvents(true);
+	InventoryComp = CreateDefaultSubobject<USInventoryComponent>(TEXT("InventoryComponent"));
+
+	// Let the significance manager lower the animation update rate of far away characters
+	GetMesh()->bEnableUpdateRateOptimizations = true;
 
 	// Variables
 	AimFOV = 20.f;
 	FOVInterpSpeed = 15.f;
 
+	AimSocketOffset = FVector(0.f, 80.f, 15.f); // Move camera a bit to the right
+	SocketOffsetInterpSpeed = 15.f;
+
+	bIsAimTransitionActive = false;
+	bTickInBlueprint = false;
+
+	AnimInputsResendInterval = 0.5f;
+
+	InteractionReach = 200.f;
+	InteractionAngle = 60.f;
+
 	PrimaryDrawSocketName = "PrimaryDrawSocket";
 	PrimaryHolsterSocketName = "PrimaryHolsterSocket";
 
-	PrimaryWeapon = NULL;
-	SecondaryWeapon = NULL;
-
 }
 
 // Called when the game starts or when spawned
 void ASCharacter::BeginPlay()
 {
+	DARKHOURS_LLM_SCOPE(Characters);
+
 	Super::BeginPlay();
 
-	// Initialize player controller
-	PlayerController = UGameplayStatics::GetPlayerController(this, 0);
+	// Initialize player controller - a dedicated server has no local player
+	PlayerController = IsNetMode(NM_DedicatedServer) ? NULL : UGameplayStatics::GetPlayerController(this, 0);
 
-	// Initialize charater default FOV
+	// Initialize charater default FOV and camera offset
 	DefaultFOV = CameraComp->FieldOfView;
+	DefaultSocketOffset = SpringArmComp->SocketOffset;
+
+	if (IsNetMode(NM_DedicatedServer)) {
+		ConfigureForDedicatedServer();
+	}
+
+	ASSignificanceManager::RegisterActor(this, ESSignificanceType::Character);
+
+	// Sublevels stream around the players
+	ASLevelStreamingManager::Get(this);
+
+	// Destructibles and ragdolls are held to the physics budget
+	ASPhysicsBudgetManager::Get(this);
+
+	// Impact effects stream in before the first shot lands, nobody sees them on a dedicated server
+	if (!IsNetMode(NM_DedicatedServer)) {
+		ASImpactEffectsManager::Get(this);
+	}
+
+	// Event Tick of Blueprint subclasses keeps running as before
+	bTickInBlueprint = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AActor, ReceiveTick));
+	UpdateTickEnabled();
 
-	GetCapsuleComponent()->OnComponentBeginOverlap.AddDynamic(this, &ASCharacter::OnStartOverlappingActors);
-	GetCapsuleComponent()->OnComponentEndOverlap.AddDynamic(this, &ASCharacter::OnEndOverlappingActors);
+	// Shots of remote players are resolved against the recorded history of the characters
+	if (HasAuthority() && !IsNetMode(NM_Standalone) && ASLagCompensationManager::IsRecordingEnabled()) {
+		ASLagCompensationManager::RegisterCharacter(this);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ASSignificanceManager::UnregisterActor(this);
+	ASPhysicsBudgetManager::UnregisterRagdoll(GetMesh());
+	ASLagCompensationManager::UnregisterCharacter(this);
+
+	Super::EndPlay(EndPlayReason);
 
 }
 
 // Called every frame
 void ASCharacter::Tick(float DeltaTime)
 {
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_CharacterTick, CharacterTick);
+	INC_DWORD_STAT(STAT_DarkHours_NumCharacterTicks);
+
 	Super::Tick(DeltaTime);
 
 	// Debug the direction value
-	if (GEngine != NULL) {
-		GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::Red, FString::Printf(TEXT("Movement Direction: %f"), MovementDirection));
-	}
+	DARKHOURS_DEBUG_MESSAGE(FColor::Red, TEXT("Movement Direction: %f"), MovementDirection);
 
-	// Calculate movement direction after every frame
-	CalculateCharacterMovementDirection(InputX, InputY);
+	// Calculate movement direction while there is movement input
+	if (HasMovementInput()) {
+		CalculateCharacterMovementDirection(InputX, InputY);
 
-	// Make target FOV for when aiming
-	float AimTargetFOV = FMath::FInterpTo(CameraComp->FieldOfView, bIsAiming ? AimFOV : DefaultFOV, DeltaTime, FOVInterpSpeed);
-
-	CameraComp->SetFieldOfView(AimTargetFOV);
-
-	if (bIsAiming) {
-		SpringArmComp->SocketOffset = FVector(0.f, 80.f, 15.f); // Move camera a bit to the right
-		SpringArmComp->bEnableCameraLag = false;
-		SpringArmComp->bEnableCameraRotationLag = false;
+		UpdateNearbyWeaponPickup();
 	}
-	else {
-		// Reset all the spring arm component values that are altered when aiming
-		SpringArmComp->SocketOffset = FVector::ZeroVector;
-		SpringArmComp->bEnableCameraLag = true;
-		SpringArmComp->bEnableCameraRotationLag = true;
+
+#if DARKHOURS_WITH_COSMETICS
+	if (bIsAimTransitionActive) {
+		UpdateAimTransition(DeltaTime);
 	}
+#endif
 
-	if (OverlappedWeaponPickup != NULL) {
-		UKismetSystemLibrary::PrintString(this, UKismetSystemLibrary::GetDisplayName(OverlappedWeaponPickup), true, false, FColor::Green, 0.f);
+	if (NearbyWeaponPickup.IsValid()) {
+		DARKHOURS_DEBUG_MESSAGE(FColor::Green, TEXT("%s"), *UKismetSystemLibrary::GetDisplayName(NearbyWeaponPickup.Get()));
 	}
 
+	// Also runs the frame the input goes back to zero, before tick is turned off
+	UpdateReplicatedAnimInputs();
+
+	// Stop ticking once idle
+	UpdateTickEnabled();
+
 }
 
 // Called to bind functionality to input
@@ -148,26 +299,38 @@ void ASCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponen
 
 	PlayerInputComponent->BindAction("Interact", IE_Pressed, this, &ASCharacter::Interact);
 
+	PlayerInputComponent->BindAction("Fire", IE_Pressed, this, &ASCharacter::FireStart);
+	PlayerInputComponent->BindAction("Fire", IE_Released, this, &ASCharacter::FireEnd);
+
 	// Camera input
 	PlayerInputComponent->BindAxis("CameraX", this, &ASCharacter::CameraX);
 	PlayerInputComponent->BindAxis("CameraY", this, &ASCharacter::CameraY);
 
 }
 
+void ASCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(ASCharacter, ReplicatedAnimInputs, COND_SkipOwner);
+
+}
+
 void ASCharacter::MoveX(float Value)
 {
 	InputX = Value;
 
-	// Debug the character forward movement input value
-	if (GEngine != NULL) {
-		GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::Blue, FString::Printf(TEXT("Input X: %f"), InputX));
+	InputFrame.SetMove(Value, InputY);
+
+	// Start ticking as soon as movement input comes in
+	if (Value != 0.f) {
+		UpdateTickEnabled();
 	}
 
-	if (Controller != NULL) {
-		if (bIsSprinting) {
-			Value *= 2;
-		}
+	// Debug the character forward movement input value
+	DARKHOURS_DEBUG_MESSAGE(FColor::Blue, TEXT("Input X: %f"), InputX);
 
+	if (Controller != NULL) {
 		// Determine the forward rotation
 		FRotator NewRotation = Controller->GetControlRotation();
 		FRotator NewYawRotation = FRotator(0.f, NewRotation.Yaw, 0.f);
@@ -185,16 +348,17 @@ void ASCharacter::MoveY(float Value)
 {
 	InputY = Value;
 
-	// Debug the character right movement input value 
-	if (GEngine != NULL) {
-		GEngine->AddOnScreenDebugMessage(-1, 0.f, FColor::Blue, FString::Printf(TEXT("Input Y: %f"), InputY));
+	InputFrame.SetMove(InputX, Value);
+
+	// Start ticking as soon as movement input comes in
+	if (Value != 0.f) {
+		UpdateTickEnabled();
 	}
 
-	if (Controller != NULL) {
-		if (bIsSprinting) {
-			Value *= 2;
-		}
+	// Debug the character right movement input value 
+	DARKHOURS_DEBUG_MESSAGE(FColor::Blue, TEXT("Input Y: %f"), InputY);
 
+	if (Controller != NULL) {
 		// Determine the right rotation
 		FRotator NewRotation = Controller->GetControlRotation();
 		FRotator NewYawRotation = FRotator(0.f, NewRotation.Yaw, 0.f);
@@ -212,9 +376,17 @@ void ASCharacter::SprintStart()
 {
 	bIsSprinting = true;
 
+	InputFrame.SetAction(ESInputAction::Sprint, true);
+
+	GetSCharacterMovement()->SetSprinting(true); // Sprint speed is part of the predicted move
+
+	UpdateReplicatedAnimInputs();
+
+#if DARKHOURS_WITH_COSMETICS
 	if (PlayerController != NULL && CamShake_Sprinting != NULL) {
 		PlayerController->ClientPlayCameraShake(CamShake_Sprinting); // Start playing sprinting cam shake when sprinting
 	}
+#endif
 
 }
 
@@ -222,14 +394,25 @@ void ASCharacter::SprintEnd()
 {
 	bIsSprinting = false;
 
+	InputFrame.SetAction(ESInputAction::Sprint, false);
+
+	GetSCharacterMovement()->SetSprinting(false);
+
+	UpdateReplicatedAnimInputs();
+
+#if DARKHOURS_WITH_COSMETICS
 	if (PlayerController != NULL && CamShake_Sprinting != NULL) {
 		PlayerController->ClientStopCameraShake(CamShake_Sprinting); // Stop playing sprinting cam shake when stop sprinting
 	}
+#endif
 
 }
 
 void ASCharacter::ToggleCrouch()
 {
+	InputFrame.SetAction(ESInputAction::Crouch, true);
+	InputFrame.SetAction(ESInputAction::Crouch, false); // Toggle - press only
+
 	if (GetCharacterMovement()->IsCrouching()) { // If character is found already in crouching state
 		UnCrouch();
 	}
@@ -241,12 +424,16 @@ void ASCharacter::ToggleCrouch()
 
 void ASCharacter::JumpStart()
 {
+	InputFrame.SetAction(ESInputAction::Jump, true);
+
 	Jump();
 
 }
 
 void ASCharacter::JumpEnd()
 {
+	InputFrame.SetAction(ESInputAction::Jump, false);
+
 	StopJumping();
 
 }
@@ -255,7 +442,13 @@ void ASCharacter::AimStart()
 {
 	bIsAiming = true;
 
-	bUseControllerRotationYaw = true; // Allow character to rotate in place
+	InputFrame.SetAction(ESInputAction::Aim, true);
+
+	GetSCharacterMovement()->SetAiming(true); // Allow character to rotate in place - applied by the predicted move
+
+	UpdateReplicatedAnimInputs();
+
+	StartAimTransition();
 
 }
 
@@ -263,36 +456,185 @@ void ASCharacter::AimEnd()
 {
 	bIsAiming = false;
 
-	bUseControllerRotationYaw = false; // When stop aiming, character is not allowed to rotate in place
+	InputFrame.SetAction(ESInputAction::Aim, false);
+
+	GetSCharacterMovement()->SetAiming(false); // When stop aiming, character is not allowed to rotate in place
+
+	UpdateReplicatedAnimInputs();
+
+	StartAimTransition();
 
 }
 
-/* This function is only called when the character overlaps with any actor that has collision component */
 void ASCharacter::Interact()
 {
-	Interaction_PrimaryWeapon();
+	if (IsLocallyControlled()) {
+		InputFrame.SetAction(ESInputAction::Interact, true);
+		InputFrame.SetAction(ESInputAction::Interact, false); // Press only
+	}
+
+	// Inventory is server authoritative
+	if (Role < ROLE_Authority) {
+		ServerInteract();
+		return;
+	}
+
+	// Frozen pickups in range become actors first
+	ASPickupInstanceManager::ThawNear(this, GetActorLocation());
+
+	ASWeaponPickup* WeaponPickup = FindInteractableWeaponPickup();
+
+	if (WeaponPickup != NULL) {
+		// Swap once the weapon class is streamed in - right away if it already is
+		PendingInteractionPickup = WeaponPickup;
+
+		WeaponPickup->RequestWeaponClass(FSimpleDelegate::CreateUObject(this, &ASCharacter::OnInteractionWeaponLoaded));
+	}
+
+}
+
+void ASCharacter::ServerInteract_Implementation()
+{
+	Interact();
+
+}
+
+bool ASCharacter::ServerInteract_Validate()
+{
+	return true;
+
+}
+
+void ASCharacter::FireStart()
+{
+	ASRifleWeapon* PrimaryWeapon = GetPrimaryWeapon();
+
+	if (PrimaryWeapon == NULL) {
+		return;
+	}
+
+	PrimaryWeapon->StartFire();
+
+	if (Role < ROLE_Authority) {
+		const AGameStateBase* GameState = GetWorld()->GetGameState();
+
+		ServerStartFire(GameState != NULL ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds());
+	}
+
+	if (PlayerController != NULL && CamShake_FiringWeapon != NULL) {
+		PlayerController->ClientPlayCameraShake(CamShake_FiringWeapon); // Start playing firing cam shake when firing
+	}
+
+}
+
+void ASCharacter::FireEnd()
+{
+	ASRifleWeapon* PrimaryWeapon = GetPrimaryWeapon();
+
+	if (PrimaryWeapon != NULL) {
+		PrimaryWeapon->StopFire();
+	}
+
+	if (Role < ROLE_Authority) {
+		ServerStopFire();
+	}
+
+	if (PlayerController != NULL && CamShake_FiringWeapon != NULL) {
+		PlayerController->ClientStopCameraShake(CamShake_FiringWeapon); // Stop playing firing cam shake when stop firing
+	}
+
+}
+
+void ASCharacter::ServerStartFire_Implementation(float ClientFireTime)
+{
+	ASRifleWeapon* PrimaryWeapon = GetPrimaryWeapon();
+
+	if (PrimaryWeapon != NULL) {
+		PrimaryWeapon->StartFire();
+		PrimaryWeapon->SetRemoteFireTime(ClientFireTime);
+	}
+
+}
+
+bool ASCharacter::ServerStartFire_Validate(float ClientFireTime)
+{
+	return true;
+
+}
+
+void ASCharacter::ServerStopFire_Implementation()
+{
+	ASRifleWeapon* PrimaryWeapon = GetPrimaryWeapon();
+
+	if (PrimaryWeapon != NULL) {
+		PrimaryWeapon->StopFire();
+	}
+
+}
+
+bool ASCharacter::ServerStopFire_Validate()
+{
+	return true;
 
 }
 
-void ASCharacter::OnStartOverlappingActors(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult)
+void ASCharacter::OnInteractionWeaponLoaded()
 {
-	if (OtherActor != NULL && OtherActor != this && OtherActor->GetClass()->IsChildOf(ASWeaponPickup::StaticClass())) {
-		OverlappedWeaponPickup = Cast<ASWeaponPickup>(OtherActor);
+	ASWeaponPickup* WeaponPickup = PendingInteractionPickup.Get();
+
+	PendingInteractionPickup.Reset();
+
+	ASInteractableRegistry* InteractableRegistry = ASInteractableRegistry::Get(this);
+
+	// Only swap if the pickup is still there and the character did not walk away from it
+	if (WeaponPickup != NULL && InteractableRegistry != NULL && InteractableRegistry->IsRegistered(WeaponPickup)
+		&& FVector::DistSquared(InteractableRegistry->GetLocation(WeaponPickup), GetActorLocation()) <= FMath::Square(InteractionReach)) {
+		Interaction_PrimaryWeapon(WeaponPickup);
 	}
 
 }
 
-void ASCharacter::OnEndOverlappingActors(UPrimitiveComponent * OverlappedComponent, AActor * OtherActor, UPrimitiveComponent * OtherComp, int32 OtherBodyIndex)
+ASWeaponPickup* ASCharacter::FindInteractableWeaponPickup() const
 {
-	if (OtherActor != NULL && OtherActor != this) {
-		OverlappedWeaponPickup = NULL;
+	ASInteractableRegistry* InteractableRegistry = ASInteractableRegistry::Get(this);
+
+	if (InteractableRegistry == NULL) {
+		return NULL;
 	}
 
+	// Facing follows the view, so players pick up what they look at
+	const float MinFacingDot = FMath::Cos(FMath::DegreesToRadians(InteractionAngle));
+
+	return Cast<ASWeaponPickup>(InteractableRegistry->FindNearest(GetActorLocation(), GetBaseAimRotation().Vector(), InteractionReach, MinFacingDot, ASWeaponPickup::StaticClass()));
+
+}
+
+void ASCharacter::UpdateNearbyWeaponPickup()
+{
+	// Frozen pickups in range become actors before the character reaches them
+	ASPickupInstanceManager::ThawNear(this, GetActorLocation());
+
+	ASWeaponPickup* WeaponPickup = FindInteractableWeaponPickup();
+
+	// Character came close to another pickup, start streaming in its weapon
+	if (WeaponPickup != NULL && WeaponPickup != NearbyWeaponPickup.Get()) {
+		WeaponPickup->RequestWeaponClass();
+	}
+
+	NearbyWeaponPickup = WeaponPickup;
+
 }
 
 void ASCharacter::CameraX(float Value)
 {
-	TurnX = Value;
+	InputFrame.CameraX = Value;
+
+	// Turning in place happens without tick
+	if (TurnX != Value) {
+		TurnX = Value;
+
+		UpdateReplicatedAnimInputs();
+	}
 
 	AddControllerYawInput(Value); // Control camera component horizontally
 
@@ -300,6 +642,8 @@ void ASCharacter::CameraX(float Value)
 
 void ASCharacter::CameraY(float Value)
 {
+	InputFrame.CameraY = Value;
+
 	AddControllerPitchInput(Value); // Control camera component vertically
 
 }
@@ -323,75 +667,328 @@ void ASCharacter::CalculateCharacterMovementDirection(float InputX, float InputY
 
 }
 
-void ASCharacter::Interaction_PrimaryWeapon()
+void ASCharacter::StartAimTransition()
+{
+#if DARKHOURS_WITH_COSMETICS
+	// Nothing looks through the camera of a dedicated server
+	if (IsNetMode(NM_DedicatedServer)) {
+		return;
+	}
+
+	// Camera lag is off while aiming, so the camera sticks to the aim point
+	SpringArmComp->bEnableCameraLag = !bIsAiming;
+	SpringArmComp->bEnableCameraRotationLag = !bIsAiming;
+
+	if (IsLocallyControlled()) {
+		bIsAimTransitionActive = true;
+
+		UpdateTickEnabled();
+	}
+	else { // Nobody looks through this camera - skip the transition
+		CameraComp->SetFieldOfView(bIsAiming ? AimFOV : DefaultFOV);
+		SpringArmComp->SocketOffset = bIsAiming ? AimSocketOffset : DefaultSocketOffset;
+	}
+#endif
+
+}
+
+void ASCharacter::UpdateAimTransition(float DeltaTime)
+{
+	const float TargetFOV = bIsAiming ? AimFOV : DefaultFOV;
+	const FVector TargetSocketOffset = bIsAiming ? AimSocketOffset : DefaultSocketOffset;
+
+	// Interpolate FOV and camera offset toward the aim state
+	CameraComp->SetFieldOfView(FMath::FInterpTo(CameraComp->FieldOfView, TargetFOV, DeltaTime, FOVInterpSpeed));
+	SpringArmComp->SocketOffset = FMath::VInterpTo(SpringArmComp->SocketOffset, TargetSocketOffset, DeltaTime, SocketOffsetInterpSpeed);
+
+	// Snap to the target and stop once converged
+	if (FMath::IsNearlyEqual(CameraComp->FieldOfView, TargetFOV, 0.05f) && SpringArmComp->SocketOffset.Equals(TargetSocketOffset, 0.1f)) {
+		CameraComp->SetFieldOfView(TargetFOV);
+		SpringArmComp->SocketOffset = TargetSocketOffset;
+
+		bIsAimTransitionActive = false;
+	}
+
+}
+
+bool ASCharacter::HasMovementInput() const
 {
-	// Holds the weapon that this character las posessed - if valid (character had picked up and possessed one)
-	ASWeapon* LastPossessedWeapon = NULL;
+	return InputX != 0.f || InputY != 0.f;
+
+}
 
-	// Holds the weapon pickup ref that the character last overlapped
-	ASWeaponPickup * LastWeaponPickupOverlapped = NULL;
+void ASCharacter::UpdateReplicatedAnimInputs()
+{
+	if (!IsLocallyControlled() || GetNetMode() == NM_Standalone) {
+		return;
+	}
 
-	// Drop location of the dropped weapon
-	FVector DropLocation;
+	FSReplicatedAnimInputs NewAnimInputs;
+	NewAnimInputs.InputX = InputX;
+	NewAnimInputs.InputY = InputY;
+	NewAnimInputs.TurnX = TurnX;
+	NewAnimInputs.MovementDirection = MovementDirection;
+	NewAnimInputs.bIsSprinting = bIsSprinting;
+	NewAnimInputs.bIsAiming = bIsAiming;
+	NewAnimInputs.Quantize();
+
+	// Only send what remote machines can tell apart
+	if (NewAnimInputs == ReplicatedAnimInputs) {
+		return;
+	}
 
-	FHitResult TraceHit;
-	FCollisionQueryParams TraceInfos;
-	TraceInfos.bTraceComplex = true;
-	TraceInfos.AddIgnoredActor(this);
+	ReplicatedAnimInputs = NewAnimInputs;
 
-	GetWorld()->LineTraceSingleByChannel(TraceHit, GetActorLocation(), GetActorLocation() + GetActorForwardVector() * 80.f, ECC_WorldStatic, TraceInfos);
+	if (Role < ROLE_Authority) {
+		ServerSetAnimInputs(NewAnimInputs);
 
-	if (TraceHit.bBlockingHit) {
-		DropLocation = TraceHit.ImpactPoint + (TraceHit.ImpactNormal * 5.f) + FVector(0.f, 20.f, 80.f);
+		if (!GetWorldTimerManager().IsTimerActive(AnimInputsResendTimerHandle)) {
+			GetWorldTimerManager().SetTimer(AnimInputsResendTimerHandle, this, &ASCharacter::ResendAnimInputs, AnimInputsResendInterval, true);
+		}
+	}
+
+}
+
+void ASCharacter::ResendAnimInputs()
+{
+	if (Role < ROLE_Authority && IsLocallyControlled()) {
+		ServerSetAnimInputs(ReplicatedAnimInputs);
 	}
 	else {
-		DropLocation = TraceHit.TraceEnd + FVector(0.f, 20.f, 80.f);
+		GetWorldTimerManager().ClearTimer(AnimInputsResendTimerHandle);
 	}
 
-	// Spawn informations and parameters
-	FActorSpawnParameters SpawnInfos;
-	SpawnInfos.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn; // Always spawn, but ignore collision
+}
 
-	if (OverlappedWeaponPickup != NULL) {
-		LastWeaponPickupOverlapped = OverlappedWeaponPickup; // Assign ref using the last overlapped weapon pickup
+void ASCharacter::ServerSetAnimInputs_Implementation(FSReplicatedAnimInputs NewAnimInputs)
+{
+	ReplicatedAnimInputs = NewAnimInputs;
 
-		if (PrimaryWeapon != NULL) {
-			LastPossessedWeapon = Cast<ASWeapon>(PrimaryWeapon); // Assign ref using the last possess primary weapon - if valid
+}
 
-			PrimaryWeapon->Destroy(); // Destroy the last primary weapon on character holding socket - to drop it
+bool ASCharacter::ServerSetAnimInputs_Validate(FSReplicatedAnimInputs NewAnimInputs)
+{
+	return true;
 
-			// Spawn the new primary weapon from weapon class of the overlapped weapon pickup
-			PrimaryWeapon = GetWorld()->SpawnActor<ASRifleWeapon>(OverlappedWeaponPickup->PendingPickupWeaponClass, GetMesh()->GetSocketTransform(PrimaryHolsterSocketName), SpawnInfos);
+}
 
-			// Attach the new primary weapon to the character holster socket
-			PrimaryWeapon->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, PrimaryHolsterSocketName);
+void ASCharacter::OnRep_ReplicatedAnimInputs()
+{
+	bIsSprinting = ReplicatedAnimInputs.bIsSprinting;
+	bIsAiming = ReplicatedAnimInputs.bIsAiming;
 
-			if (LastPossessedWeapon->WeaponPickupClass != NULL) {
-				// Spawn the pickup actor of the last possessed weapon
-				ASWeaponPickup* WeaponPickup = GetWorld()->SpawnActor<ASWeaponPickup>(LastPossessedWeapon->WeaponPickupClass, DropLocation, FRotator::ZeroRotator, SpawnInfos);
+}
 
-				if (WeaponPickup != NULL) {
-					UStaticMeshComponent* WeaponPickupMeshComp = WeaponPickup->GetMeshComponent(); // Access the mesh the pickup actor of the last weapon
+const FSReplicatedAnimInputs& ASCharacter::GetReplicatedAnimInputs() const
+{
+	return ReplicatedAnimInputs;
 
-					if (WeaponPickupMeshComp != NULL) {
-						WeaponPickupMeshComp->AddTorqueInRadians(FVector(1.f) * 4000.f); // Flip when dropped using torque force
-					}
-				}
-			}
+}
+
+void ASCharacter::UpdateTickEnabled()
+{
+	const bool bShouldTick = bTickInBlueprint || HasMovementInput() || bIsAimTransitionActive;
+
+	if (bShouldTick != IsActorTickEnabled()) {
+		SetActorTickEnabled(bShouldTick);
+	}
+
+}
+
+void ASCharacter::ConfigureForDedicatedServer()
+{
+	// Camera rig is only looked through on clients - no spring arm collision traces
+	SpringArmComp->bDoCollisionTest = false;
+	SpringArmComp->SetComponentTickEnabled(false);
+	CameraComp->SetComponentTickEnabled(false);
+
+	// Nothing renders on the server, but hit detection needs bones - keep the pose and drop what only shows on screen
+	USkeletalMeshComponent* MeshComp = GetMesh();
+
+	MeshComp->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+	MeshComp->bEnableUpdateRateOptimizations = true;
+	MeshComp->bDisableClothSimulation = true;
+	MeshComp->bDisableMorphTarget = true;
+
+}
+
+void ASCharacter::StartRagdoll(const FVector& Impulse, const FVector& ImpulseLocation)
+{
+	// Nothing moves or blocks through the capsule anymore
+	GetCharacterMovement()->DisableMovement();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+#if DARKHOURS_WITH_COSMETICS
+	// Nobody watches ragdolls on a dedicated server
+	if (IsNetMode(NM_DedicatedServer)) {
+		return;
+	}
 
-			LastWeaponPickupOverlapped->Destroy(); // Destroy the last overlapped weapon pickup, as the character chose to pickup the new weapon
+	USkeletalMeshComponent* MeshComp = GetMesh();
+
+	MeshComp->SetCollisionProfileName(TEXT("Ragdoll"));
+	MeshComp->SetSimulatePhysics(true);
+	MeshComp->AddImpulseAtLocation(Impulse, ImpulseLocation);
+
+	ASPhysicsBudgetManager::RegisterRagdoll(MeshComp);
+#endif
+
+}
+
+USCharacterMovementComponent* ASCharacter::GetSCharacterMovement() const
+{
+	return CastChecked<USCharacterMovementComponent>(GetCharacterMovement());
+
+}
+
+ASRifleWeapon* ASCharacter::GetPrimaryWeapon() const
+{
+	return Cast<ASRifleWeapon>(InventoryComp->GetWeapon(ESInventorySlot::Primary));
+
+}
+
+FName ASCharacter::GetHolsterSocketName(ESInventorySlot Slot) const
+{
+	return Slot == ESInventorySlot::Primary ? PrimaryHolsterSocketName : SecondaryHolsterSocketName;
+
+}
+
+const FSInputFrame& ASCharacter::GetInputFrame() const
+{
+	return InputFrame;
+
+}
+
+void ASCharacter::ClearPressedInputActions()
+{
+	InputFrame.PressedActions = 0;
+
+}
+
+void ASCharacter::ApplyInputFrame(const FSInputFrame& Frame, const FSInputFrame& PreviousFrame)
+{
+	// Recorded control rotation instead of the camera axes, which only turn player controllers
+	if (Controller != NULL) {
+		Controller->SetControlRotation(Frame.GetControlRotation());
+	}
+
+	MoveX(Frame.GetMoveX());
+	MoveY(Frame.GetMoveY());
+
+	CameraX(Frame.CameraX);
+	CameraY(Frame.CameraY);
+
+	// Presses before releases - a tap within one frame does both
+	if (Frame.WasPressed(ESInputAction::Sprint)) {
+		SprintStart();
+	}
+
+	if (Frame.WasPressed(ESInputAction::Crouch)) {
+		ToggleCrouch();
+	}
+
+	if (Frame.WasPressed(ESInputAction::Jump)) {
+		JumpStart();
+	}
+
+	if (Frame.WasPressed(ESInputAction::Aim)) {
+		AimStart();
+	}
+
+	if (Frame.WasPressed(ESInputAction::Interact)) {
+		Interact();
+	}
+
+	if (!Frame.IsHeld(ESInputAction::Sprint) && (PreviousFrame.IsHeld(ESInputAction::Sprint) || Frame.WasPressed(ESInputAction::Sprint))) {
+		SprintEnd();
+	}
+
+	if (!Frame.IsHeld(ESInputAction::Jump) && (PreviousFrame.IsHeld(ESInputAction::Jump) || Frame.WasPressed(ESInputAction::Jump))) {
+		JumpEnd();
+	}
+
+	if (!Frame.IsHeld(ESInputAction::Aim) && (PreviousFrame.IsHeld(ESInputAction::Aim) || Frame.WasPressed(ESInputAction::Aim))) {
+		AimEnd();
+	}
+
+}
+
+ASWeaponPickup* ASCharacter::Interaction_PrimaryWeapon(ASWeaponPickup* WeaponPickup)
+{
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_Interaction, Interaction);
+	INC_DWORD_STAT(STAT_DarkHours_NumInteractions);
+
+	if (WeaponPickup == NULL || !HasAuthority()) {
+		return NULL;
+	}
+
+	// Weapon class is streamed in before Interact gets here, it only loads here when called directly
+	UClass* WeaponClass = WeaponPickup->GetLoadedWeaponClass();
+
+	if (WeaponClass == NULL) {
+		WeaponClass = WeaponPickup->WeaponClass.LoadSynchronous();
+	}
+
+	if (WeaponClass == NULL || !WeaponClass->IsChildOf(ASRifleWeapon::StaticClass())) {
+		return NULL;
+	}
+
+	// Holds the slot of the weapon that this character las posessed - if valid (character had picked up and possessed one)
+	const FSInventorySlot* LastPrimarySlot = InventoryComp->FindSlot(ESInventorySlot::Primary);
+
+	UClass* LastWeaponClass = LastPrimarySlot != NULL ? *LastPrimarySlot->WeaponClass : NULL;
+	const int32 LastAmmo = LastPrimarySlot != NULL ? LastPrimarySlot->Ammo : 0;
+
+	// Holds the pickup of the weapon this character drops
+	ASWeaponPickup* DroppedWeaponPickup = NULL;
+
+	// Put the weapon of the pickup into the primary slot, it keeps the ammo left in the pickup - the last primary weapon goes back into the pool
+	InventoryComp->SetSlot(ESInventorySlot::Primary, WeaponClass, WeaponPickup->UpdateAmmo);
+
+	// Pickup class of the last possessed weapon
+	UClass* DropPickupClass = LastWeaponClass != NULL ? LastWeaponClass->GetDefaultObject<ASWeapon>()->LoadPickupClass() : NULL;
+
+	if (DropPickupClass != NULL) {
+		// Drop location of the dropped weapon
+		FVector DropLocation;
+
+		FHitResult TraceHit;
+		FCollisionQueryParams TraceInfos;
+		TraceInfos.bTraceComplex = true;
+		TraceInfos.AddIgnoredActor(this);
+
+		GetWorld()->LineTraceSingleByChannel(TraceHit, GetActorLocation(), GetActorLocation() + GetActorForwardVector() * 80.f, ECC_WorldStatic, TraceInfos);
+
+		if (TraceHit.bBlockingHit) {
+			DropLocation = TraceHit.ImpactPoint + (TraceHit.ImpactNormal * 5.f) + FVector(0.f, 20.f, 80.f);
+		}
+		else {
+			DropLocation = TraceHit.TraceEnd + FVector(0.f, 20.f, 80.f);
 		}
-		else { // When character has no primary weapon in possession
-			if (OverlappedWeaponPickup->PendingPickupWeaponClass != NULL) {
-				// Spawn primary weapon using weapon class from overlapped weapon pickup
-				PrimaryWeapon = GetWorld()->SpawnActor<ASRifleWeapon>(OverlappedWeaponPickup->PendingPickupWeaponClass, GetMesh()->GetSocketTransform(PrimaryHolsterSocketName), SpawnInfos);
 
-				// Attach the spawned primary weapon to holster socket
-				PrimaryWeapon->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, PrimaryHolsterSocketName);
+		// Take the pickup of the last possessed weapon out of the pool, it keeps the ammo left in the weapon
+		DroppedWeaponPickup = ASActorPool::Acquire<ASWeaponPickup>(this, DropPickupClass, FTransform(FRotator::ZeroRotator, DropLocation));
+
+		if (DroppedWeaponPickup != NULL) {
+			DroppedWeaponPickup->UpdateAmmo = LastAmmo;
+
+			UStaticMeshComponent* WeaponPickupMeshComp = DroppedWeaponPickup->GetMeshComponent(); // Access the mesh the pickup actor of the last weapon
 
-				OverlappedWeaponPickup->Destroy(); // Destroy the overlapped weapon pickup, as the character chose to pickup weapon
+#if DARKHOURS_WITH_COSMETICS
+			if (WeaponPickupMeshComp != NULL && !IsNetMode(NM_DedicatedServer)) {
+				WeaponPickupMeshComp->AddTorqueInRadians(FVector(1.f) * 4000.f); // Flip when dropped using torque force
 			}
+#endif
 		}
 	}
 
+	if (NearbyWeaponPickup.Get() == WeaponPickup) {
+		NearbyWeaponPickup.Reset();
+	}
+
+	ASActorPool::ReleaseActor(WeaponPickup); // Put the weapon pickup back into the pool, as the character chose to pickup the weapon
+
+	return DroppedWeaponPickup;
+
 }
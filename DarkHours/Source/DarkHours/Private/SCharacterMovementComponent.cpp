@@ -0,0 +1,194 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SCharacterMovementComponent.h"
+#include "DarkHours.h"
+#include "GameFramework/Character.h"
+
+// Sets default values
+USCharacterMovementComponent::USCharacterMovementComponent()
+{
+	// Variables
+	bWantsToSprint = false;
+	bWantsToAim = false;
+
+	SprintSpeedMultiplier = 2.f;
+	AimSpeedMultiplier = 1.f;
+
+	NumCorrections = 0;
+
+}
+
+float USCharacterMovementComponent::GetMaxSpeed() const
+{
+	float MaxSpeed = Super::GetMaxSpeed();
+
+	// Crouching already has its own speed
+	if (MovementMode == MOVE_Walking && !IsCrouching()) {
+		if (bWantsToSprint) {
+			MaxSpeed *= SprintSpeedMultiplier;
+		}
+
+		if (bWantsToAim) {
+			MaxSpeed *= AimSpeedMultiplier;
+		}
+	}
+
+	return MaxSpeed;
+
+}
+
+void USCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	bWantsToAim = (Flags & FSavedMove_Character::FLAG_Custom_1) != 0;
+
+}
+
+FNetworkPredictionData_Client* USCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == NULL) {
+		USCharacterMovementComponent* MutableThis = const_cast<USCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FSNetworkPredictionData_Client_Character(*this);
+	}
+
+	return ClientPredictionData;
+
+}
+
+void USCharacterMovementComponent::SetSprinting(bool bSprinting)
+{
+	bWantsToSprint = bSprinting;
+
+}
+
+void USCharacterMovementComponent::SetAiming(bool bAiming)
+{
+	bWantsToAim = bAiming;
+
+}
+
+int32 USCharacterMovementComponent::GetNumCorrections() const
+{
+	return NumCorrections;
+
+}
+
+void USCharacterMovementComponent::ResetCorrections()
+{
+	NumCorrections = 0;
+
+}
+
+void USCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	// Part of the move, so the server faces the character the same way
+	bOrientRotationToMovement = !bWantsToAim;
+
+	if (CharacterOwner != NULL) {
+		CharacterOwner->bUseControllerRotationYaw = bWantsToAim;
+	}
+
+}
+
+void USCharacterMovementComponent::ServerMoveHandleClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	Super::ServerMoveHandleClientError(ClientTimeStamp, DeltaTime, Accel, RelativeClientLocation, ClientMovementBase, ClientBaseBoneName, ClientMovementMode);
+
+	const FNetworkPredictionData_Server_Character* ServerData = GetPredictionData_Server_Character();
+
+	// An adjustment for this move is on its way to the client
+	if (ServerData != NULL && ServerData->PendingAdjustment.TimeStamp == ClientTimeStamp && !ServerData->PendingAdjustment.bAckGoodMove) {
+		INC_DWORD_STAT(STAT_DarkHours_NumMoveCorrections);
+
+		NumCorrections++;
+	}
+
+}
+
+void USCharacterMovementComponent::ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
+{
+	NumCorrections++;
+
+	Super::ClientAdjustPosition_Implementation(TimeStamp, NewLoc, NewVel, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
+
+}
+
+void FSSavedMove_Character::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToSprint = false;
+	bSavedWantsToAim = false;
+
+}
+
+uint8 FSSavedMove_Character::GetCompressedFlags() const
+{
+	uint8 Flags = Super::GetCompressedFlags();
+
+	if (bSavedWantsToSprint) {
+		Flags |= FLAG_Custom_0;
+	}
+
+	if (bSavedWantsToAim) {
+		Flags |= FLAG_Custom_1;
+	}
+
+	return Flags;
+
+}
+
+bool FSSavedMove_Character::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSSavedMove_Character* NewSavedMove = static_cast<const FSSavedMove_Character*>(NewMove.Get());
+
+	// Moves only combine while sprint and aim stay the same
+	if (bSavedWantsToSprint != NewSavedMove->bSavedWantsToSprint || bSavedWantsToAim != NewSavedMove->bSavedWantsToAim) {
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+
+}
+
+void FSSavedMove_Character::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+
+	const USCharacterMovementComponent* MovementComp = Cast<USCharacterMovementComponent>(Character->GetCharacterMovement());
+
+	if (MovementComp != NULL) {
+		bSavedWantsToSprint = MovementComp->bWantsToSprint;
+		bSavedWantsToAim = MovementComp->bWantsToAim;
+	}
+
+}
+
+void FSSavedMove_Character::PrepMoveFor(ACharacter* Character)
+{
+	Super::PrepMoveFor(Character);
+
+	// Replayed moves after a correction use the state they were made with
+	USCharacterMovementComponent* MovementComp = Cast<USCharacterMovementComponent>(Character->GetCharacterMovement());
+
+	if (MovementComp != NULL) {
+		MovementComp->bWantsToSprint = bSavedWantsToSprint;
+		MovementComp->bWantsToAim = bSavedWantsToAim;
+	}
+
+}
+
+FSNetworkPredictionData_Client_Character::FSNetworkPredictionData_Client_Character(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FSNetworkPredictionData_Client_Character::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSSavedMove_Character());
+
+}
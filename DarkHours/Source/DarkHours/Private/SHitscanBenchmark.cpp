@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SHitscanBenchmark.h"
+#include "DarkHours.h"
+#include "SHitscanFireSystem.h"
+#include "SRifleWeapon.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static void StartHitscanBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	ASHitscanBenchmark* Benchmark = Cast<ASHitscanBenchmark>(ASBenchmark::Start(World, ASHitscanBenchmark::StaticClass()));
+
+	if (Benchmark != NULL) {
+		if (Args.Num() > 0) {
+			Benchmark->NumWeapons = FMath::Max(FCString::Atoi(*Args[0]), 1);
+		}
+
+		if (Args.Num() > 1) {
+			Benchmark->FireRate = FMath::Max(FCString::Atof(*Args[1]), 0.f);
+		}
+
+		if (Args.Num() > 2) {
+			Benchmark->WeaponClass = LoadClass<ASRifleWeapon>(NULL, *Args[2]);
+		}
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs HitscanBenchmarkCommand(
+	TEXT("DarkHours.Bench.Hitscan"),
+	TEXT("Measures shots resolved per millisecond with synchronous and batched async hitscan traces. Args: [NumWeapons] [FireRate] [WeaponClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartHitscanBenchmark));
+
+// Sets default values
+ASHitscanBenchmark::ASHitscanBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("Hitscan");
+	NumPasses = 2;
+	NumWeapons = 256;
+	FireRate = 600.f;
+
+	FrameSeconds = 0.0;
+	bSampling = false;
+	bWasAsyncEnabled = true;
+
+}
+
+void ASHitscanBenchmark::BeginPass(int32 PassIndex)
+{
+	if (PassIndex == 0) {
+		IConsoleVariable* AsyncVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Hitscan.Async"));
+		bWasAsyncEnabled = AsyncVar == NULL || AsyncVar->GetInt() != 0;
+
+		if (WeaponClass == NULL) {
+			WeaponClass = LoadClass<ASRifleWeapon>(NULL, TEXT("/Game/Blueprints/Weapons/Primary/BP_AR4.BP_AR4_C"));
+		}
+
+		if (WeaponClass == NULL) {
+			WeaponClass = ASRifleWeapon::StaticClass();
+		}
+
+		FActorSpawnParameters SpawnInfos;
+		SpawnInfos.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		// Rifles without owner aim along their own rotation - point them down at the ground in front
+		for (int32 Index = 0; Index < NumWeapons; Index++) {
+			ASRifleWeapon* Weapon = GetWorld()->SpawnActor<ASRifleWeapon>(WeaponClass, GetGridLocation(Index, 16, 100.f), FRotator(-15.f, 0.f, 0.f), SpawnInfos);
+
+			if (Weapon != NULL) {
+				if (FireRate > 0.f) {
+					Weapon->FireRate = FireRate;
+				}
+
+				Weapons.Add(Weapon);
+			}
+		}
+	}
+
+	// Pass 0 traces every shot synchronously, pass 1 batches async traces
+	SetAsyncEnabled(PassIndex > 0);
+
+	FrameSeconds = 0.0;
+	bSampling = false;
+
+	for (ASRifleWeapon* Weapon : Weapons) {
+		Weapon->StartFire();
+	}
+
+}
+
+void ASHitscanBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	ASHitscanFireSystem* FireSystem = ASHitscanFireSystem::Get(this);
+
+	if (!bSampling && FireSystem != NULL) { // Only count the sampled frames
+		FireSystem->ResetCounters();
+		bSampling = true;
+	}
+
+	FrameSeconds += DeltaTime;
+
+	// Never run dry
+	for (ASRifleWeapon* Weapon : Weapons) {
+		Weapon->UpdateAmmo = Weapon->ClipSize + 1000;
+	}
+
+}
+
+void ASHitscanBenchmark::EndPass(int32 PassIndex)
+{
+	const FString PassName = PassIndex == 0 ? TEXT("Sync") : TEXT("Async");
+
+	ASHitscanFireSystem* FireSystem = ASHitscanFireSystem::Get(this);
+
+	const int32 NumShots = FireSystem != NULL ? FireSystem->GetNumResolvedShots() : 0;
+	const double ResolveMs = FireSystem != NULL ? FireSystem->GetResolveSeconds() * 1000.0 : 0.0;
+
+	AddResult(PassName + TEXT(".Shots"), NumShots);
+	AddResult(PassName + TEXT(".ResolveMs"), ResolveMs);
+	AddResult(PassName + TEXT(".ShotsPerMs"), ResolveMs > 0.0 ? NumShots / ResolveMs : 0.0);
+	AddResult(PassName + TEXT(".AvgFrameMs"), SampleFrames > 0 ? FrameSeconds * 1000.0 / SampleFrames : 0.0);
+
+	for (ASRifleWeapon* Weapon : Weapons) {
+		Weapon->StopFire();
+	}
+
+	if (PassIndex == NumPasses - 1) {
+		DestroyWeapons();
+		SetAsyncEnabled(bWasAsyncEnabled);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASHitscanBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DestroyWeapons();
+	SetAsyncEnabled(bWasAsyncEnabled);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASHitscanBenchmark::DestroyWeapons()
+{
+	for (ASRifleWeapon* Weapon : Weapons) {
+		if (Weapon != NULL && !Weapon->IsPendingKill()) {
+			Weapon->Destroy();
+		}
+	}
+
+	Weapons.Reset();
+
+}
+
+void ASHitscanBenchmark::SetAsyncEnabled(bool bEnabled)
+{
+	IConsoleVariable* AsyncVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Hitscan.Async"));
+
+	if (AsyncVar != NULL) {
+		AsyncVar->Set(bEnabled ? 1 : 0, ECVF_SetByCode);
+	}
+
+}
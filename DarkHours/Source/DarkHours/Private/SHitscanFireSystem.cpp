@@ -0,0 +1,292 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SHitscanFireSystem.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "SLagCompensationManager.h"
+#include "SProjectileManager.h"
+#include "SRifleWeapon.h"
+#include "SWorldManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Kismet/GameplayStatics.h"
+
+static TAutoConsoleVariable<int32> CVarHitscanAsync(
+	TEXT("DarkHours.Hitscan.Async"),
+	1,
+	TEXT("1: trace queued shots as one batch of async traces, resolved the next frame. 0: trace every shot synchronously."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarHitscanLagCompensation(
+	TEXT("DarkHours.Hitscan.LagCompensation"),
+	1,
+	TEXT("1: shots of remote players hit characters where the shooter saw them. 0: shots hit characters where they are on the server."),
+	ECVF_Default);
+
+static FCollisionQueryParams GetShotQueryParams(const ASRifleWeapon* Weapon)
+{
+	FCollisionQueryParams TraceInfos(SCENE_QUERY_STAT(DarkHoursHitscan), true, Weapon);
+	TraceInfos.AddIgnoredActor(Weapon->GetOwner());
+	TraceInfos.bReturnPhysicalMaterial = true;
+	TraceInfos.bTraceAsyncScene = true; // Cosmetic destructibles simulate in the async scene
+
+	return TraceInfos;
+
+}
+
+// Sets default values
+ASHitscanFireSystem::ASHitscanFireSystem()
+{
+	// Resolve after the weapons queued their shots for the frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = false;
+
+	// Variables
+	MaxQueuedShots = 1024;
+	TraceChannel = ECC_Visibility;
+
+	NumResolvedShots = 0;
+	ResolveSeconds = 0.0;
+
+}
+
+ASHitscanFireSystem* ASHitscanFireSystem::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASHitscanFireSystem>(WorldContextObject);
+
+}
+
+// Called when the game starts or when spawned
+void ASHitscanFireSystem::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Allocate the buffers once
+	QueuedShots.Reserve(MaxQueuedShots);
+	InFlightShots.Reserve(MaxQueuedShots);
+	TraceDatum.OutHits.Reserve(1);
+
+	SpreadStream.GenerateNewSeed();
+
+}
+
+bool ASHitscanFireSystem::QueueShot(ASRifleWeapon* Weapon, const FVector& Start, const FVector& Direction)
+{
+	if (Weapon == NULL || QueuedShots.Num() >= MaxQueuedShots) {
+		INC_DWORD_STAT(STAT_DarkHours_NumDroppedShots);
+		return false;
+	}
+
+	FSHitscanShot& Shot = QueuedShots.AddDefaulted_GetRef();
+	Shot.Weapon = Weapon;
+	Shot.Owner = Weapon->GetOwner();
+	Shot.InstigatorController = Weapon->GetInstigatorController();
+	Shot.Start = Start;
+	Shot.Direction = Direction;
+	Shot.bRewind = false;
+	Shot.RewindTargetTime = 0.f;
+
+	return true;
+
+}
+
+// Called every frame
+void ASHitscanFireSystem::Tick(float DeltaTime)
+{
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_HitscanResolve, HitscanResolve);
+
+	Super::Tick(DeltaTime);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	ResolveInFlightShots();
+	SubmitQueuedShots();
+
+	ResolveSeconds += FPlatformTime::Seconds() - StartTime;
+
+}
+
+void ASHitscanFireSystem::ResolveInFlightShots()
+{
+	UWorld* World = GetWorld();
+
+	for (const FSHitscanShot& Shot : InFlightShots) {
+		if (World->QueryTraceData(Shot.TraceHandle, TraceDatum) && TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit) {
+			ResolveShot(Shot, true, TraceDatum.OutHits[0]);
+		}
+		else {
+			ResolveShot(Shot, false, FHitResult());
+		}
+	}
+
+	NumResolvedShots += InFlightShots.Num();
+
+	InFlightShots.Reset();
+
+}
+
+void ASHitscanFireSystem::SubmitQueuedShots()
+{
+	UWorld* World = GetWorld();
+	const bool bAsync = CVarHitscanAsync.GetValueOnGameThread() != 0;
+
+	FHitResult Hit;
+
+	// Only looked up once a weapon with ballistics fires
+	ASProjectileManager* ProjectileManager = NULL;
+
+	// Only the server rewinds, for the shots of remote players
+	ASLagCompensationManager* LagCompensationManager = CVarHitscanLagCompensation.GetValueOnGameThread() != 0 && GetNetMode() < NM_Client ? GetWorldManager<ASLagCompensationManager>(this, false) : NULL;
+
+	for (FSHitscanShot& Shot : QueuedShots) {
+		ASRifleWeapon* Weapon = Shot.Weapon.Get();
+
+		// Weapon was destroyed or pooled since it queued the shot
+		if (Weapon == NULL || Weapon->NumPendingShots <= 0) {
+			continue;
+		}
+
+		Weapon->NumPendingShots--;
+
+		// Ammo ran out earlier in the batch
+		if (Weapon->UpdateAmmo <= 0) {
+			continue;
+		}
+
+		Weapon->ConsumeAmmo();
+
+		const FVector Direction = SpreadStream.VRandCone(Shot.Direction, FMath::DegreesToRadians(Weapon->GetSpreadAngle()));
+		const FVector End = Shot.Start + Direction * Weapon->Range;
+		Shot.Direction = Direction;
+		Shot.End = End;
+		const float RewindTime = LagCompensationManager != NULL ? LagCompensationManager->GetRewindTime(Weapon) : 0.f;
+		Shot.bRewind = RewindTime > 0.f;
+		Shot.RewindTargetTime = World->GetTimeSeconds() - RewindTime;
+
+		INC_DWORD_STAT(STAT_DarkHours_NumShots);
+
+		// Rounds with ballistics are handed to the projectile manager instead of being traced
+		if (Weapon->Ballistics.bSimulateBallistics) {
+			if (ProjectileManager == NULL) {
+				ProjectileManager = ASProjectileManager::Get(this);
+			}
+
+			if (ProjectileManager != NULL) {
+				ProjectileManager->AddRound(Weapon, Shot.Start, Direction);
+			}
+
+			NumResolvedShots++;
+			continue;
+		}
+
+		const FCollisionQueryParams TraceInfos = GetShotQueryParams(Weapon);
+
+		if (bAsync) {
+			Shot.TraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Shot.Start, End, TraceChannel, TraceInfos);
+			InFlightShots.Add(Shot);
+		}
+		else {
+			const bool bHit = World->LineTraceSingleByChannel(Hit, Shot.Start, End, TraceChannel, TraceInfos);
+
+			ResolveShot(Shot, bHit, Hit);
+
+			NumResolvedShots++;
+		}
+	}
+
+	QueuedShots.Reset();
+
+}
+
+void ASHitscanFireSystem::ResolveShot(const FSHitscanShot& Shot, bool bHit, const FHitResult& Hit)
+{
+	const ASRifleWeapon* Weapon = Shot.Weapon.Get();
+
+	// Weapon went back to the pool or changed hands while the trace was in flight
+	if (Weapon == NULL || Weapon->bHidden || Weapon->GetOwner() != Shot.Owner.Get()) {
+		return;
+	}
+
+	ASLagCompensationManager* LagCompensationManager = Shot.bRewind ? GetWorldManager<ASLagCompensationManager>(this, false) : NULL;
+
+	if (LagCompensationManager == NULL) {
+		if (bHit) {
+			ApplyHit(Shot, Hit);
+		}
+
+		return;
+	}
+
+	// Where recorded characters are now does not count, only where the shooter saw them - everything else is hit live
+	const bool bLiveCharacterHit = bHit && LagCompensationManager->IsRecorded(Cast<ASCharacter>(Hit.GetActor()));
+
+	FSRewindHit RewindHit;
+	const bool bRewindHit = LagCompensationManager->RewindTrace(Shot.Start, Shot.End, Shot.RewindTargetTime, Weapon->GetOwner(), RewindHit);
+
+	// The live trace stopped at a character, what else stands in the way is traced again without the characters -
+	// up to the rewound hit, or the whole shot for the world behind the character
+	FHitResult WorldHit = Hit;
+	bool bWorldHit = bHit && !bLiveCharacterHit;
+
+	if (bLiveCharacterHit) {
+		FCollisionQueryParams TraceInfos = GetShotQueryParams(Weapon);
+		LagCompensationManager->IgnoreRecordedCharacters(TraceInfos);
+
+		bWorldHit = GetWorld()->LineTraceSingleByChannel(WorldHit, Shot.Start, bRewindHit ? RewindHit.Location : Shot.End, TraceChannel, TraceInfos);
+	}
+
+	if (bRewindHit && (!bWorldHit || RewindHit.Distance < WorldHit.Distance)) {
+		FHitResult CharacterHit(RewindHit.Character, RewindHit.Character->GetMesh(), RewindHit.Location, -Shot.Direction);
+		CharacterHit.BoneName = RewindHit.BoneName;
+		CharacterHit.Distance = RewindHit.Distance;
+		CharacterHit.TraceStart = Shot.Start;
+		CharacterHit.TraceEnd = Shot.End;
+
+		ApplyHit(Shot, CharacterHit);
+	}
+	else if (bWorldHit) {
+		ApplyHit(Shot, WorldHit);
+	}
+
+}
+
+void ASHitscanFireSystem::ApplyHit(const FSHitscanShot& Shot, const FHitResult& Hit)
+{
+	ASRifleWeapon* Weapon = Shot.Weapon.Get();
+	AActor* HitActor = Hit.GetActor();
+
+	if (Weapon == NULL) {
+		return;
+	}
+
+	Weapon->PlayImpactEffects(Hit);
+
+	// Shots of a client only show where they hit, the server deals the damage
+	if (HitActor != NULL && Weapon->HasFireAuthority()) {
+		UGameplayStatics::ApplyPointDamage(HitActor, Weapon->Damage, Shot.Direction, Hit, Shot.InstigatorController.Get(), Weapon, Weapon->DamageType);
+	}
+
+}
+
+int32 ASHitscanFireSystem::GetNumResolvedShots() const
+{
+	return NumResolvedShots;
+
+}
+
+double ASHitscanFireSystem::GetResolveSeconds() const
+{
+	return ResolveSeconds;
+
+}
+
+void ASHitscanFireSystem::ResetCounters()
+{
+	NumResolvedShots = 0;
+	ResolveSeconds = 0.0;
+
+}
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SImpactEffectsData.h"
+
+// Sets default values
+USImpactEffectsData::USImpactEffectsData()
+{
+	// Variables
+	MaxParticlesPerSurface = 32;
+	MaxDecalsPerSurface = 64;
+	MaxSoundsPerSurface = 16;
+	MaxNewComponentsPerFrame = 8;
+	MaxImpactsPerFrame = 32;
+	MaxDistance = 8000.f;
+
+}
+
+const FSImpactEffect& USImpactEffectsData::GetEffect(EPhysicalSurface SurfaceType) const
+{
+	for (const FSImpactEffect& Effect : SurfaceEffects) {
+		if (Effect.SurfaceType == SurfaceType) {
+			return Effect;
+		}
+	}
+
+	return DefaultEffect;
+
+}
@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SImpactEffectsManager.h"
+#include "DarkHours.h"
+#include "SImpactEffectsData.h"
+#include "SWorldManager.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/AudioComponent.h"
+#include "Components/DecalComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+// Sets default values
+ASImpactEffectsManager::ASImpactEffectsManager()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = false;
+
+	// Variables
+	LoadedEffectsData = NULL;
+
+	BudgetFrame = 0;
+	NumImpactsThisFrame = 0;
+	NumNewComponentsThisFrame = 0;
+
+}
+
+ASImpactEffectsManager* ASImpactEffectsManager::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASImpactEffectsManager>(WorldContextObject);
+
+}
+
+// Called when the game starts or when spawned
+void ASImpactEffectsManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (EffectsData.IsNull()) {
+		UE_LOG(LogDarkHours, Warning, TEXT("ImpactEffects: no impact effects data asset set in DefaultGame.ini, impacts have no effects"));
+		return;
+	}
+
+	// Never load on the first impact - that would hitch the frame of the first shot
+	EffectsDataHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(EffectsData.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &ASImpactEffectsManager::OnEffectsDataLoaded));
+
+}
+
+// Called when the game ends or when destroyed
+void ASImpactEffectsManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (EffectsDataHandle.IsValid()) {
+		EffectsDataHandle->CancelHandle();
+		EffectsDataHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASImpactEffectsManager::OnEffectsDataLoaded()
+{
+	LoadedEffectsData = EffectsData.Get();
+
+	if (LoadedEffectsData == NULL) {
+		UE_LOG(LogDarkHours, Warning, TEXT("ImpactEffects: impact effects data asset %s failed to load, impacts have no effects"), *EffectsData.ToString());
+	}
+
+}
+
+void ASImpactEffectsManager::PlayImpact(const FHitResult& Hit)
+{
+	// Still streaming in
+	if (LoadedEffectsData == NULL) {
+		return;
+	}
+
+	// Budgets count per frame
+	if (BudgetFrame != GFrameCounter) {
+		BudgetFrame = GFrameCounter;
+		NumImpactsThisFrame = 0;
+		NumNewComponentsThisFrame = 0;
+	}
+
+	if (NumImpactsThisFrame >= LoadedEffectsData->MaxImpactsPerFrame || !IsNearView(Hit.ImpactPoint)) {
+		INC_DWORD_STAT(STAT_DarkHours_NumSkippedImpacts);
+		return;
+	}
+
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_ImpactEffects, ImpactEffects);
+	INC_DWORD_STAT(STAT_DarkHours_NumImpacts);
+
+	NumImpactsThisFrame++;
+
+	const EPhysicalSurface SurfaceType = UPhysicalMaterial::DetermineSurfaceType(Hit.PhysMaterial.Get());
+	const FSImpactEffect& Effect = LoadedEffectsData->GetEffect(SurfaceType);
+
+	FSImpactComponentRing& Ring = Rings.FindOrAdd((uint8)SurfaceType);
+
+	if (Effect.Particle != NULL) {
+		PlayParticle(Ring, Effect, Hit);
+	}
+
+	if (Effect.DecalMaterial != NULL) {
+		PlayDecal(Ring, Effect, Hit);
+	}
+
+	if (Effect.Sound != NULL) {
+		PlaySound(Ring, Effect, Hit);
+	}
+
+}
+
+bool ASImpactEffectsManager::IsNearView(const FVector& Location) const
+{
+	const float MaxDistanceSquared = FMath::Square(LoadedEffectsData->MaxDistance);
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It) {
+		const APlayerController* LocalController = It->Get();
+
+		if (LocalController != NULL && LocalController->IsLocalController() && LocalController->PlayerCameraManager != NULL
+			&& FVector::DistSquared(LocalController->PlayerCameraManager->GetCameraLocation(), Location) <= MaxDistanceSquared) {
+			return true;
+		}
+	}
+
+	return false;
+
+}
+
+template<typename T>
+T* ASImpactEffectsManager::NextComponent(TArray<T*>& Ring, int32& NextIndex, int32 MaxComponents)
+{
+	// Grow the ring while it is not full and the frame budget allows
+	if (Ring.Num() < MaxComponents && NumNewComponentsThisFrame < LoadedEffectsData->MaxNewComponentsPerFrame) {
+		T* Component = NewObject<T>(this);
+		Component->bAutoActivate = false;
+		Component->RegisterComponent();
+
+		Ring.Add(Component);
+		NumNewComponentsThisFrame++;
+
+		INC_DWORD_STAT(STAT_DarkHours_ImpactComponents);
+
+		return Component;
+	}
+
+	if (Ring.Num() == 0) {
+		return NULL;
+	}
+
+	// Recycle the oldest
+	NextIndex = NextIndex % Ring.Num();
+
+	T* Component = Ring[NextIndex];
+	NextIndex = (NextIndex + 1) % Ring.Num();
+
+	return Component;
+
+}
+
+void ASImpactEffectsManager::PlayParticle(FSImpactComponentRing& Ring, const FSImpactEffect& Effect, const FHitResult& Hit)
+{
+	UParticleSystemComponent* Component = NextComponent(Ring.Particles, Ring.NextParticle, LoadedEffectsData->MaxParticlesPerSurface);
+
+	if (Component == NULL) {
+		return;
+	}
+
+	if (Component->Template != Effect.Particle) {
+		Component->SetTemplate(Effect.Particle);
+	}
+
+	Component->SetWorldLocationAndRotation(Hit.ImpactPoint, Hit.ImpactNormal.Rotation());
+	Component->Activate(true); // Restart, the component may still be playing its last impact
+
+}
+
+void ASImpactEffectsManager::PlayDecal(FSImpactComponentRing& Ring, const FSImpactEffect& Effect, const FHitResult& Hit)
+{
+	UDecalComponent* Component = NextComponent(Ring.Decals, Ring.NextDecal, LoadedEffectsData->MaxDecalsPerSurface);
+
+	if (Component == NULL) {
+		return;
+	}
+
+	if (Component->GetDecalMaterial() != Effect.DecalMaterial) {
+		Component->SetDecalMaterial(Effect.DecalMaterial);
+	}
+
+	if (Component->DecalSize != Effect.DecalSize) {
+		Component->DecalSize = Effect.DecalSize;
+		Component->MarkRenderStateDirty();
+	}
+
+	// Project into the surface, with a random roll so decals do not line up
+	FRotator DecalRotation = (-Hit.ImpactNormal).Rotation();
+	DecalRotation.Roll = FMath::FRandRange(-180.f, 180.f);
+
+	Component->SetWorldLocationAndRotation(Hit.ImpactPoint, DecalRotation);
+
+}
+
+void ASImpactEffectsManager::PlaySound(FSImpactComponentRing& Ring, const FSImpactEffect& Effect, const FHitResult& Hit)
+{
+	UAudioComponent* Component = NextComponent(Ring.Sounds, Ring.NextSound, LoadedEffectsData->MaxSoundsPerSurface);
+
+	if (Component == NULL) {
+		return;
+	}
+
+	if (Component->Sound != Effect.Sound) {
+		Component->SetSound(Effect.Sound);
+	}
+
+	Component->SetWorldLocation(Hit.ImpactPoint);
+	Component->Play();
+
+}
@@ -0,0 +1,386 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SInputRecording.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "SWorldManager.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// 'DHIR' - tells input tracks apart from other files
+static const uint32 InputTrackMagic = 0x52494844;
+static const int32 InputTrackVersion = 1;
+
+// Bytes of a frame on disk, as written by operator<< of FSInputFrame
+static const int64 InputFrameDiskSize = 20;
+
+static void StartInputRecording(const TArray<FString>& Args, UWorld* World)
+{
+	ASInputRecorder* Recorder = ASInputRecorder::Get(World);
+
+	if (Recorder != NULL) {
+		Recorder->StartRecording(Args.Num() > 0 ? Args[0] : TEXT("Input"));
+	}
+
+}
+
+static void StopInputRecording(UWorld* World)
+{
+	ASInputRecorder* Recorder = GetWorldManager<ASInputRecorder>(World, false);
+
+	if (Recorder != NULL) {
+		Recorder->StopRecording();
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs InputRecordCommand(
+	TEXT("DarkHours.Input.Record"),
+	TEXT("Records the input of the local player's character until DarkHours.Input.StopRecording. Args: [Name]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartInputRecording));
+
+static FAutoConsoleCommandWithWorld InputStopRecordingCommand(
+	TEXT("DarkHours.Input.StopRecording"),
+	TEXT("Stops the input recording and writes it to Saved/InputRecordings."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&StopInputRecording));
+
+FSInputFrame::FSInputFrame()
+	: Time(0.f)
+	, MoveX(0)
+	, MoveY(0)
+	, CameraX(0.f)
+	, CameraY(0.f)
+	, ControlYaw(0)
+	, ControlPitch(0)
+	, HeldActions(0)
+	, PressedActions(0)
+{
+}
+
+float FSInputFrame::GetMoveX() const
+{
+	return MoveX / 127.f;
+
+}
+
+float FSInputFrame::GetMoveY() const
+{
+	return MoveY / 127.f;
+
+}
+
+void FSInputFrame::SetMove(float InMoveX, float InMoveY)
+{
+	MoveX = (int8)FMath::RoundToInt(FMath::Clamp(InMoveX, -1.f, 1.f) * 127.f);
+	MoveY = (int8)FMath::RoundToInt(FMath::Clamp(InMoveY, -1.f, 1.f) * 127.f);
+
+}
+
+FRotator FSInputFrame::GetControlRotation() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(ControlPitch), FRotator::DecompressAxisFromShort(ControlYaw), 0.f);
+
+}
+
+void FSInputFrame::SetControlRotation(const FRotator& Rotation)
+{
+	ControlYaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+	ControlPitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+
+}
+
+void FSInputFrame::SetAction(ESInputAction Action, bool bPressed)
+{
+	const uint8 Bit = 1 << (uint8)Action;
+
+	if (bPressed) {
+		HeldActions |= Bit;
+		PressedActions |= Bit;
+	}
+	else {
+		HeldActions &= ~Bit;
+	}
+
+}
+
+bool FSInputFrame::IsHeld(ESInputAction Action) const
+{
+	return (HeldActions & (1 << (uint8)Action)) != 0;
+
+}
+
+bool FSInputFrame::WasPressed(ESInputAction Action) const
+{
+	return (PressedActions & (1 << (uint8)Action)) != 0;
+
+}
+
+FArchive& operator<<(FArchive& Ar, FSInputFrame& Frame)
+{
+	Ar << Frame.Time;
+	Ar << Frame.MoveX;
+	Ar << Frame.MoveY;
+	Ar << Frame.CameraX;
+	Ar << Frame.CameraY;
+	Ar << Frame.ControlYaw;
+	Ar << Frame.ControlPitch;
+	Ar << Frame.HeldActions;
+	Ar << Frame.PressedActions;
+
+	return Ar;
+
+}
+
+FSInputTrack::FSInputTrack()
+	: StartLocation(FVector::ZeroVector)
+	, StartRotation(FRotator::ZeroRotator)
+{
+}
+
+float FSInputTrack::GetDuration() const
+{
+	return Frames.Num() > 0 ? Frames.Last().Time : 0.f;
+
+}
+
+bool FSInputTrack::Save(const FString& Name) const
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+
+	Writer << const_cast<FSInputTrack&>(*this);
+
+	return FFileHelper::SaveArrayToFile(Data, *GetTrackPath(Name));
+
+}
+
+bool FSInputTrack::Load(const FString& Name)
+{
+	TArray<uint8> Data;
+
+	if (!FFileHelper::LoadFileToArray(Data, *GetTrackPath(Name))) {
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+
+	Reader << *this;
+
+	return !Reader.IsError();
+
+}
+
+FString FSInputTrack::GetTrackPath(const FString& Name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("InputRecordings") / Name + TEXT(".dhinput");
+
+}
+
+FArchive& operator<<(FArchive& Ar, FSInputTrack& Track)
+{
+	uint32 Magic = InputTrackMagic;
+	int32 Version = InputTrackVersion;
+
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsLoading() && (Magic != InputTrackMagic || Version != InputTrackVersion)) {
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << Track.StartLocation;
+	Ar << Track.StartRotation;
+
+	// Frames one by one - the in memory layout has padding
+	int32 NumFrames = Track.Frames.Num();
+
+	Ar << NumFrames;
+
+	if (Ar.IsLoading()) {
+		// Truncated or corrupt files must not allocate more frames than the file holds
+		if (NumFrames < 0 || NumFrames > (Ar.TotalSize() - Ar.Tell()) / InputFrameDiskSize) {
+			Ar.SetError();
+			Track.Frames.Reset();
+			return Ar;
+		}
+
+		Track.Frames.SetNum(NumFrames);
+	}
+
+	for (FSInputFrame& Frame : Track.Frames) {
+		Ar << Frame;
+	}
+
+	return Ar;
+
+}
+
+FSInputTrackPlayer::FSInputTrackPlayer()
+	: Cursor(-1)
+	, LastTime(0.f)
+{
+}
+
+bool FSInputTrackPlayer::Advance(const FSInputTrack& Track, float Time, FSInputFrame& OutFrame)
+{
+	if (Track.Frames.Num() == 0) {
+		return false;
+	}
+
+	// Started over
+	if (Time < LastTime) {
+		Reset();
+	}
+
+	LastTime = Time;
+
+	// Gather the presses of every frame stepped over, so short taps survive a coarser timestep
+	uint8 PressedActions = 0;
+	const int32 PreviousCursor = Cursor;
+
+	while (Cursor + 1 < Track.Frames.Num() && (Cursor < 0 || Track.Frames[Cursor + 1].Time <= Time)) {
+		Cursor++;
+		PressedActions |= Track.Frames[Cursor].PressedActions;
+	}
+
+	OutFrame = Track.Frames[Cursor];
+
+	// A frame held over several steps only presses once
+	OutFrame.PressedActions = Cursor != PreviousCursor ? PressedActions : 0;
+
+	return true;
+
+}
+
+void FSInputTrackPlayer::Reset()
+{
+	Cursor = -1;
+	LastTime = 0.f;
+
+}
+
+// Sets default values
+ASInputRecorder::ASInputRecorder()
+{
+	// Record after the player controller processed the input of the frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	bReplicates = false;
+
+	// Variables
+	RecordTime = 0.f;
+	bRecording = false;
+
+}
+
+ASInputRecorder* ASInputRecorder::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASInputRecorder>(WorldContextObject);
+
+}
+
+// Called every frame
+void ASInputRecorder::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bRecording) {
+		return;
+	}
+
+	ASCharacter* RecordedCharacter = Character.Get();
+
+	if (RecordedCharacter == NULL) {
+		UE_LOG(LogDarkHours, Warning, TEXT("Input recording: character is gone, stopping"));
+		StopRecording();
+		return;
+	}
+
+	RecordTime += DeltaTime;
+
+	FSInputFrame Frame = RecordedCharacter->GetInputFrame();
+	Frame.Time = RecordTime;
+
+	if (RecordedCharacter->Controller != NULL) {
+		Frame.SetControlRotation(RecordedCharacter->Controller->GetControlRotation());
+	}
+
+	Track.Frames.Add(Frame);
+
+	RecordedCharacter->ClearPressedInputActions();
+
+}
+
+void ASInputRecorder::StartRecording(const FString& Name)
+{
+	ASCharacter* PlayerCharacter = Cast<ASCharacter>(UGameplayStatics::GetPlayerPawn(this, 0));
+
+	if (PlayerCharacter == NULL) {
+		UE_LOG(LogDarkHours, Warning, TEXT("Input recording: no player character to record"));
+		return;
+	}
+
+	if (bRecording) {
+		StopRecording();
+	}
+
+	Character = PlayerCharacter;
+	TrackName = Name;
+	RecordTime = 0.f;
+	bRecording = true;
+
+	Track = FSInputTrack();
+	Track.StartLocation = PlayerCharacter->GetActorLocation();
+	Track.StartRotation = PlayerCharacter->GetActorRotation();
+	Track.Frames.Reserve(60 * 60); // A minute at 60 fps
+
+	PlayerCharacter->ClearPressedInputActions();
+
+	UE_LOG(LogDarkHours, Log, TEXT("Input recording: started %s"), *TrackName);
+
+}
+
+bool ASInputRecorder::StopRecording()
+{
+	if (!bRecording) {
+		return false;
+	}
+
+	bRecording = false;
+
+	if (Track.Frames.Num() == 0) {
+		return false;
+	}
+
+	const bool bSaved = Track.Save(TrackName);
+
+	UE_LOG(LogDarkHours, Log, TEXT("Input recording: %s %d frames (%.1f s) to %s"), bSaved ? TEXT("wrote") : TEXT("failed to write"), Track.Frames.Num(), Track.GetDuration(), *FSInputTrack::GetTrackPath(TrackName));
+
+	Track = FSInputTrack();
+
+	return bSaved;
+
+}
+
+bool ASInputRecorder::IsRecording() const
+{
+	return bRecording;
+
+}
+
+// Called when the game ends or when destroyed
+void ASInputRecorder::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Keep what was recorded up to a map change or quit
+	StopRecording();
+
+	Super::EndPlay(EndPlayReason);
+
+}
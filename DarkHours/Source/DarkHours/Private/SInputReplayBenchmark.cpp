@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SInputReplayBenchmark.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderCore.h"
+
+static void StartInputReplay(const TArray<FString>& Args, UWorld* World)
+{
+	TArray<FString> TrackNames;
+
+	(Args.Num() > 0 ? Args[0] : FString(TEXT("Input"))).ParseIntoArray(TrackNames, TEXT(","));
+
+	if (World != NULL && !World->GetMapName().Contains(TEXT("Prototype"))) {
+		UE_LOG(LogDarkHours, Warning, TEXT("InputReplay: tracks are recorded on the Prototype map, %s may not match"), *World->GetMapName());
+	}
+
+	ASInputReplayBenchmark* Benchmark = Cast<ASInputReplayBenchmark>(ASBenchmark::Start(World, ASInputReplayBenchmark::StaticClass()));
+
+	if (Benchmark == NULL) {
+		return;
+	}
+
+	if (!Benchmark->LoadTracks(TrackNames)) {
+		UE_LOG(LogDarkHours, Warning, TEXT("InputReplay: no track could be loaded from %s"), *FSInputTrack::GetTrackPath(TEXT("*")));
+		Benchmark->Destroy();
+		return;
+	}
+
+	if (Args.Num() > 1) {
+		Benchmark->NumPawns = FMath::Max(FCString::Atoi(*Args[1]), 1);
+	}
+
+	if (Args.Num() > 2) {
+		Benchmark->FixedDeltaTime = 1.f / FMath::Max(FCString::Atof(*Args[2]), 1.f);
+	}
+
+	if (Args.Num() > 3) {
+		Benchmark->StaggerSeconds = FMath::Max(FCString::Atof(*Args[3]), 0.f);
+	}
+
+	Benchmark->CharacterClass = ASBenchmark::ResolveCharacterClass(FString());
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs InputReplayCommand(
+	TEXT("DarkHours.Input.Replay"),
+	TEXT("Plays recorded input tracks back on spawned characters at a fixed timestep and writes per frame timing. Args: [TrackNames,...] [NumPawns] [FixedFPS] [StaggerSeconds]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartInputReplay));
+
+// Sets default values
+ASInputReplayBenchmark::ASInputReplayBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("InputReplay");
+	WarmupFrames = 30;
+	NumPawns = 1;
+	FixedDeltaTime = 1.f / 60.f;
+	StaggerSeconds = 0.f;
+
+	ReplayTime = 0.f;
+	LastFrameTime = 0.0;
+	bWasFixedTimeStep = false;
+	PreviousFixedDeltaTime = 1.0 / 30.0;
+	bFixedTimeStepSet = false;
+
+}
+
+bool ASInputReplayBenchmark::LoadTracks(const TArray<FString>& TrackNames)
+{
+	Tracks.Reset();
+
+	for (const FString& TrackName : TrackNames) {
+		FSInputTrack Track;
+
+		if (Track.Load(TrackName) && Track.Frames.Num() > 0) {
+			Tracks.Add(MoveTemp(Track));
+		}
+		else {
+			UE_LOG(LogDarkHours, Warning, TEXT("InputReplay: could not load track %s"), *TrackName);
+		}
+	}
+
+	return Tracks.Num() > 0;
+
+}
+
+void ASInputReplayBenchmark::BeginPass(int32 PassIndex)
+{
+	SetFixedTimeStep(true);
+
+	if (CharacterClass == NULL) {
+		CharacterClass = ResolveCharacterClass(FString());
+	}
+
+	// Characters of a track start where it was recorded, spread out on a grid
+	const int32 NumColumns = 8;
+	const float Spacing = 300.f;
+
+	float MaxDuration = 0.f;
+
+	for (int32 Index = 0; Index < NumPawns; Index++) {
+		const int32 TrackIndex = Index % Tracks.Num();
+		const int32 SlotIndex = Index / Tracks.Num();
+		const FSInputTrack& Track = Tracks[TrackIndex];
+
+		ASCharacter* Character = SpawnCharacter(CharacterClass, Index);
+
+		if (Character == NULL) {
+			continue;
+		}
+
+		const FVector Offset((SlotIndex / NumColumns) * Spacing, (SlotIndex % NumColumns) * Spacing, 0.f);
+
+		Character->TeleportTo(Track.StartLocation + Offset, Track.StartRotation);
+
+		// Input bindings move along the control rotation, so every character needs a controller
+		if (Character->Controller == NULL) {
+			Character->SpawnDefaultController();
+		}
+
+		PawnTracks.Add(TrackIndex);
+		Players.AddDefaulted();
+		PreviousFrames.AddDefaulted();
+
+		MaxDuration = FMath::Max(MaxDuration, Track.GetDuration());
+	}
+
+	SampleFrames = FMath::Max(FMath::CeilToInt(MaxDuration / FixedDeltaTime), 1);
+
+	FrameMs.Reset(SampleFrames);
+	FrameLines.Reset(SampleFrames);
+
+	ReplayTime = 0.f;
+	LastFrameTime = 0.0;
+
+}
+
+void ASInputReplayBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	// Wall time of the previous frame - the first sampled frame has none
+	if (LastFrameTime > 0.0) {
+		const float WallMs = (float)((Now - LastFrameTime) * 1000.0);
+
+		FrameMs.Add(WallMs);
+		FrameLines.Add(FString::Printf(TEXT("%d,%.4f,%.3f,%.3f,%.3f,%d"), FrameMs.Num(), ReplayTime, WallMs, FPlatformTime::ToMilliseconds(GGameThreadTime), FPlatformTime::ToMilliseconds(GRenderThreadTime), SpawnedCharacters.Num()));
+	}
+
+	LastFrameTime = Now;
+
+	ReplayTime += DeltaTime;
+
+	for (int32 Index = 0; Index < SpawnedCharacters.Num() && Index < PawnTracks.Num(); Index++) {
+		ASCharacter* Character = SpawnedCharacters[Index];
+
+		if (Character == NULL || Character->IsPendingKill()) {
+			continue;
+		}
+
+		const FSInputTrack& Track = Tracks[PawnTracks[Index]];
+		const float Duration = FMath::Max(Track.GetDuration(), FixedDeltaTime);
+		const float TrackTime = FMath::Fmod(ReplayTime + StaggerSeconds * (Index / Tracks.Num()), Duration);
+
+		FSInputFrame Frame;
+
+		if (Players[Index].Advance(Track, TrackTime, Frame)) {
+			Character->ApplyInputFrame(Frame, PreviousFrames[Index]);
+
+			PreviousFrames[Index] = Frame;
+		}
+	}
+
+}
+
+void ASInputReplayBenchmark::EndPass(int32 PassIndex)
+{
+	SetFixedTimeStep(false);
+
+	// Per frame timing
+	FString Report = TEXT("Frame,ReplayTime,FrameMs,GameThreadMs,RenderThreadMs,Characters\n");
+
+	for (const FString& Line : FrameLines) {
+		Report += Line + TEXT("\n");
+	}
+
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / BenchmarkName + TEXT("_Frames.csv");
+
+	if (!FFileHelper::SaveStringToFile(Report, *ReportPath)) {
+		UE_LOG(LogDarkHours, Warning, TEXT("%s: failed to write frame timing to %s"), *BenchmarkName, *ReportPath);
+	}
+
+	// Summary
+	TArray<float> SortedFrameMs = FrameMs;
+	SortedFrameMs.Sort();
+
+	double TotalMs = 0.0;
+
+	for (float Ms : SortedFrameMs) {
+		TotalMs += Ms;
+	}
+
+	const int32 NumFrames = SortedFrameMs.Num();
+
+	AddResult(TEXT("Characters"), SpawnedCharacters.Num());
+	AddResult(TEXT("Tracks"), Tracks.Num());
+	AddResult(TEXT("Frames"), NumFrames);
+	AddResult(TEXT("FrameMsAvg"), NumFrames > 0 ? TotalMs / NumFrames : 0.0);
+	AddResult(TEXT("FrameMsP95"), NumFrames > 0 ? SortedFrameMs[FMath::Min(NumFrames * 95 / 100, NumFrames - 1)] : 0.0);
+	AddResult(TEXT("FrameMsMax"), NumFrames > 0 ? SortedFrameMs.Last() : 0.0);
+
+}
+
+// Called when the game ends or when destroyed
+void ASInputReplayBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetFixedTimeStep(false);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASInputReplayBenchmark::SetFixedTimeStep(bool bEnabled)
+{
+	if (bEnabled && !bFixedTimeStepSet) {
+		bWasFixedTimeStep = FApp::UseFixedTimeStep();
+		PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+
+		FApp::SetUseFixedTimeStep(true);
+		FApp::SetFixedDeltaTime(FixedDeltaTime);
+
+		bFixedTimeStepSet = true;
+	}
+	else if (!bEnabled && bFixedTimeStepSet) {
+		FApp::SetUseFixedTimeStep(bWasFixedTimeStep);
+		FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+		bFixedTimeStepSet = false;
+	}
+
+}
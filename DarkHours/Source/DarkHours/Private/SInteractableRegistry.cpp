@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SInteractableRegistry.h"
+#include "DarkHours.h"
+#include "SWorldManager.h"
+
+// Sets default values
+ASInteractableRegistry::ASInteractableRegistry()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = false;
+
+	// Variables
+	CellSize = 400.f;
+
+}
+
+ASInteractableRegistry* ASInteractableRegistry::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASInteractableRegistry>(WorldContextObject);
+
+}
+
+void ASInteractableRegistry::RegisterActor(AActor* Actor, const FVector& Location)
+{
+	ASInteractableRegistry* Registry = Get(Actor);
+
+	if (Registry == NULL || Registry->IsRegistered(Actor)) {
+		return;
+	}
+
+	const FIntVector Cell = Registry->GetCell(Location);
+
+	FSInteractableEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Location = Location;
+
+	Registry->Cells.FindOrAdd(Cell).Add(Entry);
+	Registry->ActorCells.Add(Actor, Cell);
+
+	INC_DWORD_STAT(STAT_DarkHours_Interactables);
+
+}
+
+void ASInteractableRegistry::UpdateActor(AActor* Actor, const FVector& Location)
+{
+	ASInteractableRegistry* Registry = GetWorldManager<ASInteractableRegistry>(Actor, false);
+	FIntVector* Cell = Registry != NULL ? Registry->ActorCells.Find(Actor) : NULL;
+
+	if (Cell == NULL) {
+		return;
+	}
+
+	const FIntVector NewCell = Registry->GetCell(Location);
+
+	// Still in the same cell - only move the location
+	if (NewCell == *Cell) {
+		for (FSInteractableEntry& Entry : Registry->Cells.FindChecked(NewCell)) {
+			if (Entry.Actor == Actor) {
+				Entry.Location = Location;
+				break;
+			}
+		}
+
+		return;
+	}
+
+	Registry->RemoveFromCell(Actor, *Cell);
+
+	FSInteractableEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Location = Location;
+
+	Registry->Cells.FindOrAdd(NewCell).Add(Entry);
+	*Cell = NewCell;
+
+}
+
+void ASInteractableRegistry::UnregisterActor(AActor* Actor)
+{
+	ASInteractableRegistry* Registry = GetWorldManager<ASInteractableRegistry>(Actor, false);
+	FIntVector Cell;
+
+	if (Registry == NULL || !Registry->ActorCells.RemoveAndCopyValue(Actor, Cell)) {
+		return;
+	}
+
+	Registry->RemoveFromCell(Actor, Cell);
+
+	DEC_DWORD_STAT(STAT_DarkHours_Interactables);
+
+}
+
+AActor* ASInteractableRegistry::FindNearest(const FVector& Origin, const FVector& Facing, float Reach, float MinFacingDot, TSubclassOf<AActor> ActorClass) const
+{
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_InteractableQuery, InteractableQuery);
+
+	const FVector Facing2D = Facing.GetSafeNormal2D();
+	const float ReachSquared = FMath::Square(Reach);
+
+	const FIntVector MinCell = GetCell(Origin - FVector(Reach));
+	const FIntVector MaxCell = GetCell(Origin + FVector(Reach));
+
+	AActor* NearestActor = NULL;
+	float NearestDistanceSquared = ReachSquared;
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++) {
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++) {
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++) {
+				const TArray<FSInteractableEntry>* Cell = Cells.Find(FIntVector(X, Y, Z));
+
+				if (Cell == NULL) {
+					continue;
+				}
+
+				for (const FSInteractableEntry& Entry : *Cell) {
+					const FVector Delta = Entry.Location - Origin;
+					const float DistanceSquared = Delta.SizeSquared();
+
+					if (DistanceSquared > NearestDistanceSquared) {
+						continue;
+					}
+
+					// Interactables right below the character are always in front of it
+					const FVector Delta2D = Delta.GetSafeNormal2D();
+
+					if (!Facing2D.IsZero() && !Delta2D.IsZero() && FVector::DotProduct(Facing2D, Delta2D) < MinFacingDot) {
+						continue;
+					}
+
+					if (ActorClass != NULL && !Entry.Actor->IsA(ActorClass)) {
+						continue;
+					}
+
+					NearestActor = Entry.Actor;
+					NearestDistanceSquared = DistanceSquared;
+				}
+			}
+		}
+	}
+
+	return NearestActor;
+
+}
+
+bool ASInteractableRegistry::IsRegistered(const AActor* Actor) const
+{
+	return ActorCells.Contains(Actor);
+
+}
+
+FVector ASInteractableRegistry::GetLocation(const AActor* Actor) const
+{
+	const FIntVector* Cell = ActorCells.Find(Actor);
+
+	if (Cell != NULL) {
+		for (const FSInteractableEntry& Entry : Cells.FindChecked(*Cell)) {
+			if (Entry.Actor == Actor) {
+				return Entry.Location;
+			}
+		}
+	}
+
+	return FVector::ZeroVector;
+
+}
+
+int32 ASInteractableRegistry::GetNumActors() const
+{
+	return ActorCells.Num();
+
+}
+
+FIntVector ASInteractableRegistry::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+
+}
+
+void ASInteractableRegistry::RemoveFromCell(const AActor* Actor, const FIntVector& Cell)
+{
+	TArray<FSInteractableEntry>* Entries = Cells.Find(Cell);
+
+	if (Entries == NULL) {
+		return;
+	}
+
+	for (int32 Index = 0; Index < Entries->Num(); Index++) {
+		if ((*Entries)[Index].Actor == Actor) {
+			Entries->RemoveAtSwap(Index);
+			break;
+		}
+	}
+
+	if (Entries->Num() == 0) {
+		Cells.Remove(Cell);
+	}
+
+}
@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SInventoryComponent.h"
+#include "SActorPool.h"
+#include "SCharacter.h"
+#include "SWeapon.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Net/UnrealNetwork.h"
+
+void FSInventorySlot::PostReplicatedAdd(const FSInventoryList& InArraySerializer)
+{
+	if (InArraySerializer.Owner != NULL) {
+		InArraySerializer.Owner->OnSlotsReplicated();
+	}
+
+}
+
+void FSInventorySlot::PostReplicatedChange(const FSInventoryList& InArraySerializer)
+{
+	if (InArraySerializer.Owner != NULL) {
+		InArraySerializer.Owner->OnSlotsReplicated();
+	}
+
+}
+
+void FSInventorySlot::PreReplicatedRemove(const FSInventoryList& InArraySerializer)
+{
+	// Slots are never removed, only emptied - nothing to do
+
+}
+
+// Sets default values for this component's properties
+USInventoryComponent::USInventoryComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	SetIsReplicated(true);
+
+	// Variables
+	Weapons.SetNumZeroed((int32)ESInventorySlot::MAX);
+
+	Inventory.Owner = this;
+
+}
+
+void USInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(USInventoryComponent, Inventory);
+
+}
+
+// Called when the game starts
+void USInventoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Inventory.Owner = this;
+
+	// Slots may have come in with the initial bunch
+	RefreshWeapons();
+
+}
+
+// Called when the game ends or when destroyed
+void USInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (ASWeapon*& Weapon : Weapons) {
+		if (Weapon != NULL) {
+			ASActorPool::ReleaseActor(Weapon);
+			Weapon = NULL;
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void USInventoryComponent::SetSlot(ESInventorySlot Slot, TSubclassOf<ASWeapon> WeaponClass, int32 Ammo)
+{
+	if (GetOwner() == NULL || !GetOwner()->HasAuthority()) {
+		return;
+	}
+
+	FSInventorySlot* InventorySlot = Inventory.Slots.FindByPredicate([Slot](const FSInventorySlot& Entry) { return Entry.Slot == Slot; });
+
+	if (InventorySlot == NULL) {
+		InventorySlot = &Inventory.Slots.AddDefaulted_GetRef();
+		InventorySlot->Slot = Slot;
+	}
+
+	InventorySlot->WeaponClass = WeaponClass;
+	InventorySlot->Ammo = WeaponClass != NULL ? Ammo : 0;
+
+	// Only this slot goes over the wire
+	Inventory.MarkItemDirty(*InventorySlot);
+
+	RefreshWeapons();
+
+}
+
+const FSInventorySlot* USInventoryComponent::FindSlot(ESInventorySlot Slot) const
+{
+	return Inventory.Slots.FindByPredicate([Slot](const FSInventorySlot& Entry) { return Entry.Slot == Slot; });
+
+}
+
+ASWeapon* USInventoryComponent::GetWeapon(ESInventorySlot Slot) const
+{
+	return Weapons.IsValidIndex((int32)Slot) ? Weapons[(int32)Slot] : NULL;
+
+}
+
+void USInventoryComponent::OnWeaponAmmoChanged(ASWeapon* Weapon)
+{
+	if (Weapon == NULL || GetOwner() == NULL || !GetOwner()->HasAuthority()) {
+		return;
+	}
+
+	const int32 SlotIndex = Weapons.Find(Weapon);
+
+	if (SlotIndex == INDEX_NONE) {
+		return;
+	}
+
+	FSInventorySlot* InventorySlot = Inventory.Slots.FindByPredicate([SlotIndex](const FSInventorySlot& Entry) { return (int32)Entry.Slot == SlotIndex; });
+
+	if (InventorySlot != NULL && InventorySlot->Ammo != Weapon->UpdateAmmo) {
+		InventorySlot->Ammo = Weapon->UpdateAmmo;
+		Inventory.MarkItemDirty(*InventorySlot);
+	}
+
+}
+
+void USInventoryComponent::OnSlotsReplicated()
+{
+	RefreshWeapons();
+
+}
+
+void USInventoryComponent::RefreshWeapons()
+{
+	ASCharacter* Character = Cast<ASCharacter>(GetOwner());
+
+	if (Character == NULL || !HasBegunPlay()) {
+		return;
+	}
+
+	for (int32 SlotIndex = 0; SlotIndex < Weapons.Num(); SlotIndex++) {
+		const ESInventorySlot Slot = (ESInventorySlot)SlotIndex;
+		const FSInventorySlot* InventorySlot = FindSlot(Slot);
+		UClass* WeaponClass = InventorySlot != NULL ? *InventorySlot->WeaponClass : NULL;
+
+		// Put the weapon of a changed slot back into the pool
+		if (Weapons[SlotIndex] != NULL && Weapons[SlotIndex]->GetClass() != WeaponClass) {
+			ASActorPool::ReleaseActor(Weapons[SlotIndex]);
+			Weapons[SlotIndex] = NULL;
+		}
+
+		if (WeaponClass == NULL) {
+			continue;
+		}
+
+		// Take the weapon of the slot out of the pool and attach it to the holster socket of the slot
+		if (Weapons[SlotIndex] == NULL) {
+			const FName SocketName = Character->GetHolsterSocketName(Slot);
+
+			ASWeapon* Weapon = ASActorPool::Acquire<ASWeapon>(Character, WeaponClass, Character->GetMesh()->GetSocketTransform(SocketName));
+
+			if (Weapon == NULL) {
+				continue;
+			}
+
+			Weapon->AttachToComponent(Character->GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, SocketName);
+			Weapon->SetOwner(Character); // Shots are aimed from the view of the owner
+			Weapon->Instigator = Character;
+			Weapon->Inventory = this;
+
+			Weapons[SlotIndex] = Weapon;
+		}
+
+		// Ammo of the slot is authoritative
+		Weapons[SlotIndex]->UpdateAmmo = InventorySlot->Ammo;
+	}
+
+}
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SLagCompensationBenchmark.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "SLagCompensationManager.h"
+#include "SWorldManager.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+
+// Circle the characters run around, and how fast - about the sprint speed
+static const float RunRadius = 150.f;
+
+static const float RunAngularSpeed = 4.f;
+
+static void StartLagCompensationBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	ASLagCompensationBenchmark* Benchmark = Cast<ASLagCompensationBenchmark>(ASBenchmark::Start(World, ASLagCompensationBenchmark::StaticClass()));
+
+	if (Benchmark != NULL) {
+		if (Args.Num() > 0) {
+			Benchmark->ShotsPerFrame = FMath::Max(FCString::Atoi(*Args[0]), 1);
+		}
+
+		if (Args.Num() > 1) {
+			Benchmark->CharacterClassPath = Args[1];
+		}
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs LagCompensationBenchmarkCommand(
+	TEXT("DarkHours.Bench.LagCompensation"),
+	TEXT("Measures the cost of recording hitbox history and of rewound shots for 8, 32 and 64 characters. Args: [ShotsPerFrame=256] [CharacterClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartLagCompensationBenchmark));
+
+// Sets default values
+ASLagCompensationBenchmark::ASLagCompensationBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("LagCompensation");
+	CrowdSizes = { 8, 32, 64 };
+	NumPasses = CrowdSizes.Num();
+	ShotsPerFrame = 256;
+
+	ShotStream.Initialize(0x1A6C0);
+
+	NumRecorded = 0;
+	NumShots = 0;
+	NumTargetHits = 0;
+	NumSampledFrames = 0;
+
+}
+
+void ASLagCompensationBenchmark::BeginPass(int32 PassIndex)
+{
+	TSubclassOf<ASCharacter> CharacterClass = ResolveCharacterClass(CharacterClassPath);
+
+	RunCenters.Reset(CrowdSizes[PassIndex]);
+	NumRecorded = 0;
+
+	for (int32 Index = 0; Index < CrowdSizes[PassIndex]; Index++) {
+		ASCharacter* Character = SpawnCharacter(CharacterClass, Index, 2.f * RunRadius + 100.f);
+
+		if (Character == NULL) {
+			continue;
+		}
+
+		// Moved by the benchmark alone
+		Character->GetCharacterMovement()->DisableMovement();
+
+		RunCenters.Add(Character->GetActorLocation());
+
+		// Characters only register on their own on a server - recorded the same way here
+		if (ASLagCompensationManager::RegisterCharacter(Character)) {
+			NumRecorded++;
+		}
+	}
+
+	if (NumRecorded == 0) {
+		MarkFailed(TEXT("no character recorded"));
+	}
+
+	NumShots = 0;
+	NumTargetHits = 0;
+	NumSampledFrames = 0;
+
+}
+
+void ASLagCompensationBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	ASLagCompensationManager* LagCompensationManager = GetWorldManager<ASLagCompensationManager>(this, false);
+
+	if (LagCompensationManager == NULL || SpawnedCharacters.Num() == 0) {
+		return;
+	}
+
+	if (NumSampledFrames == 0) { // Only count the sampled frames
+		LagCompensationManager->ResetCounters();
+	}
+
+	NumSampledFrames++;
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+
+	// Recorded at the end of the frame
+	for (int32 Index = 0; Index < SpawnedCharacters.Num(); Index++) {
+		if (SpawnedCharacters[Index] != NULL) {
+			SpawnedCharacters[Index]->SetActorLocation(GetRunLocation(Index, WorldTime));
+		}
+	}
+
+	// Shots from all around and steeply above, so the crowd rarely stands in the way, at where a character was within the recorded history
+	const float MaxRewindTime = LagCompensationManager->GetMaxRewindTime();
+
+	for (int32 Shot = 0; Shot < ShotsPerFrame; Shot++) {
+		const int32 Target = ShotStream.RandHelper(SpawnedCharacters.Num());
+		const float RewindTime = ShotStream.FRandRange(0.05f, FMath::Max(MaxRewindTime - 0.05f, 0.05f));
+
+		const FVector TargetLocation = GetRunLocation(Target, WorldTime - RewindTime);
+		const FVector Direction = FRotator(ShotStream.FRandRange(-80.f, -50.f), ShotStream.FRandRange(0.f, 360.f), 0.f).Vector();
+		const FVector Start = TargetLocation - Direction * ShotStream.FRandRange(1000.f, 3000.f);
+
+		FSRewindHit Hit;
+
+		if (LagCompensationManager->RewindTrace(Start, TargetLocation + Direction * 1000.f, WorldTime - RewindTime, NULL, Hit) && Hit.Character == SpawnedCharacters[Target]) {
+			NumTargetHits++;
+		}
+
+		NumShots++;
+	}
+
+}
+
+void ASLagCompensationBenchmark::EndPass(int32 PassIndex)
+{
+	const FString PassName = FString::Printf(TEXT("Characters%d"), CrowdSizes[PassIndex]);
+
+	ASLagCompensationManager* LagCompensationManager = GetWorldManager<ASLagCompensationManager>(this, false);
+
+	if (LagCompensationManager != NULL) {
+		const int32 NumRewinds = LagCompensationManager->GetNumRewinds();
+
+		AddResult(PassName + TEXT(".Recorded"), NumRecorded);
+		AddResult(PassName + TEXT(".RewindUsPerShot"), NumRewinds > 0 ? LagCompensationManager->GetRewindSeconds() * 1000000.0 / NumRewinds : 0.0);
+		AddResult(PassName + TEXT(".RecordMsPerFrame"), NumSampledFrames > 0 ? LagCompensationManager->GetRecordSeconds() * 1000.0 / NumSampledFrames : 0.0);
+		AddResult(PassName + TEXT(".HitRate"), NumShots > 0 ? (double)NumTargetHits / NumShots : 0.0);
+		AddResult(PassName + TEXT(".AllocatedKB"), LagCompensationManager->GetAllocatedBytes() / 1024.0);
+	}
+
+	// Unregistered when destroyed
+	DestroyCharacters();
+
+}
+
+FVector ASLagCompensationBenchmark::GetRunLocation(int32 Index, float WorldTime) const
+{
+	// Every character starts at its own angle
+	const float Angle = WorldTime * RunAngularSpeed + Index * 0.7f;
+
+	return RunCenters[Index] + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * RunRadius;
+
+}
@@ -0,0 +1,463 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SLagCompensationManager.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "SRifleWeapon.h"
+#include "SWorldManager.h"
+#include "CollisionQueryParams.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+static TAutoConsoleVariable<int32> CVarLagCompensationRecord(
+	TEXT("DarkHours.LagCompensation.Record"),
+	1,
+	TEXT("1: characters on a server record their hitboxes for lag compensated shots. 0: nothing is recorded, shots of remote players hit characters where they are on the server."),
+	ECVF_Default);
+
+static void LogLagCompensationReport(UWorld* World)
+{
+	ASLagCompensationManager* LagCompensationManager = GetWorldManager<ASLagCompensationManager>(World, false);
+
+	if (LagCompensationManager != NULL) {
+		LagCompensationManager->LogReport();
+	}
+	else {
+		UE_LOG(LogDarkHours, Log, TEXT("LagCompensation: no lag compensation manager in this world"));
+	}
+
+}
+
+static FAutoConsoleCommandWithWorld LagCompensationReportCommand(
+	TEXT("DarkHours.LagCompensation.Report"),
+	TEXT("Logs the characters recorded for lag compensation, the size of the history and the cost of rewinds."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogLagCompensationReport));
+
+// Sets default values
+ASLagCompensationManager::ASLagCompensationManager()
+{
+	// Records once animation has posed the characters for the frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = false;
+
+	// Variables
+	MaxCharacters = 64;
+	MaxRewindTime = 0.5f;
+	RecordInterval = 1.f / 60.f;
+	ViewDelay = 0.1f;
+
+	HistorySize = 0;
+	NumUsedSlots = 0;
+	NewestFrame = 0;
+	NumFrames = 0;
+	LastRecordTime = -BIG_NUMBER;
+
+	NumRewinds = 0;
+	RewindSeconds = 0.0;
+	RecordSeconds = 0.0;
+
+}
+
+// Called every frame
+void ASLagCompensationManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+
+	if (WorldTime - LastRecordTime >= RecordInterval - KINDA_SMALL_NUMBER) {
+		RecordFrame();
+	}
+
+}
+
+// Called when the game starts or when spawned
+void ASLagCompensationManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HistorySize == 0) {
+		AllocateHistory();
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASLagCompensationManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Allocated again if the manager comes back
+	SlotCharacters.Reset();
+	NumUsedSlots = 0;
+	HistorySize = 0;
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+ASLagCompensationManager* ASLagCompensationManager::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASLagCompensationManager>(WorldContextObject);
+
+}
+
+void ASLagCompensationManager::AllocateHistory()
+{
+	// Without any hitbox configured the character capsule is recorded
+	if (Hitboxes.Num() == 0) {
+		Hitboxes.AddDefaulted();
+	}
+
+	MaxCharacters = FMath::Max(MaxCharacters, 1);
+	HistorySize = FMath::CeilToInt(MaxRewindTime / FMath::Max(RecordInterval, KINDA_SMALL_NUMBER)) + 2;
+
+	const int32 NumHitboxes = Hitboxes.Num();
+
+	SlotCharacters.SetNum(MaxCharacters);
+	SlotBoneIndices.Init(INDEX_NONE, MaxCharacters * NumHitboxes);
+	SlotRadii.Init(0.f, MaxCharacters * NumHitboxes);
+
+	FrameTimes.Init(-BIG_NUMBER, HistorySize);
+	FrameBounds.Init(FVector4(0.f, 0.f, 0.f, -1.f), HistorySize * MaxCharacters);
+	HitboxStarts.Init(FVector::ZeroVector, HistorySize * MaxCharacters * NumHitboxes);
+	HitboxEnds.Init(FVector::ZeroVector, HistorySize * MaxCharacters * NumHitboxes);
+
+	NewestFrame = 0;
+	NumFrames = 0;
+
+}
+
+void ASLagCompensationManager::ClearSlot(int32 Slot)
+{
+	for (int32 Frame = 0; Frame < HistorySize; Frame++) {
+		FrameBounds[Frame * MaxCharacters + Slot].W = -1.f;
+	}
+
+}
+
+int32 ASLagCompensationManager::FindSlot(const ASCharacter* Character) const
+{
+	for (int32 Slot = 0; Slot < NumUsedSlots; Slot++) {
+		if (SlotCharacters[Slot].Get() == Character) {
+			return Slot;
+		}
+	}
+
+	return INDEX_NONE;
+
+}
+
+bool ASLagCompensationManager::IsRecordingEnabled()
+{
+	return CVarLagCompensationRecord.GetValueOnGameThread() != 0;
+
+}
+
+bool ASLagCompensationManager::RegisterCharacter(ASCharacter* Character)
+{
+	ASLagCompensationManager* LagCompensationManager = Get(Character);
+
+	if (LagCompensationManager == NULL || Character == NULL) {
+		return false;
+	}
+
+	if (LagCompensationManager->HistorySize == 0) { // Registered before the manager began play
+		LagCompensationManager->AllocateHistory();
+	}
+
+	if (LagCompensationManager->FindSlot(Character) != INDEX_NONE) {
+		return true;
+	}
+
+	const int32 Slot = LagCompensationManager->SlotCharacters.IndexOfByPredicate([](const TWeakObjectPtr<ASCharacter>& SlotCharacter) { return !SlotCharacter.IsValid(); });
+
+	if (Slot == INDEX_NONE) {
+		UE_LOG(LogDarkHours, Warning, TEXT("LagCompensation: all %d slots are taken, %s is not rewound"), LagCompensationManager->MaxCharacters, *Character->GetName());
+		return false;
+	}
+
+	LagCompensationManager->SlotCharacters[Slot] = Character;
+	LagCompensationManager->NumUsedSlots = FMath::Max(LagCompensationManager->NumUsedSlots, Slot + 1);
+
+	// Bones are looked up once - hitboxes without their bone follow the character capsule
+	const USkeletalMeshComponent* Mesh = Character->GetMesh();
+	const int32 NumHitboxes = LagCompensationManager->Hitboxes.Num();
+
+	for (int32 Hitbox = 0; Hitbox < NumHitboxes; Hitbox++) {
+		const FSHitboxSettings& Settings = LagCompensationManager->Hitboxes[Hitbox];
+		const int32 BoneIndex = Mesh != NULL && Settings.BoneName != NAME_None ? Mesh->GetBoneIndex(Settings.BoneName) : INDEX_NONE;
+
+		LagCompensationManager->SlotBoneIndices[Slot * NumHitboxes + Hitbox] = BoneIndex;
+		LagCompensationManager->SlotRadii[Slot * NumHitboxes + Hitbox] = BoneIndex != INDEX_NONE ? Settings.Radius : Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	}
+
+	// Frames recorded for the previous character of the slot
+	LagCompensationManager->ClearSlot(Slot);
+
+	return true;
+
+}
+
+void ASLagCompensationManager::UnregisterCharacter(ASCharacter* Character)
+{
+	ASLagCompensationManager* LagCompensationManager = GetWorldManager<ASLagCompensationManager>(Character, false);
+
+	if (LagCompensationManager == NULL) {
+		return;
+	}
+
+	const int32 Slot = LagCompensationManager->FindSlot(Character);
+
+	if (Slot != INDEX_NONE) {
+		LagCompensationManager->SlotCharacters[Slot] = NULL;
+	}
+
+}
+
+bool ASLagCompensationManager::IsRecorded(const ASCharacter* Character) const
+{
+	return Character != NULL && FindSlot(Character) != INDEX_NONE;
+
+}
+
+void ASLagCompensationManager::IgnoreRecordedCharacters(FCollisionQueryParams& QueryParams) const
+{
+	for (int32 Slot = 0; Slot < NumUsedSlots; Slot++) {
+		QueryParams.AddIgnoredActor(SlotCharacters[Slot].Get());
+	}
+
+}
+
+float ASLagCompensationManager::GetRewindTime(const ASRifleWeapon* Weapon) const
+{
+	// Local players and bots see the current state
+	if (Weapon == NULL || !Weapon->bRemoteFire) {
+		return 0.f;
+	}
+
+	// Automatic fire keeps the latency of its start - the client saw every shot as late as the first one
+	return FMath::Min(Weapon->RemoteFireLatency + ViewDelay, MaxRewindTime);
+
+}
+
+void ASLagCompensationManager::RecordFrame()
+{
+	if (HistorySize == 0) {
+		return;
+	}
+
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_LagCompensationRecord, LagCompensationRecord);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	LastRecordTime = GetWorld()->GetTimeSeconds();
+
+	NewestFrame = (NewestFrame + 1) % HistorySize;
+	NumFrames = FMath::Min(NumFrames + 1, HistorySize);
+
+	FrameTimes[NewestFrame] = LastRecordTime;
+
+	const int32 NumHitboxes = Hitboxes.Num();
+
+	FVector4* Bounds = &FrameBounds[NewestFrame * MaxCharacters];
+
+	for (int32 Slot = 0; Slot < NumUsedSlots; Slot++) {
+		const ASCharacter* Character = SlotCharacters[Slot].Get();
+
+		if (Character == NULL) {
+			Bounds[Slot].W = -1.f;
+			continue;
+		}
+
+		const USkeletalMeshComponent* Mesh = Character->GetMesh();
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+
+		const FVector Center = Capsule->GetComponentLocation();
+		const FVector CapsuleAxis = Capsule->GetUpVector() * Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+
+		const int32* BoneIndices = &SlotBoneIndices[Slot * NumHitboxes];
+		const float* Radii = &SlotRadii[Slot * NumHitboxes];
+
+		FVector* Starts = &HitboxStarts[(NewestFrame * MaxCharacters + Slot) * NumHitboxes];
+		FVector* Ends = &HitboxEnds[(NewestFrame * MaxCharacters + Slot) * NumHitboxes];
+
+		float BoundsRadius = 0.f;
+
+		for (int32 Hitbox = 0; Hitbox < NumHitboxes; Hitbox++) {
+			if (BoneIndices[Hitbox] != INDEX_NONE) {
+				const FTransform BoneTransform = Mesh->GetBoneTransform(BoneIndices[Hitbox]);
+
+				Starts[Hitbox] = BoneTransform.GetLocation();
+				Ends[Hitbox] = BoneTransform.TransformPosition(FVector(Hitboxes[Hitbox].Length, 0.f, 0.f));
+			}
+			else {
+				Starts[Hitbox] = Center - CapsuleAxis;
+				Ends[Hitbox] = Center + CapsuleAxis;
+			}
+
+			BoundsRadius = FMath::Max(BoundsRadius, FMath::Sqrt(FMath::Max(FVector::DistSquared(Center, Starts[Hitbox]), FVector::DistSquared(Center, Ends[Hitbox]))) + Radii[Hitbox]);
+		}
+
+		Bounds[Slot] = FVector4(Center, BoundsRadius);
+	}
+
+	RecordSeconds += FPlatformTime::Seconds() - StartTime;
+
+}
+
+float ASLagCompensationManager::GetMaxRewindTime() const
+{
+	return MaxRewindTime;
+
+}
+
+bool ASLagCompensationManager::RewindTrace(const FVector& Start, const FVector& End, float TargetTime, const AActor* IgnoredActor, FSRewindHit& OutHit) const
+{
+	if (NumFrames == 0) {
+		return false;
+	}
+
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_LagCompensationRewind, LagCompensationRewind);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	NumRewinds++;
+	INC_DWORD_STAT(STAT_DarkHours_NumRewinds);
+
+	// No further back than MaxRewindTime from now, however late the shot is resolved
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	TargetTime = FMath::Clamp(TargetTime, WorldTime - MaxRewindTime, WorldTime);
+
+	// Walk back from the newest frame to the two around the target time - clamped to the newest and oldest ones
+	int32 NewerFrame = NewestFrame;
+	int32 OlderFrame = NewestFrame;
+
+	for (int32 Step = 1; Step < NumFrames && FrameTimes[OlderFrame] > TargetTime; Step++) {
+		NewerFrame = OlderFrame;
+		OlderFrame = (OlderFrame + HistorySize - 1) % HistorySize;
+	}
+
+	const float FrameSpan = FrameTimes[NewerFrame] - FrameTimes[OlderFrame];
+	const float Alpha = FrameSpan > KINDA_SMALL_NUMBER ? FMath::Clamp((TargetTime - FrameTimes[OlderFrame]) / FrameSpan, 0.f, 1.f) : 1.f;
+
+	const int32 NumHitboxes = Hitboxes.Num();
+
+	const FVector4* OlderBounds = &FrameBounds[OlderFrame * MaxCharacters];
+	const FVector4* NewerBounds = &FrameBounds[NewerFrame * MaxCharacters];
+
+	float BestDistance = BIG_NUMBER;
+
+	for (int32 Slot = 0; Slot < NumUsedSlots; Slot++) {
+		// Recorded at both frames, and the ray passes through the bounds
+		if (OlderBounds[Slot].W < 0.f || NewerBounds[Slot].W < 0.f) {
+			continue;
+		}
+
+		const FVector BoundsCenter = FMath::Lerp(FVector(OlderBounds[Slot]), FVector(NewerBounds[Slot]), Alpha);
+		const float BoundsRadius = FMath::Max(OlderBounds[Slot].W, NewerBounds[Slot].W);
+
+		if (FMath::PointDistToSegmentSquared(BoundsCenter, Start, End) > FMath::Square(BoundsRadius)) {
+			continue;
+		}
+
+		ASCharacter* Character = SlotCharacters[Slot].Get();
+
+		if (Character == NULL || Character == IgnoredActor) {
+			continue;
+		}
+
+		const FVector* OlderStarts = &HitboxStarts[(OlderFrame * MaxCharacters + Slot) * NumHitboxes];
+		const FVector* OlderEnds = &HitboxEnds[(OlderFrame * MaxCharacters + Slot) * NumHitboxes];
+		const FVector* NewerStarts = &HitboxStarts[(NewerFrame * MaxCharacters + Slot) * NumHitboxes];
+		const FVector* NewerEnds = &HitboxEnds[(NewerFrame * MaxCharacters + Slot) * NumHitboxes];
+		const float* Radii = &SlotRadii[Slot * NumHitboxes];
+
+		for (int32 Hitbox = 0; Hitbox < NumHitboxes; Hitbox++) {
+			const FVector HitboxStart = FMath::Lerp(OlderStarts[Hitbox], NewerStarts[Hitbox], Alpha);
+			const FVector HitboxEnd = FMath::Lerp(OlderEnds[Hitbox], NewerEnds[Hitbox], Alpha);
+
+			FVector OnRay;
+			FVector OnHitbox;
+			FMath::SegmentDistToSegmentSafe(Start, End, HitboxStart, HitboxEnd, OnRay, OnHitbox);
+
+			const float DistanceSquared = FVector::DistSquared(OnRay, OnHitbox);
+
+			if (DistanceSquared > FMath::Square(Radii[Hitbox])) {
+				continue;
+			}
+
+			// Entry point, backed off from the closest point by the depth inside the capsule - exact for rays across the capsule axis
+			const float Distance = FMath::Max(FVector::Dist(Start, OnRay) - FMath::Sqrt(FMath::Square(Radii[Hitbox]) - DistanceSquared), 0.f);
+
+			if (Distance < BestDistance) {
+				BestDistance = Distance;
+
+				OutHit.Character = Character;
+				OutHit.HitboxIndex = Hitbox;
+				OutHit.BoneName = SlotBoneIndices[Slot * NumHitboxes + Hitbox] != INDEX_NONE ? Hitboxes[Hitbox].BoneName : NAME_None;
+				OutHit.Location = Start + (End - Start).GetSafeNormal() * Distance;
+				OutHit.Distance = Distance;
+			}
+		}
+	}
+
+	RewindSeconds += FPlatformTime::Seconds() - StartTime;
+
+	return BestDistance < BIG_NUMBER;
+
+}
+
+int32 ASLagCompensationManager::GetNumRecordedCharacters() const
+{
+	int32 NumRecorded = 0;
+
+	for (int32 Slot = 0; Slot < NumUsedSlots; Slot++) {
+		NumRecorded += SlotCharacters[Slot].IsValid() ? 1 : 0;
+	}
+
+	return NumRecorded;
+
+}
+
+int32 ASLagCompensationManager::GetAllocatedBytes() const
+{
+	return SlotCharacters.GetAllocatedSize() + SlotBoneIndices.GetAllocatedSize() + SlotRadii.GetAllocatedSize() + FrameTimes.GetAllocatedSize() + FrameBounds.GetAllocatedSize() + HitboxStarts.GetAllocatedSize() + HitboxEnds.GetAllocatedSize();
+
+}
+
+int32 ASLagCompensationManager::GetNumRewinds() const
+{
+	return NumRewinds;
+
+}
+
+double ASLagCompensationManager::GetRewindSeconds() const
+{
+	return RewindSeconds;
+
+}
+
+double ASLagCompensationManager::GetRecordSeconds() const
+{
+	return RecordSeconds;
+
+}
+
+void ASLagCompensationManager::ResetCounters()
+{
+	NumRewinds = 0;
+	RewindSeconds = 0.0;
+	RecordSeconds = 0.0;
+
+}
+
+void ASLagCompensationManager::LogReport() const
+{
+	UE_LOG(LogDarkHours, Log, TEXT("LagCompensation: %d / %d characters, %d hitboxes, %d frames over %.2fs, %d KB"), GetNumRecordedCharacters(), MaxCharacters, Hitboxes.Num(), HistorySize, HistorySize * RecordInterval, GetAllocatedBytes() / 1024);
+	UE_LOG(LogDarkHours, Log, TEXT("LagCompensation: %d rewinds, %.2f us per rewind, %.3f ms recording"), NumRewinds, NumRewinds > 0 ? RewindSeconds * 1000000.0 / NumRewinds : 0.0, RecordSeconds * 1000.0);
+
+}
@@ -0,0 +1,449 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SLevelStreamingManager.h"
+#include "DarkHours.h"
+#include "SActorPool.h"
+#include "SPickupInstanceManager.h"
+#include "SWeaponPickup.h"
+#include "SWorldManager.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Level.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static void LogStreamingReport(UWorld* World)
+{
+	ASLevelStreamingManager* StreamingManager = GetWorldManager<ASLevelStreamingManager>(World, false);
+
+	if (StreamingManager != NULL) {
+		StreamingManager->LogReport();
+	}
+	else {
+		UE_LOG(LogDarkHours, Log, TEXT("Streaming: no level streaming manager in this world"));
+	}
+
+}
+
+static FAutoConsoleCommandWithWorld StreamingReportCommand(
+	TEXT("DarkHours.Streaming.Report"),
+	TEXT("Logs the distance and state of every streamed sublevel."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogStreamingReport));
+
+// Sets default values
+ASLevelStreamingManager::ASLevelStreamingManager()
+{
+	// Streaming is updated at a fixed interval, not every frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = false;
+
+	// Variables
+	LoadDistance = 15000.f;
+	UnloadDistance = 20000.f;
+	MaxConcurrentLoads = 2;
+	UpdateInterval = 0.1f;
+
+	SourceOverride = FVector::ZeroVector;
+	bHasSourceOverride = false;
+
+	NumLoadRequests = 0;
+	NumUnloadRequests = 0;
+
+}
+
+// Called every frame
+void ASLevelStreamingManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateStreaming();
+
+}
+
+// Called when the game starts or when spawned
+void ASLevelStreamingManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetActorTickInterval(UpdateInterval);
+
+	GatherStreamedLevels();
+
+	// Placed actors are the server's to keep, clients get them replicated
+	if (HasAuthority()) {
+		LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ASLevelStreamingManager::OnLevelAdded);
+		LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &ASLevelStreamingManager::OnLevelRemoved);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASLevelStreamingManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	StreamedLevels.Reset();
+	Persistence.Reset();
+
+	SET_DWORD_STAT(STAT_DarkHours_StreamedLevelsVisible, 0);
+	SET_DWORD_STAT(STAT_DarkHours_StreamedLevelsPending, 0);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+ASLevelStreamingManager* ASLevelStreamingManager::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASLevelStreamingManager>(WorldContextObject);
+
+}
+
+void ASLevelStreamingManager::SetSourceOverride(const FVector& Location)
+{
+	SourceOverride = Location;
+	bHasSourceOverride = true;
+
+}
+
+void ASLevelStreamingManager::ClearSourceOverride()
+{
+	bHasSourceOverride = false;
+
+}
+
+void ASLevelStreamingManager::GetLevelBounds(TArray<FBox>& OutBounds) const
+{
+	for (const FSStreamedLevel& StreamedLevel : StreamedLevels) {
+		OutBounds.Add(StreamedLevel.Bounds);
+	}
+
+}
+
+int32 ASLevelStreamingManager::GetNumVisibleLevels() const
+{
+	int32 NumVisible = 0;
+
+	for (const FSStreamedLevel& StreamedLevel : StreamedLevels) {
+		const ULevelStreaming* StreamingLevel = StreamedLevel.StreamingLevel.Get();
+
+		NumVisible += StreamingLevel != NULL && StreamingLevel->IsLevelVisible() ? 1 : 0;
+	}
+
+	return NumVisible;
+
+}
+
+int32 ASLevelStreamingManager::GetNumPendingLevels() const
+{
+	int32 NumPending = 0;
+
+	for (const FSStreamedLevel& StreamedLevel : StreamedLevels) {
+		const ULevelStreaming* StreamingLevel = StreamedLevel.StreamingLevel.Get();
+
+		// Loading, or loaded and still being added to the world
+		NumPending += StreamingLevel != NULL && StreamingLevel->ShouldBeLoaded() && !StreamingLevel->IsLevelVisible() ? 1 : 0;
+	}
+
+	return NumPending;
+
+}
+
+int32 ASLevelStreamingManager::GetNumLoadRequests() const
+{
+	return NumLoadRequests;
+
+}
+
+int32 ASLevelStreamingManager::GetNumUnloadRequests() const
+{
+	return NumUnloadRequests;
+
+}
+
+void ASLevelStreamingManager::GatherStreamedLevels()
+{
+	StreamedLevels.Reset();
+
+	for (ULevelStreaming* StreamingLevel : GetWorld()->GetStreamingLevels()) {
+		if (StreamingLevel == NULL) {
+			continue;
+		}
+
+		const FName PackageName = FName(*UWorld::RemovePIEPrefix(StreamingLevel->GetWorldAssetPackageName()));
+
+		const FSStreamedLevelSettings* Settings = Levels.FindByPredicate([PackageName](const FSStreamedLevelSettings& Level) { return Level.PackageName == PackageName; });
+
+		if (Settings == NULL || !Settings->Bounds.IsValid) {
+			continue;
+		}
+
+		// Players never wait on a streamed sublevel
+		StreamingLevel->bShouldBlockOnLoad = false;
+		StreamingLevel->bShouldBlockOnUnload = false;
+
+		FSStreamedLevel& StreamedLevel = StreamedLevels.AddDefaulted_GetRef();
+		StreamedLevel.StreamingLevel = StreamingLevel;
+		StreamedLevel.Bounds = Settings->Bounds;
+		StreamedLevel.Distance = BIG_NUMBER;
+	}
+
+	if (StreamedLevels.Num() < Levels.Num()) {
+		UE_LOG(LogDarkHours, Warning, TEXT("Streaming: %d of %d configured sublevels are not streaming levels of %s"), Levels.Num() - StreamedLevels.Num(), Levels.Num(), *GetWorld()->GetMapName());
+	}
+
+}
+
+void ASLevelStreamingManager::UpdateStreaming()
+{
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_LevelStreamingUpdate, LevelStreamingUpdate);
+
+	if (StreamedLevels.Num() == 0) {
+		return;
+	}
+
+	// Stream around the override, or around every player - on a server these are the remote players too
+	SourceLocations.Reset();
+
+	if (bHasSourceOverride) {
+		SourceLocations.Add(SourceOverride);
+	}
+	else {
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It) {
+			APlayerController* PlayerController = It->Get();
+
+			if (PlayerController == NULL) {
+				continue;
+			}
+
+			if (PlayerController->GetPawn() != NULL) {
+				SourceLocations.Add(PlayerController->GetPawn()->GetActorLocation());
+			}
+			else {
+				FVector ViewLocation;
+				FRotator ViewRotation;
+
+				PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+				SourceLocations.Add(ViewLocation);
+			}
+		}
+	}
+
+	// Unload far sublevels right away, collect the near ones to load
+	LoadCandidates.Reset();
+
+	int32 NumPending = 0;
+
+	for (int32 Index = 0; Index < StreamedLevels.Num(); Index++) {
+		FSStreamedLevel& StreamedLevel = StreamedLevels[Index];
+		ULevelStreaming* StreamingLevel = StreamedLevel.StreamingLevel.Get();
+
+		if (StreamingLevel == NULL) {
+			continue;
+		}
+
+		float MinDistanceSquared = BIG_NUMBER;
+
+		for (const FVector& SourceLocation : SourceLocations) {
+			MinDistanceSquared = FMath::Min(MinDistanceSquared, StreamedLevel.Bounds.ComputeSquaredDistanceToPoint(SourceLocation));
+		}
+
+		StreamedLevel.Distance = FMath::Sqrt(MinDistanceSquared);
+
+		if (StreamingLevel->ShouldBeLoaded()) {
+			if (StreamedLevel.Distance > UnloadDistance) {
+				StreamingLevel->SetShouldBeVisible(false);
+				StreamingLevel->SetShouldBeLoaded(false);
+
+				NumUnloadRequests++;
+			}
+			else if (!StreamingLevel->IsLevelVisible()) {
+				NumPending++;
+			}
+		}
+		else if (StreamedLevel.Distance <= LoadDistance) {
+			LoadCandidates.Add(Index);
+		}
+	}
+
+	// Closest first, within the budget of concurrent loads
+	LoadCandidates.Sort([this](int32 A, int32 B) { return StreamedLevels[A].Distance < StreamedLevels[B].Distance; });
+
+	for (int32 Index : LoadCandidates) {
+		if (NumPending >= MaxConcurrentLoads) {
+			break;
+		}
+
+		ULevelStreaming* StreamingLevel = StreamedLevels[Index].StreamingLevel.Get();
+
+		// Closer sublevels get their async loads and world setup done first
+		StreamingLevel->SetPriority(FMath::Max(0, (int32)((LoadDistance - StreamedLevels[Index].Distance) / 100.f)));
+		StreamingLevel->SetShouldBeLoaded(true);
+		StreamingLevel->SetShouldBeVisible(true);
+
+		NumLoadRequests++;
+		NumPending++;
+	}
+
+	SET_DWORD_STAT(STAT_DarkHours_StreamedLevelsVisible, GetNumVisibleLevels());
+	SET_DWORD_STAT(STAT_DarkHours_StreamedLevelsPending, NumPending);
+
+}
+
+void ASLevelStreamingManager::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld() || Level == NULL || Level->IsPersistentLevel()) {
+		return;
+	}
+
+	FSLevelPersistence* LevelPersistence = Persistence.Find(Level->GetOutermost()->GetFName());
+
+	// First time in - remember which placed actors to keep track of
+	if (LevelPersistence == NULL) {
+		FSLevelPersistence& NewPersistence = Persistence.Add(Level->GetOutermost()->GetFName());
+
+		for (AActor* Actor : Level->Actors) {
+			if (IsTrackedActor(Actor)) {
+				NewPersistence.TrackedActors.Add(Actor->GetFName());
+			}
+		}
+
+		return;
+	}
+
+	// Back in - put the placed actors the way they were left
+	for (AActor* Actor : Level->Actors) {
+		const FSPlacedActorState* ActorState = Actor != NULL ? LevelPersistence->ActorStates.Find(Actor->GetFName()) : NULL;
+
+		if (ActorState == NULL) {
+			continue;
+		}
+
+		if (ActorState->bDestroyed) {
+			Actor->Destroy();
+			continue;
+		}
+
+		Actor->SetActorTransform(ActorState->Transform, false, NULL, ETeleportType::TeleportPhysics);
+
+		ASWeaponPickup* WeaponPickup = Cast<ASWeaponPickup>(Actor);
+
+		if (WeaponPickup != NULL) {
+			WeaponPickup->UpdateAmmo = ActorState->Ammo;
+		}
+	}
+
+	// Dropped pickups come back where they lay
+	for (const FSStashedPickup& StashedPickup : LevelPersistence->StashedPickups) {
+		ASWeaponPickup* WeaponPickup = ASActorPool::Acquire<ASWeaponPickup>(this, StashedPickup.PickupClass, StashedPickup.Transform);
+
+		if (WeaponPickup != NULL) {
+			WeaponPickup->UpdateAmmo = StashedPickup.Ammo;
+		}
+	}
+
+	LevelPersistence->StashedPickups.Reset();
+
+	ASPickupInstanceManager* InstanceManager = GetWorldManager<ASPickupInstanceManager>(this, false);
+
+	if (InstanceManager != NULL) {
+		InstanceManager->RestoreFrozenPickups(LevelPersistence->StashedFrozenPickups);
+	}
+
+	LevelPersistence->StashedFrozenPickups.Reset();
+
+}
+
+void ASLevelStreamingManager::OnLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld() || Level == NULL || Level->IsPersistentLevel()) {
+		return;
+	}
+
+	FSLevelPersistence& LevelPersistence = Persistence.FindOrAdd(Level->GetOutermost()->GetFName());
+
+	// Placed actors - actors missing from the level were destroyed or taken
+	TMap<FName, AActor*> LevelActors;
+
+	for (AActor* Actor : Level->Actors) {
+		if (Actor != NULL && !Actor->IsPendingKill()) {
+			LevelActors.Add(Actor->GetFName(), Actor);
+		}
+	}
+
+	for (FName ActorName : LevelPersistence.TrackedActors) {
+		FSPlacedActorState& ActorState = LevelPersistence.ActorStates.FindOrAdd(ActorName);
+		AActor* const* Actor = LevelActors.Find(ActorName);
+
+		ActorState.bDestroyed = Actor == NULL;
+
+		if (Actor != NULL) {
+			const ASWeaponPickup* WeaponPickup = Cast<ASWeaponPickup>(*Actor);
+
+			ActorState.Transform = (*Actor)->GetActorTransform();
+			ActorState.Ammo = WeaponPickup != NULL ? WeaponPickup->UpdateAmmo : 0;
+		}
+	}
+
+	// Dropped pickups live in the persistent level and would fall through the unloaded ground - stash them
+	const FSStreamedLevel* StreamedLevel = StreamedLevels.FindByPredicate([Level](const FSStreamedLevel& Streamed) { return Streamed.StreamingLevel.IsValid() && Streamed.StreamingLevel->GetLoadedLevel() == Level; });
+	const FBox Bounds = StreamedLevel != NULL ? StreamedLevel->Bounds : ALevelBounds::CalculateLevelBounds(Level);
+
+	for (TActorIterator<ASWeaponPickup> It(World); It; ++It) {
+		ASWeaponPickup* WeaponPickup = *It;
+
+		if (WeaponPickup->IsPendingKill() || WeaponPickup->bHidden || WeaponPickup->GetLevel() != World->PersistentLevel || !Bounds.IsInsideXY(WeaponPickup->GetActorLocation())) {
+			continue;
+		}
+
+		FSStashedPickup& StashedPickup = LevelPersistence.StashedPickups.AddDefaulted_GetRef();
+		StashedPickup.PickupClass = WeaponPickup->GetClass();
+		StashedPickup.Transform = WeaponPickup->GetActorTransform();
+		StashedPickup.Ammo = WeaponPickup->UpdateAmmo;
+
+		ASActorPool::ReleaseActor(WeaponPickup);
+	}
+
+	// Frozen pickups are only instances of the persistent level - stash their records the same way
+	ASPickupInstanceManager* InstanceManager = GetWorldManager<ASPickupInstanceManager>(this, false);
+
+	if (InstanceManager != NULL) {
+		InstanceManager->StashFrozenPickups(Bounds, LevelPersistence.StashedFrozenPickups);
+	}
+
+}
+
+bool ASLevelStreamingManager::IsTrackedActor(const AActor* Actor)
+{
+	if (Actor == NULL || Actor->IsPendingKill()) {
+		return false;
+	}
+
+	// Pickups, and anything else that can move or be destroyed
+	return Actor->IsA<ASWeaponPickup>() || (Actor->GetRootComponent() != NULL && Actor->GetRootComponent()->Mobility == EComponentMobility::Movable && !Actor->IsA<APawn>());
+
+}
+
+void ASLevelStreamingManager::LogReport() const
+{
+	UE_LOG(LogDarkHours, Log, TEXT("Streaming: %d sublevels, %d visible, %d pending, %d load and %d unload requests"), StreamedLevels.Num(), GetNumVisibleLevels(), GetNumPendingLevels(), NumLoadRequests, NumUnloadRequests);
+
+	for (const FSStreamedLevel& StreamedLevel : StreamedLevels) {
+		const ULevelStreaming* StreamingLevel = StreamedLevel.StreamingLevel.Get();
+
+		if (StreamingLevel == NULL) {
+			continue;
+		}
+
+		const TCHAR* State = StreamingLevel->IsLevelVisible() ? TEXT("visible") : (StreamingLevel->IsLevelLoaded() ? TEXT("loaded") : (StreamingLevel->ShouldBeLoaded() ? TEXT("loading") : TEXT("unloaded")));
+
+		UE_LOG(LogDarkHours, Log, TEXT("Streaming: %s - %.0f away, %s"), *StreamingLevel->GetWorldAssetPackageName(), StreamedLevel.Distance, State);
+	}
+
+}
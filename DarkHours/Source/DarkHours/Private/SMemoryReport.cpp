@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SMemoryReport.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "SPickupInstanceManager.h"
+#include "SWeapon.h"
+#include "SWeaponPickup.h"
+#include "SWorldManager.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimSequenceBase.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "PhysicsEngine/BodyInstance.h"
+#include "UObject/UObjectIterator.h"
+
+static void LogMemoryReport(UWorld* World)
+{
+	FSMemoryReport::Log(World);
+
+}
+
+static FAutoConsoleCommandWithWorld MemoryReportCommand(
+	TEXT("DarkHours.Memory.Report"),
+	TEXT("Logs instance counts, instance memory and shared asset memory of characters, weapons, pickups, animation and physics bodies."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogMemoryReport));
+
+// Returns the native size of the object plus the memory it owns
+static int64 GetObjectBytes(const UObject* Object)
+{
+	return Object->GetClass()->GetStructureSize() + Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+
+}
+
+// Adds the actor with its components to the category, and the meshes they use to its assets
+static void AddActor(AActor* Actor, FSMemoryCategory& Category, TSet<UObject*>& Assets)
+{
+	Category.NumInstances++;
+	Category.InstanceBytes += GetObjectBytes(Actor);
+
+	for (UActorComponent* Component : Actor->GetComponents()) {
+		if (Component == NULL) {
+			continue;
+		}
+
+		Category.InstanceBytes += GetObjectBytes(Component);
+
+		if (const USkeletalMeshComponent* SkeletalMeshComp = Cast<USkeletalMeshComponent>(Component)) {
+			Assets.Add(SkeletalMeshComp->SkeletalMesh);
+		}
+		else if (const UStaticMeshComponent* StaticMeshComp = Cast<UStaticMeshComponent>(Component)) {
+			Assets.Add(StaticMeshComp->GetStaticMesh());
+		}
+	}
+
+}
+
+// Counts the shared assets once into the category
+static void AddAssets(const TSet<UObject*>& Assets, FSMemoryCategory& Category)
+{
+	for (const UObject* Asset : Assets) {
+		if (Asset != NULL) {
+			Category.NumAssets++;
+			Category.AssetBytes += Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+		}
+	}
+
+}
+
+FSMemoryCategory::FSMemoryCategory()
+	: NumInstances(0)
+	, InstanceBytes(0)
+	, NumAssets(0)
+	, AssetBytes(0)
+{
+}
+
+int64 FSMemoryCategory::GetAverageInstanceBytes() const
+{
+	return NumInstances > 0 ? InstanceBytes / NumInstances : 0;
+
+}
+
+void FSMemoryReport::Gather(UWorld* World, TArray<FSMemoryCategory>& OutCategories)
+{
+	OutCategories.Reset();
+
+	if (World == NULL) {
+		return;
+	}
+
+	// Categories are filled through references, which must not move
+	OutCategories.Reserve(6);
+
+	FSMemoryCategory& Characters = OutCategories.AddDefaulted_GetRef();
+	Characters.Name = TEXT("Characters");
+
+	FSMemoryCategory& Weapons = OutCategories.AddDefaulted_GetRef();
+	Weapons.Name = TEXT("Weapons");
+
+	FSMemoryCategory& Pickups = OutCategories.AddDefaulted_GetRef();
+	Pickups.Name = TEXT("Pickups");
+
+	FSMemoryCategory& FrozenPickups = OutCategories.AddDefaulted_GetRef();
+	FrozenPickups.Name = TEXT("FrozenPickups");
+
+	FSMemoryCategory& Animation = OutCategories.AddDefaulted_GetRef();
+	Animation.Name = TEXT("Animation");
+
+	FSMemoryCategory& PhysicsBodies = OutCategories.AddDefaulted_GetRef();
+	PhysicsBodies.Name = TEXT("PhysicsBodies");
+
+	// Actors - pooled ones included, they still hold their memory
+	TSet<UObject*> CharacterAssets;
+	TSet<UObject*> WeaponAssets;
+	TSet<UObject*> PickupAssets;
+
+	for (TActorIterator<AActor> It(World); It; ++It) {
+		if (It->IsA<ASCharacter>()) {
+			AddActor(*It, Characters, CharacterAssets);
+		}
+		else if (It->IsA<ASWeapon>()) {
+			AddActor(*It, Weapons, WeaponAssets);
+		}
+		else if (It->IsA<ASWeaponPickup>()) {
+			AddActor(*It, Pickups, PickupAssets);
+		}
+	}
+
+	AddAssets(CharacterAssets, Characters);
+	AddAssets(WeaponAssets, Weapons);
+	AddAssets(PickupAssets, Pickups);
+
+	// Frozen pickups are a single instance each in the instance manager, their actors are pooled and counted above
+	ASPickupInstanceManager* PickupInstanceManager = GetWorldManager<ASPickupInstanceManager>(World, false);
+
+	if (PickupInstanceManager != NULL) {
+		FrozenPickups.NumInstances = PickupInstanceManager->GetNumFrozen();
+		FrozenPickups.InstanceBytes = PickupInstanceManager->GetFrozenBytes();
+	}
+
+	// Anim instances of the world and every animation loaded
+	TSet<UObject*> AnimationAssets;
+
+	for (TObjectIterator<UAnimInstance> It; It; ++It) {
+		if (It->GetWorld() == World && !It->IsTemplate()) {
+			Animation.NumInstances++;
+			Animation.InstanceBytes += GetObjectBytes(*It);
+		}
+	}
+
+	for (TObjectIterator<UAnimSequenceBase> It; It; ++It) {
+		if (!It->IsTemplate()) {
+			AnimationAssets.Add(*It);
+		}
+	}
+
+	AddAssets(AnimationAssets, Animation);
+
+	// Body instances with a physics state - the physics engine side is in the LLM PhysX tag
+	for (TObjectIterator<UPrimitiveComponent> It; It; ++It) {
+		if (It->GetWorld() != World || !It->IsPhysicsStateCreated()) {
+			continue;
+		}
+
+		const USkeletalMeshComponent* SkeletalMeshComp = Cast<USkeletalMeshComponent>(*It);
+		const int32 NumBodies = SkeletalMeshComp != NULL ? SkeletalMeshComp->Bodies.Num() : 1;
+
+		PhysicsBodies.NumInstances += NumBodies;
+		PhysicsBodies.InstanceBytes += NumBodies * sizeof(FBodyInstance);
+	}
+
+}
+
+void FSMemoryReport::Log(UWorld* World)
+{
+	TArray<FSMemoryCategory> Categories;
+	Gather(World, Categories);
+
+	UE_LOG(LogDarkHours, Log, TEXT("Memory: %-14s %10s %12s %12s %8s %12s"), TEXT("Category"), TEXT("Instances"), TEXT("InstanceKB"), TEXT("AvgKB"), TEXT("Assets"), TEXT("AssetKB"));
+
+	for (const FSMemoryCategory& Category : Categories) {
+		UE_LOG(LogDarkHours, Log, TEXT("Memory: %-14s %10d %12.1f %12.2f %8d %12.1f"), *Category.Name, Category.NumInstances, Category.InstanceBytes / 1024.0, Category.GetAverageInstanceBytes() / 1024.0, Category.NumAssets, Category.AssetBytes / 1024.0);
+	}
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	UE_LOG(LogDarkHours, Log, TEXT("Memory: allocations per DarkHours LLM tag are in 'stat LLMFULL' (run with -LLM)"));
+#endif
+
+}
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SMovementBenchmark.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "SCharacterMovementComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+
+static void StartMovementBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	if (World == NULL || World->GetNetMode() != NM_Client) {
+		UE_LOG(LogDarkHours, Warning, TEXT("Movement: run the benchmark on a client connected to a server"));
+		return;
+	}
+
+	ASMovementBenchmark* Benchmark = Cast<ASMovementBenchmark>(ASBenchmark::Start(World, ASMovementBenchmark::StaticClass()));
+
+	if (Benchmark != NULL) {
+		if (Args.Num() > 0) {
+			Benchmark->LagMs = FMath::Max(FCString::Atoi(*Args[0]), 0);
+		}
+
+		if (Args.Num() > 1) {
+			Benchmark->LossPercent = FMath::Clamp(FCString::Atoi(*Args[1]), 0, 100);
+		}
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs MovementBenchmarkCommand(
+	TEXT("DarkHours.Bench.Movement"),
+	TEXT("Counts server position corrections while sprinting, aiming and crouching under simulated latency and packet loss. Args: [LagMs] [LossPercent]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartMovementBenchmark));
+
+// Sets default values
+ASMovementBenchmark::ASMovementBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("Movement");
+	NumPasses = 3;
+	SampleFrames = 1200;
+	LagMs = 100;
+	LossPercent = 5;
+
+	MoveTime = 0.f;
+	bSampling = false;
+
+}
+
+void ASMovementBenchmark::BeginPass(int32 PassIndex)
+{
+	// Pass 0 is clean, pass 1 adds latency, pass 2 adds packet loss on top
+	SetPacketEmulation(PassIndex > 0 ? LagMs : 0, PassIndex > 1 ? LossPercent : 0);
+
+	MoveTime = 0.f;
+	bSampling = false;
+
+}
+
+void ASMovementBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	ASCharacter* Character = Cast<ASCharacter>(UGameplayStatics::GetPlayerPawn(this, 0));
+
+	if (Character == NULL) {
+		return;
+	}
+
+	USCharacterMovementComponent* MovementComp = Character->GetSCharacterMovement();
+
+	if (!bSampling) { // Only count the sampled frames
+		MovementComp->ResetCorrections();
+		bSampling = true;
+	}
+
+	MoveTime += DeltaTime;
+
+	// Walk a slow circle, sprinting every other second, aiming and crouching at other rates
+	const float Angle = MoveTime * 0.5f;
+
+	Character->AddMovementInput(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f), 1.f / 3.f);
+
+	MovementComp->SetSprinting(FMath::FloorToInt(MoveTime) % 2 == 0);
+	MovementComp->SetAiming(FMath::FloorToInt(MoveTime / 1.5f) % 2 == 1);
+
+	const bool bShouldCrouch = FMath::FloorToInt(MoveTime / 4.f) % 2 == 1;
+
+	if (bShouldCrouch != MovementComp->IsCrouching()) {
+		if (bShouldCrouch) {
+			Character->Crouch();
+		}
+		else {
+			Character->UnCrouch();
+		}
+	}
+
+}
+
+void ASMovementBenchmark::EndPass(int32 PassIndex)
+{
+	static const TCHAR* PassNames[] = { TEXT("Clean"), TEXT("Lag"), TEXT("LagLoss") };
+
+	const FString PassName = PassNames[FMath::Clamp(PassIndex, 0, 2)];
+
+	ASCharacter* Character = Cast<ASCharacter>(UGameplayStatics::GetPlayerPawn(this, 0));
+
+	const int32 NumCorrections = Character != NULL ? Character->GetSCharacterMovement()->GetNumCorrections() : 0;
+
+	AddResult(PassName + TEXT(".Corrections"), NumCorrections);
+	AddResult(PassName + TEXT(".CorrectionsPerMinute"), MoveTime > 0.f ? NumCorrections * 60.0 / MoveTime : 0.0);
+
+	ReleaseInput();
+
+	if (PassIndex == NumPasses - 1) {
+		SetPacketEmulation(0, 0);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASMovementBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ReleaseInput();
+	SetPacketEmulation(0, 0);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASMovementBenchmark::SetPacketEmulation(int32 InLagMs, int32 InLossPercent)
+{
+	if (GEngine != NULL && GetWorld() != NULL) {
+		GEngine->Exec(GetWorld(), *FString::Printf(TEXT("Net PktLag=%d PktLoss=%d"), InLagMs, InLossPercent));
+	}
+
+}
+
+void ASMovementBenchmark::ReleaseInput()
+{
+	ASCharacter* Character = Cast<ASCharacter>(UGameplayStatics::GetPlayerPawn(this, 0));
+
+	if (Character != NULL) {
+		Character->GetSCharacterMovement()->SetSprinting(false);
+		Character->GetSCharacterMovement()->SetAiming(false);
+		Character->UnCrouch();
+	}
+
+}
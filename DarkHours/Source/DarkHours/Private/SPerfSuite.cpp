@@ -0,0 +1,374 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SPerfSuite.h"
+#include "DarkHours.h"
+#include "SActorPool.h"
+#include "SCharacter.h"
+#include "SWeaponPickup.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderCore.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+static void StartPerfSuite(const TArray<FString>& Args, UWorld* World)
+{
+	ASPerfSuite* Suite = ASPerfSuite::StartScenarios(World);
+
+	if (Suite != NULL) {
+		if (Args.Num() > 0) {
+			Suite->NumCharacters = FMath::Max(FCString::Atoi(*Args[0]), 0);
+		}
+
+		if (Args.Num() > 1) {
+			Suite->NumPickups = FMath::Max(FCString::Atoi(*Args[1]), 0);
+		}
+
+		if (Args.Num() > 2) {
+			Suite->SwapsPerFrame = FMath::Max(FCString::Atoi(*Args[2]), 0);
+		}
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PerfSuiteCommand(
+	TEXT("DarkHours.PerfSuite"),
+	TEXT("Runs the perf scenarios, writes Saved/Benchmarks/PerfSuite.json and fails on blown budgets. Args: [NumCharacters] [NumPickups] [SwapsPerFrame]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartPerfSuite));
+
+// Sets default values
+ASPerfSuite::ASPerfSuite()
+{
+	// Variables
+	BenchmarkName = TEXT("PerfSuite");
+	NumPasses = NumScenarios;
+	FirstScenario = 0;
+	WarmupFrames = 60;
+	SampleFrames = 300;
+
+	NumCharacters = 100;
+	NumPickups = 256;
+	SwapsPerFrame = 10;
+	PickupClassPath = TEXT("/Game/Blueprints/Pickup/Weapons/Primary/BP_AR4_Pickup.BP_AR4_Pickup_C");
+
+	NextPickup = NULL;
+
+	LastFrameTime = 0.0;
+	InputTime = 0.f;
+	NumSpawnedActors = 0;
+	NumSwaps = 0;
+	MaxUsedPhysical = 0;
+
+}
+
+ASPerfSuite* ASPerfSuite::StartScenarios(UWorld* World, int32 InFirstScenario, int32 NumToRun)
+{
+	ASPerfSuite* Suite = Cast<ASPerfSuite>(ASBenchmark::Start(World, ASPerfSuite::StaticClass()));
+
+	if (Suite != NULL) {
+		Suite->FirstScenario = FMath::Clamp(InFirstScenario, 0, NumScenarios - 1);
+		Suite->NumPasses = FMath::Clamp(NumToRun, 1, NumScenarios - Suite->FirstScenario);
+	}
+
+	return Suite;
+
+}
+
+const TCHAR* ASPerfSuite::GetScenarioName(int32 Scenario)
+{
+	switch (Scenario) {
+		case 0:
+			return TEXT("Characters");
+
+		case 1:
+			return TEXT("Pickups");
+
+		default:
+			return TEXT("Swaps");
+	}
+
+}
+
+void ASPerfSuite::BeginPass(int32 PassIndex)
+{
+	if (PassIndex == 0) {
+		PickupClass = LoadClass<ASWeaponPickup>(NULL, *PickupClassPath);
+
+		if (PickupClass == NULL) {
+			UE_LOG(LogDarkHours, Warning, TEXT("%s: could not load pickup class %s"), *BenchmarkName, *PickupClassPath);
+		}
+
+		ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ASPerfSuite::OnActorSpawned));
+	}
+
+	// Every scenario starts from an empty scene
+	DestroyCharacters();
+	ReleasePickups();
+
+	NumSpawnedActors = 0;
+
+	const int32 Scenario = FirstScenario + PassIndex;
+	const TSubclassOf<ASCharacter> CharacterClass = ResolveCharacterClass(FString());
+
+	if (Scenario == 0) {
+		// Characters run around under AI controllers, fed through their input bindings
+		for (int32 Index = 0; Index < NumCharacters; Index++) {
+			ASCharacter* Character = SpawnCharacter(CharacterClass, Index);
+
+			if (Character != NULL && Character->Controller == NULL) {
+				Character->SpawnDefaultController();
+			}
+		}
+
+		PreviousFrames.SetNum(SpawnedCharacters.Num());
+	}
+	else if (Scenario == 1) {
+		// Pickups are dropped from above the ground and settle during warmup and sampling
+		for (int32 Index = 0; Index < NumPickups && PickupClass != NULL; Index++) {
+			ASWeaponPickup* Pickup = ASActorPool::Acquire<ASWeaponPickup>(this, PickupClass, FTransform(FRotator(0.f, Index * 37.f, 0.f), GetGridLocation(Index, 16, 150.f) + FVector(0.f, 0.f, 300.f)));
+
+			if (Pickup != NULL) {
+				Pickups.Add(Pickup);
+			}
+		}
+	}
+	else {
+		// Arm a character, then swap with the dropped pickups over and over
+		ASCharacter* Character = SpawnCharacter(CharacterClass, 0);
+
+		if (Character != NULL && PickupClass != NULL) {
+			const FTransform PickupTransform(FRotator::ZeroRotator, Character->GetActorLocation());
+
+			Character->Interaction_PrimaryWeapon(ASActorPool::Acquire<ASWeaponPickup>(this, PickupClass, PickupTransform));
+
+			NextPickup = ASActorPool::Acquire<ASWeaponPickup>(this, PickupClass, PickupTransform);
+		}
+	}
+
+	FrameMs.Reset(SampleFrames);
+	GameThreadMs.Reset(SampleFrames);
+
+	LastFrameTime = 0.0;
+	NumSwaps = 0;
+	MaxUsedPhysical = 0;
+
+}
+
+void ASPerfSuite::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (LastFrameTime == 0.0) { // Drop anything accumulated during warmup
+		FSPerfCounters::Reset();
+		FSPerfCounters::SetCapturing(true);
+	}
+	else {
+		FrameMs.Add((float)((Now - LastFrameTime) * 1000.0));
+		GameThreadMs.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+	}
+
+	LastFrameTime = Now;
+
+	MaxUsedPhysical = FMath::Max<uint64>(MaxUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+	const int32 Scenario = FirstScenario + PassIndex;
+
+	if (Scenario == 0) {
+		InputTime += DeltaTime;
+
+		MoveCharacters();
+	}
+	else if (Scenario == 2) {
+		ASCharacter* Character = SpawnedCharacters.Num() > 0 ? SpawnedCharacters[0] : NULL;
+
+		for (int32 Swap = 0; Swap < SwapsPerFrame && Character != NULL && NextPickup != NULL; Swap++) {
+			NextPickup = Character->Interaction_PrimaryWeapon(NextPickup);
+			NumSwaps++;
+		}
+	}
+
+}
+
+void ASPerfSuite::EndPass(int32 PassIndex)
+{
+	FSPerfCounters::SetCapturing(false);
+
+	FSPerfScenarioResult& Scenario = Results.AddDefaulted_GetRef();
+	Scenario.Name = GetScenarioName(FirstScenario + PassIndex);
+
+	const int32 NumFrames = FMath::Max(FrameMs.Num(), 1);
+
+	// Frame and game thread time
+	TArray<float> SortedFrameMs = FrameMs;
+	SortedFrameMs.Sort();
+
+	double TotalFrameMs = 0.0;
+	double TotalGameThreadMs = 0.0;
+
+	for (int32 Index = 0; Index < FrameMs.Num(); Index++) {
+		TotalFrameMs += FrameMs[Index];
+		TotalGameThreadMs += GameThreadMs[Index];
+	}
+
+	AddMetric(Scenario, TEXT("Frames"), FrameMs.Num());
+	AddMetric(Scenario, TEXT("FrameMsAvg"), TotalFrameMs / NumFrames);
+	AddMetric(Scenario, TEXT("FrameMsP95"), SortedFrameMs.Num() > 0 ? SortedFrameMs[FMath::Min(SortedFrameMs.Num() * 95 / 100, SortedFrameMs.Num() - 1)] : 0.0);
+	AddMetric(Scenario, TEXT("FrameMsMax"), SortedFrameMs.Num() > 0 ? SortedFrameMs.Last() : 0.0);
+	AddMetric(Scenario, TEXT("GameThreadMsAvg"), TotalGameThreadMs / NumFrames);
+
+	// Time per subsystem, summed over all threads
+	TArray<TPair<FString, double>> CounterSeconds;
+	FSPerfCounters::GetSeconds(CounterSeconds);
+
+	for (const TPair<FString, double>& Counter : CounterSeconds) {
+		AddMetric(Scenario, Counter.Key + TEXT("MsPerFrame"), Counter.Value * 1000.0 / NumFrames);
+	}
+
+	// Workload and memory
+	AddMetric(Scenario, TEXT("Characters"), SpawnedCharacters.Num());
+	AddMetric(Scenario, TEXT("Pickups"), Pickups.Num());
+	AddMetric(Scenario, TEXT("Swaps"), NumSwaps);
+	AddMetric(Scenario, TEXT("SpawnedActors"), NumSpawnedActors);
+	AddMetric(Scenario, TEXT("UsedPhysicalMaxMB"), MaxUsedPhysical / (1024.0 * 1024.0));
+	AddMetric(Scenario, TEXT("PeakUsedPhysicalMB"), FPlatformMemory::GetStats().PeakUsedPhysical / (1024.0 * 1024.0));
+
+	if (PassIndex == NumPasses - 1) {
+		FinishSuite();
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASPerfSuite::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FSPerfCounters::SetCapturing(false);
+
+	if (ActorSpawnedHandle.IsValid()) {
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	ReleasePickups();
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASPerfSuite::MoveCharacters()
+{
+	for (int32 Index = 0; Index < SpawnedCharacters.Num(); Index++) {
+		ASCharacter* Character = SpawnedCharacters[Index];
+
+		if (Character == NULL) {
+			continue;
+		}
+
+		// Run forward while slowly turning, sprint every other character
+		FSInputFrame Frame;
+		Frame.SetMove(1.f, FMath::Sin(InputTime + Index) * 0.5f);
+		Frame.SetControlRotation(FRotator(0.f, InputTime * 30.f + Index * 37.f, 0.f));
+		Frame.SetAction(ESInputAction::Sprint, (Index % 2) == 0);
+		Frame.PressedActions &= ~PreviousFrames[Index].HeldActions;
+
+		Character->ApplyInputFrame(Frame, PreviousFrames[Index]);
+
+		PreviousFrames[Index] = Frame;
+	}
+
+}
+
+void ASPerfSuite::ReleasePickups()
+{
+	for (ASWeaponPickup* Pickup : Pickups) {
+		if (Pickup != NULL && !Pickup->IsPendingKill()) {
+			ASActorPool::ReleaseActor(Pickup);
+		}
+	}
+
+	Pickups.Reset();
+
+	if (NextPickup != NULL && !NextPickup->IsPendingKill()) {
+		ASActorPool::ReleaseActor(NextPickup);
+	}
+
+	NextPickup = NULL;
+
+}
+
+void ASPerfSuite::AddMetric(FSPerfScenarioResult& Scenario, const FString& Name, double Value)
+{
+	Scenario.Metrics.Emplace(Name, Value);
+
+	AddResult(Scenario.Name + TEXT(".") + Name, Value);
+
+}
+
+void ASPerfSuite::FinishSuite()
+{
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	TSharedRef<FJsonObject> ScenariosObject = MakeShared<FJsonObject>();
+	TArray<TSharedPtr<FJsonValue>> FailuresArray;
+
+	for (const FSPerfScenarioResult& Scenario : Results) {
+		TSharedRef<FJsonObject> MetricsObject = MakeShared<FJsonObject>();
+
+		for (const TPair<FString, double>& Metric : Scenario.Metrics) {
+			MetricsObject->SetNumberField(Metric.Key, Metric.Value);
+		}
+
+		ScenariosObject->SetObjectField(Scenario.Name, MetricsObject);
+	}
+
+	// Budgets
+	for (const FSPerfBudget& Budget : Budgets) {
+		const FSPerfScenarioResult* Scenario = Results.FindByPredicate([&Budget](const FSPerfScenarioResult& Entry) { return Entry.Name == Budget.Scenario; });
+		// Scenario not part of this run
+		if (Scenario == NULL) {
+			continue;
+		}
+
+		const TPair<FString, double>* Metric = Scenario->Metrics.FindByPredicate([&Budget](const TPair<FString, double>& Entry) { return Entry.Key == Budget.Metric; });
+
+		if (Metric == NULL) {
+			UE_LOG(LogDarkHours, Warning, TEXT("%s: budget %s.%s matches no metric"), *BenchmarkName, *Budget.Scenario, *Budget.Metric);
+			continue;
+		}
+
+		if (Metric->Value > Budget.Max) {
+			const FString Failure = FString::Printf(TEXT("%s.%s = %.3f over budget %.3f"), *Budget.Scenario, *Budget.Metric, Metric->Value, Budget.Max);
+
+			MarkFailed(Failure);
+
+			FailuresArray.Add(MakeShared<FJsonValueString>(Failure));
+		}
+	}
+
+	Report->SetStringField(TEXT("Map"), GetWorld()->GetMapName());
+	Report->SetBoolField(TEXT("Passed"), FailuresArray.Num() == 0);
+	Report->SetArrayField(TEXT("Failures"), FailuresArray);
+	Report->SetObjectField(TEXT("Scenarios"), ScenariosObject);
+
+	FString ReportString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ReportString);
+
+	FJsonSerializer::Serialize(Report, Writer);
+
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / BenchmarkName + TEXT(".json");
+
+	if (!FFileHelper::SaveStringToFile(ReportString, *ReportPath)) {
+		UE_LOG(LogDarkHours, Warning, TEXT("%s: failed to write report to %s"), *BenchmarkName, *ReportPath);
+	}
+
+	UE_LOG(LogDarkHours, Log, TEXT("%s: %s, %d budget(s) blown"), *BenchmarkName, FailuresArray.Num() == 0 ? TEXT("passed") : TEXT("FAILED"), FailuresArray.Num());
+
+}
+
+void ASPerfSuite::OnActorSpawned(AActor* Actor)
+{
+	NumSpawnedActors++;
+
+}
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SPerfSuite.h"
+#include "DarkHours.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Map the scenarios are built for
+static const TCHAR* PerfSuiteMap = TEXT("/Game/Levels/Prototype");
+
+// Seconds a scenario may take before the test gives up - warmup and sampling take a few seconds at 60 fps
+static const double PerfSuiteTimeout = 600.0;
+
+// What a running scenario left behind for the test, kept past the suite destroying itself
+struct FSPerfSuiteTestState
+{
+	TWeakObjectPtr<ASPerfSuite> Suite;
+
+	bool bStarted;
+
+	bool bFinished;
+
+	TArray<FString> Failures;
+
+	FSPerfSuiteTestState()
+		: bStarted(false)
+		, bFinished(false)
+	{
+	}
+
+};
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FSStartPerfScenarioCommand, int32, Scenario, TSharedRef<FSPerfSuiteTestState>, State);
+
+bool FSStartPerfScenarioCommand::Update()
+{
+	UWorld* World = AutomationCommon::GetAnyGameWorld();
+	ASPerfSuite* Suite = World != NULL ? ASPerfSuite::StartScenarios(World, Scenario, 1) : NULL;
+
+	if (Suite != NULL) {
+		TSharedRef<FSPerfSuiteTestState> TestState = State;
+
+		Suite->OnFinished.AddLambda([TestState](ASBenchmark* Benchmark) {
+			TestState->bFinished = true;
+			TestState->Failures = Benchmark->GetFailures();
+		});
+
+		State->Suite = Suite;
+		State->bStarted = true;
+	}
+	else {
+		State->Failures.Add(TEXT("could not start the perf suite, no game world"));
+		State->bFinished = true;
+	}
+
+	return true;
+
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FSWaitForPerfScenarioCommand, FAutomationTestBase*, Test, TSharedRef<FSPerfSuiteTestState>, State);
+
+bool FSWaitForPerfScenarioCommand::Update()
+{
+	if (!State->bFinished) {
+		// Torn down with the world, or stuck
+		if (State->bStarted && !State->Suite.IsValid()) {
+			State->Failures.Add(TEXT("the perf suite ended before finishing its scenario"));
+		}
+		else if (GetCurrentRunTime() > PerfSuiteTimeout) {
+			State->Failures.Add(FString::Printf(TEXT("the scenario did not finish within %.0f seconds"), PerfSuiteTimeout));
+		}
+		else {
+			return false;
+		}
+	}
+
+	// Blown budgets and broken scenarios fail the test
+	for (const FString& Failure : State->Failures) {
+		Test->AddError(Failure);
+	}
+
+	if (State->Suite.IsValid()) {
+		State->Suite->Destroy();
+	}
+
+	return true;
+
+}
+
+/**
+ * Runs each scenario of the perf suite on the Prototype map and fails on any blown budget of
+ * [/Script/DarkHours.SPerfSuite]. Reports are written to Saved/Benchmarks like the console command does.
+ * Headless: DarkHours /Game/Levels/Prototype -game -nullrhi -ExecCmds="Automation RunTests DarkHours.PerfSuite;Quit"
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FSPerfSuiteTest, "DarkHours.PerfSuite", EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FSPerfSuiteTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (int32 Scenario = 0; Scenario < ASPerfSuite::NumScenarios; Scenario++) {
+		OutBeautifiedNames.Add(ASPerfSuite::GetScenarioName(Scenario));
+		OutTestCommands.Add(FString::FromInt(Scenario));
+	}
+
+}
+
+bool FSPerfSuiteTest::RunTest(const FString& Parameters)
+{
+	const int32 Scenario = FCString::Atoi(*Parameters);
+
+	AutomationOpenMap(PerfSuiteMap);
+
+	TSharedRef<FSPerfSuiteTestState> State = MakeShared<FSPerfSuiteTestState>();
+
+	ADD_LATENT_AUTOMATION_COMMAND(FSStartPerfScenarioCommand(Scenario, State));
+	ADD_LATENT_AUTOMATION_COMMAND(FSWaitForPerfScenarioCommand(this, State));
+
+	return true;
+
+}
+
+#endif
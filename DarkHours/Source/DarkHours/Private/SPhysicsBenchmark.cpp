@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SPhysicsBenchmark.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "SPhysicsBudgetManager.h"
+#include "SWorldManager.h"
+#include "DestructibleActor.h"
+#include "DestructibleComponent.h"
+#include "DestructibleMesh.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "RenderCore.h"
+
+static void StartPhysicsBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	ASPhysicsBenchmark* Benchmark = Cast<ASPhysicsBenchmark>(ASBenchmark::Start(World, ASPhysicsBenchmark::StaticClass()));
+
+	if (Benchmark == NULL) {
+		return;
+	}
+
+	if (Args.Num() > 0) {
+		Benchmark->DestructibleMesh = LoadObject<UDestructibleMesh>(NULL, *Args[0]);
+
+		if (Benchmark->DestructibleMesh == NULL) {
+			UE_LOG(LogDarkHours, Warning, TEXT("Benchmark Physics: no destructible mesh at %s, only ragdolls are spawned"), *Args[0]);
+		}
+	}
+
+	if (Args.Num() > 1) {
+		Benchmark->NumDestructibles = FMath::Max(FCString::Atoi(*Args[1]), 0);
+	}
+
+	if (Args.Num() > 2) {
+		Benchmark->NumRagdolls = FMath::Max(FCString::Atoi(*Args[2]), 0);
+	}
+
+	if (Args.Num() > 3) {
+		Benchmark->CharacterClassPath = Args[3];
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PhysicsBenchmarkCommand(
+	TEXT("DarkHours.Bench.Physics"),
+	TEXT("Destroys a field of destructibles and ragdolls a crowd with one explosion, without and with the physics budget. Args: [DestructibleMeshPath] [NumDestructibles=48] [NumRagdolls=32] [CharacterClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartPhysicsBenchmark));
+
+// Sets default values
+ASPhysicsBenchmark::ASPhysicsBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("Physics");
+	NumPasses = 2;
+	SampleFrames = 180;
+	NumDestructibles = 48;
+	NumRagdolls = 32;
+
+	DestructibleMesh = NULL;
+
+	LastFrameTime = 0.0;
+	MaxDestructibleChunks = 0;
+	MaxRagdolls = 0;
+	StartRetirements = 0;
+	bWasBudgetEnabled = true;
+
+}
+
+void ASPhysicsBenchmark::BeginPass(int32 PassIndex)
+{
+	if (PassIndex == 0) {
+		IConsoleVariable* BudgetVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Physics.Budget"));
+		bWasBudgetEnabled = BudgetVar == NULL || BudgetVar->GetInt() != 0;
+	}
+
+	// Pass 0 lets everything simulate, pass 1 holds it to the budget
+	SetBudgetEnabled(PassIndex > 0);
+
+	ASPhysicsBudgetManager* PhysicsBudgetManager = ASPhysicsBudgetManager::Get(this);
+
+	// Destructibles behind the origin, characters in front of it - all in reach of the explosion
+	if (DestructibleMesh != NULL && PhysicsBudgetManager != NULL) {
+		FActorSpawnParameters SpawnInfos;
+		SpawnInfos.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		for (int32 Index = 0; Index < NumDestructibles; Index++) {
+			FVector Location = GetGridLocation(Index, 16, 300.f);
+			Location.X = 2.f * GetActorLocation().X - Location.X;
+
+			ADestructibleActor* DestructibleActor = GetWorld()->SpawnActor<ADestructibleActor>(ADestructibleActor::StaticClass(), Location, FRotator::ZeroRotator, SpawnInfos);
+
+			if (DestructibleActor == NULL) {
+				continue;
+			}
+
+			// Cosmetic debris, like most of the level - registered again so it moves to the async scene
+			UDestructibleComponent* Destructible = DestructibleActor->GetDestructibleComponent();
+			Destructible->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+			Destructible->SetDestructibleMesh(DestructibleMesh);
+
+			PhysicsBudgetManager->RegisterDestructible(Destructible);
+
+			SpawnedDestructibles.Add(DestructibleActor);
+		}
+	}
+
+	TSubclassOf<ASCharacter> CharacterClass = ResolveCharacterClass(CharacterClassPath);
+
+	for (int32 Index = 0; Index < NumRagdolls; Index++) {
+		SpawnCharacter(CharacterClass, Index);
+	}
+
+	if (SpawnedDestructibles.Num() == 0 && SpawnedCharacters.Num() == 0) {
+		MarkFailed(TEXT("nothing to destroy - pass a destructible mesh or a ragdoll count"));
+	}
+
+	FrameMs.Reset(SampleFrames);
+	GameThreadMs.Reset(SampleFrames);
+
+	LastFrameTime = 0.0;
+	MaxDestructibleChunks = 0;
+	MaxRagdolls = 0;
+	StartRetirements = PhysicsBudgetManager != NULL ? PhysicsBudgetManager->GetNumRetirements() : 0;
+
+}
+
+void ASPhysicsBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (LastFrameTime > 0.0) {
+		FrameMs.Add((float)((Now - LastFrameTime) * 1000.0));
+		GameThreadMs.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+	}
+	else { // Everything goes off on the first sampled frame
+		Explode();
+	}
+
+	LastFrameTime = Now;
+
+	ASPhysicsBudgetManager* PhysicsBudgetManager = GetWorldManager<ASPhysicsBudgetManager>(this, false);
+
+	if (PhysicsBudgetManager != NULL) {
+		MaxDestructibleChunks = FMath::Max(MaxDestructibleChunks, PhysicsBudgetManager->GetNumDestructibleChunks());
+		MaxRagdolls = FMath::Max(MaxRagdolls, PhysicsBudgetManager->GetNumRagdolls());
+	}
+
+}
+
+void ASPhysicsBenchmark::EndPass(int32 PassIndex)
+{
+	const FString PassName = PassIndex == 0 ? TEXT("Unbudgeted") : TEXT("Budgeted");
+
+	const int32 NumFrames = FrameMs.Num();
+
+	if (NumFrames > 0) {
+		TArray<float> SortedFrameMs = FrameMs;
+		SortedFrameMs.Sort();
+
+		double TotalFrameMs = 0.0;
+		double TotalGameThreadMs = 0.0;
+		float MaxGameThreadMs = 0.f;
+
+		for (int32 Index = 0; Index < NumFrames; Index++) {
+			TotalFrameMs += FrameMs[Index];
+			TotalGameThreadMs += GameThreadMs[Index];
+			MaxGameThreadMs = FMath::Max(MaxGameThreadMs, GameThreadMs[Index]);
+		}
+
+		AddResult(PassName + TEXT(".FrameMsAvg"), TotalFrameMs / NumFrames);
+		AddResult(PassName + TEXT(".FrameMsP95"), SortedFrameMs[FMath::Min(NumFrames * 95 / 100, NumFrames - 1)]);
+		AddResult(PassName + TEXT(".FrameMsMax"), SortedFrameMs.Last());
+		AddResult(PassName + TEXT(".GameThreadMsAvg"), TotalGameThreadMs / NumFrames);
+		AddResult(PassName + TEXT(".GameThreadMsMax"), MaxGameThreadMs);
+	}
+
+	ASPhysicsBudgetManager* PhysicsBudgetManager = GetWorldManager<ASPhysicsBudgetManager>(this, false);
+
+	AddResult(PassName + TEXT(".MaxDestructibleChunks"), MaxDestructibleChunks);
+	AddResult(PassName + TEXT(".MaxRagdolls"), MaxRagdolls);
+	AddResult(PassName + TEXT(".Retirements"), PhysicsBudgetManager != NULL ? PhysicsBudgetManager->GetNumRetirements() - StartRetirements : 0);
+
+	// Next pass starts from a fresh field
+	DestroyDestructibles();
+	DestroyCharacters();
+
+	if (PassIndex == NumPasses - 1) {
+		SetBudgetEnabled(bWasBudgetEnabled);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASPhysicsBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DestroyDestructibles();
+
+	SetBudgetEnabled(bWasBudgetEnabled);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASPhysicsBenchmark::Explode()
+{
+	const FVector Origin = GetActorLocation();
+
+	for (ADestructibleActor* DestructibleActor : SpawnedDestructibles) {
+		if (DestructibleActor != NULL && !DestructibleActor->IsPendingKill()) {
+			DestructibleActor->GetDestructibleComponent()->ApplyRadiusDamage(100000.f, Origin, 10000.f, 50000.f, true);
+		}
+	}
+
+	for (ASCharacter* Character : SpawnedCharacters) {
+		if (Character != NULL && !Character->IsPendingKill()) {
+			const FVector Location = Character->GetActorLocation();
+
+			Character->StartRagdoll(((Location - Origin).GetSafeNormal2D() + FVector::UpVector) * 20000.f, Location);
+		}
+	}
+
+}
+
+void ASPhysicsBenchmark::DestroyDestructibles()
+{
+	for (ADestructibleActor* DestructibleActor : SpawnedDestructibles) {
+		if (DestructibleActor != NULL && !DestructibleActor->IsPendingKill()) {
+			DestructibleActor->Destroy();
+		}
+	}
+
+	SpawnedDestructibles.Reset();
+
+}
+
+void ASPhysicsBenchmark::SetBudgetEnabled(bool bEnabled)
+{
+	IConsoleVariable* BudgetVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Physics.Budget"));
+
+	if (BudgetVar != NULL) {
+		BudgetVar->Set(bEnabled ? 1 : 0, ECVF_SetByCode);
+	}
+
+}
@@ -0,0 +1,421 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SPhysicsBudgetManager.h"
+#include "DarkHours.h"
+#include "SWorldManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "DestructibleActor.h"
+#include "DestructibleComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarPhysicsBudgetEnable(
+	TEXT("DarkHours.Physics.Budget"),
+	1,
+	TEXT("1: retire destructible debris and ragdolls over the physics budget. 0: let everything simulate."),
+	ECVF_Default);
+
+static void LogPhysicsReport(UWorld* World)
+{
+	ASPhysicsBudgetManager* PhysicsBudgetManager = GetWorldManager<ASPhysicsBudgetManager>(World, false);
+
+	if (PhysicsBudgetManager != NULL) {
+		PhysicsBudgetManager->LogReport();
+	}
+	else {
+		UE_LOG(LogDarkHours, Log, TEXT("Physics: no physics budget manager in this world"));
+	}
+
+}
+
+static FAutoConsoleCommandWithWorld PhysicsReportCommand(
+	TEXT("DarkHours.Physics.Report"),
+	TEXT("Logs the destructible chunks and ragdolls simulating against their budget."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogPhysicsReport));
+
+// Returns the visible chunks of a fractured destructible, 0 while it is whole - APEX hides the bone of every chunk it replaces
+static int32 GetNumVisibleChunks(const UDestructibleComponent* Destructible)
+{
+	const int32 NumBones = Destructible->GetNumBones();
+
+	if (NumBones <= 1 || !Destructible->IsBoneHidden(UDestructibleComponent::ChunkIdxToBoneIdx(0))) {
+		return 0;
+	}
+
+	int32 NumChunks = 0;
+
+	for (int32 BoneIndex = UDestructibleComponent::ChunkIdxToBoneIdx(1); BoneIndex < NumBones; BoneIndex++) {
+		NumChunks += Destructible->IsBoneHidden(BoneIndex) ? 0 : 1;
+	}
+
+	return NumChunks;
+
+}
+
+// Sets default values
+ASPhysicsBudgetManager::ASPhysicsBudgetManager()
+{
+	// Counted after the physics step, so the chunks of this frame's fractures are retired before the next one
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	bReplicates = false;
+
+	// Variables
+	MaxDestructibleChunks = 300;
+	MaxRagdolls = 12;
+	MaxRetirementsPerUpdate = 8;
+	HiddenDistanceScale = 3.f;
+	AgeDistance = 500.f;
+	bCosmeticDestructiblesInAsyncScene = true;
+	UpdateInterval = 0.f;
+
+	NumDestructibleChunks = 0;
+	NumRagdolls = 0;
+	NumRetirements = 0;
+
+}
+
+// Called every frame
+void ASPhysicsBudgetManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateBudget();
+
+}
+
+// Called when the game starts or when spawned
+void ASPhysicsBudgetManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetActorTickInterval(UpdateInterval);
+
+	UWorld* World = GetWorld();
+
+	// Destructibles already in the world, then those streamed in or spawned later
+	for (ULevel* Level : World->GetLevels()) {
+		OnLevelAdded(Level, World);
+	}
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ASPhysicsBudgetManager::OnLevelAdded);
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ASPhysicsBudgetManager::OnActorSpawned));
+
+}
+
+// Called when the game ends or when destroyed
+void ASPhysicsBudgetManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	Entries.Reset();
+
+	SET_DWORD_STAT(STAT_DarkHours_DestructibleChunks, 0);
+	SET_DWORD_STAT(STAT_DarkHours_Ragdolls, 0);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+ASPhysicsBudgetManager* ASPhysicsBudgetManager::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASPhysicsBudgetManager>(WorldContextObject);
+
+}
+
+void ASPhysicsBudgetManager::RegisterDestructible(UDestructibleComponent* Destructible)
+{
+	if (Destructible == NULL || Destructible->IsPendingKill()) {
+		return;
+	}
+
+	// Debris nobody stands on simulates next to the frame instead of inside it - only while whole, recreating the physics state would mend it
+	if (bCosmeticDestructiblesInAsyncScene && Destructible->GetCollisionResponseToChannel(ECC_Pawn) != ECR_Block && !Destructible->BodyInstance.bUseAsyncScene && GetNumVisibleChunks(Destructible) == 0) {
+		Destructible->BodyInstance.SetUseAsyncScene(true);
+
+		if (Destructible->IsPhysicsStateCreated()) {
+			Destructible->RecreatePhysicsState();
+		}
+	}
+
+	if (Entries.ContainsByPredicate([Destructible](const FSPhysicsBodyEntry& Entry) { return Entry.Component == Destructible; })) {
+		return;
+	}
+
+	FSPhysicsBodyEntry Entry;
+	Entry.Component = Destructible;
+	Entry.Type = ESPhysicsBodyType::Destructible;
+	Entry.StartTime = 0.f;
+	Entry.NumChunks = 0;
+	Entry.Score = 0.f;
+
+	Entries.Add(Entry);
+
+}
+
+void ASPhysicsBudgetManager::RegisterRagdoll(USkeletalMeshComponent* Mesh)
+{
+	ASPhysicsBudgetManager* PhysicsBudgetManager = Get(Mesh);
+
+	if (PhysicsBudgetManager == NULL || PhysicsBudgetManager->Entries.ContainsByPredicate([Mesh](const FSPhysicsBodyEntry& Entry) { return Entry.Component == Mesh; })) {
+		return;
+	}
+
+	FSPhysicsBodyEntry Entry;
+	Entry.Component = Mesh;
+	Entry.Type = ESPhysicsBodyType::Ragdoll;
+	Entry.StartTime = PhysicsBudgetManager->GetWorld()->GetTimeSeconds();
+	Entry.NumChunks = 1;
+	Entry.Score = 0.f;
+
+	PhysicsBudgetManager->Entries.Add(Entry);
+
+}
+
+void ASPhysicsBudgetManager::UnregisterRagdoll(USkeletalMeshComponent* Mesh)
+{
+	ASPhysicsBudgetManager* PhysicsBudgetManager = GetWorldManager<ASPhysicsBudgetManager>(Mesh, false);
+
+	if (PhysicsBudgetManager != NULL) {
+		PhysicsBudgetManager->Entries.RemoveAllSwap([Mesh](const FSPhysicsBodyEntry& Entry) { return Entry.Component == Mesh; });
+	}
+
+}
+
+int32 ASPhysicsBudgetManager::GetNumDestructibleChunks() const
+{
+	return NumDestructibleChunks;
+
+}
+
+int32 ASPhysicsBudgetManager::GetNumRagdolls() const
+{
+	return NumRagdolls;
+
+}
+
+int32 ASPhysicsBudgetManager::GetNumRetirements() const
+{
+	return NumRetirements;
+
+}
+
+void ASPhysicsBudgetManager::RegisterActorDestructibles(AActor* Actor)
+{
+	if (Actor == NULL || Actor == this) {
+		return;
+	}
+
+	TInlineComponentArray<UDestructibleComponent*> Destructibles(Actor);
+
+	for (UDestructibleComponent* Destructible : Destructibles) {
+		RegisterDestructible(Destructible);
+	}
+
+}
+
+void ASPhysicsBudgetManager::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (Level == NULL || World != GetWorld()) {
+		return;
+	}
+
+	for (AActor* Actor : Level->Actors) {
+		RegisterActorDestructibles(Actor);
+	}
+
+}
+
+void ASPhysicsBudgetManager::OnActorSpawned(AActor* Actor)
+{
+	RegisterActorDestructibles(Actor);
+
+}
+
+void ASPhysicsBudgetManager::UpdateBudget()
+{
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_PhysicsBudgetUpdate, PhysicsBudgetUpdate);
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+
+	NumDestructibleChunks = 0;
+	NumRagdolls = 0;
+
+	// Drop bodies that went away or stopped simulating on their own, count the rest
+	for (int32 Index = Entries.Num() - 1; Index >= 0; Index--) {
+		FSPhysicsBodyEntry& Entry = Entries[Index];
+		UPrimitiveComponent* Component = Entry.Component.Get();
+
+		if (Component == NULL || Component->IsPendingKill() || (Entry.Type == ESPhysicsBodyType::Ragdoll && !Component->IsSimulatingPhysics())) {
+			Entries.RemoveAtSwap(Index);
+			continue;
+		}
+
+		if (Entry.Type == ESPhysicsBodyType::Ragdoll) {
+			NumRagdolls++;
+		}
+		else {
+			Entry.NumChunks = GetNumVisibleChunks(CastChecked<UDestructibleComponent>(Component));
+
+			if (Entry.NumChunks > 0 && Entry.StartTime == 0.f) { // Fractured since the last update
+				Entry.StartTime = FMath::Max(WorldTime, KINDA_SMALL_NUMBER);
+			}
+
+			NumDestructibleChunks += Entry.NumChunks;
+		}
+	}
+
+	const bool bOverChunks = MaxDestructibleChunks > 0 && NumDestructibleChunks > MaxDestructibleChunks;
+	const bool bOverRagdolls = MaxRagdolls > 0 && NumRagdolls > MaxRagdolls;
+
+	if (CVarPhysicsBudgetEnable.GetValueOnGameThread() != 0 && (bOverChunks || bOverRagdolls)) {
+		ScoreBodies();
+
+		// Least significant first, until back within budget or out of retirements for this update
+		int32 NumRetired = 0;
+
+		for (int32 Index : SortedEntries) {
+			if (NumRetired >= MaxRetirementsPerUpdate) {
+				break;
+			}
+
+			FSPhysicsBodyEntry& Entry = Entries[Index];
+
+			if (Entry.Type == ESPhysicsBodyType::Destructible) {
+				if (MaxDestructibleChunks <= 0 || NumDestructibleChunks <= MaxDestructibleChunks) {
+					continue;
+				}
+
+				NumDestructibleChunks -= Entry.NumChunks;
+			}
+			else {
+				if (MaxRagdolls <= 0 || NumRagdolls <= MaxRagdolls) {
+					continue;
+				}
+
+				NumRagdolls--;
+			}
+
+			RetireBody(Entry);
+			NumRetired++;
+		}
+
+		Entries.RemoveAllSwap([](const FSPhysicsBodyEntry& Entry) { return !Entry.Component.IsValid(); });
+
+		NumRetirements += NumRetired;
+		INC_DWORD_STAT_BY(STAT_DarkHours_NumPhysicsRetirements, NumRetired);
+	}
+
+	SET_DWORD_STAT(STAT_DarkHours_DestructibleChunks, NumDestructibleChunks);
+	SET_DWORD_STAT(STAT_DarkHours_Ragdolls, NumRagdolls);
+
+}
+
+void ASPhysicsBudgetManager::ScoreBodies()
+{
+	// Gather the views of all the players - on a server these are the views of the remote players too
+	ViewLocations.Reset();
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It) {
+		APlayerController* PlayerController = It->Get();
+
+		if (PlayerController != NULL) {
+			FVector ViewLocation;
+			FRotator ViewRotation;
+
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+
+	SortedEntries.Reset();
+
+	for (int32 Index = 0; Index < Entries.Num(); Index++) {
+		FSPhysicsBodyEntry& Entry = Entries[Index];
+
+		if (Entry.NumChunks == 0) { // Whole destructibles do not simulate
+			continue;
+		}
+
+		const UPrimitiveComponent* Component = Entry.Component.Get();
+
+		// Destructibles blocking pawns still hold up their static support chunks, gameplay needs them
+		if (Entry.Type == ESPhysicsBodyType::Destructible && Component->GetCollisionResponseToChannel(ECC_Pawn) == ECR_Block) {
+			continue;
+		}
+
+		const FVector Location = Component->Bounds.Origin;
+
+		// Without any view (a server without players) bodies are retired by age alone
+		float Distance = ViewLocations.Num() > 0 ? BIG_NUMBER : 0.f;
+
+		for (const FVector& ViewLocation : ViewLocations) {
+			Distance = FMath::Min(Distance, FVector::Dist(Location, ViewLocation));
+		}
+
+		if (!Component->WasRecentlyRendered(0.25f)) {
+			Distance *= HiddenDistanceScale;
+		}
+
+		Entry.Score = Distance + (WorldTime - Entry.StartTime) * AgeDistance;
+
+		SortedEntries.Add(Index);
+	}
+
+	SortedEntries.Sort([this](int32 A, int32 B) { return Entries[A].Score > Entries[B].Score; });
+
+}
+
+void ASPhysicsBudgetManager::RetireBody(FSPhysicsBodyEntry& Entry)
+{
+	UPrimitiveComponent* Component = Entry.Component.Get();
+
+	if (Entry.Type == ESPhysicsBodyType::Destructible) {
+		// Removes the debris along with all its chunk bodies - the whole destructible actor when it is its root
+		ADestructibleActor* DestructibleActor = Cast<ADestructibleActor>(Component->GetOwner());
+
+		if (DestructibleActor != NULL && DestructibleActor->GetRootComponent() == Component) {
+			DestructibleActor->Destroy();
+		}
+		else {
+			Component->DestroyComponent();
+		}
+	}
+	else {
+		// Frozen in its last pose - out of the simulation, and the animation no longer overrides the pose
+		USkeletalMeshComponent* Mesh = CastChecked<USkeletalMeshComponent>(Component);
+
+		Mesh->PutAllRigidBodiesToSleep();
+		Mesh->SetSimulatePhysics(false);
+		Mesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Mesh->bPauseAnims = true;
+		Mesh->SetComponentTickEnabled(false);
+	}
+
+	Entry.Component = NULL;
+
+}
+
+void ASPhysicsBudgetManager::LogReport() const
+{
+	int32 NumWholeDestructibles = 0;
+	int32 NumFracturedDestructibles = 0;
+
+	for (const FSPhysicsBodyEntry& Entry : Entries) {
+		if (Entry.Type == ESPhysicsBodyType::Destructible) {
+			NumWholeDestructibles += Entry.NumChunks == 0 ? 1 : 0;
+			NumFracturedDestructibles += Entry.NumChunks > 0 ? 1 : 0;
+		}
+	}
+
+	UE_LOG(LogDarkHours, Log, TEXT("Physics: %d / %d destructible chunks, %d / %d ragdolls, %d retired - budget %s"), NumDestructibleChunks, MaxDestructibleChunks, NumRagdolls, MaxRagdolls, NumRetirements, CVarPhysicsBudgetEnable.GetValueOnGameThread() != 0 ? TEXT("on") : TEXT("off"));
+	UE_LOG(LogDarkHours, Log, TEXT("Physics: %d whole and %d fractured destructibles registered"), NumWholeDestructibles, NumFracturedDestructibles);
+
+}
@@ -0,0 +1,412 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SPickupInstanceManager.h"
+#include "DarkHours.h"
+#include "SActorPool.h"
+#include "SCharacter.h"
+#include "SWeaponPickup.h"
+#include "SWorldManager.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+
+static TAutoConsoleVariable<int32> CVarPickupFreeze(
+	TEXT("DarkHours.Pickup.Freeze"),
+	1,
+	TEXT("1: freeze pickups that came to rest into instanced static meshes. 0: keep them as simulating actors."),
+	ECVF_Default);
+
+void FSReplicatedFrozenPickup::PostReplicatedAdd(const FSReplicatedFrozenPickupList& InArraySerializer)
+{
+	if (InArraySerializer.Owner != NULL) {
+		InArraySerializer.Owner->AddReplicatedInstance(*this);
+	}
+
+}
+
+void FSReplicatedFrozenPickup::PreReplicatedRemove(const FSReplicatedFrozenPickupList& InArraySerializer)
+{
+	if (InArraySerializer.Owner != NULL) {
+		InArraySerializer.Owner->RemoveReplicatedInstance(*this);
+	}
+
+}
+
+// Sets default values
+ASPickupInstanceManager::ASPickupInstanceManager()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Clients build their own instances from the frozen pickups of the server
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	NetUpdateFrequency = 2.f;
+
+	ReplicatedFrozenPickups.Owner = this;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
+
+	// Variables
+	ThawDistance = 400.f;
+	FreezeDelay = 2.f;
+	CellSize = 800.f;
+
+}
+
+void ASPickupInstanceManager::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASPickupInstanceManager, ReplicatedFrozenPickups);
+
+}
+
+// Called when the game starts or when spawned
+void ASPickupInstanceManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ReplicatedFrozenPickups.Owner = this;
+
+}
+
+ASPickupInstanceManager* ASPickupInstanceManager::Get(const UObject* WorldContextObject)
+{
+	// Clients wait for the manager of the server
+	const UWorld* World = WorldContextObject != NULL ? WorldContextObject->GetWorld() : NULL;
+
+	return GetWorldManager<ASPickupInstanceManager>(WorldContextObject, World != NULL && World->GetNetMode() != NM_Client);
+
+}
+
+bool ASPickupInstanceManager::IsFreezeEnabled()
+{
+	return CVarPickupFreeze.GetValueOnGameThread() != 0;
+
+}
+
+bool ASPickupInstanceManager::FreezePickup(ASWeaponPickup* WeaponPickup)
+{
+	// Only the server freezes, clients follow through the replicated frozen pickups
+	if (WeaponPickup == NULL || WeaponPickup->IsPendingKill() || !WeaponPickup->HasAuthority() || !IsFreezeEnabled()) {
+		return false;
+	}
+
+	UStaticMeshComponent* MeshComp = WeaponPickup->GetMeshComponent();
+	UStaticMesh* Mesh = MeshComp != NULL ? WeaponPickup->GetDisplayMesh() : NULL;
+
+	if (Mesh == NULL || MeshComp->RigidBodyIsAwake()) {
+		return false;
+	}
+
+	ASPickupInstanceManager* InstanceManager = Get(WeaponPickup);
+
+	if (InstanceManager == NULL || InstanceManager->IsCharacterNear(MeshComp->GetComponentLocation())) {
+		return false;
+	}
+
+	FSFrozenPickup FrozenPickup;
+	FrozenPickup.PickupClass = WeaponPickup->GetClass();
+	FrozenPickup.Mesh = Mesh;
+	FrozenPickup.Transform = MeshComp->GetComponentTransform();
+	FrozenPickup.UpdateAmmo = WeaponPickup->UpdateAmmo;
+
+	InstanceManager->AddFrozenPickup(FrozenPickup, MeshComp);
+
+	// The instance stands in for the actor from now on
+	ASActorPool::ReleaseActor(WeaponPickup);
+
+	return true;
+
+}
+
+void ASPickupInstanceManager::ThawNear(const UObject* WorldContextObject, const FVector& Location)
+{
+	ASPickupInstanceManager* InstanceManager = GetWorldManager<ASPickupInstanceManager>(WorldContextObject, false);
+
+	// Pickups are only thawed by the server, clients see the actor come back through replication
+	if (InstanceManager == NULL || !InstanceManager->HasAuthority() || InstanceManager->FrozenCells.Num() == 0) {
+		return;
+	}
+
+	const float ThawDistanceSquared = FMath::Square(InstanceManager->ThawDistance);
+
+	const FIntVector MinCell = InstanceManager->GetCell(Location - FVector(InstanceManager->ThawDistance));
+	const FIntVector MaxCell = InstanceManager->GetCell(Location + FVector(InstanceManager->ThawDistance));
+
+	TArray<int32, TInlineAllocator<8>> ThawIndices;
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++) {
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++) {
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++) {
+				const TArray<int32>* Cell = InstanceManager->FrozenCells.Find(FIntVector(X, Y, Z));
+
+				if (Cell == NULL) {
+					continue;
+				}
+
+				for (int32 FrozenIndex : *Cell) {
+					if (FVector::DistSquared(InstanceManager->FrozenPickups[FrozenIndex].Transform.GetLocation(), Location) <= ThawDistanceSquared) {
+						ThawIndices.Add(FrozenIndex);
+					}
+				}
+			}
+		}
+	}
+
+	for (int32 FrozenIndex : ThawIndices) {
+		InstanceManager->ThawPickup(FrozenIndex);
+	}
+
+}
+
+float ASPickupInstanceManager::GetFreezeDelay() const
+{
+	return FreezeDelay;
+
+}
+
+int32 ASPickupInstanceManager::GetNumFrozen() const
+{
+	return HasAuthority() ? FrozenPickups.Num() - FreeFrozenPickups.Num() : ReplicatedFrozenPickups.Items.Num();
+
+}
+
+int64 ASPickupInstanceManager::GetFrozenBytes() const
+{
+	int64 Bytes = FrozenPickups.GetAllocatedSize() + FreeFrozenPickups.GetAllocatedSize() + FrozenCells.GetAllocatedSize() + ReplicatedFrozenPickups.Items.GetAllocatedSize();
+
+	for (const TPair<FIntVector, TArray<int32>>& Cell : FrozenCells) {
+		Bytes += Cell.Value.GetAllocatedSize();
+	}
+
+	// Per instance data of the components, and what they keep for rendering
+	for (const TPair<UStaticMesh*, FSPickupInstanceBatch>& Batch : Batches) {
+		Bytes += Batch.Value.FreeInstances.GetAllocatedSize();
+
+		if (Batch.Value.Component != NULL) {
+			Bytes += Batch.Value.Component->GetClass()->GetStructureSize() + Batch.Value.Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+	}
+
+	return Bytes;
+
+}
+
+bool ASPickupInstanceManager::IsCharacterNear(const FVector& Location) const
+{
+	const float ThawDistanceSquared = FMath::Square(ThawDistance);
+
+	for (TActorIterator<ASCharacter> It(GetWorld()); It; ++It) {
+		if (FVector::DistSquared(It->GetActorLocation(), Location) <= ThawDistanceSquared) {
+			return true;
+		}
+	}
+
+	return false;
+
+}
+
+FSPickupInstanceBatch& ASPickupInstanceManager::FindOrAddBatch(UStaticMesh* Mesh, const UStaticMeshComponent* SourceComponent)
+{
+	FSPickupInstanceBatch& Batch = Batches.FindOrAdd(Mesh);
+
+	if (Batch.Component == NULL) {
+		Batch.Component = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+		Batch.Component->SetMobility(EComponentMobility::Movable);
+		Batch.Component->SetStaticMesh(Mesh);
+		Batch.Component->SetCollisionEnabled(ECollisionEnabled::NoCollision); // Only a visual stand-in, thawed before anyone can touch it
+
+		// Keep the materials the pickup was authored with
+		for (int32 MaterialIndex = 0; MaterialIndex < SourceComponent->GetNumMaterials(); MaterialIndex++) {
+			Batch.Component->SetMaterial(MaterialIndex, SourceComponent->GetMaterial(MaterialIndex));
+		}
+
+		Batch.Component->SetupAttachment(RootComponent);
+		Batch.Component->RegisterComponent();
+	}
+
+	return Batch;
+
+}
+
+void ASPickupInstanceManager::ThawPickup(int32 FrozenIndex)
+{
+	const FSFrozenPickup FrozenPickup = RemoveFrozenPickup(FrozenIndex);
+
+	// Bring the actor back where the mesh rested, with the ammo it was frozen with
+	ASWeaponPickup* WeaponPickup = ASActorPool::Acquire<ASWeaponPickup>(this, FrozenPickup.PickupClass, FTransform(FrozenPickup.Transform.GetLocation()));
+
+	if (WeaponPickup != NULL) {
+		WeaponPickup->GetMeshComponent()->SetWorldTransform(FrozenPickup.Transform, false, NULL, ETeleportType::TeleportPhysics);
+		WeaponPickup->UpdateAmmo = FrozenPickup.UpdateAmmo;
+	}
+
+}
+
+void ASPickupInstanceManager::StashFrozenPickups(const FBox& Bounds, TArray<FSFrozenPickup>& OutStashed)
+{
+	if (!HasAuthority()) {
+		return;
+	}
+
+	for (int32 FrozenIndex = 0; FrozenIndex < FrozenPickups.Num(); FrozenIndex++) {
+		// Free slots have no class
+		if (FrozenPickups[FrozenIndex].PickupClass != NULL && Bounds.IsInsideXY(FrozenPickups[FrozenIndex].Transform.GetLocation())) {
+			OutStashed.Add(RemoveFrozenPickup(FrozenIndex));
+		}
+	}
+
+}
+
+void ASPickupInstanceManager::RestoreFrozenPickups(const TArray<FSFrozenPickup>& Stashed)
+{
+	if (!HasAuthority()) {
+		return;
+	}
+
+	for (const FSFrozenPickup& StashedPickup : Stashed) {
+		if (StashedPickup.PickupClass == NULL || StashedPickup.Mesh == NULL) {
+			continue;
+		}
+
+		FSFrozenPickup FrozenPickup = StashedPickup;
+
+		// Materials come from the pickup class, as for the instances of clients
+		AddFrozenPickup(FrozenPickup, StashedPickup.PickupClass->GetDefaultObject<ASWeaponPickup>()->GetMeshComponent());
+	}
+
+}
+
+int32 ASPickupInstanceManager::AddFrozenPickup(FSFrozenPickup& FrozenPickup, const UStaticMeshComponent* SourceComponent)
+{
+	FrozenPickup.Cell = GetCell(FrozenPickup.Transform.GetLocation());
+	FrozenPickup.InstanceIndex = INDEX_NONE;
+
+	// Nobody sees the instance on a dedicated server, the record is enough
+	if (!IsNetMode(NM_DedicatedServer)) {
+		FrozenPickup.InstanceIndex = AddInstance(FrozenPickup.Mesh, SourceComponent, FrozenPickup.Transform);
+	}
+
+	int32 FrozenIndex;
+
+	if (FreeFrozenPickups.Num() > 0) {
+		FrozenIndex = FreeFrozenPickups.Pop(false);
+		FrozenPickups[FrozenIndex] = FrozenPickup;
+	}
+	else {
+		FrozenIndex = FrozenPickups.Add(FrozenPickup);
+	}
+
+	FrozenCells.FindOrAdd(FrozenPickup.Cell).Add(FrozenIndex);
+
+	FSReplicatedFrozenPickup& ReplicatedPickup = ReplicatedFrozenPickups.Items.AddDefaulted_GetRef();
+	ReplicatedPickup.FrozenIndex = FrozenIndex;
+	ReplicatedPickup.PickupClass = FrozenPickup.PickupClass;
+	ReplicatedPickup.Mesh = FrozenPickup.Mesh;
+	ReplicatedPickup.Location = FrozenPickup.Transform.GetLocation();
+	ReplicatedPickup.Rotation = FrozenPickup.Transform.Rotator();
+
+	ReplicatedFrozenPickups.MarkItemDirty(ReplicatedPickup);
+
+	INC_DWORD_STAT(STAT_DarkHours_FrozenPickups);
+
+	return FrozenIndex;
+
+}
+
+FSFrozenPickup ASPickupInstanceManager::RemoveFrozenPickup(int32 FrozenIndex)
+{
+	const FSFrozenPickup FrozenPickup = FrozenPickups[FrozenIndex];
+
+	// Drop the frozen pickup from the grid
+	TArray<int32>* Cell = FrozenCells.Find(FrozenPickup.Cell);
+
+	if (Cell != NULL) {
+		Cell->RemoveSingleSwap(FrozenIndex);
+
+		if (Cell->Num() == 0) {
+			FrozenCells.Remove(FrozenPickup.Cell);
+		}
+	}
+
+	FrozenPickups[FrozenIndex] = FSFrozenPickup();
+	FreeFrozenPickups.Add(FrozenIndex);
+
+	DEC_DWORD_STAT(STAT_DarkHours_FrozenPickups);
+
+	RemoveInstance(FrozenPickup.Mesh, FrozenPickup.InstanceIndex, FrozenPickup.Transform);
+
+	// Clients hide their instance of it
+	const int32 ReplicatedIndex = ReplicatedFrozenPickups.Items.IndexOfByPredicate([FrozenIndex](const FSReplicatedFrozenPickup& ReplicatedPickup) { return ReplicatedPickup.FrozenIndex == FrozenIndex; });
+
+	if (ReplicatedIndex != INDEX_NONE) {
+		ReplicatedFrozenPickups.Items.RemoveAtSwap(ReplicatedIndex);
+		ReplicatedFrozenPickups.MarkArrayDirty();
+	}
+
+	return FrozenPickup;
+
+}
+
+int32 ASPickupInstanceManager::AddInstance(UStaticMesh* Mesh, const UStaticMeshComponent* SourceComponent, const FTransform& Transform)
+{
+	FSPickupInstanceBatch& Batch = FindOrAddBatch(Mesh, SourceComponent);
+
+	// Reuse a hidden instance if there is one
+	if (Batch.FreeInstances.Num() > 0) {
+		const int32 InstanceIndex = Batch.FreeInstances.Pop(false);
+		Batch.Component->UpdateInstanceTransform(InstanceIndex, Transform, true, true, true);
+
+		return InstanceIndex;
+	}
+
+	return Batch.Component->AddInstanceWorldSpace(Transform);
+
+}
+
+void ASPickupInstanceManager::RemoveInstance(UStaticMesh* Mesh, int32 InstanceIndex, const FTransform& Transform)
+{
+	FSPickupInstanceBatch* Batch = Batches.Find(Mesh);
+
+	if (Batch == NULL || Batch->Component == NULL || InstanceIndex == INDEX_NONE) {
+		return;
+	}
+
+	FTransform HiddenTransform = Transform;
+	HiddenTransform.SetScale3D(FVector::ZeroVector);
+
+	Batch->Component->UpdateInstanceTransform(InstanceIndex, HiddenTransform, true, true, true);
+	Batch->FreeInstances.Add(InstanceIndex);
+
+}
+
+void ASPickupInstanceManager::AddReplicatedInstance(FSReplicatedFrozenPickup& ReplicatedPickup)
+{
+	if (ReplicatedPickup.Mesh == NULL || ReplicatedPickup.PickupClass == NULL) {
+		return;
+	}
+
+	// Materials come from the pickup class, the actor itself is hidden in the pool of the server
+	const UStaticMeshComponent* SourceComponent = ReplicatedPickup.PickupClass->GetDefaultObject<ASWeaponPickup>()->GetMeshComponent();
+
+	ReplicatedPickup.InstanceIndex = AddInstance(ReplicatedPickup.Mesh, SourceComponent, FTransform(ReplicatedPickup.Rotation, ReplicatedPickup.Location, SourceComponent->RelativeScale3D));
+
+}
+
+void ASPickupInstanceManager::RemoveReplicatedInstance(FSReplicatedFrozenPickup& ReplicatedPickup)
+{
+	RemoveInstance(ReplicatedPickup.Mesh, ReplicatedPickup.InstanceIndex, FTransform(ReplicatedPickup.Rotation, ReplicatedPickup.Location));
+
+	ReplicatedPickup.InstanceIndex = INDEX_NONE;
+
+}
+
+FIntVector ASPickupInstanceManager::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+
+}
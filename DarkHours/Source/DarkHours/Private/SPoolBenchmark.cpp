@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SPoolBenchmark.h"
+#include "DarkHours.h"
+#include "SActorPool.h"
+#include "SCharacter.h"
+#include "SWeaponPickup.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "UObject/UObjectGlobals.h"
+
+static void StartPoolBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	ASPoolBenchmark* Benchmark = Cast<ASPoolBenchmark>(ASBenchmark::Start(World, ASPoolBenchmark::StaticClass()));
+
+	if (Benchmark != NULL) {
+		if (Args.Num() > 0) {
+			Benchmark->SwapsPerFrame = FMath::Max(FCString::Atoi(*Args[0]), 1);
+		}
+
+		if (Args.Num() > 1) {
+			Benchmark->SwapFrames = FMath::Max(FCString::Atoi(*Args[1]), 1);
+			Benchmark->SampleFrames = Benchmark->SwapFrames + 30;
+		}
+
+		if (Args.Num() > 2) {
+			Benchmark->PickupClass = LoadClass<ASWeaponPickup>(NULL, *Args[2]);
+		}
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PoolBenchmarkCommand(
+	TEXT("DarkHours.Bench.WeaponSwap"),
+	TEXT("Measures weapon swap and garbage collection time with and without the actor pool. Args: [SwapsPerFrame] [SwapFrames] [PickupClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartPoolBenchmark));
+
+// Sets default values
+ASPoolBenchmark::ASPoolBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("WeaponSwap");
+	NumPasses = 2;
+	WarmupFrames = 30;
+	SwapsPerFrame = 20;
+	SwapFrames = 200;
+	SampleFrames = SwapFrames + 30;
+
+	NextPickup = NULL;
+
+	PassFrame = 0;
+	NumSwaps = 0;
+	SwapSeconds = 0.0;
+	NumGarbageCollects = 0;
+	GarbageCollectSeconds = 0.0;
+	GarbageCollectStartTime = 0.0;
+	bWasPoolEnabled = true;
+
+}
+
+void ASPoolBenchmark::BeginPass(int32 PassIndex)
+{
+	if (PassIndex == 0) {
+		IConsoleVariable* PoolEnableVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Pool.Enable"));
+		bWasPoolEnabled = PoolEnableVar == NULL || PoolEnableVar->GetInt() != 0;
+
+		if (PickupClass == NULL) {
+			PickupClass = LoadClass<ASWeaponPickup>(NULL, TEXT("/Game/Blueprints/Pickup/Weapons/Primary/BP_AR4_Pickup.BP_AR4_Pickup_C"));
+		}
+
+		SpawnCharacter(ResolveCharacterClass(FString()), 0);
+
+		FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &ASPoolBenchmark::OnPreGarbageCollect);
+		FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &ASPoolBenchmark::OnPostGarbageCollect);
+	}
+
+	// Pass 0 spawns and destroys, pass 1 goes through the pool
+	SetPoolEnabled(PassIndex > 0);
+
+	PassFrame = 0;
+	NumSwaps = 0;
+	SwapSeconds = 0.0;
+	NumGarbageCollects = 0;
+	GarbageCollectSeconds = 0.0;
+
+	// Arm the character, then swap with the dropped pickups over and over
+	ASCharacter* Character = SpawnedCharacters.Num() > 0 ? SpawnedCharacters[0] : NULL;
+
+	if (Character != NULL && PickupClass != NULL) {
+		const FTransform PickupTransform(FRotator::ZeroRotator, Character->GetActorLocation());
+
+		Character->Interaction_PrimaryWeapon(ASActorPool::Acquire<ASWeaponPickup>(this, PickupClass, PickupTransform));
+
+		NextPickup = ASActorPool::Acquire<ASWeaponPickup>(this, PickupClass, PickupTransform);
+	}
+
+}
+
+void ASPoolBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	if (PassFrame == 0) { // Only count collections of the sampled frames
+		NumGarbageCollects = 0;
+		GarbageCollectSeconds = 0.0;
+	}
+
+	ASCharacter* Character = SpawnedCharacters.Num() > 0 ? SpawnedCharacters[0] : NULL;
+
+	if (PassFrame < SwapFrames) {
+		for (int32 Swap = 0; Swap < SwapsPerFrame && Character != NULL && NextPickup != NULL; Swap++) {
+			const double StartTime = FPlatformTime::Seconds();
+
+			NextPickup = Character->Interaction_PrimaryWeapon(NextPickup);
+
+			SwapSeconds += FPlatformTime::Seconds() - StartTime;
+			NumSwaps++;
+		}
+
+		if (NextPickup == NULL) {
+			UE_LOG(LogDarkHours, Warning, TEXT("%s: swap dropped no pickup, check PickupClass of the weapon"), *BenchmarkName);
+		}
+	}
+	else if (PassFrame == SwapFrames) { // Done swapping - purge what the swaps left behind
+		GEngine->ForceGarbageCollection(true);
+	}
+
+	PassFrame++;
+
+}
+
+void ASPoolBenchmark::EndPass(int32 PassIndex)
+{
+	const FString PassName = PassIndex == 0 ? TEXT("SpawnDestroy") : TEXT("Pool");
+
+	AddResult(PassName + TEXT(".Swaps"), NumSwaps);
+	AddResult(PassName + TEXT(".UsPerSwap"), NumSwaps > 0 ? SwapSeconds * 1000000.0 / NumSwaps : 0.0);
+	AddResult(PassName + TEXT(".GarbageCollects"), NumGarbageCollects);
+	AddResult(PassName + TEXT(".GarbageCollectMs"), GarbageCollectSeconds * 1000.0);
+
+	if (PassIndex == NumPasses - 1) {
+		SetPoolEnabled(bWasPoolEnabled);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASPoolBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().RemoveAll(this);
+	FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+
+	SetPoolEnabled(bWasPoolEnabled);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASPoolBenchmark::OnPreGarbageCollect()
+{
+	GarbageCollectStartTime = FPlatformTime::Seconds();
+
+}
+
+void ASPoolBenchmark::OnPostGarbageCollect()
+{
+	GarbageCollectSeconds += FPlatformTime::Seconds() - GarbageCollectStartTime;
+	NumGarbageCollects++;
+
+}
+
+void ASPoolBenchmark::SetPoolEnabled(bool bEnabled)
+{
+	IConsoleVariable* PoolEnableVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Pool.Enable"));
+
+	if (PoolEnableVar != NULL) {
+		PoolEnableVar->Set(bEnabled ? 1 : 0, ECVF_SetByCode);
+	}
+
+}
@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SProjectileBenchmark.h"
+#include "DarkHours.h"
+#include "SProjectileManager.h"
+#include "SRifleWeapon.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static void StartProjectileBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	ASProjectileBenchmark* Benchmark = Cast<ASProjectileBenchmark>(ASBenchmark::Start(World, ASProjectileBenchmark::StaticClass()));
+
+	if (Benchmark != NULL) {
+		if (Args.Num() > 0) {
+			Benchmark->NumRounds = FMath::Max(FCString::Atoi(*Args[0]), 1);
+		}
+
+		if (Args.Num() > 1) {
+			Benchmark->SampleFrames = FMath::Max(FCString::Atoi(*Args[1]), 1);
+		}
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ProjectileBenchmarkCommand(
+	TEXT("DarkHours.Bench.Projectiles"),
+	TEXT("Measures rounds simulated per frame by the projectile manager with scalar and SIMD math. Args: [NumRounds] [SampleFrames]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartProjectileBenchmark));
+
+// Sets default values
+ASProjectileBenchmark::ASProjectileBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("Projectiles");
+	NumPasses = 2;
+	NumRounds = 4000;
+
+	Weapon = NULL;
+
+	bSampling = false;
+	bWasSimdEnabled = true;
+
+}
+
+void ASProjectileBenchmark::BeginPass(int32 PassIndex)
+{
+	if (PassIndex == 0) {
+		IConsoleVariable* SimdVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Projectile.Simd"));
+		bWasSimdEnabled = SimdVar == NULL || SimdVar->GetInt() != 0;
+
+		FActorSpawnParameters SpawnInfos;
+		SpawnInfos.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		Weapon = GetWorld()->SpawnActor<ASRifleWeapon>(ASRifleWeapon::StaticClass(), GetActorLocation(), FRotator::ZeroRotator, SpawnInfos);
+
+		if (Weapon != NULL) {
+			// Long flights, so the rounds stay up for the whole pass
+			Weapon->Ballistics.bSimulateBallistics = true;
+			Weapon->Ballistics.MaxLifetime = 60.f;
+			Weapon->SetActorHiddenInGame(true);
+		}
+
+		RandomStream.Initialize(1234);
+	}
+
+	// Pass 0 advances with scalar math, pass 1 with SIMD
+	SetSimdEnabled(PassIndex > 0);
+
+	bSampling = false;
+
+	TopUpRounds();
+
+}
+
+void ASProjectileBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	ASProjectileManager* ProjectileManager = ASProjectileManager::Get(this);
+
+	if (!bSampling && ProjectileManager != NULL) { // Only count the sampled frames
+		ProjectileManager->ResetCounters();
+		bSampling = true;
+	}
+
+	// Replace rounds that hit something
+	TopUpRounds();
+
+}
+
+void ASProjectileBenchmark::EndPass(int32 PassIndex)
+{
+	const FString PassName = PassIndex == 0 ? TEXT("Scalar") : TEXT("Simd");
+
+	ASProjectileManager* ProjectileManager = ASProjectileManager::Get(this);
+
+	const int32 NumSimulated = ProjectileManager != NULL ? ProjectileManager->GetNumSimulatedRounds() : 0;
+	const double SimulateMs = ProjectileManager != NULL ? ProjectileManager->GetSimulateSeconds() * 1000.0 : 0.0;
+	const double SweepMs = ProjectileManager != NULL ? ProjectileManager->GetSweepSeconds() * 1000.0 : 0.0;
+
+	AddResult(PassName + TEXT(".RoundsPerFrame"), SampleFrames > 0 ? (double)NumSimulated / SampleFrames : 0.0);
+	AddResult(PassName + TEXT(".SimulateMsPerFrame"), SampleFrames > 0 ? SimulateMs / SampleFrames : 0.0);
+	AddResult(PassName + TEXT(".RoundsPerMs"), SimulateMs > 0.0 ? NumSimulated / SimulateMs : 0.0);
+	AddResult(PassName + TEXT(".SweepMsPerFrame"), SampleFrames > 0 ? SweepMs / SampleFrames : 0.0);
+
+	if (PassIndex == NumPasses - 1) {
+		SetSimdEnabled(bWasSimdEnabled);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASProjectileBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Weapon != NULL && !Weapon->IsPendingKill()) {
+		Weapon->Destroy();
+	}
+
+	SetSimdEnabled(bWasSimdEnabled);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASProjectileBenchmark::TopUpRounds()
+{
+	ASProjectileManager* ProjectileManager = ASProjectileManager::Get(this);
+
+	if (ProjectileManager == NULL || Weapon == NULL) {
+		return;
+	}
+
+	for (int32 Index = ProjectileManager->GetNumRounds(); Index < NumRounds; Index++) {
+		// Steep up into the sky, away from the level
+		const FVector Direction = RandomStream.VRandCone(FVector::UpVector, FMath::DegreesToRadians(30.f));
+
+		if (!ProjectileManager->AddRound(Weapon, GetActorLocation(), Direction)) {
+			break;
+		}
+	}
+
+}
+
+void ASProjectileBenchmark::SetSimdEnabled(bool bEnabled)
+{
+	IConsoleVariable* SimdVar = IConsoleManager::Get().FindConsoleVariable(TEXT("DarkHours.Projectile.Simd"));
+
+	if (SimdVar != NULL) {
+		SimdVar->Set(bEnabled ? 1 : 0, ECVF_SetByCode);
+	}
+
+}
@@ -0,0 +1,279 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SProjectileManager.h"
+#include "DarkHours.h"
+#include "SRifleWeapon.h"
+#include "SWorldManager.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Kismet/GameplayStatics.h"
+
+static TAutoConsoleVariable<int32> CVarProjectileSimd(
+	TEXT("DarkHours.Projectile.Simd"),
+	1,
+	TEXT("1: advance rounds with SIMD vector math. 0: advance rounds with scalar math."),
+	ECVF_Default);
+
+// Sets default values
+ASProjectileManager::ASProjectileManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = false;
+
+	// Variables
+	MaxRounds = 4096;
+	TraceChannel = ECC_Visibility;
+
+	NumSimulatedRounds = 0;
+	SimulateSeconds = 0.0;
+	SweepSeconds = 0.0;
+
+}
+
+ASProjectileManager* ASProjectileManager::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASProjectileManager>(WorldContextObject);
+
+}
+
+// Called when the game starts or when spawned
+void ASProjectileManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Allocate the rounds once
+	Positions.Reserve(MaxRounds);
+	PreviousPositions.Reserve(MaxRounds);
+	Velocities.Reserve(MaxRounds);
+	Drags.Reserve(MaxRounds);
+	GravityScales.Reserve(MaxRounds);
+	Lifetimes.Reserve(MaxRounds);
+	Weapons.Reserve(MaxRounds);
+	TraceHandles.Reserve(MaxRounds);
+	RemovedRounds.Reserve(MaxRounds);
+	TraceDatum.OutHits.Reserve(1);
+
+}
+
+bool ASProjectileManager::AddRound(ASRifleWeapon* Weapon, const FVector& Start, const FVector& Direction)
+{
+	if (Weapon == NULL || Positions.Num() >= MaxRounds) {
+		INC_DWORD_STAT(STAT_DarkHours_NumDroppedShots);
+		return false;
+	}
+
+	const FSBallistics& Ballistics = Weapon->Ballistics;
+
+	Positions.Add(Start);
+	PreviousPositions.Add(Start);
+	Velocities.Add(Direction * Ballistics.MuzzleVelocity);
+	Drags.Add(Ballistics.DragCoefficient);
+	GravityScales.Add(Ballistics.GravityScale);
+	Lifetimes.Add(Ballistics.MaxLifetime);
+	Weapons.Add(Weapon);
+	TraceHandles.Add(FTraceHandle());
+
+	INC_DWORD_STAT(STAT_DarkHours_Rounds);
+
+	return true;
+
+}
+
+// Called every frame
+void ASProjectileManager::Tick(float DeltaTime)
+{
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_ProjectileStep, ProjectileStep);
+
+	Super::Tick(DeltaTime);
+
+	ResolveSweeps();
+
+	if (Positions.Num() == 0) {
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	AdvanceRounds(DeltaTime);
+
+	const double AdvanceTime = FPlatformTime::Seconds();
+
+	SweepRounds();
+
+	SimulateSeconds += AdvanceTime - StartTime;
+	SweepSeconds += FPlatformTime::Seconds() - AdvanceTime;
+	NumSimulatedRounds += Positions.Num();
+
+}
+
+void ASProjectileManager::ResolveSweeps()
+{
+	UWorld* World = GetWorld();
+
+	RemovedRounds.Reset();
+
+	for (int32 Index = 0; Index < Positions.Num(); Index++) {
+		// Rounds fired since the last step were not swept yet
+		if (TraceHandles[Index].IsValid() && World->QueryTraceData(TraceHandles[Index], TraceDatum) && TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit) {
+			const FHitResult& Hit = TraceDatum.OutHits[0];
+			ASRifleWeapon* Weapon = Weapons[Index].Get();
+
+			if (Weapon != NULL) {
+				Weapon->PlayImpactEffects(Hit);
+			}
+
+			// Rounds of a client only show where they hit, the server deals the damage
+			if (Weapon != NULL && Hit.GetActor() != NULL && Weapon->HasFireAuthority()) {
+				UGameplayStatics::ApplyPointDamage(Hit.GetActor(), Weapon->Damage, Velocities[Index].GetSafeNormal(), Hit, Weapon->GetInstigatorController(), Weapon, Weapon->DamageType);
+			}
+
+			RemovedRounds.Add(Index);
+		}
+		else if (Lifetimes[Index] <= 0.f) {
+			RemovedRounds.Add(Index);
+		}
+	}
+
+	// Back to front, so swapped in rounds were already visited
+	for (int32 RemovedIndex = RemovedRounds.Num() - 1; RemovedIndex >= 0; RemovedIndex--) {
+		RemoveRound(RemovedRounds[RemovedIndex]);
+	}
+
+}
+
+void ASProjectileManager::AdvanceRounds(float DeltaTime)
+{
+	if (CVarProjectileSimd.GetValueOnGameThread() == 0) {
+		AdvanceRoundsScalar(DeltaTime);
+		return;
+	}
+
+	const FVector Gravity(0.f, 0.f, GetWorld()->GetGravityZ());
+
+	const VectorRegister GravityRegister = VectorLoadFloat3_W0(&Gravity);
+	const VectorRegister DeltaTimeRegister = VectorSetFloat1(DeltaTime);
+	const VectorRegister SmallNumberRegister = VectorSetFloat1(KINDA_SMALL_NUMBER);
+
+	const int32 NumRounds = Positions.Num();
+
+	FVector* RESTRICT PositionData = Positions.GetData();
+	FVector* RESTRICT PreviousPositionData = PreviousPositions.GetData();
+	FVector* RESTRICT VelocityData = Velocities.GetData();
+	const float* RESTRICT DragData = Drags.GetData();
+	const float* RESTRICT GravityScaleData = GravityScales.GetData();
+	float* RESTRICT LifetimeData = Lifetimes.GetData();
+
+	for (int32 Index = 0; Index < NumRounds; Index++) {
+		VectorRegister Position = VectorLoadFloat3_W0(&PositionData[Index]);
+		VectorRegister Velocity = VectorLoadFloat3_W0(&VelocityData[Index]);
+
+		// Speed = |v|, drag deceleration = k * |v| * v
+		const VectorRegister SpeedSquared = VectorAdd(VectorDot3(Velocity, Velocity), SmallNumberRegister);
+		const VectorRegister Speed = VectorMultiply(SpeedSquared, VectorReciprocalSqrt(SpeedSquared));
+		const VectorRegister DragScale = VectorMultiply(Speed, VectorSetFloat1(DragData[Index]));
+
+		const VectorRegister Acceleration = VectorSubtract(VectorMultiply(GravityRegister, VectorSetFloat1(GravityScaleData[Index])), VectorMultiply(Velocity, DragScale));
+
+		// Semi-implicit Euler
+		Velocity = VectorMultiplyAdd(Acceleration, DeltaTimeRegister, Velocity);
+
+		VectorStoreFloat3(Position, &PreviousPositionData[Index]);
+
+		Position = VectorMultiplyAdd(Velocity, DeltaTimeRegister, Position);
+
+		VectorStoreFloat3(Position, &PositionData[Index]);
+		VectorStoreFloat3(Velocity, &VelocityData[Index]);
+
+		LifetimeData[Index] -= DeltaTime;
+	}
+
+}
+
+void ASProjectileManager::AdvanceRoundsScalar(float DeltaTime)
+{
+	const FVector Gravity(0.f, 0.f, GetWorld()->GetGravityZ());
+
+	for (int32 Index = 0; Index < Positions.Num(); Index++) {
+		const FVector Velocity = Velocities[Index];
+		const FVector Acceleration = Gravity * GravityScales[Index] - Velocity * (Velocity.Size() * Drags[Index]);
+
+		Velocities[Index] = Velocity + Acceleration * DeltaTime;
+
+		PreviousPositions[Index] = Positions[Index];
+		Positions[Index] += Velocities[Index] * DeltaTime;
+
+		Lifetimes[Index] -= DeltaTime;
+	}
+
+}
+
+void ASProjectileManager::SweepRounds()
+{
+	UWorld* World = GetWorld();
+
+	for (int32 Index = 0; Index < Positions.Num(); Index++) {
+		const ASRifleWeapon* Weapon = Weapons[Index].Get();
+
+		FCollisionQueryParams TraceInfos(SCENE_QUERY_STAT(DarkHoursProjectile), true, Weapon);
+
+		if (Weapon != NULL) {
+			TraceInfos.AddIgnoredActor(Weapon->GetOwner());
+		}
+
+		TraceInfos.bReturnPhysicalMaterial = true;
+		TraceInfos.bTraceAsyncScene = true; // Cosmetic destructibles simulate in the async scene
+
+		TraceHandles[Index] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, PreviousPositions[Index], Positions[Index], TraceChannel, TraceInfos);
+	}
+
+}
+
+void ASProjectileManager::RemoveRound(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, false);
+	PreviousPositions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Drags.RemoveAtSwap(Index, 1, false);
+	GravityScales.RemoveAtSwap(Index, 1, false);
+	Lifetimes.RemoveAtSwap(Index, 1, false);
+	Weapons.RemoveAtSwap(Index, 1, false);
+	TraceHandles.RemoveAtSwap(Index, 1, false);
+
+	DEC_DWORD_STAT(STAT_DarkHours_Rounds);
+
+}
+
+int32 ASProjectileManager::GetNumRounds() const
+{
+	return Positions.Num();
+
+}
+
+int32 ASProjectileManager::GetNumSimulatedRounds() const
+{
+	return NumSimulatedRounds;
+
+}
+
+double ASProjectileManager::GetSimulateSeconds() const
+{
+	return SimulateSeconds;
+
+}
+
+double ASProjectileManager::GetSweepSeconds() const
+{
+	return SweepSeconds;
+
+}
+
+void ASProjectileManager::ResetCounters()
+{
+	NumSimulatedRounds = 0;
+	SimulateSeconds = 0.0;
+	SweepSeconds = 0.0;
+
+}
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SReplicationBenchmark.h"
+#include "DarkHours.h"
+#include "SActorPool.h"
+#include "SCharacter.h"
+#include "SReplicationGraph.h"
+#include "SWeaponPickup.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static void StartReplicationBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	if (World == NULL || World->GetNetMode() == NM_Client || World->GetNetMode() == NM_Standalone) {
+		UE_LOG(LogDarkHours, Warning, TEXT("Replication: run the benchmark on a listen or dedicated server"));
+		return;
+	}
+
+	ASReplicationBenchmark* Benchmark = Cast<ASReplicationBenchmark>(ASBenchmark::Start(World, ASReplicationBenchmark::StaticClass()));
+
+	if (Benchmark != NULL) {
+		if (Args.Num() > 0) {
+			Benchmark->MaxCharacters = FMath::Max(FCString::Atoi(*Args[0]), 0);
+		}
+
+		if (Args.Num() > 1) {
+			Benchmark->MaxPickups = FMath::Max(FCString::Atoi(*Args[1]), 0);
+		}
+
+		if (Args.Num() > 2) {
+			Benchmark->NumPasses = FMath::Max(FCString::Atoi(*Args[2]), 1);
+		}
+
+		if (Args.Num() > 3) {
+			Benchmark->PickupClass = LoadClass<ASWeaponPickup>(NULL, *Args[3]);
+		}
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ReplicationBenchmarkCommand(
+	TEXT("DarkHours.Bench.Replication"),
+	TEXT("Measures server replication time per frame as character and pickup counts grow. Args: [MaxCharacters] [MaxPickups] [NumPasses] [PickupClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartReplicationBenchmark));
+
+// Sets default values
+ASReplicationBenchmark::ASReplicationBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("Replication");
+	NumPasses = 4;
+	WarmupFrames = 120; // Pickups settle and go dormant
+	MaxCharacters = 64;
+	MaxPickups = 512;
+
+	FrameSeconds = 0.0;
+	MoveTime = 0.f;
+	bSampling = false;
+
+}
+
+void ASReplicationBenchmark::BeginPass(int32 PassIndex)
+{
+	if (PassIndex == 0 && PickupClass == NULL) {
+		PickupClass = LoadClass<ASWeaponPickup>(NULL, TEXT("/Game/Blueprints/Pickup/Weapons/Primary/BP_AR4_Pickup.BP_AR4_Pickup_C"));
+	}
+
+	// Every pass adds an even share of the characters and pickups
+	const int32 NumCharacters = MaxCharacters * (PassIndex + 1) / NumPasses;
+	const int32 NumPickups = MaxPickups * (PassIndex + 1) / NumPasses;
+
+	const TSubclassOf<ASCharacter> CharacterClass = ResolveCharacterClass(FString());
+
+	for (int32 Index = SpawnedCharacters.Num(); Index < NumCharacters; Index++) {
+		ASCharacter* Character = SpawnCharacter(CharacterClass, Index, 600.f);
+
+		CharacterOrigins.Add(Character != NULL ? Character->GetActorLocation() : FVector::ZeroVector);
+	}
+
+	// Pickups lie on a grid past the characters
+	const FVector PickupOffset(-2000.f, 0.f, 100.f);
+
+	for (int32 Index = Pickups.Num(); Index < NumPickups && PickupClass != NULL; Index++) {
+		ASWeaponPickup* Pickup = ASActorPool::Acquire<ASWeaponPickup>(this, PickupClass, FTransform(FRotator::ZeroRotator, GetGridLocation(Index, 32, 150.f) + PickupOffset));
+
+		if (Pickup == NULL) {
+			break;
+		}
+
+		Pickups.Add(Pickup);
+	}
+
+	FrameSeconds = 0.0;
+	bSampling = false;
+
+}
+
+void ASReplicationBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	USReplicationGraph* ReplicationGraph = USReplicationGraph::Get(this);
+
+	if (!bSampling && ReplicationGraph != NULL) { // Only count the sampled frames
+		ReplicationGraph->ResetCounters();
+		bSampling = true;
+	}
+
+	FrameSeconds += DeltaTime;
+	MoveTime += DeltaTime;
+
+	// Characters circle around their spawn location, so their movement replicates every frame
+	for (int32 Index = 0; Index < SpawnedCharacters.Num(); Index++) {
+		ASCharacter* Character = SpawnedCharacters[Index];
+
+		if (Character != NULL) {
+			const float Angle = MoveTime * 2.f + Index;
+
+			Character->SetActorLocation(CharacterOrigins[Index] + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * 200.f);
+		}
+	}
+
+}
+
+void ASReplicationBenchmark::EndPass(int32 PassIndex)
+{
+	const FString PassName = FString::Printf(TEXT("Pass%d"), PassIndex);
+
+	USReplicationGraph* ReplicationGraph = USReplicationGraph::Get(this);
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+
+	if (ReplicationGraph == NULL) {
+		UE_LOG(LogDarkHours, Warning, TEXT("%s: the net driver does not use the DarkHours replication graph"), *BenchmarkName);
+	}
+
+	const int32 NumFrames = ReplicationGraph != NULL ? ReplicationGraph->GetNumReplicatedFrames() : 0;
+	const double ReplicateMs = ReplicationGraph != NULL ? ReplicationGraph->GetReplicateSeconds() * 1000.0 : 0.0;
+
+	AddResult(PassName + TEXT(".Connections"), NetDriver != NULL ? NetDriver->ClientConnections.Num() : 0);
+	AddResult(PassName + TEXT(".Characters"), SpawnedCharacters.Num());
+	AddResult(PassName + TEXT(".Pickups"), Pickups.Num());
+	AddResult(PassName + TEXT(".ReplicateMsPerFrame"), NumFrames > 0 ? ReplicateMs / NumFrames : 0.0);
+	AddResult(PassName + TEXT(".AvgFrameMs"), SampleFrames > 0 ? FrameSeconds * 1000.0 / SampleFrames : 0.0);
+
+	if (PassIndex == NumPasses - 1) {
+		ReleasePickups();
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASReplicationBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ReleasePickups();
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASReplicationBenchmark::ReleasePickups()
+{
+	for (ASWeaponPickup* Pickup : Pickups) {
+		ASActorPool::ReleaseActor(Pickup);
+	}
+
+	Pickups.Reset();
+
+}
@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SReplicationGraph.h"
+#include "DarkHours.h"
+#include "SCharacter.h"
+#include "SWeapon.h"
+#include "SWeaponPickup.h"
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformTime.h"
+
+// Sets default values
+USReplicationGraph::USReplicationGraph()
+{
+	// Variables
+	GridCellSize = 10000.f;
+	SpatialBias = FVector2D(-200000.f, -200000.f);
+	CharacterCullDistance = 15000.f;
+	PickupCullDistance = 5000.f;
+
+	GridNode = NULL;
+	AlwaysRelevantNode = NULL;
+
+	NumReplicatedFrames = 0;
+	ReplicateSeconds = 0.0;
+
+}
+
+USReplicationGraph* USReplicationGraph::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject != NULL ? WorldContextObject->GetWorld() : NULL;
+	UNetDriver* NetDriver = World != NULL ? World->GetNetDriver() : NULL;
+
+	return NetDriver != NULL ? Cast<USReplicationGraph>(NetDriver->GetReplicationDriver()) : NULL;
+
+}
+
+void USReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Routing
+	ClassRepNodePolicies.Set(ASCharacter::StaticClass(), ESClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(ASWeaponPickup::StaticClass(), ESClassRepNodeMapping::Spatialize_Dormancy);
+	ClassRepNodePolicies.Set(ASWeapon::StaticClass(), ESClassRepNodeMapping::NotRouted); // Attached from the inventory of the character
+	ClassRepNodePolicies.Set(APlayerController::StaticClass(), ESClassRepNodeMapping::NotRouted); // Gathered per connection
+	ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), ESClassRepNodeMapping::NotRouted);
+
+	// Cull distances - everything else keeps the cull distance of its actor defaults
+	FClassReplicationInfo DefaultInfo;
+	DefaultInfo.CullDistanceSquared = GetDefault<AActor>()->NetCullDistanceSquared;
+	GlobalActorReplicationInfoMap.SetClassInfo(AActor::StaticClass(), DefaultInfo);
+
+	FClassReplicationInfo CharacterInfo;
+	CharacterInfo.CullDistanceSquared = FMath::Square(CharacterCullDistance);
+	GlobalActorReplicationInfoMap.SetClassInfo(ASCharacter::StaticClass(), CharacterInfo);
+
+	FClassReplicationInfo PickupInfo;
+	PickupInfo.CullDistanceSquared = FMath::Square(PickupCullDistance);
+	GlobalActorReplicationInfoMap.SetClassInfo(ASWeaponPickup::StaticClass(), PickupInfo);
+
+}
+
+void USReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = SpatialBias;
+
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+}
+
+void USReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	AddConnectionGraphNode(CreateNewNode<USReplicationGraphNode_AlwaysRelevant_ForConnection>(), RepGraphConnection);
+
+}
+
+void USReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class)) {
+		case ESClassRepNodeMapping::RelevantAllConnections:
+			AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+			break;
+
+		case ESClassRepNodeMapping::Spatialize_Dynamic:
+			GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			break;
+
+		case ESClassRepNodeMapping::Spatialize_Dormancy:
+			GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+			break;
+
+		default:
+			break;
+	}
+
+}
+
+void USReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class)) {
+		case ESClassRepNodeMapping::RelevantAllConnections:
+			AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+			break;
+
+		case ESClassRepNodeMapping::Spatialize_Dynamic:
+			GridNode->RemoveActor_Dynamic(ActorInfo);
+			break;
+
+		case ESClassRepNodeMapping::Spatialize_Dormancy:
+			GridNode->RemoveActor_Dormancy(ActorInfo);
+			break;
+
+		default:
+			break;
+	}
+
+}
+
+int32 USReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	DARKHOURS_SCOPED_STAT(STAT_DarkHours_ServerReplicateActors, ServerReplicateActors);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const int32 NumReplicated = Super::ServerReplicateActors(DeltaSeconds);
+
+	ReplicateSeconds += FPlatformTime::Seconds() - StartTime;
+	NumReplicatedFrames++;
+
+	return NumReplicated;
+
+}
+
+int32 USReplicationGraph::GetNumReplicatedFrames() const
+{
+	return NumReplicatedFrames;
+
+}
+
+double USReplicationGraph::GetReplicateSeconds() const
+{
+	return ReplicateSeconds;
+
+}
+
+void USReplicationGraph::ResetCounters()
+{
+	NumReplicatedFrames = 0;
+	ReplicateSeconds = 0.0;
+
+}
+
+ESClassRepNodeMapping USReplicationGraph::GetMappingPolicy(UClass* Class)
+{
+	ESClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(Class);
+
+	if (Policy != NULL) {
+		return *Policy;
+	}
+
+	// Game state and friends are always relevant, owner only actors come in through their owner
+	const AActor* DefaultActor = Class->GetDefaultObject<AActor>();
+
+	ESClassRepNodeMapping NewPolicy = ESClassRepNodeMapping::Spatialize_Dynamic;
+
+	if (DefaultActor->bAlwaysRelevant) {
+		NewPolicy = ESClassRepNodeMapping::RelevantAllConnections;
+	}
+	else if (DefaultActor->bOnlyRelevantToOwner) {
+		NewPolicy = ESClassRepNodeMapping::NotRouted;
+	}
+
+	ClassRepNodePolicies.Set(Class, NewPolicy);
+
+	return NewPolicy;
+
+}
+
+void USReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	APlayerController* PlayerController = Cast<APlayerController>(Params.Viewer.InViewer);
+
+	if (PlayerController != NULL) {
+		ReplicationActorList.Add(PlayerController);
+	}
+
+	// Own pawn stays relevant even beyond the cull distance
+	if (Params.Viewer.ViewTarget != NULL && Params.Viewer.ViewTarget != Params.Viewer.InViewer) {
+		ReplicationActorList.Add(Params.Viewer.ViewTarget);
+	}
+
+	Super::GatherActorListsForConnection(Params);
+
+}
@@ -1,15 +1,38 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "SRifleWeapon.h"
+#include "SCharacter.h"
+#include "SHitscanFireSystem.h"
+#include "SImpactEffectsManager.h"
+#include "Engine/World.h"
+#include "GameFramework/DamageType.h"
 
 // Sets default values
 ASRifleWeapon::ASRifleWeapon()
 {
+	// Tick only while the trigger is held
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
 	// Initialize components and variables
 	// Variables
 	ClipSize = 30; // Using the most generic clip size for assault rifles, clip size is customizable within BPs
 	MaxAmmo = 90;
 
+	FireRate = 600.f;
+	Damage = 20.f;
+	DamageType = UDamageType::StaticClass();
+	Range = 10000.f;
+	SpreadAngle = 2.f;
+	AimSpreadAngle = 0.5f;
+
+	bIsFiring = false;
+	TimeUntilNextShot = 0.f;
+	LastShotTime = -BIG_NUMBER;
+	NumPendingShots = 0;
+	bRemoteFire = false;
+	RemoteFireLatency = 0.f;
+
 }
 
 // Called when the game starts or when spawned
@@ -24,4 +47,138 @@ void ASRifleWeapon::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	if (!bIsFiring) {
+		return;
+	}
+
+	ASHitscanFireSystem* FireSystem = ASHitscanFireSystem::Get(this);
+
+	if (FireSystem == NULL) {
+		return;
+	}
+
+	const float ShotInterval = 60.f / FMath::Max(FireRate, 1.f);
+
+	TimeUntilNextShot -= DeltaTime;
+
+	// Queue every shot that came due this frame - several when the weapon ticks at a lower rate
+	while (TimeUntilNextShot <= 0.f) {
+		// Out of ammo, counting the shots that are still queued
+		if (UpdateAmmo - NumPendingShots <= 0) {
+			StopFire();
+			break;
+		}
+
+		FVector FireLocation;
+		FRotator FireRotation;
+		GetFireViewPoint(FireLocation, FireRotation);
+
+		if (FireSystem->QueueShot(this, FireLocation, FireRotation.Vector())) {
+			NumPendingShots++;
+		}
+
+		TimeUntilNextShot += ShotInterval;
+		LastShotTime = GetWorld()->GetTimeSeconds();
+	}
+
+}
+
+void ASRifleWeapon::OnReleasedToPool()
+{
+	Super::OnReleasedToPool();
+
+	StopFire();
+
+	// Queued shots of a pooled weapon are skipped
+	NumPendingShots = 0;
+
+}
+
+void ASRifleWeapon::StartFire()
+{
+	if (bIsFiring) {
+		return;
+	}
+
+	bIsFiring = true;
+
+	// Tapping the trigger does not fire faster than the fire rate
+	const float ShotInterval = 60.f / FMath::Max(FireRate, 1.f);
+	TimeUntilNextShot = FMath::Max(LastShotTime + ShotInterval - GetWorld()->GetTimeSeconds(), 0.f);
+
+	SetActorTickEnabled(true);
+
+}
+
+void ASRifleWeapon::StopFire()
+{
+	bIsFiring = false;
+	bRemoteFire = false;
+	RemoteFireLatency = 0.f;
+
+	SetActorTickEnabled(false);
+
+}
+
+bool ASRifleWeapon::IsFiring() const
+{
+	return bIsFiring;
+
+}
+
+bool ASRifleWeapon::HasFireAuthority() const
+{
+	// Weapons are spawned on every machine, only the role of the holder tells
+	const AActor* WeaponOwner = GetOwner();
+
+	return WeaponOwner == NULL || WeaponOwner->HasAuthority();
+
+}
+
+void ASRifleWeapon::SetRemoteFireTime(float ClientFireTime)
+{
+	if (!bIsFiring) {
+		return;
+	}
+
+	bRemoteFire = true;
+	RemoteFireLatency = FMath::Max(GetWorld()->GetTimeSeconds() - ClientFireTime, 0.f);
+
+}
+
+float ASRifleWeapon::GetSpreadAngle() const
+{
+	const ASCharacter* OwnerCharacter = Cast<ASCharacter>(GetOwner());
+
+	return OwnerCharacter != NULL && OwnerCharacter->bIsAiming ? AimSpreadAngle : SpreadAngle;
+
+}
+
+void ASRifleWeapon::PlayImpactEffects(const FHitResult& Hit) const
+{
+	// Nobody sees them on a dedicated server
+	if (GetNetMode() == NM_DedicatedServer) {
+		return;
+	}
+
+	ASImpactEffectsManager* ImpactEffectsManager = ASImpactEffectsManager::Get(this);
+
+	if (ImpactEffectsManager != NULL) {
+		ImpactEffectsManager->PlayImpact(Hit);
+	}
+
+}
+
+void ASRifleWeapon::GetFireViewPoint(FVector& OutLocation, FRotator& OutRotation) const
+{
+	const AActor* WeaponOwner = GetOwner();
+
+	if (WeaponOwner != NULL) {
+		WeaponOwner->GetActorEyesViewPoint(OutLocation, OutRotation);
+	}
+	else {
+		OutLocation = GetActorLocation();
+		OutRotation = GetActorRotation();
+	}
+
 }
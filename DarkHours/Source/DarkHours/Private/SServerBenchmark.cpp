@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SServerBenchmark.h"
+#include "DarkHours.h"
+#include "SBotManager.h"
+#include "SWorldManager.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+
+static void StartServerBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	if (World == NULL || World->GetNetMode() == NM_Client) {
+		UE_LOG(LogDarkHours, Warning, TEXT("ServerBenchmark: runs on the server only"));
+		return;
+	}
+
+	if (World->GetNetMode() != NM_DedicatedServer) {
+		UE_LOG(LogDarkHours, Warning, TEXT("ServerBenchmark: not a dedicated server, frame times include rendering"));
+	}
+
+	ASServerBenchmark* Benchmark = Cast<ASServerBenchmark>(ASBenchmark::Start(World, ASServerBenchmark::StaticClass()));
+
+	if (Benchmark == NULL) {
+		return;
+	}
+
+	if (Args.Num() > 0) {
+		Benchmark->NumPlayers = FMath::Max(FCString::Atoi(*Args[0]), 1);
+	}
+
+	if (Args.Num() > 1) {
+		Benchmark->TickRate = FMath::Max(FCString::Atof(*Args[1]), 1.f);
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ServerBenchmarkCommand(
+	TEXT("DarkHours.Bench.Server"),
+	TEXT("Measures the server frame with bots standing in for the players. Args: [NumPlayers=32] [TickRate=30]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartServerBenchmark));
+
+// Sets default values
+ASServerBenchmark::ASServerBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("Server");
+	WarmupFrames = 150;
+	SampleFrames = 900;
+	NumPlayers = 32;
+	TickRate = 30.f;
+
+	LastFrameTime = 0.0;
+
+	bTickRateApplied = false;
+	PreviousNetServerMaxTickRate = 0;
+	PreviousMaxFPS = 0.f;
+
+}
+
+void ASServerBenchmark::BeginPass(int32 PassIndex)
+{
+	// The budget only holds if the server actually runs at the tick rate
+	ApplyTickRate(true);
+
+	ASBotManager* BotManager = ASBotManager::Get(this);
+
+	if (BotManager == NULL) {
+		MarkFailed(TEXT("no bot manager"));
+		return;
+	}
+
+	BotManager->SpawnBots(NumPlayers, ASBotManager::ResolveCharacterClass(GetWorld(), FString()), GetActorLocation());
+
+	FrameMs.Reset(SampleFrames);
+	BusyMs.Reset(SampleFrames);
+
+	LastFrameTime = 0.0;
+
+}
+
+void ASServerBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (LastFrameTime == 0.0) { // First sampled frame - start timing
+		FSPerfCounters::Reset();
+		FSPerfCounters::SetCapturing(true);
+	}
+	else {
+		// The engine idles at the start of the frame to hold the tick rate, between the previous sample and this one
+		const float WallMs = (float)((Now - LastFrameTime) * 1000.0);
+
+		FrameMs.Add(WallMs);
+		BusyMs.Add(FMath::Max(WallMs - (float)(FApp::GetIdleTime() * 1000.0), 0.f));
+	}
+
+	LastFrameTime = Now;
+
+}
+
+void ASServerBenchmark::EndPass(int32 PassIndex)
+{
+	FSPerfCounters::SetCapturing(false);
+
+	ASBotManager* BotManager = GetWorldManager<ASBotManager>(this, false);
+	const int32 NumBots = BotManager != NULL ? BotManager->GetNumBots() : 0;
+
+	const int32 NumFrames = BusyMs.Num();
+
+	if (NumFrames == 0) {
+		MarkFailed(TEXT("no frames sampled"));
+		return;
+	}
+
+	TArray<float> SortedBusyMs = BusyMs;
+	SortedBusyMs.Sort();
+
+	double TotalFrameMs = 0.0;
+	double TotalBusyMs = 0.0;
+
+	for (int32 Index = 0; Index < NumFrames; Index++) {
+		TotalFrameMs += FrameMs[Index];
+		TotalBusyMs += BusyMs[Index];
+	}
+
+	const double BudgetMs = 1000.0 / TickRate;
+	const double Utilization = (TotalBusyMs / NumFrames) / BudgetMs;
+
+	AddResult(TEXT("Players"), NumBots);
+	AddResult(TEXT("TickRate"), TickRate);
+	AddResult(TEXT("Frames"), NumFrames);
+	AddResult(TEXT("FrameMsAvg"), TotalFrameMs / NumFrames);
+	AddResult(TEXT("BusyMsAvg"), TotalBusyMs / NumFrames);
+	AddResult(TEXT("BusyMsP95"), SortedBusyMs[FMath::Min(NumFrames * 95 / 100, NumFrames - 1)]);
+	AddResult(TEXT("BusyMsMax"), SortedBusyMs.Last());
+	AddResult(TEXT("Utilization"), Utilization);
+	AddResult(TEXT("MatchesPerCore"), Utilization > 0.0 ? 1.0 / Utilization : 0.0);
+
+	// Where the busy time goes
+	TArray<TPair<FString, double>> CounterSeconds;
+	FSPerfCounters::GetSeconds(CounterSeconds);
+
+	for (const TPair<FString, double>& Counter : CounterSeconds) {
+		AddResult(Counter.Key + TEXT("MsPerFrame"), Counter.Value * 1000.0 / NumFrames);
+	}
+
+	if (NumBots < NumPlayers) {
+		MarkFailed(FString::Printf(TEXT("only %d of %d players spawned"), NumBots, NumPlayers));
+	}
+
+	if (BotManager != NULL) {
+		BotManager->DestroyBots();
+	}
+
+	if (PassIndex == NumPasses - 1) {
+		ApplyTickRate(false);
+	}
+
+}
+
+// Called when the game ends or when destroyed
+void ASServerBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FSPerfCounters::SetCapturing(false);
+
+	ApplyTickRate(false);
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASServerBenchmark::ApplyTickRate(bool bApply)
+{
+	if (bApply == bTickRateApplied) {
+		return;
+	}
+
+	// Dedicated servers are limited by the net driver, anything else by t.MaxFPS
+	UNetDriver* NetDriver = GetWorld() != NULL ? GetWorld()->GetNetDriver() : NULL;
+	IConsoleVariable* MaxFPSVar = IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS"));
+
+	if (bApply) {
+		if (NetDriver != NULL) {
+			PreviousNetServerMaxTickRate = NetDriver->NetServerMaxTickRate;
+			NetDriver->NetServerMaxTickRate = FMath::RoundToInt(TickRate);
+		}
+
+		if (MaxFPSVar != NULL) {
+			PreviousMaxFPS = MaxFPSVar->GetFloat();
+			MaxFPSVar->Set(TickRate, ECVF_SetByCode);
+		}
+	}
+	else {
+		if (NetDriver != NULL && PreviousNetServerMaxTickRate > 0) {
+			NetDriver->NetServerMaxTickRate = PreviousNetServerMaxTickRate;
+		}
+
+		if (MaxFPSVar != NULL) {
+			MaxFPSVar->Set(PreviousMaxFPS, ECVF_SetByCode);
+		}
+	}
+
+	bTickRateApplied = bApply;
+
+}
@@ -0,0 +1,332 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SSignificanceManager.h"
+#include "DarkHours.h"
+#include "SWorldManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarSignificanceEnable(
+	TEXT("DarkHours.Significance.Enable"),
+	1,
+	TEXT("1: throttle characters, weapons and pickups by significance. 0: update everything at full rate."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSignificanceServerMaxAnimUpdateRate(
+	TEXT("DarkHours.Significance.ServerMaxAnimUpdateRate"),
+	2,
+	TEXT("Max frames between animation updates of characters on a dedicated server, whatever their tier - hit detection runs against their bones."),
+	ECVF_Default);
+
+static void LogSignificanceReport(UWorld* World)
+{
+	ASSignificanceManager* SignificanceManager = GetWorldManager<ASSignificanceManager>(World, false);
+
+	if (SignificanceManager != NULL) {
+		SignificanceManager->LogReport();
+	}
+	else {
+		UE_LOG(LogDarkHours, Log, TEXT("Significance: no significance manager in this world"));
+	}
+
+}
+
+static FAutoConsoleCommandWithWorld SignificanceReportCommand(
+	TEXT("DarkHours.Significance.Report"),
+	TEXT("Logs the number of characters, weapons and pickups in each significance tier."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogSignificanceReport));
+
+// Sets default values
+ASSignificanceManager::ASSignificanceManager()
+{
+	// Significance is updated at a fixed interval, not every frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = false;
+
+	// Variables
+	HiddenDistanceScale = 3.f;
+	ViewConeCos = 0.5f;
+	UpdateInterval = 0.25f;
+
+	bWasEnabled = true;
+
+	// Defaults - overridden from DefaultGame.ini
+	Tiers.SetNum((int32)ESSignificanceTier::MAX);
+
+	Tiers[(int32)ESSignificanceTier::Critical].MaxDistance = 1500.f;
+	Tiers[(int32)ESSignificanceTier::Critical].Budget = 16;
+
+	Tiers[(int32)ESSignificanceTier::High].MaxDistance = 4000.f;
+	Tiers[(int32)ESSignificanceTier::High].Budget = 32;
+	Tiers[(int32)ESSignificanceTier::High].NonRenderedAnimUpdateRate = 4;
+
+	Tiers[(int32)ESSignificanceTier::Medium].MaxDistance = 10000.f;
+	Tiers[(int32)ESSignificanceTier::Medium].Budget = 64;
+	Tiers[(int32)ESSignificanceTier::Medium].TickInterval = 0.1f;
+	Tiers[(int32)ESSignificanceTier::Medium].NonRenderedAnimUpdateRate = 8;
+
+	Tiers[(int32)ESSignificanceTier::Low].MaxDistance = 20000.f;
+	Tiers[(int32)ESSignificanceTier::Low].TickInterval = 0.25f;
+	Tiers[(int32)ESSignificanceTier::Low].NonRenderedAnimUpdateRate = 16;
+	Tiers[(int32)ESSignificanceTier::Low].bOnlyTickPoseWhenRendered = true;
+
+	Tiers[(int32)ESSignificanceTier::Dormant].MaxDistance = BIG_NUMBER;
+	Tiers[(int32)ESSignificanceTier::Dormant].TickInterval = 1.f;
+	Tiers[(int32)ESSignificanceTier::Dormant].NonRenderedAnimUpdateRate = 32;
+	Tiers[(int32)ESSignificanceTier::Dormant].bOnlyTickPoseWhenRendered = true;
+
+}
+
+ASSignificanceManager* ASSignificanceManager::Get(const UObject* WorldContextObject)
+{
+	return GetWorldManager<ASSignificanceManager>(WorldContextObject);
+
+}
+
+void ASSignificanceManager::RegisterActor(AActor* Actor, ESSignificanceType Type)
+{
+	ASSignificanceManager* SignificanceManager = Get(Actor);
+
+	if (SignificanceManager == NULL || Actor == SignificanceManager) {
+		return;
+	}
+
+	FSSignificanceEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Type = Type;
+	Entry.Tier = ESSignificanceTier::Critical; // Registered actors start at full rate until the next update
+	Entry.Score = 0.f;
+	Entry.DefaultTickInterval = Actor->GetActorTickInterval();
+
+	SignificanceManager->Entries.Add(Entry);
+
+}
+
+void ASSignificanceManager::UnregisterActor(AActor* Actor)
+{
+	ASSignificanceManager* SignificanceManager = GetWorldManager<ASSignificanceManager>(Actor, false);
+
+	if (SignificanceManager == NULL) {
+		return;
+	}
+
+	for (int32 Index = 0; Index < SignificanceManager->Entries.Num(); Index++) {
+		if (SignificanceManager->Entries[Index].Actor.Get() == Actor) {
+			SignificanceManager->Entries.RemoveAtSwap(Index);
+			break;
+		}
+	}
+
+}
+
+ESSignificanceTier ASSignificanceManager::GetTier(const AActor* Actor) const
+{
+	for (const FSSignificanceEntry& Entry : Entries) {
+		if (Entry.Actor.Get() == Actor) {
+			return Entry.Tier;
+		}
+	}
+
+	return ESSignificanceTier::Critical;
+
+}
+
+// Called every frame
+void ASSignificanceManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateSignificance();
+
+}
+
+// Called when the game starts or when spawned
+void ASSignificanceManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetActorTickInterval(UpdateInterval);
+
+}
+
+// Called when the game ends or when destroyed
+void ASSignificanceManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Entries.Reset();
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASSignificanceManager::UpdateSignificance()
+{
+	const bool bEnabled = CVarSignificanceEnable.GetValueOnGameThread() != 0;
+
+	// Drop actors that went away without unregistering
+	Entries.RemoveAllSwap([](const FSSignificanceEntry& Entry) { return !Entry.Actor.IsValid(); });
+
+	if (!bEnabled) {
+		if (bWasEnabled) { // Back to full rate for everything
+			for (FSSignificanceEntry& Entry : Entries) {
+				ApplyTier(Entry, ESSignificanceTier::Critical);
+			}
+		}
+
+		bWasEnabled = false;
+		return;
+	}
+
+	bWasEnabled = true;
+
+	// Gather the views of all the players - on a server these are the views of the remote players too
+	ViewLocations.Reset();
+	ViewDirections.Reset();
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It) {
+		APlayerController* PlayerController = It->Get();
+
+		if (PlayerController != NULL) {
+			FVector ViewLocation;
+			FRotator ViewRotation;
+
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			ViewLocations.Add(ViewLocation);
+			ViewDirections.Add(ViewRotation.Vector());
+		}
+	}
+
+	// Score every actor by effective distance to the closest view
+	SortedEntries.Reset();
+
+	for (int32 Index = 0; Index < Entries.Num(); Index++) {
+		FSSignificanceEntry& Entry = Entries[Index];
+		AActor* Actor = Entry.Actor.Get();
+
+		// Locally controlled characters and what they hold are always significant
+		APawn* Pawn = Cast<APawn>(Entry.Type == ESSignificanceType::Character ? Actor : Actor->GetAttachParentActor());
+
+		if (Pawn != NULL && Pawn->IsLocallyControlled()) {
+			Entry.Score = -1.f;
+		}
+		else {
+			const FVector ActorLocation = Actor->GetActorLocation();
+			const bool bRendered = Actor->WasRecentlyRendered(0.25f);
+
+			float BestScore = BIG_NUMBER;
+
+			for (int32 ViewIndex = 0; ViewIndex < ViewLocations.Num(); ViewIndex++) {
+				const FVector ToActor = ActorLocation - ViewLocations[ViewIndex];
+				const float Distance = ToActor.Size();
+				const bool bInViewCone = Distance < KINDA_SMALL_NUMBER || FVector::DotProduct(ToActor / Distance, ViewDirections[ViewIndex]) > ViewConeCos;
+
+				BestScore = FMath::Min(BestScore, (bRendered || bInViewCone) ? Distance : Distance * HiddenDistanceScale);
+			}
+
+			Entry.Score = BestScore;
+		}
+
+		SortedEntries.Add(Index);
+	}
+
+	SortedEntries.Sort([this](int32 A, int32 B) { return Entries[A].Score < Entries[B].Score; });
+
+	// Fill the tiers from the most significant actor on, overflowing tiers push actors down
+	int32 TierCounts[(int32)ESSignificanceTier::MAX] = { 0 };
+
+	for (int32 Index : SortedEntries) {
+		FSSignificanceEntry& Entry = Entries[Index];
+
+		int32 Tier = 0;
+
+		while (Tier < (int32)ESSignificanceTier::Dormant && Entry.Score > GetTierSettings((ESSignificanceTier)Tier).MaxDistance) {
+			Tier++;
+		}
+
+		while (Tier < (int32)ESSignificanceTier::Dormant && GetTierSettings((ESSignificanceTier)Tier).Budget > 0 && TierCounts[Tier] >= GetTierSettings((ESSignificanceTier)Tier).Budget) {
+			Tier++;
+		}
+
+		TierCounts[Tier]++;
+
+		if (Entry.Tier != (ESSignificanceTier)Tier) {
+			ApplyTier(Entry, (ESSignificanceTier)Tier);
+		}
+	}
+
+}
+
+void ASSignificanceManager::ApplyTier(FSSignificanceEntry& Entry, ESSignificanceTier NewTier)
+{
+	Entry.Tier = NewTier;
+
+	AActor* Actor = Entry.Actor.Get();
+
+	if (Actor == NULL) {
+		return;
+	}
+
+	const FSSignificanceTierSettings& Settings = GetTierSettings(NewTier);
+
+	Actor->SetActorTickInterval(Settings.TickInterval > 0.f ? Settings.TickInterval : Entry.DefaultTickInterval);
+
+	TInlineComponentArray<USkeletalMeshComponent*> SkeletalMeshes;
+	Actor->GetComponents(SkeletalMeshes);
+
+	// Nothing is rendered on a dedicated server, the bones of characters must still follow for hit detection
+	const bool bDedicatedServer = IsNetMode(NM_DedicatedServer) && Entry.Type == ESSignificanceType::Character;
+
+	for (USkeletalMeshComponent* SkeletalMesh : SkeletalMeshes) {
+		// Full rate tiers use the values the mesh was authored with
+		const USkeletalMeshComponent* DefaultMesh = CastChecked<USkeletalMeshComponent>(SkeletalMesh->GetArchetype());
+
+		if (bDedicatedServer) {
+			SkeletalMesh->SetComponentTickInterval(DefaultMesh->PrimaryComponentTick.TickInterval);
+			SkeletalMesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+		}
+		else {
+			SkeletalMesh->SetComponentTickInterval(Settings.TickInterval > 0.f ? Settings.TickInterval : DefaultMesh->PrimaryComponentTick.TickInterval);
+			SkeletalMesh->VisibilityBasedAnimTickOption = Settings.bOnlyTickPoseWhenRendered ? EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered : DefaultMesh->VisibilityBasedAnimTickOption;
+		}
+
+		if (SkeletalMesh->AnimUpdateRateParams != NULL) {
+			SkeletalMesh->AnimUpdateRateParams->BaseNonRenderedUpdateRate = bDedicatedServer ? FMath::Min(Settings.NonRenderedAnimUpdateRate, FMath::Max(CVarSignificanceServerMaxAnimUpdateRate.GetValueOnGameThread(), 1)) : Settings.NonRenderedAnimUpdateRate;
+		}
+	}
+
+}
+
+const FSSignificanceTierSettings& ASSignificanceManager::GetTierSettings(ESSignificanceTier Tier) const
+{
+	static const FSSignificanceTierSettings FullRateSettings;
+
+	return Tiers.IsValidIndex((int32)Tier) ? Tiers[(int32)Tier] : FullRateSettings;
+
+}
+
+void ASSignificanceManager::LogReport() const
+{
+	static const TCHAR* TierNames[] = { TEXT("Critical"), TEXT("High"), TEXT("Medium"), TEXT("Low"), TEXT("Dormant") };
+
+	int32 Counts[(int32)ESSignificanceType::MAX][(int32)ESSignificanceTier::MAX] = { { 0 } };
+
+	for (const FSSignificanceEntry& Entry : Entries) {
+		Counts[(int32)Entry.Type][(int32)Entry.Tier]++;
+	}
+
+	UE_LOG(LogDarkHours, Log, TEXT("Significance: %d actors, %d views, %s"), Entries.Num(), ViewLocations.Num(), CVarSignificanceEnable.GetValueOnGameThread() != 0 ? TEXT("enabled") : TEXT("disabled"));
+
+	for (int32 Tier = 0; Tier < (int32)ESSignificanceTier::MAX; Tier++) {
+		const FSSignificanceTierSettings& Settings = GetTierSettings((ESSignificanceTier)Tier);
+
+		UE_LOG(LogDarkHours, Log, TEXT("  %-8s (dist < %8.0f, budget %3d, tick %.2fs): %4d characters, %4d weapons, %4d pickups"),
+			TierNames[Tier], Settings.MaxDistance, Settings.Budget, Settings.TickInterval,
+			Counts[(int32)ESSignificanceType::Character][Tier], Counts[(int32)ESSignificanceType::Weapon][Tier], Counts[(int32)ESSignificanceType::Pickup][Tier]);
+	}
+
+}
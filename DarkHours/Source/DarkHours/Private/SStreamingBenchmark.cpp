@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SStreamingBenchmark.h"
+#include "DarkHours.h"
+#include "SLevelStreamingManager.h"
+#include "SWorldManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Kismet/GameplayStatics.h"
+
+static void StartStreamingBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+	ASStreamingBenchmark* Benchmark = Cast<ASStreamingBenchmark>(ASBenchmark::Start(World, ASStreamingBenchmark::StaticClass()));
+
+	if (Benchmark == NULL) {
+		return;
+	}
+
+	if (Args.Num() > 0) {
+		Benchmark->Speed = FMath::Max(FCString::Atof(*Args[0]), 100.f);
+	}
+
+	if (Args.Num() > 1) {
+		Benchmark->HitchMs = FMath::Max(FCString::Atof(*Args[1]), 1.f);
+	}
+
+	if (Args.Num() > 2) {
+		Benchmark->Altitude = FCString::Atof(*Args[2]);
+	}
+
+}
+
+static FAutoConsoleCommandWithWorldAndArgs StreamingBenchmarkCommand(
+	TEXT("DarkHours.Bench.Streaming"),
+	TEXT("Flies through the streamed sublevels and reports the longest frame and the hitch count. Args: [Speed=3000] [HitchMs=50] [Altitude=500]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartStreamingBenchmark));
+
+// Sets default values
+ASStreamingBenchmark::ASStreamingBenchmark()
+{
+	// Variables
+	BenchmarkName = TEXT("Streaming");
+	WarmupFrames = 120;
+	Speed = 3000.f;
+	HitchMs = 50.f;
+	Altitude = 500.f;
+
+	RouteIndex = 0;
+	RouteLength = 0.f;
+	FlightLocation = FVector::ZeroVector;
+	LastFrameTime = 0.0;
+	StartLoadRequests = 0;
+	StartUnloadRequests = 0;
+	MaxPendingLevels = 0;
+
+}
+
+void ASStreamingBenchmark::BeginPass(int32 PassIndex)
+{
+	ASLevelStreamingManager* StreamingManager = ASLevelStreamingManager::Get(this);
+
+	TArray<FBox> LevelBounds;
+
+	if (StreamingManager != NULL) {
+		StreamingManager->GetLevelBounds(LevelBounds);
+	}
+
+	if (LevelBounds.Num() == 0) {
+		MarkFailed(TEXT("no streamed sublevels configured for this map"));
+		SampleFrames = 1;
+		return;
+	}
+
+	StartLoadRequests = StreamingManager->GetNumLoadRequests();
+	StartUnloadRequests = StreamingManager->GetNumUnloadRequests();
+	MaxPendingLevels = 0;
+
+	// Nearest neighbour route over the sublevel centers from the player, and back to the start
+	const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+	const FVector Origin = PlayerPawn != NULL ? PlayerPawn->GetActorLocation() : LevelBounds[0].GetCenter();
+
+	Route.Reset();
+	Route.Add(Origin);
+
+	while (LevelBounds.Num() > 0) {
+		int32 NearestIndex = 0;
+
+		for (int32 Index = 1; Index < LevelBounds.Num(); Index++) {
+			if (FVector::DistSquared2D(LevelBounds[Index].GetCenter(), Route.Last()) < FVector::DistSquared2D(LevelBounds[NearestIndex].GetCenter(), Route.Last())) {
+				NearestIndex = Index;
+			}
+		}
+
+		Route.Add(FVector(LevelBounds[NearestIndex].GetCenter().X, LevelBounds[NearestIndex].GetCenter().Y, Origin.Z + Altitude));
+
+		LevelBounds.RemoveAtSwap(NearestIndex);
+	}
+
+	Route.Add(Origin);
+
+	RouteLength = 0.f;
+
+	for (int32 Index = 1; Index < Route.Num(); Index++) {
+		RouteLength += FVector::Dist(Route[Index - 1], Route[Index]);
+	}
+
+	// A fixed step per frame - the flight takes the same frames whatever the hitches
+	SampleFrames = FMath::Max(FMath::CeilToInt(RouteLength / (Speed / 60.f)), 1);
+
+	RouteIndex = 1;
+	FlightLocation = Origin;
+	LastFrameTime = 0.0;
+
+	// Streaming follows the flight, not the players
+	StreamingManager->SetSourceOverride(FlightLocation);
+
+	FrameMs.Reset(SampleFrames);
+
+}
+
+void ASStreamingBenchmark::SampleFrame(int32 PassIndex, float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (LastFrameTime > 0.0) {
+		FrameMs.Add((float)((Now - LastFrameTime) * 1000.0));
+	}
+
+	LastFrameTime = Now;
+
+	// Fly along the route
+	float StepDistance = Speed / 60.f;
+	FVector Location = FlightLocation;
+
+	while (RouteIndex < Route.Num() && StepDistance > 0.f) {
+		const float Distance = FVector::Dist(Location, Route[RouteIndex]);
+
+		if (Distance > StepDistance) {
+			Location += (Route[RouteIndex] - Location) / Distance * StepDistance;
+			break;
+		}
+
+		Location = Route[RouteIndex];
+		StepDistance -= Distance;
+		RouteIndex++;
+	}
+
+	FlightLocation = Location;
+
+	ASLevelStreamingManager* StreamingManager = GetWorldManager<ASLevelStreamingManager>(this, false);
+
+	if (StreamingManager != NULL) {
+		StreamingManager->SetSourceOverride(FlightLocation);
+
+		MaxPendingLevels = FMath::Max(MaxPendingLevels, StreamingManager->GetNumPendingLevels());
+	}
+
+}
+
+void ASStreamingBenchmark::EndPass(int32 PassIndex)
+{
+	ASLevelStreamingManager* StreamingManager = GetWorldManager<ASLevelStreamingManager>(this, false);
+
+	if (StreamingManager != NULL) {
+		StreamingManager->ClearSourceOverride();
+	}
+
+	const int32 NumFrames = FrameMs.Num();
+
+	if (NumFrames == 0 || StreamingManager == NULL) {
+		return;
+	}
+
+	TArray<float> SortedFrameMs = FrameMs;
+	SortedFrameMs.Sort();
+
+	double TotalMs = 0.0;
+	int32 NumHitches = 0;
+
+	for (float Ms : SortedFrameMs) {
+		TotalMs += Ms;
+		NumHitches += Ms > HitchMs ? 1 : 0;
+	}
+
+	AddResult(TEXT("RouteLength"), RouteLength);
+	AddResult(TEXT("Frames"), NumFrames);
+	AddResult(TEXT("FrameMsAvg"), TotalMs / NumFrames);
+	AddResult(TEXT("FrameMsP95"), SortedFrameMs[FMath::Min(NumFrames * 95 / 100, NumFrames - 1)]);
+	AddResult(TEXT("FrameMsMax"), SortedFrameMs.Last());
+	AddResult(TEXT("Hitches"), NumHitches);
+	AddResult(TEXT("LevelLoads"), StreamingManager->GetNumLoadRequests() - StartLoadRequests);
+	AddResult(TEXT("LevelUnloads"), StreamingManager->GetNumUnloadRequests() - StartUnloadRequests);
+	AddResult(TEXT("MaxPendingLevels"), MaxPendingLevels);
+
+}
+
+// Called when the game ends or when destroyed
+void ASStreamingBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ASLevelStreamingManager* StreamingManager = GetWorldManager<ASLevelStreamingManager>(this, false);
+
+	if (StreamingManager != NULL) {
+		StreamingManager->ClearSourceOverride();
+	}
+
+	Super::EndPlay(EndPlayReason);
+
+}
@@ -1,20 +1,27 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "SWeapon.h"
+#include "DarkHours.h"
+#include "SInventoryComponent.h"
+#include "SSignificanceManager.h"
 #include "SWeaponPickup.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/SphereComponent.h"
+#include "Engine/AssetManager.h"
 
 // Sets default values
 ASWeapon::ASWeapon()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	DARKHOURS_LLM_SCOPE(Weapons);
+
+ 	// Weapons do not tick, rifles turn it on while firing
+	PrimaryActorTick.bCanEverTick = false;
 
 	// Initialize components and variables
 	// Components
 	WeaponMeshComp = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("WeaponMeshComponent"));
 	RootComponent = WeaponMeshComp;
+	WeaponMeshComp->bEnableUpdateRateOptimizations = true;
 
 	// Variables
 	ClipSize = 0;
@@ -25,17 +32,89 @@ ASWeapon::ASWeapon()
 // Called when the game starts or when spawned
 void ASWeapon::BeginPlay()
 {
+	DARKHOURS_LLM_SCOPE(Weapons);
+
 	Super::BeginPlay();
 	
 	// Fill the update amount of ammo with clip size
 	UpdateAmmo = ClipSize;
 
+	ASSignificanceManager::RegisterActor(this, ESSignificanceType::Weapon);
+
+	RequestPickupClass();
+
+}
+
+// Called when the game ends or when destroyed
+void ASWeapon::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ASSignificanceManager::UnregisterActor(this);
+
+	PickupClassHandle.Reset();
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASWeapon::PostLoad()
+{
+	Super::PostLoad();
+
+	if (WeaponPickupClass_DEPRECATED != NULL) {
+		PickupClass = WeaponPickupClass_DEPRECATED.Get();
+		WeaponPickupClass_DEPRECATED = NULL;
+	}
+
+}
+
+void ASWeapon::RequestPickupClass()
+{
+	if (!PickupClass.IsNull() && !PickupClassHandle.IsValid()) {
+		PickupClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(PickupClass.ToSoftObjectPath());
+	}
+
 }
 
-// Called every frame
-void ASWeapon::Tick(float DeltaTime)
+UClass* ASWeapon::LoadPickupClass() const
 {
-	Super::Tick(DeltaTime);
+	// Streamed in when the weapon was taken, only loads here if that did not finish yet
+	return PickupClass.Get() != NULL ? PickupClass.Get() : PickupClass.LoadSynchronous();
+
+}
+
+void ASWeapon::ConsumeAmmo()
+{
+	UpdateAmmo--;
+
+	if (Inventory.IsValid()) {
+		Inventory->OnWeaponAmmoChanged(this);
+	}
+
+}
+
+void ASWeapon::OnAcquiredFromPool()
+{
+	WeaponMeshComp->SetComponentTickEnabled(true);
+
+	ASSignificanceManager::RegisterActor(this, ESSignificanceType::Weapon);
+
+	RequestPickupClass();
+
+}
+
+void ASWeapon::OnReleasedToPool()
+{
+	ASSignificanceManager::UnregisterActor(this);
+
+	// Pooled weapons are hidden, no need to keep the pose updated
+	WeaponMeshComp->SetComponentTickEnabled(false);
+
+	// Nobody holds a pooled weapon
+	SetOwner(NULL);
+	Instigator = NULL;
+	Inventory.Reset();
+
+	PickupClassHandle.Reset();
 
 }
 
@@ -1,55 +1,316 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "SWeaponPickup.h"
+#include "DarkHours.h"
+#include "SInteractableRegistry.h"
+#include "SPickupInstanceManager.h"
+#include "SSignificanceManager.h"
 #include "SWeapon.h"
 #include "Components/BoxComponent.h"
 #include "Components/StaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StaticMesh.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
 
 // Sets default values
 ASWeaponPickup::ASWeaponPickup()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	DARKHOURS_LLM_SCOPE(Pickups);
+
+ 	// Pickups do not tick, physics and timers move them along
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Replicated, but dormant while the pickup rests - only woken up while it moves or changes. The mesh
+	// transform is replicated instead of the movement of the root, which stays where the pickup was spawned
+	bReplicates = true;
+	bReplicateMovement = false;
+	NetDormancy = DORM_DormantAll;
 
 	// Inititalize components and variables
 	/* Components */
 	PickupComp = CreateDefaultSubobject<UBoxComponent>(TEXT("PickupComponent"));
 	RootComponent = PickupComp;
 	PickupComp->InitBoxExtent(FVector(100.f, 100.f, 200.f));
-	PickupComp->SetCollisionResponseToAllChannels(ECR_Overlap);
+	PickupComp->SetCollisionEnabled(ECollisionEnabled::NoCollision); // Characters find pickups through the interactable registry
+	PickupComp->SetGenerateOverlapEvents(false);
 
 	WeaponRepMeshComp = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("WeaponRepMeshComponent"));
 	WeaponRepMeshComp->SetupAttachment(RootComponent);
 	WeaponRepMeshComp->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-	WeaponRepMeshComp->SetCollisionResponseToAllChannels(ECR_Overlap);
+	WeaponRepMeshComp->SetCollisionResponseToAllChannels(ECR_Ignore);
 	WeaponRepMeshComp->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);
+	WeaponRepMeshComp->SetGenerateOverlapEvents(false);
+	WeaponRepMeshComp->BodyInstance.bGenerateWakeEvents = true; // Settled pickups are frozen into instances
+	WeaponRepMeshComp->BodyInstance.bUseAsyncScene = true; // Only rests on the world, so it tumbles in the async scene, off the game thread step
+
+}
+
+void ASWeaponPickup::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASWeaponPickup, ReplicatedMeshLocation);
+	DOREPLIFETIME(ASWeaponPickup, ReplicatedMeshRotation);
 
 }
 
 // Called when the game starts or when spawned
 void ASWeaponPickup::BeginPlay()
 {
+	DARKHOURS_LLM_SCOPE(Pickups);
+
 	Super::BeginPlay();
 
-	WeaponRepMeshComp->SetSimulatePhysics(true); // Stimulate physics
+	// Only the server simulates, clients follow the replicated mesh transform
+	if (HasAuthority()) {
+		DARKHOURS_LLM_SCOPE(PhysicsBodies);
+
+		WeaponRepMeshComp->SetSimulatePhysics(true); // Stimulate physics
+	}
+
+	ReplicatedMeshLocation = WeaponRepMeshComp->GetComponentLocation();
+	ReplicatedMeshRotation = WeaponRepMeshComp->GetComponentRotation();
+
+	// Ammo comes from the weapon stats of this pickup, the weapon itself stays unloaded until a character comes close
+	UpdateAmmo = WeaponStats.ClipSize; // Start with a full clip
+	ClipSize = WeaponStats.ClipSize;
+	MaxAmmo = WeaponStats.MaxAmmo;
+
+	ASSignificanceManager::RegisterActor(this, ESSignificanceType::Pickup);
+
+	// Register as interactable, then follow the mesh only when it moves
+	ASInteractableRegistry::RegisterActor(this, GetInteractionLocation());
+
+	WeaponRepMeshComp->TransformUpdated.AddUObject(this, &ASWeaponPickup::OnMeshTransformUpdated);
+
+	WeaponRepMeshComp->OnComponentSleep.AddDynamic(this, &ASWeaponPickup::OnMeshSleep);
+	WeaponRepMeshComp->OnComponentWake.AddDynamic(this, &ASWeaponPickup::OnMeshWake);
+
+}
+
+// Called when the game ends or when destroyed
+void ASWeaponPickup::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ASSignificanceManager::UnregisterActor(this);
+	ASInteractableRegistry::UnregisterActor(this);
+
+	WeaponClassHandle.Reset();
+	WeaponClassCallbacks.Reset();
+
+	Super::EndPlay(EndPlayReason);
+
+}
+
+void ASWeaponPickup::PostLoad()
+{
+	Super::PostLoad();
+
+	if (PendingPickupWeaponClass_DEPRECATED != NULL) {
+		WeaponClass = PendingPickupWeaponClass_DEPRECATED.Get();
+
+		// The weapon is loaded anyway through the old hard ref, take its stats while they are at hand
+		if (WeaponStats.ClipSize == 0) {
+			CopyWeaponStats(PendingPickupWeaponClass_DEPRECATED->GetDefaultObject<ASWeapon>());
+		}
+
+		PendingPickupWeaponClass_DEPRECATED = NULL;
+	}
+
+}
+
+#if WITH_EDITOR
+void ASWeaponPickup::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(ASWeaponPickup, WeaponClass)) {
+		RefreshWeaponStats();
+	}
+
+}
+
+void ASWeaponPickup::PreSave(const ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	// Keep the saved stats in sync with the weapon
+	if (HasAnyFlags(RF_ClassDefaultObject)) {
+		RefreshWeaponStats();
+	}
+
+}
+
+void ASWeaponPickup::RefreshWeaponStats()
+{
+	UClass* LoadedWeaponClass = WeaponClass.LoadSynchronous();
+
+	if (LoadedWeaponClass != NULL) {
+		CopyWeaponStats(LoadedWeaponClass->GetDefaultObject<ASWeapon>());
+	}
+
+}
+#endif
 
-	if (PendingPickupWeaponClass != NULL) {
-		ASWeapon* PendingPickupWeapon = Cast<ASWeapon>(PendingPickupWeaponClass->GetDefaultObject());
+void ASWeaponPickup::CopyWeaponStats(const ASWeapon* DefaultWeapon)
+{
+	if (DefaultWeapon != NULL) {
+		WeaponStats.ClipSize = DefaultWeapon->ClipSize;
+		WeaponStats.MaxAmmo = DefaultWeapon->MaxAmmo;
+	}
+
+	if (WeaponRepMeshComp != NULL && WeaponRepMeshComp->GetStaticMesh() != NULL) {
+		WeaponStats.DisplayMesh = WeaponRepMeshComp->GetStaticMesh();
+	}
+
+}
+
+void ASWeaponPickup::RequestWeaponClass(FSimpleDelegate OnLoaded)
+{
+	if (WeaponClass.IsNull()) {
+		return;
+	}
 
-		if (PendingPickupWeapon != NULL) {
-			UpdateAmmo = PendingPickupWeapon->UpdateAmmo;
-			ClipSize = PendingPickupWeapon->ClipSize;
-			MaxAmmo = PendingPickupWeapon->MaxAmmo;
+	if (GetLoadedWeaponClass() != NULL) {
+		// Already resident - only hold on to it
+		if (!WeaponClassHandle.IsValid()) {
+			WeaponClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(WeaponClass.ToSoftObjectPath());
 		}
+
+		OnLoaded.ExecuteIfBound();
+		return;
+	}
+
+	if (OnLoaded.IsBound()) {
+		WeaponClassCallbacks.Add(OnLoaded);
+	}
+
+	if (!WeaponClassHandle.IsValid() || !WeaponClassHandle->IsLoadingInProgress()) {
+		WeaponClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(WeaponClass.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &ASWeaponPickup::OnWeaponClassLoaded));
 	}
-	
+
 }
 
-// Called every frame
-void ASWeaponPickup::Tick(float DeltaTime)
+UClass* ASWeaponPickup::GetLoadedWeaponClass() const
 {
-	Super::Tick(DeltaTime);
+	return WeaponClass.Get();
+
+}
+
+void ASWeaponPickup::OnMeshTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	ASInteractableRegistry::UpdateActor(this, GetInteractionLocation());
+
+	if (HasAuthority()) {
+		ReplicatedMeshLocation = WeaponRepMeshComp->GetComponentLocation();
+		ReplicatedMeshRotation = WeaponRepMeshComp->GetComponentRotation();
+	}
+
+}
+
+void ASWeaponPickup::OnRep_MeshTransform()
+{
+	WeaponRepMeshComp->SetWorldLocationAndRotation(ReplicatedMeshLocation, ReplicatedMeshRotation, false, NULL, ETeleportType::TeleportPhysics);
+
+}
+
+void ASWeaponPickup::OnMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName)
+{
+	// Clients leave resting and freezing to the server
+	if (!HasAuthority()) {
+		return;
+	}
+
+	// Resting pickups go dormant, the final transform goes out as the channel closes
+	SetNetDormancy(DORM_DormantAll);
+
+	if (!ASPickupInstanceManager::IsFreezeEnabled()) {
+		return;
+	}
+
+	ASPickupInstanceManager* InstanceManager = ASPickupInstanceManager::Get(this);
+
+	if (InstanceManager != NULL) {
+		GetWorldTimerManager().SetTimer(FreezeTimerHandle, this, &ASWeaponPickup::TryFreeze, InstanceManager->GetFreezeDelay(), true);
+	}
+
+}
+
+void ASWeaponPickup::OnMeshWake(UPrimitiveComponent* WakingComponent, FName BoneName)
+{
+	// Replicate movement while the pickup is pushed around
+	if (HasAuthority()) {
+		SetNetDormancy(DORM_Awake);
+	}
+
+	GetWorldTimerManager().ClearTimer(FreezeTimerHandle);
+
+}
+
+void ASWeaponPickup::TryFreeze()
+{
+	// Releases this actor on success
+	ASPickupInstanceManager::FreezePickup(this);
+
+}
+
+void ASWeaponPickup::OnWeaponClassLoaded()
+{
+	TArray<FSimpleDelegate> Callbacks = MoveTemp(WeaponClassCallbacks);
+
+	for (FSimpleDelegate& Callback : Callbacks) {
+		Callback.ExecuteIfBound();
+	}
+
+}
+
+void ASWeaponPickup::OnAcquiredFromPool()
+{
+	// Put the mesh back where the pickup was authored - physics moved it away last time
+	const UStaticMeshComponent* DefaultMeshComp = CastChecked<UStaticMeshComponent>(WeaponRepMeshComp->GetArchetype());
+
+	WeaponRepMeshComp->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+	WeaponRepMeshComp->SetRelativeLocationAndRotation(DefaultMeshComp->RelativeLocation, DefaultMeshComp->RelativeRotation, false, NULL, ETeleportType::TeleportPhysics);
+
+	{
+		DARKHOURS_LLM_SCOPE(PhysicsBodies);
+
+		WeaponRepMeshComp->SetSimulatePhysics(true);
+	}
+
+	ASSignificanceManager::RegisterActor(this, ESSignificanceType::Pickup);
+	ASInteractableRegistry::RegisterActor(this, GetInteractionLocation());
+
+	// Shown again and moved - let clients know
+	if (HasAuthority()) {
+		FlushNetDormancy();
+	}
+
+}
+
+void ASWeaponPickup::OnReleasedToPool()
+{
+	ASSignificanceManager::UnregisterActor(this);
+	ASInteractableRegistry::UnregisterActor(this);
+
+	GetWorldTimerManager().ClearTimer(FreezeTimerHandle);
+
+	WeaponRepMeshComp->SetSimulatePhysics(false);
+
+	// Whoever took the weapon keeps it loaded
+	WeaponClassHandle.Reset();
+	WeaponClassCallbacks.Reset();
+
+	// Hidden - let clients know, then stay dormant in the pool
+	if (HasAuthority()) {
+		if (NetDormancy == DORM_Awake) {
+			SetNetDormancy(DORM_DormantAll);
+		}
+		else {
+			FlushNetDormancy();
+		}
+	}
 
 }
 
@@ -60,3 +321,21 @@ UStaticMeshComponent* ASWeaponPickup::GetMeshComponent()
 
 }
 
+UStaticMesh* ASWeaponPickup::GetDisplayMesh() const
+{
+	// Resident with the pickup, its mesh component holds the same mesh
+	UStaticMesh* DisplayMesh = WeaponStats.DisplayMesh.Get();
+
+	if (DisplayMesh == NULL && WeaponRepMeshComp != NULL) {
+		DisplayMesh = WeaponRepMeshComp->GetStaticMesh();
+	}
+
+	return DisplayMesh;
+
+}
+
+FVector ASWeaponPickup::GetInteractionLocation() const
+{
+	return WeaponRepMeshComp->GetComponentLocation();
+
+}
@@ -3,4 +3,161 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "HAL/PlatformTime.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+// Project wide log category
+DECLARE_LOG_CATEGORY_EXTERN(LogDarkHours, Log, All);
+
+// Stat group of the gameplay code - 'stat DarkHours'
+DECLARE_STATS_GROUP(TEXT("DarkHours"), STATGROUP_DarkHours, STATCAT_Advanced);
+
+// Cycle counters
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Tick"), STAT_DarkHours_CharacterTick, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Update (Game Thread)"), STAT_DarkHours_AnimUpdateGameThread, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Update (Worker)"), STAT_DarkHours_AnimUpdateWorker, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Interaction"), STAT_DarkHours_Interaction, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Interactable Query"), STAT_DarkHours_InteractableQuery, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hitscan Resolve"), STAT_DarkHours_HitscanResolve, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile Step"), STAT_DarkHours_ProjectileStep, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Impact Effects"), STAT_DarkHours_ImpactEffects, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Server Replicate Actors"), STAT_DarkHours_ServerReplicateActors, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn"), STAT_DarkHours_Spawn, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Destroy"), STAT_DarkHours_Destroy, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bot Update"), STAT_DarkHours_BotUpdate, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Level Streaming Update"), STAT_DarkHours_LevelStreamingUpdate, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics Budget Update"), STAT_DarkHours_PhysicsBudgetUpdate, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lag Compensation Record"), STAT_DarkHours_LagCompensationRecord, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lag Compensation Rewind"), STAT_DarkHours_LagCompensationRewind, STATGROUP_DarkHours, DARKHOURS_API);
+
+// Per frame counters
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Character Ticks"), STAT_DarkHours_NumCharacterTicks, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Anim Updates"), STAT_DarkHours_NumAnimUpdates, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Interactions"), STAT_DarkHours_NumInteractions, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Spawns"), STAT_DarkHours_NumSpawns, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Destroys"), STAT_DarkHours_NumDestroys, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pool Reuses"), STAT_DarkHours_NumPoolReuses, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Shots"), STAT_DarkHours_NumShots, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Dropped Shots"), STAT_DarkHours_NumDroppedShots, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impacts"), STAT_DarkHours_NumImpacts, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Skipped Impacts"), STAT_DarkHours_NumSkippedImpacts, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Move Corrections"), STAT_DarkHours_NumMoveCorrections, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bot Decisions"), STAT_DarkHours_NumBotDecisions, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bot Path Queries"), STAT_DarkHours_NumBotPathQueries, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bot Path Cache Hits"), STAT_DarkHours_NumBotPathCacheHits, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Physics Retirements"), STAT_DarkHours_NumPhysicsRetirements, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Rewinds"), STAT_DarkHours_NumRewinds, STATGROUP_DarkHours, DARKHOURS_API);
+
+// Running totals
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Actors"), STAT_DarkHours_PooledActors, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Interactables"), STAT_DarkHours_Interactables, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Frozen Pickups"), STAT_DarkHours_FrozenPickups, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Rounds In Flight"), STAT_DarkHours_Rounds, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Impact Components"), STAT_DarkHours_ImpactComponents, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Bots"), STAT_DarkHours_Bots, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Streamed Levels Visible"), STAT_DarkHours_StreamedLevelsVisible, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Streamed Levels Pending"), STAT_DarkHours_StreamedLevelsPending, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Destructible Chunks"), STAT_DarkHours_DestructibleChunks, STATGROUP_DarkHours, DARKHOURS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ragdolls"), STAT_DarkHours_Ragdolls, STATGROUP_DarkHours, DARKHOURS_API);
+
+// Low level memory tracker tags of the gameplay code - 'stat LLMFULL' with -LLM on the command line
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+enum class ESLLMTag : LLM_TAG_TYPE
+{
+	Characters = (LLM_TAG_TYPE)ELLMTag::ProjectTagStart,
+	Weapons,
+	Pickups,
+	Animation,
+	PhysicsBodies,
+};
+
+// Registers the tag names and stats with the tracker - called on module startup
+void RegisterDarkHoursLLMTags();
+
+#define DARKHOURS_LLM_SCOPE(Tag) LLM_SCOPE((ELLMTag)ESLLMTag::Tag)
+#else
+#define DARKHOURS_LLM_SCOPE(Tag)
+#endif
+
+// CSV profiler category of the gameplay code - captured with 'csvprofile start' / -csvCategories=DarkHours
+CSV_DECLARE_CATEGORY_EXTERN(DarkHours);
+
+// Time of the scoped stats by name, summed over all threads while a capture runs - read by the perf suite in any build
+struct DARKHOURS_API FSPerfCounters
+{
+	// Returns the index of the named counter, adding it if needed
+	static int32 Register(const TCHAR* Name);
+
+	static void Add(int32 Index, uint32 Cycles);
+
+	static void SetCapturing(bool bInCapturing);
+
+	static bool IsCapturing() { return bCapturing; }
+
+	static void Reset();
+
+	// Seconds of every counter since the last reset
+	static void GetSeconds(TArray<TPair<FString, double>>& OutSeconds);
+
+private:
+	static bool bCapturing;
+
+};
+
+// Adds the time of its scope to a perf counter while capturing
+struct FSScopedPerfCounter
+{
+	FSScopedPerfCounter(int32 InIndex)
+		: Index(InIndex)
+		, StartCycles(FSPerfCounters::IsCapturing() ? FPlatformTime::Cycles() : 0)
+	{
+	}
+
+	~FSScopedPerfCounter()
+	{
+		if (StartCycles != 0) {
+			FSPerfCounters::Add(Index, FPlatformTime::Cycles() - StartCycles);
+		}
+	}
+
+private:
+	int32 Index;
+
+	uint32 StartCycles;
+
+};
+
+// Scoped cycle counter plus a CSV timing stat and a perf counter of the same name in the DarkHours category
+#define DARKHOURS_SCOPED_STAT(Stat, CsvStat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	CSV_SCOPED_TIMING_STAT(DarkHours, CsvStat); \
+	static const int32 PerfCounterIndex_##CsvStat = FSPerfCounters::Register(TEXT(#CsvStat)); \
+	FSScopedPerfCounter PerfCounter_##CsvStat(PerfCounterIndex_##CsvStat)
+
+// Debug visualization (on-screen messages, debug draw) - compiled out of test, shipping and dedicated server builds
+#ifndef DARKHOURS_DEBUG_DRAW
+	#define DARKHOURS_DEBUG_DRAW !(UE_BUILD_SHIPPING || UE_BUILD_TEST || UE_SERVER)
+#endif
+
+// Cosmetic code (camera shakes and transitions, cosmetic physics) - compiled out of the server target, skipped at runtime on other dedicated servers
+#ifndef DARKHOURS_WITH_COSMETICS
+	#define DARKHOURS_WITH_COSMETICS !UE_SERVER
+#endif
+
+#if DARKHOURS_DEBUG_DRAW
+// Whether debug visualization is turned on at runtime - 'DarkHours.Debug 1'
+DARKHOURS_API bool IsDarkHoursDebugEnabled();
+
+// Prints a single frame on-screen debug message, only formats the string when debugging is turned on
+#define DARKHOURS_DEBUG_MESSAGE(Color, Format, ...) \
+	do { \
+		if (GEngine != NULL && IsDarkHoursDebugEnabled()) { \
+			GEngine->AddOnScreenDebugMessage(-1, 0.f, Color, FString::Printf(Format, ##__VA_ARGS__)); \
+		} \
+	} while (0)
+#else
+#define DARKHOURS_DEBUG_MESSAGE(Color, Format, ...) do { } while (0)
+#endif
 
@@ -13,5 +13,12 @@ UCLASS()
 class DARKHOURS_API ADarkHoursGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
-	
+
+public:
+	// Spawns the load test bots asked for with -Bots=<Count> on the command line
+	virtual void StartPlay() override;
+
+	// Spawns player pawns under the characters memory tag
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
 };
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "UObject/SoftObjectPath.h"
+#include "SActorPool.generated.h"
+
+// Free actors of a single class
+USTRUCT()
+struct FSActorPoolList
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<AActor*> FreeActors;
+
+};
+
+// Class and number of actors to spawn into the pool at map load
+USTRUCT()
+struct FSActorPoolPrewarm
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+		FSoftClassPath Class;
+
+	UPROPERTY(Config)
+		int32 Count;
+
+	FSActorPoolPrewarm()
+		: Count(0)
+	{
+	}
+
+};
+
+/**
+ * Pool of weapon and pickup actors, keyed by class. Released actors are hidden, detached and have collision
+ * disabled instead of being destroyed; acquiring one moves it into place and reactivates it.
+ * Actors implementing ISPooledActor get hooks for the rest of their state. Pools are pre-warmed at map
+ * load from DefaultGame.ini and from the pickups placed in the level.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASActorPool : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASActorPool();
+
+	// Returns the actor pool of the world, spawns one if needed
+	static ASActorPool* Get(const UObject* WorldContextObject);
+
+	// Takes an actor of given class out of the pool, spawns a new one if the pool is empty
+	static AActor* AcquireActor(const UObject* WorldContextObject, TSubclassOf<AActor> ActorClass, const FTransform& Transform);
+
+	template<typename T>
+	static T* Acquire(const UObject* WorldContextObject, TSubclassOf<AActor> ActorClass, const FTransform& Transform)
+	{
+		return Cast<T>(AcquireActor(WorldContextObject, ActorClass, Transform));
+	}
+
+	// Puts an actor back into the pool, destroys it if the pool is full or disabled
+	static void ReleaseActor(AActor* Actor);
+
+	// Spawns actors into the pool until it holds at least Count free actors of the class
+	void Prewarm(TSubclassOf<AActor> ActorClass, int32 Count);
+
+	// Returns number of free actors of the class
+	int32 GetNumFree(TSubclassOf<AActor> ActorClass) const;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Pre-warms the configured classes and the weapons of placed pickups
+	void PrewarmLevel();
+
+	// Spawns an actor, tracked by the spawn stats
+	AActor* SpawnPooledActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform);
+
+	// Classes pre-warmed at map load
+	UPROPERTY(Config)
+		TArray<FSActorPoolPrewarm> PrewarmClasses;
+
+	// Number of weapons and pickups pre-warmed for each weapon class placed in the level
+	UPROPERTY(Config)
+		int32 LevelPrewarmCount;
+
+	// Max number of free actors kept per class - the rest is destroyed
+	UPROPERTY(Config)
+		int32 MaxFreeActorsPerClass;
+
+	// Free actors per class
+	UPROPERTY()
+		TMap<UClass*, FSActorPoolList> Pools;
+
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SAnimBenchmark.generated.h"
+
+/**
+ * Spawns a crowd of characters and compares game thread animation update time of the
+ * game thread path (pass 0) against the anim instance proxy path (pass 1).
+ * Usage: DarkHours.Bench.AnimUpdate [NumCharacters] [SampleFrames] [CharacterClassPath]
+ */
+UCLASS()
+class DARKHOURS_API ASAnimBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASAnimBenchmark();
+
+	// Number of characters to spawn
+	int32 NumCharacters;
+
+	// Class of characters to spawn
+	TSubclassOf<ASCharacter> CharacterClass;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Sets anim proxy update console variable
+	void SetProxyUpdate(bool bEnabled);
+
+	// Accumulated frame time of the current pass
+	double FrameSeconds;
+
+	// Elapsed time, drives the fake input of the spawned characters
+	float InputTime;
+
+	// Proxy update setting before the benchmark started - restored when done
+	bool bWasProxyUpdateEnabled;
+
+};
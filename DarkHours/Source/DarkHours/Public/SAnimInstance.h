@@ -4,15 +4,110 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
 #include "SAnimInstance.generated.h"
 
+class APawn;
 class ASCharacter;
+class USAnimInstance;
+
+// Owner character state the animation needs - gathered once per frame on the game thread
+struct FSAnimCharacterSnapshot
+{
+	FVector Velocity;
+
+	FVector RightVector;
+
+	float MaxWalkSpeed;
+
+	float InputX;
+
+	float InputY;
+
+	float TurnX;
+
+	float MovementDirection;
+
+	bool bIsFalling;
+
+	bool bIsCrouching;
+
+	bool bIsSprinting;
+
+	bool bIsAiming;
+
+	// Whether the owner is a valid character - nothing else is valid otherwise
+	bool bHasCharacter;
+
+	// Whether the inputs came over the network - interpolated toward instead of taken as they are
+	bool bInterpolateInputs;
+
+	// Whether the start direction is latched natively for the anim nodes instead of by the Blueprint event
+	bool bNativeStartDirection;
+
+	// Whether the cosmetic leaning is computed - not on dedicated servers, hit detection does not need it
+	bool bProceduralLeaning;
+
+	FSAnimCharacterSnapshot();
+
+	// Copy state from owner pawn and its character (if any)
+	void Gather(const APawn* OwnerPawn, const ASCharacter* OwnerCharacter);
+
+};
+
+/**
+ * Anim instance proxy - snapshots the owner character in PreUpdate on the game thread,
+ * then derives all the animation properties in Update on an anim worker thread.
+ */
+USTRUCT()
+struct DARKHOURS_API FSAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FSAnimInstanceProxy();
+
+	FSAnimInstanceProxy(UAnimInstance* Instance);
+
+	// Derives the animation properties of the anim instance from the snapshot, returns true when the initial direction has to be received
+	static bool UpdateProperties(USAnimInstance* AnimInstance, const FSAnimCharacterSnapshot& Snapshot, float DeltaSeconds);
+
+protected:
+	virtual void Initialize(UAnimInstance* InAnimInstance) override;
+
+	// Game thread - gather owner character state
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	// Worker thread - derive the animation properties
+	virtual void Update(float DeltaSeconds) override;
+
+	// Worker thread - update the anim graph, timed for benchmarks
+	virtual void UpdateAnimationNode(float DeltaSeconds) override;
+
+	// Game thread - trigger the Blueprint events requested by the update
+	virtual void PostUpdate(UAnimInstance* InAnimInstance) const override;
+
+private:
+	// Anim instance owning this proxy
+	USAnimInstance* SAnimInstance;
+
+	// State of the owner character for this frame
+	FSAnimCharacterSnapshot Snapshot;
+
+	// Whether this frame is updated by the proxy, false when using the game thread path
+	bool bUpdateOnWorker;
+
+	// Set by the worker update when the initial direction has to be received
+	bool bRequestInitialDirection;
+
+};
 
 UCLASS()
 class DARKHOURS_API USAnimInstance : public UAnimInstance
 {
 	GENERATED_BODY()
 
+	friend struct FSAnimInstanceProxy;
+
 protected:
 	// Holds character movements speed
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
@@ -31,6 +126,10 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
 		float MovementDirection;
 
+	// Movement direction of the character as it changes - smoothed for simulated proxies. MovementDirection is left to the start direction latch
+	UPROPERTY(BlueprintReadOnly)
+		float LiveMovementDirection;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
 		bool bIsSprinting;
 
@@ -47,6 +146,10 @@ protected:
 	UPROPERTY(BlueprintReadWrite)
 		bool bReceivedInitialDirection;
 
+	// Movement direction the character started moving in - latched natively for the start direction node
+	UPROPERTY(BlueprintReadOnly)
+		float StartDirection;
+
 	// Animation play rate - used for manipulating the anim play speed
 	UPROPERTY(BlueprintReadWrite)
 		float AnimPlayRate;
@@ -63,8 +166,24 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
 		float LeaningScale;
 
+	// Interpolation speed toward the replicated inputs of simulated proxies
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
+		float ReplicatedInputInterpSpeed;
+
+	// Native initialization override point - caches the owner character
+	virtual void NativeInitializeAnimation() override;
+
+	// Creates the proxy that runs the property update on anim worker threads
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+	// Called on the game thread once the proxy has updated
+	void OnProxyPostUpdate(bool bRequestInitialDirection);
+
 public:
-	// Called for updating the character animation properties
+	// Sets default values
+	USAnimInstance();
+
+	// Called for updating the character animation properties - only does work when the proxy update is disabled (DarkHours.Anim.ProxyUpdate 0)
 	UFUNCTION(BlueprintCallable)
 		void UpdateAnimationProperties(float DeltaTime);
 
@@ -72,4 +191,25 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent)
 		void SetDirectionAndReceiveInitialDirection();
 
+	// Native anim node inputs - read on anim worker threads
+	float GetStartDirection() const;
+
+	FRotator GetProcedualLeaningRotation() const;
+
+	// Whether animation properties are updated by the proxy on worker threads
+	static bool IsProxyUpdateEnabled();
+
+	// Whether the start direction is latched natively instead of by the Blueprint event (DarkHours.Anim.NativeNodes)
+	static bool IsNativeNodesEnabled();
+
+	// Game thread seconds spent updating animation properties since the last reset - used by benchmarks
+	static double GetGameThreadUpdateSeconds();
+
+	static void ResetGameThreadUpdateSeconds();
+
+	// Anim graph update seconds summed over all threads since the last reset - used by benchmarks
+	static double GetGraphUpdateSeconds();
+
+	static void ResetGraphUpdateSeconds();
+
 };
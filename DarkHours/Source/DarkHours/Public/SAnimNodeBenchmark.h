@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SAnimNodeBenchmark.generated.h"
+
+class UAnimInstance;
+
+/**
+ * Spawns a crowd of characters and compares the game thread and anim graph update time of the
+ * Blueprint start direction event (pass 0) against the native anim nodes (pass 1). The native pass
+ * switches the characters to the given anim class, so an anim Blueprint wired to the native nodes
+ * can be measured against the one the character class ships with.
+ * Usage: DarkHours.Bench.AnimNodes [NumCharacters] [NativeAnimClassPath] [CharacterClassPath]
+ */
+UCLASS()
+class DARKHOURS_API ASAnimNodeBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASAnimNodeBenchmark();
+
+	// Number of characters to spawn
+	int32 NumCharacters;
+
+	// Class of characters to spawn
+	TSubclassOf<ASCharacter> CharacterClass;
+
+	// Anim class of the native pass, the characters keep their own if NULL
+	TSubclassOf<UAnimInstance> NativeAnimClass;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Sets native anim nodes console variable
+	void SetNativeNodes(bool bEnabled);
+
+	// Accumulated frame time of the current pass
+	double FrameSeconds;
+
+	// Elapsed time, drives the fake input of the spawned characters
+	float InputTime;
+
+	// Native nodes setting before the benchmark started - restored when done
+	bool bWasNativeNodesEnabled;
+
+};
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "SAnimNode_Leaning.generated.h"
+
+/**
+ * Adds the procedural leaning rotation of USAnimInstance to a bone, read natively on the anim worker thread.
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct DARKHOURS_API FSAnimNode_Leaning : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	// Bone the character leans with
+	UPROPERTY(EditAnywhere, Category = "Leaning")
+		FBoneReference LeanBone;
+
+	// Space the leaning rotation is added in
+	UPROPERTY(EditAnywhere, Category = "Leaning")
+		TEnumAsByte<EBoneControlSpace> LeanSpace;
+
+	// Scale of the leaning rotation
+	UPROPERTY(EditAnywhere, Category = "Leaning")
+		float LeanScale;
+
+	FSAnimNode_Leaning();
+
+	// FAnimNode_SkeletalControlBase interface
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+
+protected:
+	virtual void UpdateInternal(const FAnimationUpdateContext& Context) override;
+
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+
+private:
+	// Leaning rotation of this update
+	FRotator LeanRotation;
+
+};
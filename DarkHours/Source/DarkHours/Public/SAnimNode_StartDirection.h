@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+#include "SAnimNode_StartDirection.generated.h"
+
+/**
+ * Picks the start pose by the direction the character started moving in, read natively from
+ * USAnimInstance on the anim worker thread, and cross fades when the start direction changes.
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct DARKHOURS_API FSAnimNode_StartDirection : public FAnimNode_Base
+{
+	GENERATED_BODY()
+
+	// Start poses - start direction around 0, +90, 180 and -90 degrees
+	UPROPERTY(EditAnywhere, Category = "Links")
+		FPoseLink Forward;
+
+	UPROPERTY(EditAnywhere, Category = "Links")
+		FPoseLink Right;
+
+	UPROPERTY(EditAnywhere, Category = "Links")
+		FPoseLink Backward;
+
+	UPROPERTY(EditAnywhere, Category = "Links")
+		FPoseLink Left;
+
+	// Cross fade time when the start direction changes
+	UPROPERTY(EditAnywhere, Category = "Settings")
+		float BlendTime;
+
+	FSAnimNode_StartDirection();
+
+	// FAnimNode_Base interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+
+	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
+
+	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+
+	// Returns the pose index of the start direction in degrees
+	static int32 GetDirectionIndex(float StartDirection);
+
+private:
+	// Returns the pose link of the index
+	FPoseLink& GetPose(int32 Index);
+
+	// Weight of each pose
+	float BlendWeights[4];
+
+	// Pose blended toward
+	int32 ActiveIndex;
+
+};
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SBenchmark.generated.h"
+
+class ASCharacter;
+class ASBenchmark;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FSOnBenchmarkFinished, ASBenchmark*);
+
+/**
+ * Base of the headless benchmarks. Runs a number of passes, each pass waits for a few warmup
+ * frames and then samples a fixed number of frames. Results are logged and written as CSV to
+ * Saved/Benchmarks. Pass -BenchmarkExit on the command line to quit once the benchmark is done,
+ * automation tests bind OnFinished instead.
+ */
+UCLASS(Abstract, NotPlaceable, Transient)
+class DARKHOURS_API ASBenchmark : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASBenchmark();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Spawns a benchmark of given class at the benchmark origin of the world
+	static ASBenchmark* Start(UWorld* World, TSubclassOf<ASBenchmark> BenchmarkClass);
+
+	// Number of frames each pass waits before sampling - lets spawned actors settle
+	int32 WarmupFrames;
+
+	// Number of frames sampled per pass
+	int32 SampleFrames;
+
+	// Number of passes the benchmark runs
+	int32 NumPasses;
+
+	// Broadcast once the report is written, right before the benchmark destroys itself
+	FSOnBenchmarkFinished OnFinished;
+
+	// Whether the benchmark was marked failed, and why
+	bool HasFailed() const;
+
+	const TArray<FString>& GetFailures() const;
+
+protected:
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called when a pass starts - spawn or configure the workload here
+	virtual void BeginPass(int32 PassIndex);
+
+	// Called for every sampled frame of the current pass
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime);
+
+	// Called when a pass is done sampling - add the results of the pass here
+	virtual void EndPass(int32 PassIndex);
+
+	// Records a named result, which is logged and written to the benchmark report
+	void AddResult(const FString& Name, double Value);
+
+	// Marks the benchmark as failed - -BenchmarkExit then quits with a non-zero exit code
+	void MarkFailed(const FString& Reason);
+
+	// Spawns a character that is not possessed by any player at a grid slot around the benchmark origin
+	ASCharacter* SpawnCharacter(TSubclassOf<ASCharacter> CharacterClass, int32 Index, float Spacing = 300.f);
+
+	// Destroys all the characters spawned by this benchmark
+	void DestroyCharacters();
+
+	// Returns grid slot location around the benchmark origin
+	FVector GetGridLocation(int32 Index, int32 NumColumns, float Spacing) const;
+
+	// Loads character class from the given path, falls back to BP_Proto and then to the native character
+	static TSubclassOf<ASCharacter> ResolveCharacterClass(const FString& ClassPath);
+
+	// Name of the benchmark, used for the log and the report file
+	FString BenchmarkName;
+
+	// Characters spawned by this benchmark
+	UPROPERTY(Transient)
+		TArray<ASCharacter*> SpawnedCharacters;
+
+private:
+	// Writes the report and cleans up
+	void FinishBenchmark();
+
+	int32 CurrentPass;
+
+	int32 CurrentFrame;
+
+	bool bFinished;
+
+	bool bFailed;
+
+	TArray<FString> ResultLines;
+
+	TArray<FString> Failures;
+
+};
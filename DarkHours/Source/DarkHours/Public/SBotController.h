@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Controller.h"
+#include "SInputRecording.h"
+#include "SBotController.generated.h"
+
+class ASBotManager;
+class ASCharacter;
+
+// What a bot is doing between two decisions
+enum class ESBotBehavior : uint8
+{
+	Wander,
+	SeekPickup,
+	SwapWeapon,
+};
+
+/**
+ * Load test bot. Drives its ASCharacter through ApplyInputFrame, so it runs the same input bindings
+ * as a player (MoveX, MoveY, CameraX, SprintStart, AimStart, Interact). Bots do not tick themselves:
+ * ASBotManager feeds their input every frame and lets a few of them think per frame. Paths come from
+ * the shared path cache of the manager, so the load measured is the character and not the AI.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASBotController : public AController
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASBotController();
+
+	// Seeds the decisions of the bot - same seed, same choices
+	void SetRandomSeed(int32 Seed);
+
+	// Picks the next behavior and goal, requests a path if needed - time sliced by the manager
+	void Think(ASBotManager* BotManager);
+
+	// Steers along the path and applies the resulting input frame to the character - every frame
+	void UpdateInput(float DeltaTime);
+
+	ESBotBehavior GetBehavior() const;
+
+	// Returns the possessed character
+	ASCharacter* GetBotCharacter() const;
+
+protected:
+	// Starts following the path from the point after its start, the start may be anywhere in the cell of the bot
+	void SetPath(TSharedPtr<const TArray<FVector>> NewPath);
+
+	// Chance to seek a pickup instead of wandering when picking a new goal
+	UPROPERTY(Config)
+		float SeekPickupChance;
+
+	// Max distance of the pickups a bot seeks
+	UPROPERTY(Config)
+		float SeekPickupRadius;
+
+	// Chance to sprint or aim on the way to a new goal
+	UPROPERTY(Config)
+		float SprintChance;
+
+	UPROPERTY(Config)
+		float AimChance;
+
+	// Distance at which a path point counts as reached
+	UPROPERTY(Config)
+		float AcceptRadius;
+
+	// Distance to the pickup at which the bot interacts - within the interaction reach of the character
+	UPROPERTY(Config)
+		float SwapDistance;
+
+	// Degrees per second the bot turns its control rotation
+	UPROPERTY(Config)
+		float TurnRate;
+
+	ESBotBehavior Behavior;
+
+	// Where the bot is going
+	FVector Goal;
+
+	// Pickup the bot seeks
+	TWeakObjectPtr<AActor> TargetPickup;
+
+	// Path to the goal, shared with the bots going the same way
+	TSharedPtr<const TArray<FVector>> Path;
+
+	int32 PathIndex;
+
+	// Whether the goal changed and a path is still needed - retried next decision when the query budget ran out
+	bool bNeedsPath;
+
+	bool bWantsSprint;
+
+	bool bWantsAim;
+
+	// Press interact with the next input frame
+	bool bWantsInteract;
+
+	// Input frame applied last
+	FSInputFrame PreviousFrame;
+
+	FRandomStream RandomStream;
+
+};
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SBotManager.generated.h"
+
+class ASBotController;
+class ASCharacter;
+
+// Path shared by the bots going from one cell to another
+struct FSBotPath
+{
+	TSharedPtr<const TArray<FVector>> Points;
+
+	// World time the path was found at
+	float Time;
+
+};
+
+/**
+ * Spawns and runs the load test bots of a world - server only. Every frame it feeds the input of all bots,
+ * but only lets DecisionsPerFrame of them think, round robin. Paths are cached by start and goal cell and
+ * shared between bots, at most PathQueriesPerFrame new ones are searched per frame. Wander goals come from
+ * a small shared set of navigable points, so bots wandering the same area reuse the same paths.
+ * Usage: DarkHours.Bots.Spawn [Count] [CharacterClassPath], DarkHours.Bots.Clear, DarkHours.Bots.Report
+ * Command line: -Bots=<Count> spawns bots when the match starts
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASBotManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASBotManager();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Returns the bot manager of the world, spawns one if needed
+	static ASBotManager* Get(const UObject* WorldContextObject);
+
+	// Spawns bots around the origin, returns the number spawned - server only
+	int32 SpawnBots(int32 Count, TSubclassOf<ASCharacter> CharacterClass, const FVector& Origin);
+
+	// Destroys all bots and their characters
+	void DestroyBots();
+
+	// Returns the shared path between the cells of start and goal, NULL when the query budget of the frame is spent
+	TSharedPtr<const TArray<FVector>> FindPath(const FVector& Start, const FVector& Goal);
+
+	// Returns one of the shared wander points, false when none could be found yet
+	bool GetWanderPoint(FRandomStream& RandomStream, FVector& OutPoint);
+
+	int32 GetNumBots() const;
+
+	// Logs bots per behavior and path cache use
+	void LogReport() const;
+
+	// Returns the class of the player pawn of the game mode, or the class at the path
+	static TSubclassOf<ASCharacter> ResolveCharacterClass(UWorld* World, const FString& ClassPath);
+
+protected:
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Returns the path cache cell containing the location
+	FIntVector GetCell(const FVector& Location) const;
+
+	// Returns a navigable point around the location, the location itself without a navmesh
+	FVector GetRandomNavigablePoint(const FVector& Location, float Radius, FRandomStream& RandomStream) const;
+
+	// Max number of bots thinking per frame
+	UPROPERTY(Config)
+		int32 DecisionsPerFrame;
+
+	// Max number of path searches per frame - bots waiting for a path retry on their next decision
+	UPROPERTY(Config)
+		int32 PathQueriesPerFrame;
+
+	// Size of a path cache cell - bots starting and ending in the same cells share a path
+	UPROPERTY(Config)
+		float PathCellSize;
+
+	// Seconds a cached path is reused
+	UPROPERTY(Config)
+		float PathLifetime;
+
+	// Max number of cached paths, expired ones are dropped first
+	UPROPERTY(Config)
+		int32 MaxCachedPaths;
+
+	// Number of shared wander points
+	UPROPERTY(Config)
+		int32 NumWanderPoints;
+
+	// Radius around the spawn origin of the wander points
+	UPROPERTY(Config)
+		float WanderRadius;
+
+	// Radius around the origin the bots spawn in
+	UPROPERTY(Config)
+		float SpawnRadius;
+
+	// Bots of the world, in thinking order
+	UPROPERTY()
+		TArray<ASBotController*> Bots;
+
+	// Bot thinking next
+	int32 NextBotIndex;
+
+	TMap<TPair<FIntVector, FIntVector>, FSBotPath> Paths;
+
+	TArray<FVector> WanderPoints;
+
+	FVector WanderOrigin;
+
+	// Path searches done this frame
+	int32 NumPathQueries;
+
+	// Totals for the report
+	int32 TotalPathQueries;
+
+	int32 TotalPathCacheHits;
+
+};
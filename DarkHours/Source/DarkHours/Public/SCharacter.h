@@ -4,15 +4,75 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "SInputRecording.h"
+#include "SInventoryComponent.h"
 #include "SCharacter.generated.h"
 
 class ASRifleWeapon;
-class ASWeapon;
 class ASWeaponPickup;
 class UCameraComponent;
 class UCameraShake;
+class USCharacterMovementComponent;
 class USpringArmComponent;
 
+// Animation inputs of a character for remote machines - quantized to a few bits per axis, flags packed into bits
+USTRUCT()
+struct FSReplicatedAnimInputs
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		float InputX;
+
+	UPROPERTY()
+		float InputY;
+
+	UPROPERTY()
+		float TurnX;
+
+	UPROPERTY()
+		float MovementDirection;
+
+	UPROPERTY()
+		uint8 bIsSprinting : 1;
+
+	UPROPERTY()
+		uint8 bIsAiming : 1;
+
+	FSReplicatedAnimInputs()
+		: InputX(0.f)
+		, InputY(0.f)
+		, TurnX(0.f)
+		, MovementDirection(0.f)
+		, bIsSprinting(false)
+		, bIsAiming(false)
+	{
+	}
+
+	// Snaps the values to what survives quantization, so unchanged inputs compare equal
+	void Quantize();
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FSReplicatedAnimInputs& Other) const;
+
+	bool operator!=(const FSReplicatedAnimInputs& Other) const
+	{
+		return !(*this == Other);
+	}
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FSReplicatedAnimInputs> : public TStructOpsTypeTraitsBase2<FSReplicatedAnimInputs>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
+
 UCLASS()
 class DARKHOURS_API ASCharacter : public ACharacter
 {
@@ -20,12 +80,15 @@ class DARKHOURS_API ASCharacter : public ACharacter
 
 public:
 	// Sets default values for this character's properties
-	ASCharacter();
+	ASCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Components
 	// Spring arm component to control the camera component
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "Components")
@@ -35,6 +98,10 @@ protected:
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "Components")
 		UCameraComponent* CameraComp;
 
+	// Weapon inventory component
+	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "Components")
+		USInventoryComponent* InventoryComp;
+
 	// Binding functions
 	// Character input
 	void MoveX(float Value);
@@ -53,6 +120,30 @@ protected:
 
 	void Interact();
 
+	// Runs the interaction on the server, which finds the pickup from its own view of the character
+	UFUNCTION(Server, Reliable, WithValidation)
+		void ServerInteract();
+
+	void FireStart();
+	void FireEnd();
+
+	// Fires the primary weapon on the server, which deals the damage - the shots of the client only play effects. Carries the
+	// server time the client fired at, so the server knows how late the shots arrive
+	UFUNCTION(Server, Reliable, WithValidation)
+		void ServerStartFire(float ClientFireTime);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+		void ServerStopFire();
+
+	// Finishes the interaction once the weapon class of the pickup is loaded
+	void OnInteractionWeaponLoaded();
+
+	// Returns the nearest weapon pickup within interaction reach and facing cone
+	ASWeaponPickup* FindInteractableWeaponPickup() const;
+
+	// Thaws frozen pickups around the character, tracks the pickup in front of it and starts streaming in its weapon
+	void UpdateNearbyWeaponPickup();
+
 	// Camera input
 	void CameraX(float Value);
 	void CameraY(float Value);
@@ -60,8 +151,47 @@ protected:
 	// Calculates character movement direction
 	void CalculateCharacterMovementDirection(float InputX, float InputY);
 
-	// On interaction of primary weapon
-	void Interaction_PrimaryWeapon();
+	// Starts the camera transition toward the current aim state
+	void StartAimTransition();
+
+	// Moves FOV and camera offset toward the current aim state, ends the transition once converged
+	void UpdateAimTransition(float DeltaTime);
+
+	// Whether any movement input is held
+	bool HasMovementInput() const;
+
+	// Sends the animation inputs to the server when they changed - locally controlled only
+	void UpdateReplicatedAnimInputs();
+
+	// Runs on the server, which passes the animation inputs on to the other clients - unreliable, as the axes change almost every frame
+	UFUNCTION(Server, Unreliable, WithValidation)
+		void ServerSetAnimInputs(FSReplicatedAnimInputs NewAnimInputs);
+
+	// Sends the last animation inputs again, so a lost update does not stick on the other clients
+	void ResendAnimInputs();
+
+	// Seconds between resends of the last animation inputs
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = Replication)
+		float AnimInputsResendInterval;
+
+	FTimerHandle AnimInputsResendTimerHandle;
+
+	// Copies the flags onto the character of simulated proxies
+	UFUNCTION()
+		void OnRep_ReplicatedAnimInputs();
+
+	// Animation inputs of the owning client - not replicated back to it
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedAnimInputs)
+		FSReplicatedAnimInputs ReplicatedAnimInputs;
+
+	// Enables tick only while there is movement input or an active camera transition, or always for Blueprints ticking on their own
+	void UpdateTickEnabled();
+
+	// Turns off the camera rig and the cosmetic mesh work - dedicated server only
+	void ConfigureForDedicatedServer();
+
+	// Input that reached the bindings this frame
+	FSInputFrame InputFrame;
 
 	// Variables
 	// Ref to sprinting camera shake
@@ -100,14 +230,36 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = Camera)
 		float FOVInterpSpeed;
 
-	// Ref to weapon pickup class that character potentially overlaps with
-	ASWeaponPickup* OverlappedWeaponPickup;
+	// Camera offset when character is aiming
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = Camera)
+		FVector AimSocketOffset;
+
+	// Character default camera offset
+	FVector DefaultSocketOffset;
 
-	// Primary weapon of the weapon inventory
-	ASRifleWeapon* PrimaryWeapon;
+	// Camera offset transition interpolation speed
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = Camera)
+		float SocketOffsetInterpSpeed;
+
+	// Whether the camera is transitioning between aiming and default state
+	bool bIsAimTransitionActive;
+
+	// Whether the Blueprint class implements Event Tick - then tick is never turned off
+	bool bTickInBlueprint;
+
+	// Max distance between the character and a pickup it interacts with
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Interaction")
+		float InteractionReach;
 
-	// Secondary weapon of the weapon inventory
-	ASWeapon* SecondaryWeapon;
+	// Half angle of the cone in front of the character in which pickups can be interacted with
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Interaction")
+		float InteractionAngle;
+
+	// Ref to weapon pickup the character currently stands in front of - weak, pickups are destroyed or pooled under it
+	TWeakObjectPtr<ASWeaponPickup> NearbyWeaponPickup;
+
+	// Pickup the character interacted with, waiting for its weapon class to stream in
+	TWeakObjectPtr<ASWeaponPickup> PendingInteractionPickup;
 
 public:
 	// Called every frame
@@ -116,13 +268,34 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
-	// When character starts overlapping
-	UFUNCTION()
-		void OnStartOverlappingActors(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult);
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
-	// When characer stop overlapping
-	UFUNCTION()
-		void OnEndOverlappingActors(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	// Returns the animation inputs last received - used by the animation of simulated proxies
+	const FSReplicatedAnimInputs& GetReplicatedAnimInputs() const;
+
+	// On interaction of primary weapon - swaps primary weapon with the weapon of the pickup, returns the pickup of the dropped weapon (if any) - server only
+	ASWeaponPickup* Interaction_PrimaryWeapon(ASWeaponPickup* WeaponPickup);
+
+	// Returns the character movement component with predicted sprint and aim
+	USCharacterMovementComponent* GetSCharacterMovement() const;
+
+	// Returns the primary weapon of the inventory
+	ASRifleWeapon* GetPrimaryWeapon() const;
+
+	// Returns the name of the holster socket of the inventory slot
+	FName GetHolsterSocketName(ESInventorySlot Slot) const;
+
+	// Returns the input that reached the bindings this frame - used by the input recorder
+	const FSInputFrame& GetInputFrame() const;
+
+	// Forgets the presses of the frame once they were recorded
+	void ClearPressedInputActions();
+
+	// Feeds recorded input through the input bindings, previous frame is the one applied last
+	void ApplyInputFrame(const FSInputFrame& Frame, const FSInputFrame& PreviousFrame);
+
+	// Lets the mesh fall as a ragdoll pushed by the impulse - cosmetic and not replicated, call it on every machine
+	void StartRagdoll(const FVector& Impulse, const FVector& ImpulseLocation);
 
 	// Variables
 	// Character movement values
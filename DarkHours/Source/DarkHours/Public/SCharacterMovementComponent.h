@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "SCharacterMovementComponent.generated.h"
+
+/**
+ * Character movement with predicted sprint and aim. Both are sent to the server in the compressed flags of
+ * the saved moves (crouch already is), max speed comes from that state instead of scaled input, and aiming
+ * turns the character with the view - so server and client simulate the same move and agree.
+ */
+UCLASS()
+class DARKHOURS_API USCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	USCharacterMovementComponent();
+
+	virtual float GetMaxSpeed() const override;
+
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	// Starts / stops sprinting, predicted on the owning client
+	void SetSprinting(bool bSprinting);
+
+	// Starts / stops aiming, predicted on the owning client
+	void SetAiming(bool bAiming);
+
+	// Corrections sent to clients (server) or received from the server (owning client) since the last reset
+	int32 GetNumCorrections() const;
+
+	void ResetCorrections();
+
+	// Whether the character wants to sprint
+	uint8 bWantsToSprint : 1;
+
+	// Whether the character wants to aim
+	uint8 bWantsToAim : 1;
+
+	// Walk speed scale while sprinting
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Character Movement: Walking")
+		float SprintSpeedMultiplier;
+
+	// Walk speed scale while aiming
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Character Movement: Walking")
+		float AimSpeedMultiplier;
+
+protected:
+	// Turns the character with the view while aiming, with the movement otherwise
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	virtual void ServerMoveHandleClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+	virtual void ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+
+	int32 NumCorrections;
+
+};
+
+// Saved move carrying sprint and aim
+class FSSavedMove_Character : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+
+	virtual uint8 GetCompressedFlags() const override;
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+
+	virtual void PrepMoveFor(ACharacter* Character) override;
+
+	uint8 bSavedWantsToSprint : 1;
+
+	uint8 bSavedWantsToAim : 1;
+
+};
+
+// Client prediction data allocating the saved moves above
+class FSNetworkPredictionData_Client_Character : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FSNetworkPredictionData_Client_Character(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+
+};
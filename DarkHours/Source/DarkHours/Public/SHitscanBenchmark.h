@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SHitscanBenchmark.generated.h"
+
+class ASRifleWeapon;
+
+/**
+ * Spawns a grid of rifles that fire automatically at the ground and compares the hitscan fire system
+ * tracing every shot synchronously (pass 0) against one batch of async traces per frame (pass 1).
+ * Reports shots resolved per millisecond of game thread time and the average frame time.
+ * Usage: DarkHours.Bench.Hitscan [NumWeapons] [FireRate] [WeaponClassPath]
+ */
+UCLASS()
+class DARKHOURS_API ASHitscanBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASHitscanBenchmark();
+
+	// Number of weapons firing
+	int32 NumWeapons;
+
+	// Rounds per minute of every weapon, 0 keeps the fire rate of the weapon class
+	float FireRate;
+
+	// Class of weapons to spawn
+	TSubclassOf<ASRifleWeapon> WeaponClass;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Destroys the spawned weapons
+	void DestroyWeapons();
+
+	// Sets hitscan async console variable
+	void SetAsyncEnabled(bool bEnabled);
+
+	// Weapons spawned by this benchmark
+	UPROPERTY(Transient)
+		TArray<ASRifleWeapon*> Weapons;
+
+	// Accumulated frame time of the current pass
+	double FrameSeconds;
+
+	// Whether the first sampled frame of the pass was seen
+	bool bSampling;
+
+	// Async setting before the benchmark started - restored when done
+	bool bWasAsyncEnabled;
+
+};
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "GameFramework/Info.h"
+#include "WorldCollision.h"
+#include "SHitscanFireSystem.generated.h"
+
+class AController;
+class ASRifleWeapon;
+
+// Shot waiting to be traced or waiting for its trace result
+struct FSHitscanShot
+{
+	TWeakObjectPtr<ASRifleWeapon> Weapon;
+
+	// Owner and instigator of the weapon when the shot was queued - the shot is void once the weapon changes hands
+	TWeakObjectPtr<AActor> Owner;
+
+	TWeakObjectPtr<AController> InstigatorController;
+
+	FVector Start;
+
+	// Aim direction, spread is added when the shot is traced
+	FVector Direction;
+
+	FVector End;
+
+	// Lag compensation of remote shooters on the server - world time the characters are rewound to, taken when
+	// the shot is traced since async results only come in the next frame
+	bool bRewind;
+
+	float RewindTargetTime;
+
+	FTraceHandle TraceHandle;
+
+};
+
+/**
+ * Resolves the hitscan shots of all rifles in the world in one batch per frame. Weapons queue their shots
+ * into a fixed capacity buffer; at the end of the frame ammo and spread are applied to the whole queue and
+ * the shots are issued as async line traces, whose results are picked up the next frame to apply damage.
+ * The buffers are allocated once, queuing and resolving a shot does not allocate. Shots of weapons with
+ * ballistics are handed to the projectile manager instead of being traced. On the server, shots of remote
+ * players hit characters as the shooter saw them, through the lag compensation manager. Clients trace the
+ * shots of their own weapons for the impact effects only, the server fires them again and deals the damage.
+ * 'DarkHours.Hitscan.Async 0' traces synchronously instead, for comparison.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASHitscanFireSystem : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASHitscanFireSystem();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Returns the hitscan fire system of the world, spawns one if needed
+	static ASHitscanFireSystem* Get(const UObject* WorldContextObject);
+
+	// Queues a shot of the weapon, returns false if the queue is full
+	bool QueueShot(ASRifleWeapon* Weapon, const FVector& Start, const FVector& Direction);
+
+	// Number of shots resolved and game thread seconds spent resolving since the last reset
+	int32 GetNumResolvedShots() const;
+
+	double GetResolveSeconds() const;
+
+	void ResetCounters();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Picks up the trace results of last frame's batch and applies damage
+	void ResolveInFlightShots();
+
+	// Applies ammo and spread to the queued shots and issues their traces
+	void SubmitQueuedShots();
+
+	// Settles what the traced shot hit - characters are taken from the rewound hitboxes for lag compensated shots
+	void ResolveShot(const FSHitscanShot& Shot, bool bHit, const FHitResult& Hit);
+
+	// Applies the damage of the weapon to what the shot hit
+	void ApplyHit(const FSHitscanShot& Shot, const FHitResult& Hit);
+
+	// Max number of shots queued per frame - shots beyond are dropped
+	UPROPERTY(Config)
+		int32 MaxQueuedShots;
+
+	// Collision channel shots are traced on
+	UPROPERTY(Config)
+		TEnumAsByte<ECollisionChannel> TraceChannel;
+
+	// Shots queued this frame
+	TArray<FSHitscanShot> QueuedShots;
+
+	// Shots traced last frame, waiting for their results
+	TArray<FSHitscanShot> InFlightShots;
+
+	// Reused to read trace results
+	FTraceDatum TraceDatum;
+
+	// Spread of all shots
+	FRandomStream SpreadStream;
+
+	int32 NumResolvedShots;
+
+	double ResolveSeconds;
+
+};
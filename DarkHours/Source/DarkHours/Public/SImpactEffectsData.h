@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/EngineTypes.h"
+#include "SImpactEffectsData.generated.h"
+
+class UMaterialInterface;
+class UParticleSystem;
+class USoundBase;
+
+// Particle, decal and sound played where a shot hits a surface type
+USTRUCT(BlueprintType)
+struct FSImpactEffect
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Impact")
+		TEnumAsByte<EPhysicalSurface> SurfaceType;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Impact")
+		UParticleSystem* Particle;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Impact")
+		UMaterialInterface* DecalMaterial;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Impact")
+		FVector DecalSize;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Impact")
+		USoundBase* Sound;
+
+	FSImpactEffect()
+		: SurfaceType(SurfaceType_Default)
+		, Particle(NULL)
+		, DecalMaterial(NULL)
+		, DecalSize(4.f, 8.f, 8.f)
+		, Sound(NULL)
+	{
+	}
+
+};
+
+/**
+ * Impact effects per surface type and the budgets of the impact effects manager.
+ */
+UCLASS(BlueprintType)
+class DARKHOURS_API USImpactEffectsData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	USImpactEffectsData();
+
+	// Returns the effect of the surface type, the default effect if there is none
+	const FSImpactEffect& GetEffect(EPhysicalSurface SurfaceType) const;
+
+	// Effect of surfaces without their own entry
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Impact")
+		FSImpactEffect DefaultEffect;
+
+	// Effects per surface type
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Impact")
+		TArray<FSImpactEffect> SurfaceEffects;
+
+	// Particle components kept per surface type - the oldest is recycled beyond
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Budget")
+		int32 MaxParticlesPerSurface;
+
+	// Decal components kept per surface type - decals stay until recycled
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Budget")
+		int32 MaxDecalsPerSurface;
+
+	// Audio components kept per surface type - the oldest is recycled beyond
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Budget")
+		int32 MaxSoundsPerSurface;
+
+	// Components created per frame - the oldest is recycled beyond, even if the ring is not full yet
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Budget")
+		int32 MaxNewComponentsPerFrame;
+
+	// Impacts played per frame - the rest of the frame has no effects
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Budget")
+		int32 MaxImpactsPerFrame;
+
+	// Impacts further away from every view are not played
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Budget")
+		float MaxDistance;
+
+};
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/Info.h"
+#include "SImpactEffectsManager.generated.h"
+
+class UAudioComponent;
+class UDecalComponent;
+class UParticleSystemComponent;
+class USImpactEffectsData;
+struct FSImpactEffect;
+
+// Ring buffers of the components of one surface type
+USTRUCT()
+struct FSImpactComponentRing
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<UParticleSystemComponent*> Particles;
+
+	UPROPERTY()
+		TArray<UDecalComponent*> Decals;
+
+	UPROPERTY()
+		TArray<UAudioComponent*> Sounds;
+
+	// Slot used next - the oldest once the ring is full
+	int32 NextParticle;
+
+	int32 NextDecal;
+
+	int32 NextSound;
+
+	FSImpactComponentRing()
+		: NextParticle(0)
+		, NextDecal(0)
+		, NextSound(0)
+	{
+	}
+
+};
+
+/**
+ * Plays the particle, decal and sound of shot impacts from ring buffers of reusable components, one set of
+ * rings per surface type. Components are created until a ring is full or the per frame creation budget is
+ * spent, after that the oldest component of the ring is recycled - memory stays bounded however long the
+ * firefight. Effects and budgets come from the impact effects data asset set in DefaultGame.ini, streamed in
+ * when the manager begins play - spawned with the first character, impacts before that have no effects.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASImpactEffectsManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASImpactEffectsManager();
+
+	// Returns the impact effects manager of the world, spawns one if needed
+	static ASImpactEffectsManager* Get(const UObject* WorldContextObject);
+
+	// Plays the effects of the surface that was hit
+	void PlayImpact(const FHitResult& Hit);
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called once the effects data and its assets streamed in
+	void OnEffectsDataLoaded();
+
+	// Whether the impact is close enough to a local view
+	bool IsNearView(const FVector& Location) const;
+
+	// Returns the next component of the ring - creates one while the ring and the frame budget allow, recycles the oldest otherwise
+	template<typename T>
+	T* NextComponent(TArray<T*>& Ring, int32& NextIndex, int32 MaxComponents);
+
+	void PlayParticle(FSImpactComponentRing& Ring, const FSImpactEffect& Effect, const FHitResult& Hit);
+
+	void PlayDecal(FSImpactComponentRing& Ring, const FSImpactEffect& Effect, const FHitResult& Hit);
+
+	void PlaySound(FSImpactComponentRing& Ring, const FSImpactEffect& Effect, const FHitResult& Hit);
+
+	// Effects and budgets
+	UPROPERTY(Config)
+		TSoftObjectPtr<USImpactEffectsData> EffectsData;
+
+	UPROPERTY()
+		USImpactEffectsData* LoadedEffectsData;
+
+	TSharedPtr<FStreamableHandle> EffectsDataHandle;
+
+	// Component rings per surface type
+	UPROPERTY()
+		TMap<uint8, FSImpactComponentRing> Rings;
+
+	// Frame the budgets below count for
+	uint64 BudgetFrame;
+
+	int32 NumImpactsThisFrame;
+
+	int32 NumNewComponentsThisFrame;
+
+};
@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SInputRecording.generated.h"
+
+class ASCharacter;
+
+// Actions of the character input, bit index in FSInputFrame
+enum class ESInputAction : uint8
+{
+	Sprint,
+	Crouch,
+	Jump,
+	Aim,
+	Interact,
+	MAX
+};
+
+// Character input of one frame - 20 bytes on disk
+struct DARKHOURS_API FSInputFrame
+{
+	// Seconds since the recording started
+	float Time;
+
+	// Movement axes, quantized to -127..127
+	int8 MoveX;
+
+	int8 MoveY;
+
+	// Camera axes as they reached the character
+	float CameraX;
+
+	float CameraY;
+
+	// Control rotation at the end of the frame, compressed to shorts - replay does not depend on mouse sensitivity
+	uint16 ControlYaw;
+
+	uint16 ControlPitch;
+
+	// Actions held at the end of the frame, one bit per ESInputAction
+	uint8 HeldActions;
+
+	// Actions pressed during the frame, one bit per ESInputAction
+	uint8 PressedActions;
+
+	FSInputFrame();
+
+	float GetMoveX() const;
+
+	float GetMoveY() const;
+
+	void SetMove(float InMoveX, float InMoveY);
+
+	FRotator GetControlRotation() const;
+
+	void SetControlRotation(const FRotator& Rotation);
+
+	// Records a press or a release of the action
+	void SetAction(ESInputAction Action, bool bPressed);
+
+	bool IsHeld(ESInputAction Action) const;
+
+	bool WasPressed(ESInputAction Action) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FSInputFrame& Frame);
+
+};
+
+/**
+ * Recorded input of one character with the transform it started at. Stored as a small binary file
+ * in Saved/InputRecordings, played back by FSInputTrackPlayer.
+ */
+struct DARKHOURS_API FSInputTrack
+{
+	FVector StartLocation;
+
+	FRotator StartRotation;
+
+	TArray<FSInputFrame> Frames;
+
+	FSInputTrack();
+
+	// Seconds covered by the track
+	float GetDuration() const;
+
+	bool Save(const FString& Name) const;
+
+	bool Load(const FString& Name);
+
+	// Returns the file of the named track
+	static FString GetTrackPath(const FString& Name);
+
+	friend FArchive& operator<<(FArchive& Ar, FSInputTrack& Track);
+
+};
+
+// Plays back a track at any timestep - press events of frames stepped over are kept
+struct DARKHOURS_API FSInputTrackPlayer
+{
+	FSInputTrackPlayer();
+
+	// Moves to the frame at the time, returns false when the track is empty
+	bool Advance(const FSInputTrack& Track, float Time, FSInputFrame& OutFrame);
+
+	void Reset();
+
+private:
+	int32 Cursor;
+
+	float LastTime;
+
+};
+
+/**
+ * Records the input of the local player's character every frame. Started and stopped by console command.
+ * Usage: DarkHours.Input.Record [Name], DarkHours.Input.StopRecording
+ */
+UCLASS(NotPlaceable, Transient)
+class DARKHOURS_API ASInputRecorder : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASInputRecorder();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Starts recording the character of the local player
+	void StartRecording(const FString& Name);
+
+	// Saves the track, returns false if nothing was recorded
+	bool StopRecording();
+
+	bool IsRecording() const;
+
+	static ASInputRecorder* Get(const UObject* WorldContextObject);
+
+protected:
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Character being recorded
+	TWeakObjectPtr<ASCharacter> Character;
+
+	FSInputTrack Track;
+
+	FString TrackName;
+
+	float RecordTime;
+
+	bool bRecording;
+
+};
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SInputRecording.h"
+#include "SInputReplayBenchmark.generated.h"
+
+/**
+ * Plays recorded input tracks back on spawned characters at a fixed timestep and writes the timing of
+ * every frame to Saved/Benchmarks/InputReplay_Frames.csv, so builds can be compared on the same gameplay.
+ * Characters take the tracks in turn and may be staggered in time, so a few tracks drive a crowd.
+ * Usage: DarkHours.Input.Replay [TrackNames,...] [NumPawns] [FixedFPS] [StaggerSeconds]
+ * Headless: DarkHours /Game/Levels/Prototype -game -nullrhi -ExecCmds="DarkHours.Input.Replay Input 50" -BenchmarkExit
+ */
+UCLASS()
+class DARKHOURS_API ASInputReplayBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASInputReplayBenchmark();
+
+	// Loads the named tracks, returns false if none could be loaded
+	bool LoadTracks(const TArray<FString>& TrackNames);
+
+	// Number of characters to drive
+	int32 NumPawns;
+
+	// Timestep of the replay
+	float FixedDeltaTime;
+
+	// Time offset between characters playing the same track
+	float StaggerSeconds;
+
+	// Class of characters to spawn
+	TSubclassOf<ASCharacter> CharacterClass;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Turns the fixed timestep of the engine on, or back to what it was
+	void SetFixedTimeStep(bool bEnabled);
+
+	TArray<FSInputTrack> Tracks;
+
+	// Track, player and last applied frame per spawned character
+	TArray<int32> PawnTracks;
+
+	TArray<FSInputTrackPlayer> Players;
+
+	TArray<FSInputFrame> PreviousFrames;
+
+	// Wall time of each sampled frame
+	TArray<float> FrameMs;
+
+	TArray<FString> FrameLines;
+
+	float ReplayTime;
+
+	double LastFrameTime;
+
+	bool bWasFixedTimeStep;
+
+	double PreviousFixedDeltaTime;
+
+	bool bFixedTimeStepSet;
+
+};
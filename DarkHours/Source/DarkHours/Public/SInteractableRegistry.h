@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SInteractableRegistry.generated.h"
+
+// Interactable actor and its interaction location, stored in a grid cell
+struct FSInteractableEntry
+{
+	AActor* Actor;
+
+	FVector Location;
+
+};
+
+/**
+ * Index of the actors a character can interact with (weapon pickups), kept in a uniform spatial hash grid.
+ * Interactables register when they spawn, update their location when they move and unregister when they
+ * are destroyed or pooled. A query only visits the few cells around the character, so the cost of an
+ * interaction does not depend on the amount of loot in the level and no overlap events are needed.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASInteractableRegistry : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASInteractableRegistry();
+
+	// Returns the interactable registry of the world, spawns one if needed
+	static ASInteractableRegistry* Get(const UObject* WorldContextObject);
+
+	// Registers actor as interactable at the location - call from BeginPlay
+	static void RegisterActor(AActor* Actor, const FVector& Location);
+
+	// Moves a registered actor, only rehashes when it changes cell
+	static void UpdateActor(AActor* Actor, const FVector& Location);
+
+	// Unregisters actor - call from EndPlay
+	static void UnregisterActor(AActor* Actor);
+
+	// Returns the nearest interactable of the class within reach of Origin, whose direction is within the facing cone (MinFacingDot is the cosine of the half angle, checked on the horizontal plane)
+	AActor* FindNearest(const FVector& Origin, const FVector& Facing, float Reach, float MinFacingDot, TSubclassOf<AActor> ActorClass = NULL) const;
+
+	// Whether the actor is registered
+	bool IsRegistered(const AActor* Actor) const;
+
+	// Returns the registered location of the actor, zero if not registered
+	FVector GetLocation(const AActor* Actor) const;
+
+	// Returns the number of registered actors
+	int32 GetNumActors() const;
+
+protected:
+	// Returns the grid cell containing the location
+	FIntVector GetCell(const FVector& Location) const;
+
+	// Removes the actor from the cell, drops the cell once empty
+	void RemoveFromCell(const AActor* Actor, const FIntVector& Cell);
+
+	// Size of a grid cell - about the interaction reach, so a query visits few cells
+	UPROPERTY(Config)
+		float CellSize;
+
+	// Interactables per grid cell
+	TMap<FIntVector, TArray<FSInteractableEntry>> Cells;
+
+	// Grid cell of each registered actor
+	TMap<const AActor*, FIntVector> ActorCells;
+
+};
@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
+#include "SInventoryComponent.generated.h"
+
+class ASWeapon;
+class USInventoryComponent;
+
+// Weapon slots of the inventory
+UENUM(BlueprintType)
+enum class ESInventorySlot : uint8
+{
+	Primary,
+	Secondary,
+	MAX UMETA(Hidden)
+};
+
+// Weapon and ammo of a slot - replicated on its own when changed
+USTRUCT()
+struct FSInventorySlot : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		ESInventorySlot Slot;
+
+	// Weapon in the slot, empty if NULL
+	UPROPERTY()
+		TSubclassOf<ASWeapon> WeaponClass;
+
+	// Ammo left in the clip of the weapon
+	UPROPERTY()
+		int32 Ammo;
+
+	FSInventorySlot()
+		: Slot(ESInventorySlot::Primary)
+		, Ammo(0)
+	{
+	}
+
+	// Fast array callbacks - refresh the weapons of the client
+	void PostReplicatedAdd(const struct FSInventoryList& InArraySerializer);
+
+	void PostReplicatedChange(const struct FSInventoryList& InArraySerializer);
+
+	void PreReplicatedRemove(const struct FSInventoryList& InArraySerializer);
+
+};
+
+// Slots of the inventory, delta replicated per slot
+USTRUCT()
+struct FSInventoryList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<FSInventorySlot> Slots;
+
+	// Component owning the list
+	UPROPERTY(NotReplicated)
+		USInventoryComponent* Owner;
+
+	FSInventoryList()
+		: Owner(NULL)
+	{
+	}
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FSInventorySlot, FSInventoryList>(Slots, DeltaParms, *this);
+	}
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FSInventoryList> : public TStructOpsTypeTraitsBase2<FSInventoryList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Server authoritative weapon inventory. Slots hold a weapon class and its ammo and replicate as a fast
+ * array, so only changed slots go over the wire. Weapon actors are not replicated - every machine takes
+ * the weapon of each slot out of the actor pool and attaches it to the owner from the slot state.
+ */
+UCLASS(ClassGroup = (DarkHours), meta = (BlueprintSpawnableComponent))
+class DARKHOURS_API USInventoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	USInventoryComponent();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Puts the weapon class with its ammo into the slot, NULL empties it - server only
+	void SetSlot(ESInventorySlot Slot, TSubclassOf<ASWeapon> WeaponClass, int32 Ammo);
+
+	// Returns the slot, NULL if it never held a weapon
+	const FSInventorySlot* FindSlot(ESInventorySlot Slot) const;
+
+	// Returns the weapon actor of the slot on this machine
+	ASWeapon* GetWeapon(ESInventorySlot Slot) const;
+
+	// Writes the ammo of the weapon back into its slot - server only
+	void OnWeaponAmmoChanged(ASWeapon* Weapon);
+
+	// Called by the fast array when slots were replicated
+	void OnSlotsReplicated();
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Takes the weapons of the slots out of the pool and attaches them, puts weapons of emptied slots back
+	void RefreshWeapons();
+
+	// Slots
+	UPROPERTY(Replicated)
+		FSInventoryList Inventory;
+
+	// Weapon actor per slot, indexed by ESInventorySlot
+	UPROPERTY(Transient)
+		TArray<ASWeapon*> Weapons;
+
+};
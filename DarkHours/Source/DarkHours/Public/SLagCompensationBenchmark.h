@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SLagCompensationBenchmark.generated.h"
+
+/**
+ * Records growing crowds of characters running in circles (8, 32 and 64, one pass each) and fires a number
+ * of rewound shots per frame at where a random character was a random time ago, up to the max rewind.
+ * Reports the cost per rewound shot and of recording a frame, the rate of shots hitting their target - the
+ * accuracy of the interpolated history - and the memory of the history, which must not grow with the crowd.
+ * Usage: DarkHours.Bench.LagCompensation [ShotsPerFrame] [CharacterClassPath]
+ */
+UCLASS()
+class DARKHOURS_API ASLagCompensationBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASLagCompensationBenchmark();
+
+	// Number of rewound shots per frame
+	int32 ShotsPerFrame;
+
+	// Character class of the crowd, the default pawn class if empty
+	FString CharacterClassPath;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+private:
+	// Where the character runs at given world time
+	FVector GetRunLocation(int32 Index, float WorldTime) const;
+
+	// Number of characters of each pass
+	TArray<int32> CrowdSizes;
+
+	// Center of the circle each character runs around
+	TArray<FVector> RunCenters;
+
+	// Fixed seed, so every run fires the same shots
+	FRandomStream ShotStream;
+
+	// Characters recorded in the current pass
+	int32 NumRecorded;
+
+	int32 NumShots;
+
+	int32 NumTargetHits;
+
+	// Frames sampled in the current pass
+	int32 NumSampledFrames;
+
+};
@@ -0,0 +1,201 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SLagCompensationManager.generated.h"
+
+class ASCharacter;
+class ASRifleWeapon;
+struct FCollisionQueryParams;
+
+// Capsule around a bone of the character mesh, recorded for rewinds
+USTRUCT()
+struct FSHitboxSettings
+{
+	GENERATED_BODY()
+
+	// Bone the capsule starts at - the character capsule is recorded instead if the mesh has no such bone
+	UPROPERTY(Config)
+		FName BoneName;
+
+	UPROPERTY(Config)
+		float Radius;
+
+	// Length of the capsule along the X axis of the bone, 0 for a sphere - negative for bones pointing down -X, like mirrored limbs
+	UPROPERTY(Config)
+		float Length;
+
+	FSHitboxSettings()
+		: Radius(10.f)
+		, Length(0.f)
+	{
+	}
+
+};
+
+// Hitbox hit by a rewound ray
+struct FSRewindHit
+{
+	ASCharacter* Character;
+
+	// Index of the hitbox in the settings
+	int32 HitboxIndex;
+
+	FName BoneName;
+
+	// Where the ray entered the hitbox, and how far along the ray
+	FVector Location;
+
+	float Distance;
+
+};
+
+/**
+ * Server side lag compensation. Records the hitbox capsules of every character into one ring buffer of
+ * HistorySize frames allocated once for MaxCharacters: frame major, so a frame of all characters is
+ * written in one run and the bounds tested by a shot are contiguous, and the capsules of one character
+ * at one frame share a few cache lines. A rewind interpolates between the two frames around the view time
+ * of the shooter, culls by the bounds and tests the ray against the capsules of the remaining characters
+ * only - plain math, the live physics scene is never moved. Rewinds are clamped to MaxRewindTime.
+ * Remote players fire through ServerStartFire, whose client timestamp sets how far their shots are rewound.
+ * 'DarkHours.LagCompensation.Record 0' stops characters from registering, the benchmark registers its own.
+ * Settings live in DefaultGame.ini. 'DarkHours.LagCompensation.Report' logs the use of the buffer.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASLagCompensationManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASLagCompensationManager();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Returns the lag compensation manager of the world, spawns one if needed
+	static ASLagCompensationManager* Get(const UObject* WorldContextObject);
+
+	// Whether characters register themselves on the server - 'DarkHours.LagCompensation.Record'
+	static bool IsRecordingEnabled();
+
+	// Starts recording the hitboxes of the character, returns false when all slots are taken - call from BeginPlay on the server
+	static bool RegisterCharacter(ASCharacter* Character);
+
+	// Stops recording the character - call from EndPlay
+	static void UnregisterCharacter(ASCharacter* Character);
+
+	// Whether the character has a recorded history
+	bool IsRecorded(const ASCharacter* Character) const;
+
+	// Makes the query ignore every recorded character - traces for what stands in the way of a rewound hit
+	void IgnoreRecordedCharacters(FCollisionQueryParams& QueryParams) const;
+
+	// Seconds the shots of the weapon are rewound by - how late the remote fire reached the server plus the view delay, 0 for local fire
+	float GetRewindTime(const ASRifleWeapon* Weapon) const;
+
+	// Max seconds a shot is rewound
+	float GetMaxRewindTime() const;
+
+	// Tests the ray against the hitboxes as they were at the given world time, returns the closest hit
+	bool RewindTrace(const FVector& Start, const FVector& End, float TargetTime, const AActor* IgnoredActor, FSRewindHit& OutHit) const;
+
+	// Records the hitboxes of all characters now instead of at the end of the frame
+	void RecordFrame();
+
+	// Number of characters recorded
+	int32 GetNumRecordedCharacters() const;
+
+	// Bytes of the history buffers - fixed once allocated
+	int32 GetAllocatedBytes() const;
+
+	// Rewinds and game thread seconds spent rewinding and recording since the last reset - used by benchmarks
+	int32 GetNumRewinds() const;
+
+	double GetRewindSeconds() const;
+
+	double GetRecordSeconds() const;
+
+	void ResetCounters();
+
+	// Logs the use of the buffer and the cost of rewinds
+	void LogReport() const;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Allocates the history for MaxCharacters and HistorySize frames
+	void AllocateHistory();
+
+	// Marks every frame of the slot as not recorded
+	void ClearSlot(int32 Slot);
+
+	// Returns the slot of the character, INDEX_NONE if it is not recorded
+	int32 FindSlot(const ASCharacter* Character) const;
+
+	// Hitboxes recorded for each character
+	UPROPERTY(Config)
+		TArray<FSHitboxSettings> Hitboxes;
+
+	// Max number of characters recorded - the buffers are sized for it once
+	UPROPERTY(Config)
+		int32 MaxCharacters;
+
+	// Max seconds a shot is rewound
+	UPROPERTY(Config)
+		float MaxRewindTime;
+
+	// Seconds between recorded frames
+	UPROPERTY(Config)
+		float RecordInterval;
+
+	// Seconds remote players see the others behind the replicated state - interpolation of simulated proxies
+	UPROPERTY(Config)
+		float ViewDelay;
+
+	// Number of frames kept, covering MaxRewindTime
+	int32 HistorySize;
+
+	// Characters of the slots
+	TArray<TWeakObjectPtr<ASCharacter>> SlotCharacters;
+
+	// Bone and radius of each hitbox of each slot, [Slot * NumHitboxes + Hitbox]
+	TArray<int32> SlotBoneIndices;
+
+	TArray<float> SlotRadii;
+
+	// Slots in use are below
+	int32 NumUsedSlots;
+
+	// World time of each frame
+	TArray<float> FrameTimes;
+
+	// Bounding sphere of each character at each frame, W < 0 when not recorded - [Frame * MaxCharacters + Slot]
+	TArray<FVector4> FrameBounds;
+
+	// Capsule segments of each hitbox at each frame - [(Frame * MaxCharacters + Slot) * NumHitboxes + Hitbox]
+	TArray<FVector> HitboxStarts;
+
+	TArray<FVector> HitboxEnds;
+
+	// Frame written last, and number of frames written so far up to HistorySize
+	int32 NewestFrame;
+
+	int32 NumFrames;
+
+	float LastRecordTime;
+
+	// Counters for benchmarks
+	mutable int32 NumRewinds;
+
+	mutable double RewindSeconds;
+
+	double RecordSeconds;
+
+};
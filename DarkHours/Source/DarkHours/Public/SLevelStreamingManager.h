@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SPickupInstanceManager.h"
+#include "SLevelStreamingManager.generated.h"
+
+class ULevel;
+class ULevelStreaming;
+
+// Streamed sublevel and the area it covers
+USTRUCT()
+struct FSStreamedLevelSettings
+{
+	GENERATED_BODY()
+
+	// Package of the sublevel, without PIE prefix
+	UPROPERTY(Config)
+		FName PackageName;
+
+	// World space area of the sublevel - distance to the players is measured to it
+	UPROPERTY(Config)
+		FBox Bounds;
+
+	FSStreamedLevelSettings()
+		: Bounds(ForceInit)
+	{
+	}
+
+};
+
+// Streaming level managed by distance
+struct FSStreamedLevel
+{
+	TWeakObjectPtr<ULevelStreaming> StreamingLevel;
+
+	FBox Bounds;
+
+	// Distance to the closest player at the last update
+	float Distance;
+
+};
+
+// State of an actor placed in a sublevel, kept while the sublevel is unloaded
+struct FSPlacedActorState
+{
+	FTransform Transform;
+
+	// Ammo of weapon pickups
+	int32 Ammo;
+
+	// Whether the actor was destroyed or taken - it is destroyed again when the sublevel comes back
+	bool bDestroyed;
+
+};
+
+// Dropped pickup lying in a sublevel - stashed while the sublevel is unloaded, so it does not fall through
+struct FSStashedPickup
+{
+	TSubclassOf<AActor> PickupClass;
+
+	FTransform Transform;
+
+	int32 Ammo;
+
+};
+
+// What survives the unload of a sublevel
+struct FSLevelPersistence
+{
+	// Names of the placed actors tracked, gathered the first time the sublevel was added
+	TSet<FName> TrackedActors;
+
+	TMap<FName, FSPlacedActorState> ActorStates;
+
+	TArray<FSStashedPickup> StashedPickups;
+
+	// Frozen pickups lying in the sublevel - restored as frozen pickups, no actor is spawned for them
+	TArray<FSFrozenPickup> StashedFrozenPickups;
+
+};
+
+/**
+ * Streams the sublevels of the map in and out by distance to the players. Loads are asynchronous only,
+ * closest first, with at most MaxConcurrentLoads sublevels loading or being added at a time; the engine
+ * time slices the rest through the [/Script/Engine.StreamingSettings] of DefaultEngine.ini. Placed
+ * pickups and movable actors keep their state across unload and reload, and dropped and frozen pickups
+ * lying in an unloading sublevel are stashed until it is back - server only, clients get that state replicated.
+ * Sublevels and their bounds live in DefaultGame.ini. 'DarkHours.Streaming.Report' logs the current state.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASLevelStreamingManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASLevelStreamingManager();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Returns the level streaming manager of the world, spawns one if needed
+	static ASLevelStreamingManager* Get(const UObject* WorldContextObject);
+
+	// Streams around the location only instead of around the players - used by the streaming benchmark
+	void SetSourceOverride(const FVector& Location);
+
+	// Streams around the players again
+	void ClearSourceOverride();
+
+	// Returns the bounds of the managed sublevels
+	void GetLevelBounds(TArray<FBox>& OutBounds) const;
+
+	// Number of managed sublevels loaded and visible
+	int32 GetNumVisibleLevels() const;
+
+	// Number of managed sublevels loading or being added to the world
+	int32 GetNumPendingLevels() const;
+
+	// Totals of the load and unload requests
+	int32 GetNumLoadRequests() const;
+
+	int32 GetNumUnloadRequests() const;
+
+	// Logs the state of every managed sublevel
+	void LogReport() const;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Finds the configured sublevels among the streaming levels of the world
+	void GatherStreamedLevels();
+
+	// Measures the distances and requests loads and unloads within budget
+	void UpdateStreaming();
+
+	// Restores the placed actors and the stashed pickups of the sublevel - server only
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	// Records the placed actors and stashes the dropped pickups of the sublevel - server only
+	void OnLevelRemoved(ULevel* Level, UWorld* World);
+
+	// Whether the state of the placed actor is kept across unloads
+	static bool IsTrackedActor(const AActor* Actor);
+
+	// Sublevels and their bounds
+	UPROPERTY(Config)
+		TArray<FSStreamedLevelSettings> Levels;
+
+	// Distance from a player at which a sublevel is loaded
+	UPROPERTY(Config)
+		float LoadDistance;
+
+	// Distance from all players past which a sublevel is unloaded - larger than LoadDistance, so borders do not thrash
+	UPROPERTY(Config)
+		float UnloadDistance;
+
+	// Max number of sublevels loading or being added at the same time
+	UPROPERTY(Config)
+		int32 MaxConcurrentLoads;
+
+	// Seconds between streaming updates
+	UPROPERTY(Config)
+		float UpdateInterval;
+
+	TArray<FSStreamedLevel> StreamedLevels;
+
+	// Persistence of each sublevel, by package name
+	TMap<FName, FSLevelPersistence> Persistence;
+
+	FVector SourceOverride;
+
+	bool bHasSourceOverride;
+
+	// Source locations, gathered every update
+	TArray<FVector> SourceLocations;
+
+	// Indices of the sublevels to load, sorted by distance
+	TArray<int32> LoadCandidates;
+
+	int32 NumLoadRequests;
+
+	int32 NumUnloadRequests;
+
+	FDelegateHandle LevelAddedHandle;
+
+	FDelegateHandle LevelRemovedHandle;
+
+};
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+// Memory of one category of gameplay objects
+struct DARKHOURS_API FSMemoryCategory
+{
+	FString Name;
+
+	// Live instances in the world
+	int32 NumInstances;
+
+	// Memory owned by the instances - objects, components and their render / physics data
+	int64 InstanceBytes;
+
+	// Assets the instances use, counted once however many instances share them
+	int32 NumAssets;
+
+	int64 AssetBytes;
+
+	FSMemoryCategory();
+
+	int64 GetAverageInstanceBytes() const;
+
+};
+
+/**
+ * Per category memory of the gameplay objects of a world - characters, weapons, pickups, frozen pickups,
+ * animation and physics bodies. Tells apart memory that grows with instances (pickup buildup) from shared asset memory
+ * (asset loading). Complements the DarkHours LLM tags, which track the allocations made while spawning.
+ * Usage: DarkHours.Memory.Report
+ */
+struct DARKHOURS_API FSMemoryReport
+{
+	// Measures all the categories of the world
+	static void Gather(UWorld* World, TArray<FSMemoryCategory>& OutCategories);
+
+	// Logs the categories as a table
+	static void Log(UWorld* World);
+
+};
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SMovementBenchmark.generated.h"
+
+/**
+ * Drives the locally controlled character of a client through a loop of moves while toggling sprint, aim
+ * and crouch, without packet emulation (pass 0), with latency (pass 1) and with latency plus packet loss
+ * (pass 2). Reports the position corrections the client received from the server.
+ * Run it on a client connected to a server. Usage: DarkHours.Bench.Movement [LagMs] [LossPercent]
+ */
+UCLASS()
+class DARKHOURS_API ASMovementBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASMovementBenchmark();
+
+	// Simulated latency of the lag passes
+	int32 LagMs;
+
+	// Simulated packet loss of the last pass
+	int32 LossPercent;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Sets packet emulation of the net driver
+	void SetPacketEmulation(int32 InLagMs, int32 InLossPercent);
+
+	// Releases the input held by the benchmark
+	void ReleaseInput();
+
+	// Time the character has been driven this pass
+	float MoveTime;
+
+	// Whether the first sampled frame of the pass was seen
+	bool bSampling;
+
+};
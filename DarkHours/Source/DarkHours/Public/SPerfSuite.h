@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SInputRecording.h"
+#include "SPerfSuite.generated.h"
+
+class ASWeaponPickup;
+
+// Upper bound of a metric of a scenario, e.g. Characters / FrameMsP95 / 33.3
+USTRUCT()
+struct FSPerfBudget
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+		FString Scenario;
+
+	UPROPERTY(Config)
+		FString Metric;
+
+	UPROPERTY(Config)
+		float Max;
+
+	FSPerfBudget()
+		: Max(0.f)
+	{
+	}
+
+};
+
+// Metrics of a finished scenario, in the order they were recorded
+struct FSPerfScenarioResult
+{
+	FString Name;
+
+	TArray<TPair<FString, double>> Metrics;
+
+};
+
+/**
+ * Scripted perf scenarios for the Prototype map, one per pass - characters moving, pickups settling and
+ * repeated primary weapon swaps. Each scenario records frame and game thread time, time per subsystem
+ * (the DarkHours scoped stats), actor spawns and memory high-water marks. Results go to
+ * Saved/Benchmarks/PerfSuite.json and .csv, budgets come from [/Script/DarkHours.SPerfSuite].
+ * A blown budget fails the suite, which makes -BenchmarkExit quit with exit code 1. The automation tests
+ * DarkHours.PerfSuite.<Scenario> load the Prototype map and run one scenario each.
+ * Usage: DarkHours.PerfSuite [NumCharacters] [NumPickups] [SwapsPerFrame]
+ * Headless: DarkHours /Game/Levels/Prototype -game -nullrhi -ExecCmds="Automation RunTests DarkHours.PerfSuite;Quit"
+ */
+UCLASS(Config = Game)
+class DARKHOURS_API ASPerfSuite : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASPerfSuite();
+
+	// Number of scenarios of the suite
+	static const int32 NumScenarios = 3;
+
+	// Spawns the suite in the world, running NumToRun scenarios from FirstScenario on
+	static ASPerfSuite* StartScenarios(UWorld* World, int32 InFirstScenario = 0, int32 NumToRun = NumScenarios);
+
+	// Name of the scenario, as used by the budgets and the reports
+	static const TCHAR* GetScenarioName(int32 Scenario);
+
+	// First scenario run, one per pass from there on
+	int32 FirstScenario;
+
+	// Characters moving in the first scenario
+	UPROPERTY(Config)
+		int32 NumCharacters;
+
+	// Pickups dropped in the second scenario
+	UPROPERTY(Config)
+		int32 NumPickups;
+
+	// Weapon swaps per frame in the third scenario
+	UPROPERTY(Config)
+		int32 SwapsPerFrame;
+
+	// Pickup class dropped and swapped with
+	UPROPERTY(Config)
+		FString PickupClassPath;
+
+	// Metric budgets - any metric above its budget fails the suite
+	UPROPERTY(Config)
+		TArray<FSPerfBudget> Budgets;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Moves the characters of the first scenario with synthetic input
+	void MoveCharacters();
+
+	// Puts the pickups of the second scenario back into the pool
+	void ReleasePickups();
+
+	// Records a metric of the current scenario
+	void AddMetric(FSPerfScenarioResult& Scenario, const FString& Name, double Value);
+
+	// Checks the budgets and writes the JSON report
+	void FinishSuite();
+
+	void OnActorSpawned(AActor* Actor);
+
+	TSubclassOf<ASWeaponPickup> PickupClass;
+
+	UPROPERTY(Transient)
+		TArray<ASWeaponPickup*> Pickups;
+
+	// Pickup the swap character swaps with next
+	UPROPERTY(Transient)
+		ASWeaponPickup* NextPickup;
+
+	// Last synthetic input per character
+	TArray<FSInputFrame> PreviousFrames;
+
+	TArray<FSPerfScenarioResult> Results;
+
+	// Sampled frames of the current scenario
+	TArray<float> FrameMs;
+
+	TArray<float> GameThreadMs;
+
+	double LastFrameTime;
+
+	float InputTime;
+
+	int32 NumSpawnedActors;
+
+	int32 NumSwaps;
+
+	uint64 MaxUsedPhysical;
+
+	FDelegateHandle ActorSpawnedHandle;
+
+};
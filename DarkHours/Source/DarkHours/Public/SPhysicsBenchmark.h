@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SPhysicsBenchmark.generated.h"
+
+class ADestructibleActor;
+class UDestructibleMesh;
+
+/**
+ * Destroys a field of destructibles and throws a crowd of characters into ragdolls with one explosion, first
+ * without the physics budget (pass 0) and then with it (pass 1). Reports the frame and game thread times
+ * around the explosion, the peak of simulated chunks and ragdolls, and the bodies retired by the budget.
+ * Usage: DarkHours.Bench.Physics [DestructibleMeshPath] [NumDestructibles] [NumRagdolls] [CharacterClassPath]
+ */
+UCLASS()
+class DARKHOURS_API ASPhysicsBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASPhysicsBenchmark();
+
+	// Mesh of the destructibles, none are spawned without one
+	UPROPERTY(Transient)
+		UDestructibleMesh* DestructibleMesh;
+
+	int32 NumDestructibles;
+
+	int32 NumRagdolls;
+
+	// Character class of the ragdolls, the default pawn class if empty
+	FString CharacterClassPath;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Fractures every destructible and ragdolls every character from the benchmark origin
+	void Explode();
+
+	// Destroys the destructibles spawned by this benchmark
+	void DestroyDestructibles();
+
+	// Sets physics budget console variable
+	void SetBudgetEnabled(bool bEnabled);
+
+	// Destructibles spawned by this benchmark
+	UPROPERTY(Transient)
+		TArray<ADestructibleActor*> SpawnedDestructibles;
+
+	// Wall time and game thread time of every sampled frame
+	TArray<float> FrameMs;
+
+	TArray<float> GameThreadMs;
+
+	double LastFrameTime;
+
+	int32 MaxDestructibleChunks;
+
+	int32 MaxRagdolls;
+
+	int32 StartRetirements;
+
+	// Budget setting before the benchmark started - restored when done
+	bool bWasBudgetEnabled;
+
+};
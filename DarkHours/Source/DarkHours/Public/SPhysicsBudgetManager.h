@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SPhysicsBudgetManager.generated.h"
+
+class AActor;
+class ULevel;
+class UDestructibleComponent;
+class UPrimitiveComponent;
+class USkeletalMeshComponent;
+
+// Kind of simulated body held to the physics budget
+enum class ESPhysicsBodyType : uint8
+{
+	Destructible,
+	Ragdoll,
+};
+
+// Destructible or ragdoll registered to the physics budget
+struct FSPhysicsBodyEntry
+{
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+
+	ESPhysicsBodyType Type;
+
+	// World time the body started simulating - fracture or ragdoll start, 0 while an unfractured destructible
+	float StartTime;
+
+	// Visible chunks of a fractured destructible, 1 for a ragdoll
+	int32 NumChunks;
+
+	// Retire priority - effective view distance plus age, larger retires first
+	float Score;
+
+};
+
+/**
+ * Holds fractured destructibles and ragdolls to a budget of simulated chunks and ragdolls. Over budget,
+ * the least significant bodies are retired first - far from and hidden to every view, then oldest: the
+ * debris of a destructible is removed, a ragdoll is frozen in its last pose. Only cosmetic destructibles (not
+ * blocking pawns) are retired, those blocking pawns keep their support chunks. Cosmetic destructibles are
+ * also moved to the async physics scene, next to dropped weapon pickups, so their debris
+ * never holds up the game thread step. Settings live in DefaultGame.ini, the per fracture chunk cap of
+ * APEX in DefaultEngine.ini. 'DarkHours.Physics.Report' logs the current use of the budget.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASPhysicsBudgetManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASPhysicsBudgetManager();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Returns the physics budget manager of the world, spawns one if needed
+	static ASPhysicsBudgetManager* Get(const UObject* WorldContextObject);
+
+	// Registers destructible to the budget, moves it to the async scene if cosmetic - found in levels and spawned actors on its own, register again after changing its mesh or collision
+	void RegisterDestructible(UDestructibleComponent* Destructible);
+
+	// Registers a mesh that started simulating as a ragdoll - call once its bodies simulate
+	static void RegisterRagdoll(USkeletalMeshComponent* Mesh);
+
+	// Unregisters ragdoll, when its owner stops it on its own
+	static void UnregisterRagdoll(USkeletalMeshComponent* Mesh);
+
+	// Current use of the budget
+	int32 GetNumDestructibleChunks() const;
+
+	int32 GetNumRagdolls() const;
+
+	// Total of the bodies retired
+	int32 GetNumRetirements() const;
+
+	// Logs the use of the budget and the registered bodies
+	void LogReport() const;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Registers the destructibles of the actor
+	void RegisterActorDestructibles(AActor* Actor);
+
+	// Registers the destructibles of a streamed level
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	// Registers the destructibles of a spawned actor
+	void OnActorSpawned(AActor* Actor);
+
+	// Counts chunks and ragdolls, retires the least significant bodies over budget
+	void UpdateBudget();
+
+	// Scores every simulating body for retirement
+	void ScoreBodies();
+
+	// Removes the debris of a cosmetic destructible, or freezes a ragdoll
+	void RetireBody(FSPhysicsBodyEntry& Entry);
+
+	// Max number of visible chunks of fractured destructibles, 0 is unlimited
+	UPROPERTY(Config)
+		int32 MaxDestructibleChunks;
+
+	// Max number of simulated ragdolls, 0 is unlimited
+	UPROPERTY(Config)
+		int32 MaxRagdolls;
+
+	// Max number of bodies retired per update - retiring is not free either, big overflows are spread over frames
+	UPROPERTY(Config)
+		int32 MaxRetirementsPerUpdate;
+
+	// Distance multiplier for bodies that are not rendered
+	UPROPERTY(Config)
+		float HiddenDistanceScale;
+
+	// Distance added to the score per second of simulation - older bodies retire first at equal distance
+	UPROPERTY(Config)
+		float AgeDistance;
+
+	// Whether destructibles not blocking pawns simulate in the async scene
+	UPROPERTY(Config)
+		bool bCosmeticDestructiblesInAsyncScene;
+
+	// Seconds between budget updates, 0 updates every frame
+	UPROPERTY(Config)
+		float UpdateInterval;
+
+	// Registered destructibles and ragdolls
+	TArray<FSPhysicsBodyEntry> Entries;
+
+	// Indices of the simulating entries sorted by score, reused between updates
+	TArray<int32> SortedEntries;
+
+	// View locations, gathered every update
+	TArray<FVector> ViewLocations;
+
+	int32 NumDestructibleChunks;
+
+	int32 NumRagdolls;
+
+	int32 NumRetirements;
+
+	FDelegateHandle LevelAddedHandle;
+
+	FDelegateHandle ActorSpawnedHandle;
+
+};
@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "GameFramework/Info.h"
+#include "SPickupInstanceManager.generated.h"
+
+class ASPickupInstanceManager;
+class ASWeaponPickup;
+class UHierarchicalInstancedStaticMeshComponent;
+class UStaticMesh;
+
+// Instances of one weapon mesh
+USTRUCT()
+struct FSPickupInstanceBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		UHierarchicalInstancedStaticMeshComponent* Component;
+
+	// Hidden instances, reused before new ones are added
+	TArray<int32> FreeInstances;
+
+	FSPickupInstanceBatch()
+		: Component(NULL)
+	{
+	}
+
+};
+
+// Pickup that was frozen into an instance - what is needed to bring the actor back
+USTRUCT()
+struct FSFrozenPickup
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TSubclassOf<ASWeaponPickup> PickupClass;
+
+	UPROPERTY()
+		UStaticMesh* Mesh;
+
+	// World transform of the pickup mesh
+	FTransform Transform;
+
+	int32 InstanceIndex;
+
+	int32 UpdateAmmo;
+
+	FIntVector Cell;
+
+	FSFrozenPickup()
+		: Mesh(NULL)
+		, InstanceIndex(INDEX_NONE)
+		, UpdateAmmo(0)
+	{
+	}
+
+};
+
+// Frozen pickup as clients see it - an instance of its mesh where the pickup rests on the server
+USTRUCT()
+struct FSReplicatedFrozenPickup : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	// Slot of the frozen pickup on the server
+	UPROPERTY()
+		int32 FrozenIndex;
+
+	UPROPERTY()
+		TSubclassOf<ASWeaponPickup> PickupClass;
+
+	UPROPERTY()
+		UStaticMesh* Mesh;
+
+	UPROPERTY()
+		FVector_NetQuantize10 Location;
+
+	UPROPERTY()
+		FRotator Rotation;
+
+	// Instance showing it on this client
+	UPROPERTY(NotReplicated)
+		int32 InstanceIndex;
+
+	FSReplicatedFrozenPickup()
+		: FrozenIndex(INDEX_NONE)
+		, Mesh(NULL)
+		, Location(FVector::ZeroVector)
+		, Rotation(FRotator::ZeroRotator)
+		, InstanceIndex(INDEX_NONE)
+	{
+	}
+
+	// Fast array callbacks - show and hide the instances of the client
+	void PostReplicatedAdd(const struct FSReplicatedFrozenPickupList& InArraySerializer);
+
+	void PreReplicatedRemove(const struct FSReplicatedFrozenPickupList& InArraySerializer);
+
+};
+
+// Frozen pickups of the server, delta replicated per pickup
+USTRUCT()
+struct FSReplicatedFrozenPickupList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<FSReplicatedFrozenPickup> Items;
+
+	// Manager owning the list
+	UPROPERTY(NotReplicated)
+		ASPickupInstanceManager* Owner;
+
+	FSReplicatedFrozenPickupList()
+		: Owner(NULL)
+	{
+	}
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FSReplicatedFrozenPickup, FSReplicatedFrozenPickupList>(Items, DeltaParms, *this);
+	}
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FSReplicatedFrozenPickupList> : public TStructOpsTypeTraitsBase2<FSReplicatedFrozenPickupList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Turns weapon pickups that came to rest into instances of a hierarchical instanced static mesh, one per
+ * weapon mesh, and puts their actor back into the actor pool - no physics body, components or draw call
+ * per dropped weapon. Frozen pickups are kept in a spatial hash grid and turned back into live actors as
+ * soon as a character comes within ThawDistance. Only the server freezes and thaws; the frozen pickups
+ * replicate to clients as a fast array, from which every client builds its own instances. A dedicated
+ * server keeps the records only, no instances. Settings live in DefaultGame.ini.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASPickupInstanceManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASPickupInstanceManager();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Returns the pickup instance manager of the world, spawns one if needed - clients get the one replicated by the server
+	static ASPickupInstanceManager* Get(const UObject* WorldContextObject);
+
+	// Whether settled pickups are frozen into instances - 'DarkHours.Pickup.Freeze'
+	static bool IsFreezeEnabled();
+
+	// Freezes the pickup into an instance and releases its actor, unless it still moves or a character is near
+	static bool FreezePickup(ASWeaponPickup* WeaponPickup);
+
+	// Turns the frozen pickups within ThawDistance of the location back into actors
+	static void ThawNear(const UObject* WorldContextObject, const FVector& Location);
+
+	// Seconds a pickup has to rest before it is frozen
+	float GetFreezeDelay() const;
+
+	// Returns number of frozen pickups
+	int32 GetNumFrozen() const;
+
+	// Returns bytes held for the frozen pickups - their records and the instance data of the instanced meshes
+	int64 GetFrozenBytes() const;
+
+	// Shows a frozen pickup replicated by the server as an instance - clients only
+	void AddReplicatedInstance(FSReplicatedFrozenPickup& ReplicatedPickup);
+
+	// Hides the instance of a thawed pickup - clients only
+	void RemoveReplicatedInstance(FSReplicatedFrozenPickup& ReplicatedPickup);
+
+	// Takes the frozen pickups within the bounds out of the world, without thawing them - used when their sublevel unloads, server only
+	void StashFrozenPickups(const FBox& Bounds, TArray<FSFrozenPickup>& OutStashed);
+
+	// Puts stashed frozen pickups back as they were - server only
+	void RestoreFrozenPickups(const TArray<FSFrozenPickup>& Stashed);
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Adds an instance of the mesh, reusing a hidden one if there is one
+	int32 AddInstance(UStaticMesh* Mesh, const UStaticMeshComponent* SourceComponent, const FTransform& Transform);
+
+	// Hides the instance, it is reused by the next instance of the mesh
+	void RemoveInstance(UStaticMesh* Mesh, int32 InstanceIndex, const FTransform& Transform);
+
+	// Whether any character is within ThawDistance of the location
+	bool IsCharacterNear(const FVector& Location) const;
+
+	// Returns the instance batch of the mesh, creates its component if needed
+	FSPickupInstanceBatch& FindOrAddBatch(UStaticMesh* Mesh, const UStaticMeshComponent* SourceComponent);
+
+	// Spawns the actor of a frozen pickup and removes its instance
+	void ThawPickup(int32 FrozenIndex);
+
+	// Records the frozen pickup, shows it as an instance and replicates it - returns its slot
+	int32 AddFrozenPickup(FSFrozenPickup& FrozenPickup, const UStaticMeshComponent* SourceComponent);
+
+	// Removes the frozen pickup, its instance and its replicated item - returns its record
+	FSFrozenPickup RemoveFrozenPickup(int32 FrozenIndex);
+
+	// Returns the grid cell containing the location
+	FIntVector GetCell(const FVector& Location) const;
+
+	// Distance from a character at which frozen pickups become actors again - above the interaction reach
+	UPROPERTY(Config)
+		float ThawDistance;
+
+	// Seconds a pickup has to rest before it is frozen
+	UPROPERTY(Config)
+		float FreezeDelay;
+
+	// Size of a grid cell of frozen pickups
+	UPROPERTY(Config)
+		float CellSize;
+
+	// Instance batch per weapon mesh
+	UPROPERTY()
+		TMap<UStaticMesh*, FSPickupInstanceBatch> Batches;
+
+	// Frozen pickups
+	UPROPERTY()
+		TArray<FSFrozenPickup> FrozenPickups;
+
+	// Unused slots of FrozenPickups
+	TArray<int32> FreeFrozenPickups;
+
+	// Indices of frozen pickups per grid cell
+	TMap<FIntVector, TArray<int32>> FrozenCells;
+
+	// Frozen pickups as the clients see them
+	UPROPERTY(Replicated)
+		FSReplicatedFrozenPickupList ReplicatedFrozenPickups;
+
+};
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SPoolBenchmark.generated.h"
+
+class ASWeaponPickup;
+
+/**
+ * Swaps the primary weapon of a character with pickups thousands of times, once with spawn / destroy
+ * (pass 0) and once through the actor pool (pass 1). Reports time per swap and garbage collection time,
+ * including a full purge at the end of each pass.
+ * Usage: DarkHours.Bench.WeaponSwap [SwapsPerFrame] [SwapFrames] [PickupClassPath]
+ */
+UCLASS()
+class DARKHOURS_API ASPoolBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASPoolBenchmark();
+
+	// Number of swaps done each frame
+	int32 SwapsPerFrame;
+
+	// Number of frames swapping, the rest of the pass waits for the garbage collection
+	int32 SwapFrames;
+
+	// Pickup class to start swapping with
+	TSubclassOf<ASWeaponPickup> PickupClass;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Garbage collection timing
+	void OnPreGarbageCollect();
+
+	void OnPostGarbageCollect();
+
+	// Sets actor pool console variable
+	void SetPoolEnabled(bool bEnabled);
+
+	// Pickup the character swaps with next
+	UPROPERTY(Transient)
+		ASWeaponPickup* NextPickup;
+
+	int32 PassFrame;
+
+	int32 NumSwaps;
+
+	double SwapSeconds;
+
+	int32 NumGarbageCollects;
+
+	double GarbageCollectSeconds;
+
+	double GarbageCollectStartTime;
+
+	bool bWasPoolEnabled;
+
+};
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "SPooledActor.generated.h"
+
+UINTERFACE(MinimalAPI)
+class USPooledActor : public UInterface
+{
+	GENERATED_BODY()
+
+};
+
+/**
+ * Actors reused by the actor pool. The pool hides, detaches and disables collision of released actors by
+ * itself - these hooks handle the rest of the per class state, like stopping a tick. Gameplay state that travels
+ * with the actor (ammo) is left alone.
+ */
+class DARKHOURS_API ISPooledActor
+{
+	GENERATED_BODY()
+
+public:
+	// Called after the actor was taken out of the pool, moved and made visible again
+	virtual void OnAcquiredFromPool() {}
+
+	// Called before the actor is hidden and put back into the pool
+	virtual void OnReleasedToPool() {}
+
+};
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SProjectileBenchmark.generated.h"
+
+class ASRifleWeapon;
+
+/**
+ * Keeps the projectile manager filled with rounds fired into the sky and compares advancing them with
+ * scalar math (pass 0) against SIMD vector math (pass 1). Reports rounds simulated per frame and per
+ * millisecond, and the time of the batched sweeps.
+ * Usage: DarkHours.Bench.Projectiles [NumRounds] [SampleFrames]
+ */
+UCLASS()
+class DARKHOURS_API ASProjectileBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASProjectileBenchmark();
+
+	// Number of rounds kept in flight
+	int32 NumRounds;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Fires rounds until NumRounds are in flight
+	void TopUpRounds();
+
+	// Sets projectile SIMD console variable
+	void SetSimdEnabled(bool bEnabled);
+
+	// Weapon the rounds are fired from
+	UPROPERTY(Transient)
+		ASRifleWeapon* Weapon;
+
+	// Random directions of the rounds
+	FRandomStream RandomStream;
+
+	// Whether the first sampled frame of the pass was seen
+	bool bSampling;
+
+	// SIMD setting before the benchmark started - restored when done
+	bool bWasSimdEnabled;
+
+};
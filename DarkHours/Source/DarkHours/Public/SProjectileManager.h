@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "GameFramework/Info.h"
+#include "WorldCollision.h"
+#include "SProjectileManager.generated.h"
+
+class ASRifleWeapon;
+
+/**
+ * Simulates the rounds of all weapons with ballistics in the world, without an actor per round. Rounds are
+ * kept as a structure of arrays and advanced with SIMD vector math (gravity and quadratic drag) every frame.
+ * The segment each round flew is swept as one batch of async line traces, whose hits are resolved at the
+ * start of the next step, before rounds move on. 'DarkHours.Projectile.Simd 0' advances with scalar math.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASProjectileManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASProjectileManager();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Returns the projectile manager of the world, spawns one if needed
+	static ASProjectileManager* Get(const UObject* WorldContextObject);
+
+	// Fires a round of the weapon, with the ballistics of the weapon - returns false if at capacity
+	bool AddRound(ASRifleWeapon* Weapon, const FVector& Start, const FVector& Direction);
+
+	// Returns number of rounds in flight
+	int32 GetNumRounds() const;
+
+	// Rounds advanced and game thread seconds spent advancing and sweeping since the last reset
+	int32 GetNumSimulatedRounds() const;
+
+	double GetSimulateSeconds() const;
+
+	double GetSweepSeconds() const;
+
+	void ResetCounters();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Picks up the sweep results of the last step, applies damage and removes rounds that hit or expired
+	void ResolveSweeps();
+
+	// Moves all rounds by one step
+	void AdvanceRounds(float DeltaTime);
+
+	void AdvanceRoundsScalar(float DeltaTime);
+
+	// Issues one async line trace per round for the segment it flew this step
+	void SweepRounds();
+
+	// Removes a round, swapping the last round into its slot
+	void RemoveRound(int32 Index);
+
+	// Max number of rounds in flight - rounds beyond are dropped
+	UPROPERTY(Config)
+		int32 MaxRounds;
+
+	// Collision channel rounds are swept on
+	UPROPERTY(Config)
+		TEnumAsByte<ECollisionChannel> TraceChannel;
+
+	// Rounds, one entry per round in each array
+	TArray<FVector> Positions;
+
+	TArray<FVector> PreviousPositions;
+
+	TArray<FVector> Velocities;
+
+	TArray<float> Drags;
+
+	TArray<float> GravityScales;
+
+	TArray<float> Lifetimes;
+
+	TArray<TWeakObjectPtr<ASRifleWeapon>> Weapons;
+
+	TArray<FTraceHandle> TraceHandles;
+
+	// Rounds to remove after resolving, reused every step
+	TArray<int32> RemovedRounds;
+
+	// Reused to read trace results
+	FTraceDatum TraceDatum;
+
+	int32 NumSimulatedRounds;
+
+	double SimulateSeconds;
+
+	double SweepSeconds;
+
+};
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SReplicationBenchmark.generated.h"
+
+class ASWeaponPickup;
+
+/**
+ * Grows the number of moving characters and resting pickups over a few passes and reports the server
+ * time spent in the replication graph per frame. Run it on a listen or dedicated server with local
+ * clients connected (e.g. a few '-game 127.0.0.1' instances) - without connections nothing replicates.
+ * Usage: DarkHours.Bench.Replication [MaxCharacters] [MaxPickups] [NumPasses] [PickupClassPath]
+ */
+UCLASS()
+class DARKHOURS_API ASReplicationBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASReplicationBenchmark();
+
+	// Number of characters in the last pass, earlier passes have an even share of it
+	int32 MaxCharacters;
+
+	// Number of pickups in the last pass, earlier passes have an even share of it
+	int32 MaxPickups;
+
+	// Class of pickups to spawn
+	TSubclassOf<ASWeaponPickup> PickupClass;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Puts the spawned pickups back into the pool
+	void ReleasePickups();
+
+	// Pickups spawned by this benchmark
+	UPROPERTY(Transient)
+		TArray<ASWeaponPickup*> Pickups;
+
+	// Where each character circles around
+	TArray<FVector> CharacterOrigins;
+
+	// Accumulated frame time of the current pass
+	double FrameSeconds;
+
+	// Time the characters have been moving
+	float MoveTime;
+
+	// Whether the first sampled frame of the pass was seen
+	bool bSampling;
+
+};
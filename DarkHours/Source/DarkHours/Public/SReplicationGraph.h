@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "SReplicationGraph.generated.h"
+
+// How actors of a class are routed through the replication graph
+UENUM()
+enum class ESClassRepNodeMapping : uint8
+{
+	NotRouted,				// Replicated through their owner or not at all
+	RelevantAllConnections,	// Relevant to every connection
+	Spatialize_Dynamic,		// Moving actors, put into the grid cells they touch every frame
+	Spatialize_Dormancy,	// Actors at rest most of the time - kept in their cells while dormant
+};
+
+/**
+ * Replication graph of DarkHours. Replaces the per connection relevancy checks of every actor with a 2D
+ * spatial grid - characters move through it every frame, pickups only while awake and are skipped while
+ * dormant. Player controllers and view targets are gathered per connection, game and player states are
+ * relevant to all. Weapons are not replicated, every machine attaches them from the character inventory.
+ */
+UCLASS(Config = Game, Transient)
+class DARKHOURS_API USReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	USReplicationGraph();
+
+	// Returns the replication graph of the world, NULL if it is not a server using it
+	static USReplicationGraph* Get(const UObject* WorldContextObject);
+
+	virtual void InitGlobalActorClassSettings() override;
+
+	virtual void InitGlobalGraphNodes() override;
+
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	// Frames replicated and game thread seconds spent replicating since the last reset
+	int32 GetNumReplicatedFrames() const;
+
+	double GetReplicateSeconds() const;
+
+	void ResetCounters();
+
+protected:
+	// Returns the routing of the class, classes without one are routed by their actor defaults
+	ESClassRepNodeMapping GetMappingPolicy(UClass* Class);
+
+	// Size of the cells of the spatial grid
+	UPROPERTY(Config)
+		float GridCellSize;
+
+	// Lowest corner of the spatial grid - actors beyond are clamped into the border cells
+	UPROPERTY(Config)
+		FVector2D SpatialBias;
+
+	// Distance beyond which characters are not replicated to a connection
+	UPROPERTY(Config)
+		float CharacterCullDistance;
+
+	// Distance beyond which pickups are not replicated to a connection
+	UPROPERTY(Config)
+		float PickupCullDistance;
+
+	UPROPERTY()
+		UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+		UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	// Routing per class
+	TClassMap<ESClassRepNodeMapping> ClassRepNodePolicies;
+
+	int32 NumReplicatedFrames;
+
+	double ReplicateSeconds;
+
+};
+
+/**
+ * Per connection node - the player controller of the connection and its view target.
+ */
+UCLASS()
+class DARKHOURS_API USReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+};
@@ -6,6 +6,45 @@
 #include "SWeapon.h"
 #include "SRifleWeapon.generated.h"
 
+class UDamageType;
+
+// Flight of the rounds of a weapon, simulated by the projectile manager
+USTRUCT(BlueprintType)
+struct FSBallistics
+{
+	GENERATED_BODY()
+
+	// Whether rounds fly as projectiles with drop and travel time - hitscan otherwise
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Ballistics")
+		bool bSimulateBallistics;
+
+	// Speed of a round leaving the barrel, in cm/s
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Ballistics")
+		float MuzzleVelocity;
+
+	// Quadratic drag - deceleration is DragCoefficient * speed^2
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Ballistics")
+		float DragCoefficient;
+
+	// Multiplier of the world gravity
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Ballistics")
+		float GravityScale;
+
+	// Seconds a round flies before it is dropped
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Ballistics")
+		float MaxLifetime;
+
+	FSBallistics()
+		: bSimulateBallistics(false)
+		, MuzzleVelocity(90000.f)
+		, DragCoefficient(0.000005f)
+		, GravityScale(1.f)
+		, MaxLifetime(3.f)
+	{
+	}
+
+};
+
 UCLASS()
 class DARKHOURS_API ASRifleWeapon : public ASWeapon
 {
@@ -19,8 +58,81 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Returns where shots start and where they are aimed at - the view of the owner, or the weapon itself without owner
+	void GetFireViewPoint(FVector& OutLocation, FRotator& OutRotation) const;
+
+	// Whether the trigger is held
+	bool bIsFiring;
+
+	// Seconds until the next automatic shot is due
+	float TimeUntilNextShot;
+
+	// World time of the last shot
+	float LastShotTime;
+
 public:
-	// Called every frame
+	// Called every frame - only while firing
 	virtual void Tick(float DeltaTime) override;
 
+	// Called when put back into the actor pool
+	virtual void OnReleasedToPool() override;
+
+	// Starts automatic fire, shots are queued to the hitscan fire system
+	void StartFire();
+
+	// Stops automatic fire
+	void StopFire();
+
+	// Whether the trigger is held
+	bool IsFiring() const;
+
+	// Whether shots of this weapon deal damage - not held, or held by a character this machine has authority over.
+	// Clients trace their own shots for the impact effects only, the server fires them again
+	bool HasFireAuthority() const;
+
+	// Marks the fire started by the remote owner at the given server time - call on the server after StartFire
+	void SetRemoteFireTime(float ClientFireTime);
+
+	// Whether the current fire was started by a remote owner, and how many seconds its start took to reach the server
+	bool bRemoteFire;
+
+	float RemoteFireLatency;
+
+	// Returns the spread half angle in degrees - smaller while the owner aims
+	float GetSpreadAngle() const;
+
+	// Plays particle, decal and sound where a shot of this weapon hit
+	void PlayImpactEffects(const FHitResult& Hit) const;
+
+	// Rounds per minute
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing")
+		float FireRate;
+
+	// Damage of a single shot
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing")
+		float Damage;
+
+	// Damage type of the shots
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing")
+		TSubclassOf<UDamageType> DamageType;
+
+	// Max distance of a shot
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing")
+		float Range;
+
+	// Spread half angle in degrees when firing from the hip
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing")
+		float SpreadAngle;
+
+	// Spread half angle in degrees while aiming
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing")
+		float AimSpreadAngle;
+
+	// Flight of the rounds - authored per weapon Blueprint
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Firing")
+		FSBallistics Ballistics;
+
+	// Shots queued to the hitscan fire system that were not traced yet - ammo is taken when they are
+	int32 NumPendingShots;
+
 };
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SServerBenchmark.generated.h"
+
+/**
+ * Measures the server frame at a fixed player count. Bots stand in for the players and drive their characters
+ * through the input bindings. Busy time is the frame minus the time the engine idled to hold the tick rate,
+ * and utilization is the busy share of the tick budget. The matches per core estimate follows from utilization.
+ * The server runs at TickRate for the whole benchmark (NetServerMaxTickRate and t.MaxFPS), restored once done.
+ * Usage: DarkHours.Bench.Server [NumPlayers=32] [TickRate=30]
+ * Headless: DarkHoursServer /Game/Levels/Prototype -log -ExecCmds="DarkHours.Bench.Server 32" -BenchmarkExit
+ */
+UCLASS()
+class DARKHOURS_API ASServerBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASServerBenchmark();
+
+	// Number of players simulated by bots
+	int32 NumPlayers;
+
+	// Server tick rate the server runs at during the benchmark, and the budget is taken from
+	float TickRate;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Makes the engine hold TickRate, or restores the rates it had before
+	void ApplyTickRate(bool bApply);
+
+	// Wall time and busy time of each sampled frame
+	TArray<float> FrameMs;
+
+	TArray<float> BusyMs;
+
+	double LastFrameTime;
+
+	// Rates before the benchmark, restored when done
+	bool bTickRateApplied;
+
+	int32 PreviousNetServerMaxTickRate;
+
+	float PreviousMaxFPS;
+
+};
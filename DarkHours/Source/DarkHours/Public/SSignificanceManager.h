@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "SSignificanceManager.generated.h"
+
+// Kind of actor registered to the significance manager
+UENUM(BlueprintType)
+enum class ESSignificanceType : uint8
+{
+	Character,
+	Weapon,
+	Pickup,
+	MAX UMETA(Hidden)
+};
+
+// Significance tiers, from full rate to barely updated
+UENUM(BlueprintType)
+enum class ESSignificanceTier : uint8
+{
+	Critical,
+	High,
+	Medium,
+	Low,
+	Dormant,
+	MAX UMETA(Hidden)
+};
+
+// Update rates applied to actors of a tier
+USTRUCT()
+struct FSSignificanceTierSettings
+{
+	GENERATED_BODY()
+
+	// Effective view distance below which actors may be in this tier
+	UPROPERTY(Config)
+		float MaxDistance;
+
+	// Max number of actors in this tier per update - overflow goes down a tier, 0 is unlimited
+	UPROPERTY(Config)
+		int32 Budget;
+
+	// Actor and skeletal mesh tick interval, 0 ticks every frame
+	UPROPERTY(Config)
+		float TickInterval;
+
+	// Update rate of skeletal meshes while not rendered (update rate optimizations)
+	UPROPERTY(Config)
+		int32 NonRenderedAnimUpdateRate;
+
+	// Whether skeletal meshes only tick pose while rendered
+	UPROPERTY(Config)
+		bool bOnlyTickPoseWhenRendered;
+
+	FSSignificanceTierSettings()
+		: MaxDistance(0.f)
+		, Budget(0)
+		, TickInterval(0.f)
+		, NonRenderedAnimUpdateRate(4)
+		, bOnlyTickPoseWhenRendered(false)
+	{
+	}
+
+};
+
+// Actor registered to the significance manager
+struct FSSignificanceEntry
+{
+	TWeakObjectPtr<AActor> Actor;
+
+	ESSignificanceType Type;
+
+	ESSignificanceTier Tier;
+
+	// Effective view distance - smaller is more significant
+	float Score;
+
+	// Actor tick interval at registration, used for full rate tiers
+	float DefaultTickInterval;
+
+};
+
+/**
+ * Scores registered characters, weapons and pickups by distance and visibility to the player views and
+ * sorts them into tiers. Each tier has an actor budget and a set of update rates (actor tick interval,
+ * skeletal mesh tick interval and update rate optimizations) which are applied when the tier of an actor changes.
+ * Settings live in DefaultGame.ini. 'DarkHours.Significance.Report' logs the current tiers.
+ */
+UCLASS(Config = Game, NotPlaceable, Transient)
+class DARKHOURS_API ASSignificanceManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASSignificanceManager();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	// Returns the significance manager of the world, spawns one if needed
+	static ASSignificanceManager* Get(const UObject* WorldContextObject);
+
+	// Registers actor to be throttled by significance - call from BeginPlay
+	static void RegisterActor(AActor* Actor, ESSignificanceType Type);
+
+	// Unregisters actor and restores its update rates - call from EndPlay
+	static void UnregisterActor(AActor* Actor);
+
+	// Returns the current tier of the actor, Critical if not registered
+	ESSignificanceTier GetTier(const AActor* Actor) const;
+
+	// Logs the number of actors per type and tier
+	void LogReport() const;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Settings of each tier, indexed by ESSignificanceTier
+	UPROPERTY(Config)
+		TArray<FSSignificanceTierSettings> Tiers;
+
+	// Distance multiplier for actors that are neither rendered nor in front of any view
+	UPROPERTY(Config)
+		float HiddenDistanceScale;
+
+	// Cosine of the half angle of the view cone used for visibility
+	UPROPERTY(Config)
+		float ViewConeCos;
+
+	// Seconds between significance updates
+	UPROPERTY(Config)
+		float UpdateInterval;
+
+private:
+	// Scores all actors and assigns their tiers within budget
+	void UpdateSignificance();
+
+	// Applies the update rates of the tier to the actor
+	void ApplyTier(FSSignificanceEntry& Entry, ESSignificanceTier NewTier);
+
+	// Returns the tier settings, falls back to full rate if not configured
+	const FSSignificanceTierSettings& GetTierSettings(ESSignificanceTier Tier) const;
+
+	// Registered actors
+	TArray<FSSignificanceEntry> Entries;
+
+	// View locations and directions, gathered every update
+	TArray<FVector> ViewLocations;
+
+	TArray<FVector> ViewDirections;
+
+	// Indices of entries sorted by score, reused between updates
+	TArray<int32> SortedEntries;
+
+	// Whether the manager was enabled last update
+	bool bWasEnabled;
+
+};
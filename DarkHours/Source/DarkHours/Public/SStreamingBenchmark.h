@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SBenchmark.h"
+#include "SStreamingBenchmark.generated.h"
+
+/**
+ * Flies through the streamed sublevels and measures the hitches. The route visits the center of every
+ * sublevel, nearest first, and streaming follows the benchmark instead of the players. The flight moves
+ * a fixed distance per frame, so a hitch cannot skip part of the route. Reports the longest frame and the
+ * number of frames over the hitch threshold.
+ * Usage: DarkHours.Bench.Streaming [Speed=3000] [HitchMs=50] [Altitude=500]
+ * Headless: DarkHours /Game/Levels/Prototype -game -nullrhi -ExecCmds="DarkHours.Bench.Streaming" -BenchmarkExit
+ */
+UCLASS()
+class DARKHOURS_API ASStreamingBenchmark : public ASBenchmark
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASStreamingBenchmark();
+
+	// Units per second of flight, at 60 frames per second
+	float Speed;
+
+	// Frames longer than this count as hitches
+	float HitchMs;
+
+	// Height of the route above the benchmark origin
+	float Altitude;
+
+protected:
+	virtual void BeginPass(int32 PassIndex) override;
+
+	virtual void SampleFrame(int32 PassIndex, float DeltaTime) override;
+
+	virtual void EndPass(int32 PassIndex) override;
+
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Points of the route and the one flown toward
+	TArray<FVector> Route;
+
+	int32 RouteIndex;
+
+	FVector FlightLocation;
+
+	float RouteLength;
+
+	TArray<float> FrameMs;
+
+	double LastFrameTime;
+
+	// Load and unload requests of the streaming manager when the pass started
+	int32 StartLoadRequests;
+
+	int32 StartUnloadRequests;
+
+	// Most sublevels pending at once
+	int32 MaxPendingLevels;
+
+};
@@ -3,14 +3,17 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/Actor.h"
+#include "SPooledActor.h"
 #include "SWeapon.generated.h"
 
 class ASWeaponPickup;
+class USInventoryComponent;
 class USphereComponent;
 
 UCLASS()
-class DARKHOURS_API ASWeapon : public AActor
+class DARKHOURS_API ASWeapon : public AActor, public ISPooledActor
 {
 	GENERATED_BODY()
 	
@@ -22,22 +25,50 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Moves the deprecated hard pickup class over to the soft pickup class
+	virtual void PostLoad() override;
+
+	// Streams in the pickup class, so it is ready when the weapon gets dropped
+	void RequestPickupClass();
+
+	// Deprecated - use PickupClass
+	UPROPERTY()
+		TSubclassOf<ASWeaponPickup> WeaponPickupClass_DEPRECATED;
+
+	// Keeps the pickup class loaded while the weapon is held
+	TSharedPtr<FStreamableHandle> PickupClassHandle;
+
 	// Components
 	// Weapon (skeletal) mesh component
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadWrite, Category = "Components")
 		USkeletalMeshComponent* WeaponMeshComp;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	// Called when taken out of the actor pool - ammo is kept
+	virtual void OnAcquiredFromPool() override;
+
+	// Called when put back into the actor pool
+	virtual void OnReleasedToPool() override;
 
 	// Ref to pickup class of this weapon when character never/no longer possesses this weapon
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Pickup")
-		TSubclassOf<class ASWeaponPickup> WeaponPickupClass;
+		TSoftClassPtr<ASWeaponPickup> PickupClass;
+
+	// Returns the pickup class, loads it if streaming did not finish yet
+	UClass* LoadPickupClass() const;
 
 	// Update amount of ammo
 	int32 UpdateAmmo;
 
+	// Uses up a round, held weapons write their ammo back into the inventory slot
+	void ConsumeAmmo();
+
+	// Inventory holding this weapon - NULL while not held
+	TWeakObjectPtr<USInventoryComponent> Inventory;
+
 	// Max amount of ammo in a single clip
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Ammunition")
 		int32 ClipSize;
@@ -3,14 +3,44 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/Actor.h"
+#include "SPooledActor.h"
 #include "SWeaponPickup.generated.h"
 
 class ASWeapon;
 class UBoxComponent;
+class UStaticMesh;
+
+// What a pickup needs to know about its weapon without loading it
+USTRUCT(BlueprintType)
+struct FSWeaponPickupStats
+{
+	GENERATED_BODY()
+
+	// Clip size of the weapon
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ammunition")
+		int32 ClipSize;
+
+	// Max amount of ammo of the weapon
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ammunition")
+		int32 MaxAmmo;
+
+	// Mesh that represents the weapon while it lies on the ground - used for the frozen instances and by the UI
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon")
+		TSoftObjectPtr<UStaticMesh> DisplayMesh;
+
+	FSWeaponPickupStats()
+		: ClipSize(0)
+		, MaxAmmo(0)
+	{
+	}
+
+};
 
 UCLASS()
-class DARKHOURS_API ASWeaponPickup : public AActor
+class DARKHOURS_API ASWeaponPickup : public AActor, public ISPooledActor
 {
 	GENERATED_BODY()
 	
@@ -18,10 +48,73 @@ public:
 	// Sets default values for this actor's properties
 	ASWeaponPickup();
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Moves the deprecated hard weapon class over to the soft weapon class
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	// Refreshes the weapon stats when the weapon class changes
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	// Refreshes the weapon stats before the pickup Blueprint is saved
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+
+	// Copies the weapon stats from the weapon defaults - editor only, loads the weapon
+	void RefreshWeaponStats();
+#endif
+
+	// Copies clip size and max ammo of the weapon, and the display mesh of this pickup, into the weapon stats
+	void CopyWeaponStats(const ASWeapon* DefaultWeapon);
+
+	// Runs the callbacks waiting for the weapon class
+	void OnWeaponClassLoaded();
+
+	// Keeps the interactable registry up to date while the mesh moves
+	void OnMeshTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	// When the mesh comes to rest - starts trying to freeze the pickup into an instance
+	UFUNCTION()
+		void OnMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName);
+
+	// When the mesh is pushed again
+	UFUNCTION()
+		void OnMeshWake(UPrimitiveComponent* WakingComponent, FName BoneName);
+
+	// Moves the mesh of clients to where it is on the server
+	UFUNCTION()
+		void OnRep_MeshTransform();
+
+	// Where the mesh is on the server - physics moves the mesh away from the root, so replicated movement would not carry it
+	UPROPERTY(ReplicatedUsing = OnRep_MeshTransform)
+		FVector_NetQuantize10 ReplicatedMeshLocation;
+
+	UPROPERTY(ReplicatedUsing = OnRep_MeshTransform)
+		FRotator ReplicatedMeshRotation;
+
+	// Freezes the pickup into an instance if nobody is near
+	void TryFreeze();
+
+	// Retries freezing while the pickup rests
+	FTimerHandle FreezeTimerHandle;
+
+	// Callbacks waiting for the weapon class to stream in
+	TArray<FSimpleDelegate> WeaponClassCallbacks;
+
+	// Deprecated - hard ref pulled the weapon into memory with every pickup, use WeaponClass
+	UPROPERTY()
+		TSubclassOf<ASWeapon> PendingPickupWeaponClass_DEPRECATED;
+
+	// Keeps the weapon class loaded while needed
+	TSharedPtr<FStreamableHandle> WeaponClassHandle;
+
 	/* Components */
 	// Pickup component
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadWrite, Category = "Components")
@@ -32,16 +125,35 @@ protected:
 		UStaticMeshComponent* WeaponRepMeshComp;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	// Called when taken out of the actor pool - ammo is kept
+	virtual void OnAcquiredFromPool() override;
+
+	// Called when put back into the actor pool
+	virtual void OnReleasedToPool() override;
+
+	// Weapon to be possessed by character is this object is picked - streamed in when a character comes close
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Weapon")
+		TSoftClassPtr<ASWeapon> WeaponClass;
 
-	// Weapon to be possessed by character is this object is picked
+	// Stats of the weapon, filled in by the editor so the weapon does not need to be loaded
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Weapon")
-		TSubclassOf<ASWeapon> PendingPickupWeaponClass;
+		FSWeaponPickupStats WeaponStats;
+
+	// Starts streaming in the weapon class, OnLoaded is called once it is loaded (right away if it already is)
+	void RequestWeaponClass(FSimpleDelegate OnLoaded = FSimpleDelegate());
+
+	// Returns the weapon class if it is loaded
+	UClass* GetLoadedWeaponClass() const;
 
 	// Return weapon pickup rep mesh component 
 	UStaticMeshComponent* GetMeshComponent();
 
+	// Returns the display mesh of the weapon stats, or the mesh of the rep mesh component while the stats have none
+	UStaticMesh* GetDisplayMesh() const;
+
+	// Returns where characters interact with this pickup - the mesh, as physics moves it away from the root
+	FVector GetInteractionLocation() const;
+
 	// Update amount of ammo
 	int32 UpdateAmmo;
 
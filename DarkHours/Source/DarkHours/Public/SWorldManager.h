@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+/**
+ * Returns the manager actor of the given class in the world of the context object. Spawns one when
+ * there is none yet and bCreateIfMissing is set. The manager found is cached per world, so calling this
+ * from gameplay code is cheap, also with several worlds alive in PIE or a listen server next to the editor.
+ */
+template<typename T>
+T* GetWorldManager(const UObject* WorldContextObject, bool bCreateIfMissing = true)
+{
+	UWorld* World = (GEngine != NULL && WorldContextObject != NULL) ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : NULL;
+
+	if (World == NULL) {
+		return NULL;
+	}
+
+	static TMap<TWeakObjectPtr<UWorld>, TWeakObjectPtr<T>> CachedManagers;
+
+	const TWeakObjectPtr<T>* CachedManager = CachedManagers.Find(World);
+
+	if (CachedManager != NULL && CachedManager->IsValid() && !(*CachedManager)->IsPendingKill()) {
+		return CachedManager->Get();
+	}
+
+	// Worlds are rarely created, stale ones are dropped when a new manager is cached
+	for (auto It = CachedManagers.CreateIterator(); It; ++It) {
+		if (!It.Key().IsValid()) {
+			It.RemoveCurrent();
+		}
+	}
+
+	for (TActorIterator<T> It(World); It; ++It) {
+		if (!It->IsPendingKill()) {
+			CachedManagers.Add(World, *It);
+			return *It;
+		}
+	}
+
+	if (!bCreateIfMissing || World->bIsTearingDown) {
+		return NULL;
+	}
+
+	FActorSpawnParameters SpawnInfos;
+	SpawnInfos.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnInfos.ObjectFlags |= RF_Transient;
+
+	T* Manager = World->SpawnActor<T>(T::StaticClass(), FTransform::Identity, SpawnInfos);
+	CachedManagers.Add(World, Manager);
+
+	return Manager;
+}
@@ -9,6 +9,6 @@ public class DarkHoursEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 
-		ExtraModuleNames.AddRange( new string[] { "DarkHours" } );
+		ExtraModuleNames.AddRange( new string[] { "DarkHours", "DarkHoursEditor" } );
 	}
 }
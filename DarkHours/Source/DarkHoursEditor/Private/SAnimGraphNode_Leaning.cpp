@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SAnimGraphNode_Leaning.h"
+
+#define LOCTEXT_NAMESPACE "DarkHoursAnimNodes"
+
+FText USAnimGraphNode_Leaning::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if (TitleType == ENodeTitleType::ListView || TitleType == ENodeTitleType::MenuTitle || Node.LeanBone.BoneName == NAME_None) {
+		return GetControllerDescription();
+	}
+
+	return FText::Format(LOCTEXT("LeaningTitle", "{0}\nBone: {1}"), GetControllerDescription(), FText::FromName(Node.LeanBone.BoneName));
+
+}
+
+FText USAnimGraphNode_Leaning::GetTooltipText() const
+{
+	return LOCTEXT("LeaningTooltip", "Adds the procedural leaning rotation of SAnimInstance to a bone");
+
+}
+
+FString USAnimGraphNode_Leaning::GetNodeCategory() const
+{
+	return TEXT("DarkHours");
+
+}
+
+FText USAnimGraphNode_Leaning::GetControllerDescription() const
+{
+	return LOCTEXT("LeaningDescription", "Procedural Leaning");
+
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SAnimGraphNode_StartDirection.h"
+
+#define LOCTEXT_NAMESPACE "DarkHoursAnimNodes"
+
+FText USAnimGraphNode_StartDirection::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return LOCTEXT("StartDirectionTitle", "Blend Poses by Start Direction");
+
+}
+
+FText USAnimGraphNode_StartDirection::GetTooltipText() const
+{
+	return LOCTEXT("StartDirectionTooltip", "Picks the start pose by the direction the character started moving in, latched natively by SAnimInstance");
+
+}
+
+FLinearColor USAnimGraphNode_StartDirection::GetNodeTitleColor() const
+{
+	return FLinearColor(0.2f, 0.8f, 0.2f);
+
+}
+
+FString USAnimGraphNode_StartDirection::GetNodeCategory() const
+{
+	return TEXT("DarkHours");
+
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,349 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SAssetAuditCommandlet.h"
+#include "AssetRegistryModule.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectIterator.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDarkHoursAssetAudit, Log, All);
+
+// Tarjan's strongly connected components over the package graph
+struct FSCycleFinder
+{
+	const TMap<FName, TArray<FName>>& Dependencies;
+
+	TMap<FName, int32> Indices;
+
+	TMap<FName, int32> LowLinks;
+
+	TSet<FName> OnStack;
+
+	TArray<FName> Stack;
+
+	TArray<TArray<FName>> Cycles;
+
+	int32 NextIndex;
+
+	FSCycleFinder(const TMap<FName, TArray<FName>>& InDependencies)
+		: Dependencies(InDependencies)
+		, NextIndex(0)
+	{
+	}
+
+	void Visit(FName Package)
+	{
+		Indices.Add(Package, NextIndex);
+		LowLinks.Add(Package, NextIndex);
+		NextIndex++;
+
+		Stack.Push(Package);
+		OnStack.Add(Package);
+
+		const TArray<FName>* PackageDependencies = Dependencies.Find(Package);
+		bool bReferencesItself = false;
+
+		if (PackageDependencies != NULL) {
+			for (FName Dependency : *PackageDependencies) {
+				bReferencesItself |= Dependency == Package;
+
+				if (!Indices.Contains(Dependency)) {
+					Visit(Dependency);
+					LowLinks[Package] = FMath::Min(LowLinks[Package], LowLinks[Dependency]);
+				}
+				else if (OnStack.Contains(Dependency)) {
+					LowLinks[Package] = FMath::Min(LowLinks[Package], Indices[Dependency]);
+				}
+			}
+		}
+
+		if (LowLinks[Package] != Indices[Package]) {
+			return;
+		}
+
+		// Package is the root of a component
+		TArray<FName> Component;
+		FName Member;
+
+		do {
+			Member = Stack.Pop(false);
+			OnStack.Remove(Member);
+			Component.Add(Member);
+		} while (Member != Package);
+
+		if (Component.Num() > 1 || bReferencesItself) {
+			Cycles.Add(MoveTemp(Component));
+		}
+	}
+
+};
+
+// Returns true for packages of the project, engine and script packages are not audited
+static bool IsProjectPackage(FName PackageName)
+{
+	return PackageName.ToString().StartsWith(TEXT("/Game/"));
+
+}
+
+// Sets default values
+USAssetAuditCommandlet::USAssetAuditCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+}
+
+int32 USAssetAuditCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamsMap;
+
+	ParseCommandLine(*Params, Tokens, Switches, ParamsMap);
+
+	const bool bLoad = Switches.Contains(TEXT("Load"));
+	const bool bFailOnCycles = Switches.Contains(TEXT("FailOnCycles"));
+	const int64 HeavyEdgeBytes = (int64)(FCString::Atof(ParamsMap.Contains(TEXT("HeavyEdgeMB")) ? *ParamsMap[TEXT("HeavyEdgeMB")] : TEXT("16")) * 1024.0 * 1024.0);
+	const FString OutputPath = ParamsMap.Contains(TEXT("Output")) ? ParamsMap[TEXT("Output")] : FPaths::ProjectSavedDir() / TEXT("Audit") / TEXT("AssetAudit.json");
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	AssetRegistry.SearchAllAssets(true);
+
+	// Roots - named packages, or the Blueprints and maps below the root paths
+	TArray<FName> Roots;
+	TMap<FName, FName> RootClasses;
+
+	if (ParamsMap.Contains(TEXT("Roots"))) {
+		TArray<FString> RootNames;
+		ParamsMap[TEXT("Roots")].ParseIntoArray(RootNames, TEXT("+"));
+
+		for (const FString& RootName : RootNames) {
+			Roots.AddUnique(FName(*RootName));
+		}
+	}
+	else {
+		TArray<FString> RootPaths;
+		(ParamsMap.Contains(TEXT("RootPaths")) ? ParamsMap[TEXT("RootPaths")] : FString(TEXT("/Game/Blueprints+/Game/Levels"))).ParseIntoArray(RootPaths, TEXT("+"));
+
+		for (const FString& RootPath : RootPaths) {
+			TArray<FAssetData> Assets;
+			AssetRegistry.GetAssetsByPath(FName(*RootPath), Assets, true);
+
+			for (const FAssetData& Asset : Assets) {
+				if (Asset.AssetClass == TEXT("Blueprint") || Asset.AssetClass == TEXT("AnimBlueprint") || Asset.AssetClass == TEXT("World")) {
+					Roots.AddUnique(Asset.PackageName);
+					RootClasses.Add(Asset.PackageName, Asset.AssetClass);
+				}
+			}
+		}
+	}
+
+	for (FName Root : Roots) {
+		AddToGraph(AssetRegistry, Root);
+	}
+
+	UE_LOG(LogDarkHoursAssetAudit, Display, TEXT("Auditing %d roots, %d packages in the hard reference graph"), Roots.Num(), Dependencies.Num());
+
+	// Roots
+	TArray<TSharedPtr<FJsonValue>> RootValues;
+
+	for (FName Root : Roots) {
+		TSet<FName> Closure;
+		GatherClosure(Root, Closure);
+
+		const int64 DiskBytes = GetClosureDiskBytes(Closure);
+
+		TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+		RootObject->SetStringField(TEXT("Package"), Root.ToString());
+		RootObject->SetStringField(TEXT("Class"), RootClasses.Contains(Root) ? RootClasses[Root].ToString() : FString());
+		RootObject->SetNumberField(TEXT("Packages"), Closure.Num());
+		RootObject->SetNumberField(TEXT("DiskBytes"), (double)DiskBytes);
+
+		if (bLoad) {
+			double LoadSeconds = 0.0;
+			int64 ResidentBytes = 0;
+
+			MeasureLoad(Root, Closure, LoadSeconds, ResidentBytes);
+
+			RootObject->SetNumberField(TEXT("LoadSeconds"), LoadSeconds);
+			RootObject->SetNumberField(TEXT("ResidentBytes"), (double)ResidentBytes);
+		}
+
+		UE_LOG(LogDarkHoursAssetAudit, Display, TEXT("%s: %d packages, %.1f MB on disk"), *Root.ToString(), Closure.Num(), DiskBytes / (1024.0 * 1024.0));
+
+		RootValues.Add(MakeShared<FJsonValueObject>(RootObject));
+	}
+
+	// Cycles
+	TArray<TArray<FName>> Cycles;
+	FindCycles(Cycles);
+
+	TArray<TSharedPtr<FJsonValue>> CycleValues;
+
+	for (const TArray<FName>& Cycle : Cycles) {
+		TArray<TSharedPtr<FJsonValue>> PackageValues;
+		FString CycleString;
+
+		for (FName Package : Cycle) {
+			PackageValues.Add(MakeShared<FJsonValueString>(Package.ToString()));
+			CycleString += (CycleString.IsEmpty() ? TEXT("") : TEXT(" <-> ")) + Package.ToString();
+		}
+
+		UE_LOG(LogDarkHoursAssetAudit, Warning, TEXT("Cycle: %s"), *CycleString);
+
+		CycleValues.Add(MakeShared<FJsonValueArray>(PackageValues));
+	}
+
+	// Heavy edges - a single hard reference pulling in a large closure
+	TArray<TSharedPtr<FJsonValue>> HeavyEdgeValues;
+	TMap<FName, int64> ClosureDiskBytes;
+
+	for (const TPair<FName, TArray<FName>>& Package : Dependencies) {
+		for (FName Dependency : Package.Value) {
+			if (!ClosureDiskBytes.Contains(Dependency)) {
+				TSet<FName> Closure;
+				GatherClosure(Dependency, Closure);
+
+				ClosureDiskBytes.Add(Dependency, GetClosureDiskBytes(Closure));
+			}
+
+			const int64 EdgeBytes = ClosureDiskBytes[Dependency];
+
+			if (EdgeBytes >= HeavyEdgeBytes) {
+				TSharedRef<FJsonObject> EdgeObject = MakeShared<FJsonObject>();
+				EdgeObject->SetStringField(TEXT("From"), Package.Key.ToString());
+				EdgeObject->SetStringField(TEXT("To"), Dependency.ToString());
+				EdgeObject->SetNumberField(TEXT("DiskBytes"), (double)EdgeBytes);
+
+				UE_LOG(LogDarkHoursAssetAudit, Warning, TEXT("Heavy edge: %s -> %s pulls in %.1f MB"), *Package.Key.ToString(), *Dependency.ToString(), EdgeBytes / (1024.0 * 1024.0));
+
+				HeavyEdgeValues.Add(MakeShared<FJsonValueObject>(EdgeObject));
+			}
+		}
+	}
+
+	// Report
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("HeavyEdgeBytes"), (double)HeavyEdgeBytes);
+	Report->SetArrayField(TEXT("Roots"), RootValues);
+	Report->SetArrayField(TEXT("Cycles"), CycleValues);
+	Report->SetArrayField(TEXT("HeavyEdges"), HeavyEdgeValues);
+
+	FString ReportString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ReportString);
+
+	FJsonSerializer::Serialize(Report, Writer);
+
+	if (!FFileHelper::SaveStringToFile(ReportString, *OutputPath)) {
+		UE_LOG(LogDarkHoursAssetAudit, Error, TEXT("Failed to write %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogDarkHoursAssetAudit, Display, TEXT("%d roots, %d cycles, %d heavy edges - written to %s"), Roots.Num(), Cycles.Num(), HeavyEdgeValues.Num(), *OutputPath);
+
+	return bFailOnCycles && Cycles.Num() > 0 ? 1 : 0;
+
+}
+
+void USAssetAuditCommandlet::AddToGraph(IAssetRegistry& AssetRegistry, FName PackageName)
+{
+	if (Dependencies.Contains(PackageName)) {
+		return;
+	}
+
+	// Hard references only - soft references do not load with the package
+	TArray<FName> PackageDependencies;
+	AssetRegistry.GetDependencies(PackageName, PackageDependencies, EAssetRegistryDependencyType::Hard);
+
+	PackageDependencies.RemoveAll([](FName Dependency) { return !IsProjectPackage(Dependency); });
+
+	Dependencies.Add(PackageName, PackageDependencies);
+
+	FString Filename;
+	DiskSizes.Add(PackageName, FPackageName::DoesPackageExist(PackageName.ToString(), NULL, &Filename) ? FMath::Max<int64>(IFileManager::Get().FileSize(*Filename), 0) : 0);
+
+	for (FName Dependency : PackageDependencies) {
+		AddToGraph(AssetRegistry, Dependency);
+	}
+
+}
+
+void USAssetAuditCommandlet::GatherClosure(FName Root, TSet<FName>& OutClosure) const
+{
+	TArray<FName> PendingPackages;
+	PendingPackages.Add(Root);
+
+	while (PendingPackages.Num() > 0) {
+		const FName Package = PendingPackages.Pop(false);
+
+		if (OutClosure.Contains(Package)) {
+			continue;
+		}
+
+		OutClosure.Add(Package);
+
+		const TArray<FName>* PackageDependencies = Dependencies.Find(Package);
+
+		if (PackageDependencies != NULL) {
+			PendingPackages.Append(*PackageDependencies);
+		}
+	}
+
+}
+
+int64 USAssetAuditCommandlet::GetClosureDiskBytes(const TSet<FName>& Closure) const
+{
+	int64 Bytes = 0;
+
+	for (FName Package : Closure) {
+		const int64* DiskSize = DiskSizes.Find(Package);
+
+		Bytes += DiskSize != NULL ? *DiskSize : 0;
+	}
+
+	return Bytes;
+
+}
+
+void USAssetAuditCommandlet::FindCycles(TArray<TArray<FName>>& OutCycles) const
+{
+	FSCycleFinder CycleFinder(Dependencies);
+
+	for (const TPair<FName, TArray<FName>>& Package : Dependencies) {
+		if (!CycleFinder.Indices.Contains(Package.Key)) {
+			CycleFinder.Visit(Package.Key);
+		}
+	}
+
+	OutCycles = MoveTemp(CycleFinder.Cycles);
+
+}
+
+void USAssetAuditCommandlet::MeasureLoad(FName Root, const TSet<FName>& Closure, double& OutSeconds, int64& OutResidentBytes) const
+{
+	// Start from nothing loaded, so shared packages count for every root
+	CollectGarbage(RF_NoFlags);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	LoadPackage(NULL, *Root.ToString(), LOAD_None);
+
+	OutSeconds = FPlatformTime::Seconds() - StartTime;
+	OutResidentBytes = 0;
+
+	for (TObjectIterator<UObject> It; It; ++It) {
+		if (Closure.Contains(It->GetOutermost()->GetFName())) {
+			OutResidentBytes += It->GetClass()->GetStructureSize() + It->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+	}
+
+}
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraphNode_SkeletalControlBase.h"
+#include "SAnimNode_Leaning.h"
+#include "SAnimGraphNode_Leaning.generated.h"
+
+/**
+ * Anim graph node of FSAnimNode_Leaning.
+ */
+UCLASS()
+class DARKHOURSEDITOR_API USAnimGraphNode_Leaning : public UAnimGraphNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Settings")
+		FSAnimNode_Leaning Node;
+
+	// UEdGraphNode interface
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+
+	virtual FText GetTooltipText() const override;
+
+	// UAnimGraphNode_Base interface
+	virtual FString GetNodeCategory() const override;
+
+protected:
+	// UAnimGraphNode_SkeletalControlBase interface
+	virtual FText GetControllerDescription() const override;
+
+	virtual const FAnimNode_SkeletalControlBase* GetNode() const override { return &Node; }
+
+};
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraphNode_Base.h"
+#include "SAnimNode_StartDirection.h"
+#include "SAnimGraphNode_StartDirection.generated.h"
+
+/**
+ * Anim graph node of FSAnimNode_StartDirection.
+ */
+UCLASS()
+class DARKHOURSEDITOR_API USAnimGraphNode_StartDirection : public UAnimGraphNode_Base
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Settings")
+		FSAnimNode_StartDirection Node;
+
+	// UEdGraphNode interface
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+
+	virtual FText GetTooltipText() const override;
+
+	virtual FLinearColor GetNodeTitleColor() const override;
+
+	// UAnimGraphNode_Base interface
+	virtual FString GetNodeCategory() const override;
+
+};
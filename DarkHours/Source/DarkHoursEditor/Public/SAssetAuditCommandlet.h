@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SAssetAuditCommandlet.generated.h"
+
+/**
+ * Walks the hard reference graph of the gameplay Blueprints and maps. Reports the transitive disk size of
+ * every root and, with -Load, the resident size and load time of each root loaded on its own. Flags
+ * reference cycles and heavy edges (a hard reference pulling in more than HeavyEdgeMB), and writes JSON.
+ * Usage: UE4Editor-Cmd DarkHours.uproject -run=SAssetAudit [-RootPaths=/Game/Blueprints+/Game/Levels]
+ *        [-Roots=/Game/Path/Package+...] [-Load] [-HeavyEdgeMB=16] [-Output=Path.json] [-FailOnCycles]
+ */
+UCLASS()
+class DARKHOURSEDITOR_API USAssetAuditCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	USAssetAuditCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	// Adds the package and all the project packages it hard references to the graph
+	void AddToGraph(class IAssetRegistry& AssetRegistry, FName PackageName);
+
+	// Returns the packages the root hard references, directly or not, the root included
+	void GatherClosure(FName Root, TSet<FName>& OutClosure) const;
+
+	int64 GetClosureDiskBytes(const TSet<FName>& Closure) const;
+
+	// Strongly connected components of more than one package, and packages referencing themselves
+	void FindCycles(TArray<TArray<FName>>& OutCycles) const;
+
+	// Loads the root on its own, returns the load time and the memory of the objects of its closure
+	void MeasureLoad(FName Root, const TSet<FName>& Closure, double& OutSeconds, int64& OutResidentBytes) const;
+
+	// Project packages each package hard references
+	TMap<FName, TArray<FName>> Dependencies;
+
+	// Size of each package on disk
+	TMap<FName, int64> DiskSizes;
+
+};
@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+[SupportedPlatforms(UnrealPlatformClass.Server)]
+public class DarkHoursServerTarget : TargetRules
+{
+	public DarkHoursServerTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Server;
+
+		// Hosted servers keep their logs in shipping builds
+		bUseLoggingInShipping = true;
+
+		ExtraModuleNames.AddRange( new string[] { "DarkHours" } );
+	}
+}